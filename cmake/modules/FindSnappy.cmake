@@ -0,0 +1,21 @@
+# Try to find the snappy compression library
+# SNAPPY_FOUND - system has snappy lib
+# SNAPPY_INCLUDE_DIR - the snappy include directory
+# SNAPPY_LIBRARY - Libraries needed to use snappy
+
+if(SNAPPY_INCLUDE_DIR AND SNAPPY_LIBRARY)
+	# Already in cache, be silent
+    set(Snappy_FIND_QUIETLY TRUE)
+endif()
+
+find_path(SNAPPY_INCLUDE_DIR NAMES snappy.h)
+find_library(SNAPPY_LIBRARY NAMES snappy)
+message(STATUS "snappy lib: " ${SNAPPY_LIBRARY})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Snappy DEFAULT_MSG SNAPPY_INCLUDE_DIR SNAPPY_LIBRARY)
+
+mark_as_advanced(SNAPPY_INCLUDE_DIR SNAPPY_LIBRARY)
+
+set(SNAPPY_LIBRARIES ${SNAPPY_LIBRARY})
+set(SNAPPY_INCLUDE_DIRS ${SNAPPY_INCLUDE_DIR})
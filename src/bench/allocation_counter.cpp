@@ -0,0 +1,35 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Only linked into bench_tapyrus_allocs: replacing the global operator new
+// adds to every allocation of the binary.
+static std::atomic<uint64_t> g_num_allocs{0};
+
+void* operator new(std::size_t size)
+{
+    g_num_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+static uint64_t NumAllocations()
+{
+    return g_num_allocs.load(std::memory_order_relaxed);
+}
+
+static const struct AllocationCounterInit {
+    AllocationCounterInit() { benchmark::g_num_allocations = NumAllocations; }
+} g_allocation_counter_init;
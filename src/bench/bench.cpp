@@ -19,9 +19,11 @@ void writeTestGenesisBlockToFile(fs::path genesisPath)
     stream.close();
 }
 
+uint64_t (*benchmark::g_num_allocations)() = nullptr;
+
 void benchmark::ConsolePrinter::header()
 {
-    std::cout << "# Benchmark, evals, iterations, total, min, max, median" << std::endl;
+    std::cout << "# Benchmark, evals, iterations, total, min, max, median[, counter=value...]" << std::endl;
 }
 
 void benchmark::ConsolePrinter::result(const State& state)
@@ -47,7 +49,11 @@ void benchmark::ConsolePrinter::result(const State& state)
     }
 
     std::cout << std::setprecision(6);
-    std::cout << state.m_name << ", " << state.m_num_evals << ", " << state.m_num_iters << ", " << total << ", " << front << ", " << back << ", " << median << std::endl;
+    std::cout << state.m_name << ", " << state.m_num_evals << ", " << state.m_num_iters << ", " << total << ", " << front << ", " << back << ", " << median;
+    for (const auto& counter : state.m_counters) {
+        std::cout << ", " << counter.first << "=" << counter.second;
+    }
+    std::cout << std::endl;
 }
 
 void benchmark::ConsolePrinter::footer() {}
@@ -62,6 +62,8 @@ public:
     const uint64_t m_num_evals;
     std::vector<double> m_elapsed_results;
     time_point m_start_time;
+    //! Figures other than time to report with the results, e.g. allocations per iteration
+    std::map<std::string, double> m_counters;
 
     bool UpdateTimer(time_point finish_time);
 
@@ -84,6 +86,13 @@ public:
 
 typedef std::function<void(State&)> BenchFunction;
 
+/**
+ * Returns the number of heap allocations made so far. Only set in
+ * bench_tapyrus_allocs, which replaces the global operator new to count
+ * them; null in bench_tapyrus, so that its timings are not affected.
+ */
+extern uint64_t (*g_num_allocations)();
+
 class BenchRunner
 {
     struct Bench {
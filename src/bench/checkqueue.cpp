@@ -6,7 +6,10 @@
 #include <util.h>
 #include <validation.h>
 #include <checkqueue.h>
+#include <key.h>
 #include <prevector.h>
+#include <primitives/transaction.h>
+#include <script/sigcache.h>
 #include <vector>
 #include <random.h>
 
@@ -16,6 +19,8 @@ static const size_t BATCHES = 101;
 static const size_t BATCH_SIZE = 30;
 static const int PREVECTOR_SIZE = 28;
 static const unsigned int QUEUE_BATCH_SIZE = 128;
+static const int SIGCACHE_BENCH_THREADS = 32;
+static const size_t SIGCACHE_BENCH_SIGS = 1000;
 
 // This Benchmark tests the CheckQueue with a slightly realistic workload,
 // where checks all contain a prevector that is indirect 50% of the time
@@ -54,3 +59,58 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::State& state)
     }
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob, 1400);
+
+// This Benchmark measures signature cache contention: 32 script check threads
+// (independent of the number of cores) concurrently look up signatures that
+// are all already in the cache, as happens when a block is connected whose
+// transactions were verified on mempool acceptance. A small fraction of the
+// lookups store again to exercise the insert path.
+static void CCheckQueueSigCacheContention(benchmark::State& state)
+{
+    InitSignatureCache();
+
+    struct SigCheck {
+        const CPubKey* pubkey;
+        const std::vector<unsigned char>* sig;
+        const uint256* hash;
+        bool store;
+        SigCheck() : pubkey(nullptr), sig(nullptr), hash(nullptr), store(false) {}
+        SigCheck(const CPubKey& pubkeyIn, const std::vector<unsigned char>& sigIn, const uint256& hashIn, bool storeIn) : pubkey(&pubkeyIn), sig(&sigIn), hash(&hashIn), store(storeIn) {}
+        bool operator()()
+        {
+            static const CTransaction tx;
+            static PrecomputedTransactionData txdata(tx);
+            return CachingTransactionSignatureChecker(&tx, 0, 0, store, txdata).VerifySignature(*sig, *pubkey, *hash);
+        }
+        void swap(SigCheck& x) { std::swap(*this, x); }
+    };
+
+    std::vector<CPubKey> pubkeys;
+    std::vector<std::vector<unsigned char>> sigs(SIGCACHE_BENCH_SIGS);
+    std::vector<uint256> hashes;
+    for (size_t i = 0; i < SIGCACHE_BENCH_SIGS; ++i) {
+        CKey key;
+        key.MakeNewKey(true);
+        hashes.push_back(GetRandHash());
+        pubkeys.push_back(key.GetPubKey());
+        key.Sign_Schnorr(hashes.back(), sigs[i]);
+        // Populate the cache.
+        SigCheck(pubkeys[i], sigs[i], hashes[i], true)();
+    }
+
+    CCheckQueue<SigCheck> queue {QUEUE_BATCH_SIZE, SIGCACHE_BENCH_THREADS - 1};
+    while (state.KeepRunning()) {
+        CCheckQueueControl<SigCheck> control(&queue);
+        for (size_t b = 0; b < BATCHES; ++b) {
+            std::vector<SigCheck> vChecks;
+            vChecks.reserve(SIGCACHE_BENCH_SIGS);
+            for (size_t i = 0; i < SIGCACHE_BENCH_SIGS; ++i) {
+                vChecks.emplace_back(pubkeys[i], sigs[i], hashes[i], i % 100 == 0);
+            }
+            control.Add(std::move(vChecks));
+        }
+        bool ok = control.Wait();
+        assert(ok);
+    }
+}
+BENCHMARK(CCheckQueueSigCacheContention, 20);
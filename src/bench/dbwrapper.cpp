@@ -0,0 +1,117 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include <bench/bench.h>
+#include <dbwrapper.h>
+#include <fs.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+//! Entries written per batch, roughly what a chainstate flush of a small block holds
+static const int ENTRIES_PER_BATCH = 1000;
+//! Entries written before the read benchmarks start
+static const int PREFILL_ENTRIES = 200000;
+//! Cache given to each benchmark database
+static const size_t BENCH_DB_CACHE = 8 << 20;
+
+/** A LevelDB database in a temporary directory, removed again when done. */
+class BenchDB
+{
+public:
+    explicit BenchDB(const std::string& profile)
+        : m_path(fs::temp_directory_path() / fs::unique_path("tapyrus_bench_dbwrapper_%%%%%%%%")),
+          m_db(new CDBWrapper(m_path, BENCH_DB_CACHE, false, true, false, profile))
+    {
+    }
+
+    ~BenchDB()
+    {
+        m_db.reset();
+        fs::remove_all(m_path);
+    }
+
+    CDBWrapper& db() { return *m_db; }
+
+private:
+    fs::path m_path;
+    std::unique_ptr<CDBWrapper> m_db;
+};
+
+static std::vector<unsigned char> BenchValue(FastRandomContext& rand)
+{
+    // About the size of a serialized coin paying to a P2PKH script.
+    std::vector<unsigned char> value(40);
+    for (unsigned char& c : value) {
+        c = rand.randbits(8);
+    }
+    return value;
+}
+
+static void WriteBatch(CDBWrapper& db, FastRandomContext& rand)
+{
+    CDBBatch batch(db);
+    for (int i = 0; i < ENTRIES_PER_BATCH; ++i) {
+        batch.Write(rand.rand256(), BenchValue(rand));
+    }
+    db.WriteBatch(batch);
+}
+
+static void DBWrapperWrite(benchmark::State& state, const std::string& profile)
+{
+    BenchDB bench_db(profile);
+    FastRandomContext rand(true);
+    while (state.KeepRunning()) {
+        WriteBatch(bench_db.db(), rand);
+    }
+}
+
+static void DBWrapperRead(benchmark::State& state, const std::string& profile)
+{
+    BenchDB bench_db(profile);
+    FastRandomContext rand(true);
+    std::vector<uint256> keys;
+    for (int i = 0; i < PREFILL_ENTRIES / ENTRIES_PER_BATCH; ++i) {
+        CDBBatch batch(bench_db.db());
+        for (int j = 0; j < ENTRIES_PER_BATCH; ++j) {
+            keys.push_back(rand.rand256());
+            batch.Write(keys.back(), BenchValue(rand));
+        }
+        bench_db.db().WriteBatch(batch);
+    }
+
+    std::vector<unsigned char> value;
+    while (state.KeepRunning()) {
+        // Half of the lookups miss, like the checks for coins that do not exist yet.
+        for (int i = 0; i < ENTRIES_PER_BATCH; ++i) {
+            bool found = bench_db.db().Read(i % 2 ? keys[rand.randrange(keys.size())] : rand.rand256(), value);
+            assert(found == (i % 2 == 1));
+        }
+    }
+}
+
+static void DBWrapperWriteDefault(benchmark::State& state) { DBWrapperWrite(state, "default"); }
+static void DBWrapperWriteBulkLoad(benchmark::State& state) { DBWrapperWrite(state, "bulkload"); }
+static void DBWrapperReadDefault(benchmark::State& state) { DBWrapperRead(state, "default"); }
+static void DBWrapperReadBulkLoad(benchmark::State& state) { DBWrapperRead(state, "bulkload"); }
+
+BENCHMARK(DBWrapperWriteDefault, 200);
+BENCHMARK(DBWrapperWriteBulkLoad, 200);
+BENCHMARK(DBWrapperReadDefault, 50);
+BENCHMARK(DBWrapperReadBulkLoad, 50);
+
+#if USE_SNAPPY
+static void DBWrapperWriteCompressed(benchmark::State& state) { DBWrapperWrite(state, "compressed"); }
+static void DBWrapperReadCompressed(benchmark::State& state) { DBWrapperRead(state, "compressed"); }
+
+BENCHMARK(DBWrapperWriteCompressed, 200);
+BENCHMARK(DBWrapperReadCompressed, 50);
+#endif
@@ -15,11 +15,12 @@ static void AddTx(const CTransactionRef& tx, const CAmount& nFee, CTxMemPool& po
     int64_t nTime = 0;
     unsigned int nHeight = 1;
     bool spendsCoinbase = false;
+    bool spendsToken = false;
     unsigned int sigOpCost = 4;
     LockPoints lp;
     pool.addUnchecked(tx->GetHashMalFix(), CTxMemPoolEntry(
                                          tx, nFee, nTime, nHeight,
-                                         spendsCoinbase, sigOpCost, lp));
+                                         spendsCoinbase, spendsToken, sigOpCost, lp));
 }
 
 // Right now this is only testing eviction performance in an extremely small
@@ -0,0 +1,111 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <coloridentifier.h>
+#include <consensus/merkle.h>
+#include <jsonwriter.h>
+#include <key.h>
+#include <random.h>
+#include <rpc/blockchain.h>
+#include <validation.h>
+
+#include <univalue.h>
+
+#include <cassert>
+#include <memory>
+
+//! Transactions in the benchmark block
+static const int NUM_TXS = 2000;
+
+/**
+ * A block of transactions with two signed P2PKH inputs and a TPC and a token
+ * output each, about the size of a full block, and an index entry for it.
+ */
+class JSONBenchBlock
+{
+public:
+    CBlock block;
+    uint256 hash;
+    std::unique_ptr<CBlockIndex> index;
+
+    JSONBenchBlock()
+    {
+        SelectParams(TAPYRUS_OP_MODE::PROD);
+        FastRandomContext rand(true);
+
+        CKey key;
+        key.MakeNewKey(true);
+        const CKeyID keyid = key.GetPubKey().GetID();
+        const ColorIdentifier color(CScript() << 1);
+
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].prevout.SetNull();
+        coinbase.vin[0].scriptSig = CScript() << 1 << OP_0;
+        coinbase.vout.emplace_back(50 * COIN, GetScriptForDestination(keyid));
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+
+        for (int i = 0; i < NUM_TXS; ++i) {
+            CMutableTransaction tx;
+            for (int j = 0; j < 2; ++j) {
+                std::vector<unsigned char> sig;
+                key.Sign_ECDSA(rand.rand256(), sig);
+                sig.push_back(SIGHASH_ALL);
+                tx.vin.emplace_back(COutPoint(rand.rand256(), j));
+                tx.vin.back().scriptSig = CScript() << sig << ToByteVector(key.GetPubKey());
+            }
+            tx.vout.emplace_back(COIN + i, GetScriptForDestination(keyid));
+            tx.vout.emplace_back(1000 + i, GetScriptForDestination(CColorKeyID(keyid, color)));
+            block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+        }
+        block.hashMerkleRoot = BlockMerkleRoot(block);
+        block.hashImMerkleRoot = BlockMerkleRoot(block, nullptr, true);
+
+        hash = block.GetHash();
+        index.reset(new CBlockIndex(block.GetBlockHeader()));
+        index->phashBlock = &hash;
+        index->nTx = block.vtx.size();
+    }
+};
+
+static JSONBenchBlock& GetJSONBenchBlock()
+{
+    static JSONBenchBlock bench_block;
+    return bench_block;
+}
+
+static void BlockToJsonUniValue(benchmark::State& state)
+{
+    const JSONBenchBlock& bench_block = GetJSONBenchBlock();
+    LOCK(cs_main);
+    while (state.KeepRunning()) {
+        std::string json = blockToJSON(bench_block.block, bench_block.index.get(), true).write();
+        assert(!json.empty());
+    }
+}
+
+static void BlockToJsonWriter(benchmark::State& state)
+{
+    const JSONBenchBlock& bench_block = GetJSONBenchBlock();
+    LOCK(cs_main);
+    {
+        // Both paths have to give the same bytes.
+        std::string json;
+        JSONWriter writer(json);
+        blockToJSON(bench_block.block, bench_block.index.get(), true, writer);
+        assert(json == blockToJSON(bench_block.block, bench_block.index.get(), true).write());
+    }
+    while (state.KeepRunning()) {
+        std::string json;
+        JSONWriter writer(json);
+        blockToJSON(bench_block.block, bench_block.index.get(), true, writer);
+        assert(!json.empty());
+    }
+}
+
+BENCHMARK(BlockToJsonUniValue, 10);
+BENCHMARK(BlockToJsonWriter, 10);
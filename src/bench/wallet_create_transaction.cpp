@@ -0,0 +1,201 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <coloridentifier.h>
+#include <key.h>
+#include <random.h>
+#include <validation.h>
+#include <wallet/coincontrol.h>
+#include <wallet/wallet.h>
+
+#include <map>
+#include <memory>
+
+//! Number of outputs in each funding transaction added to the wallet
+static const int OUTPUTS_PER_TX = 1000;
+//! Number of token colors the wallet UTXOs are spread over (plus TPC)
+static const int NUM_COLORS = 100;
+
+/**
+ * A wallet holding a large number of confirmed UTXOs, spread evenly over TPC
+ * and NUM_COLORS tokens. All outputs belong to a single key and are confirmed
+ * in a fake block that is made the tip of chainActive, so no chainstate is
+ * needed. Built once per size and shared by the benchmarks of that size.
+ */
+class WalletBenchSetup
+{
+public:
+    CWallet wallet{"dummy", WalletDatabase::CreateDummy()};
+    CKey key;
+    CKeyID keyid;
+    CKeyID destid;
+    std::vector<ColorIdentifier> colors;
+    COutPoint issueOutPoint;
+
+    explicit WalletBenchSetup(int num_utxos)
+    {
+        key.MakeNewKey(true);
+        keyid = key.GetPubKey().GetID();
+        CKey destKey;
+        destKey.MakeNewKey(true);
+        destid = destKey.GetPubKey().GetID();
+        {
+            LOCK(wallet.cs_wallet);
+            wallet.AddKeyPubKey(key, key.GetPubKey());
+        }
+
+        for (int i = 0; i < NUM_COLORS; ++i) {
+            colors.emplace_back(CScript() << i);
+        }
+
+        LOCK(cs_main);
+        auto inserted = mapBlockIndex.emplace(GetRandHash(), new CBlockIndex);
+        m_block = inserted.first->second;
+        m_block->phashBlock = &inserted.first->first;
+        m_block->nHeight = 0;
+        m_block->nTime = GetTime();
+        chainActive.SetTip(m_block);
+
+        const CScript scriptTPC = GetScriptForDestination(keyid);
+        std::vector<CScript> scriptColored;
+        for (const ColorIdentifier& color : colors) {
+            scriptColored.push_back(GetScriptForDestination(CColorKeyID(keyid, color)));
+        }
+
+        int n = 0;
+        for (int txindex = 0; n < num_utxos; ++txindex) {
+            CMutableTransaction tx;
+            tx.vin.emplace_back(COutPoint(GetRandHash(), 0));
+            for (int i = 0; i < OUTPUTS_PER_TX && n < num_utxos; ++i, ++n) {
+                const int color = n % (NUM_COLORS + 1);
+                if (color == 0) {
+                    tx.vout.emplace_back(COIN + (n % 1000) * CENT, scriptTPC);
+                } else {
+                    tx.vout.emplace_back(100 + n % 50, scriptColored[color - 1]);
+                }
+            }
+            CWalletTx wtx(&wallet, MakeTransactionRef(std::move(tx)));
+            wtx.SetMerkleBranch(m_block, txindex);
+            wallet.AddToWallet(wtx);
+            if (txindex == 0) {
+                issueOutPoint = COutPoint(wtx.GetHash(), 0);
+            }
+        }
+    }
+
+    ~WalletBenchSetup()
+    {
+        LOCK(cs_main);
+        chainActive.SetTip(nullptr);
+        mapBlockIndex.erase(m_block->GetBlockHash());
+        delete m_block;
+    }
+
+    //! Make chainActive point at this wallet's block again
+    void Activate()
+    {
+        LOCK(cs_main);
+        chainActive.SetTip(m_block);
+    }
+
+private:
+    CBlockIndex* m_block;
+};
+
+static WalletBenchSetup& GetWalletBenchSetup(int num_utxos)
+{
+    static std::map<int, std::unique_ptr<WalletBenchSetup>> setups;
+    if (setups.empty()) {
+        SelectParams(TAPYRUS_OP_MODE::PROD);
+    }
+    if (!setups.count(num_utxos)) {
+        setups.emplace(num_utxos, std::unique_ptr<WalletBenchSetup>(new WalletBenchSetup(num_utxos)));
+    }
+    WalletBenchSetup& setup = *setups.at(num_utxos);
+    setup.Activate();
+    return setup;
+}
+
+enum class WalletBenchTx {
+    TPC,
+    TOKEN_TRANSFER,
+    TOKEN_ISSUE,
+    MIXED,
+};
+
+static void WalletCreateTransaction(benchmark::State& state, int num_utxos, WalletBenchTx type)
+{
+    WalletBenchSetup& setup = GetWalletBenchSetup(num_utxos);
+    CWallet& wallet = setup.wallet;
+
+    CCoinControl coin_control;
+    // Change goes to a fixed destination so the dummy wallet needs no keypool.
+    coin_control.destChange = setup.keyid;
+    CWallet::ChangePosInOut mapChangePosRequest;
+    mapChangePosRequest[ColorIdentifier()] = -1;
+    std::vector<CRecipient> vecSend;
+    switch (type) {
+    case WalletBenchTx::TPC:
+        vecSend.push_back({GetScriptForDestination(setup.destid), 5 * COIN, false});
+        break;
+    case WalletBenchTx::TOKEN_TRANSFER:
+        vecSend.push_back({GetScriptForDestination(CColorKeyID(setup.destid, setup.colors[0])), 1000, false});
+        break;
+    case WalletBenchTx::TOKEN_ISSUE:
+        coin_control.m_colorTxType = ColoredTxType::ISSUE;
+        coin_control.m_colorId = ColorIdentifier(setup.issueOutPoint, TokenTypes::NON_REISSUABLE);
+        coin_control.Select(setup.issueOutPoint);
+        vecSend.push_back({GetScriptForDestination(CColorKeyID(setup.destid, coin_control.m_colorId)), 1000000, false});
+        break;
+    case WalletBenchTx::MIXED:
+        vecSend.push_back({GetScriptForDestination(setup.destid), 5 * COIN, false});
+        vecSend.push_back({GetScriptForDestination(CColorKeyID(setup.destid, setup.colors[1])), 1000, false});
+        vecSend.push_back({GetScriptForDestination(CColorKeyID(setup.destid, setup.colors[2])), 1000, false});
+        break;
+    }
+
+    uint64_t num_calls = 0;
+    uint64_t num_allocs = 0;
+    while (state.KeepRunning()) {
+        CReserveKey reservekey(&wallet);
+        CAmount nFeeRequired;
+        std::string strError;
+        CWallet::ChangePosInOut mapChangePosRet(mapChangePosRequest);
+        CTransactionRef tx;
+
+        const uint64_t allocs_before = benchmark::g_num_allocations ? benchmark::g_num_allocations() : 0;
+        bool created = wallet.CreateTransaction(vecSend, tx, reservekey, nFeeRequired, mapChangePosRet, strError, coin_control);
+        if (benchmark::g_num_allocations) num_allocs += benchmark::g_num_allocations() - allocs_before;
+        ++num_calls;
+        assert(created);
+    }
+    if (benchmark::g_num_allocations && num_calls) {
+        state.m_counters["allocs_per_call"] = num_allocs / num_calls;
+    }
+}
+
+#define WALLET_CREATE_TX_BENCHMARK(type, name, num_utxos, num_iters)                               \
+    static void WalletCreateTx##name##_##num_utxos(benchmark::State& state)                        \
+    {                                                                                               \
+        WalletCreateTransaction(state, num_utxos, WalletBenchTx::type);                             \
+    }                                                                                               \
+    BENCHMARK(WalletCreateTx##name##_##num_utxos, num_iters);
+
+WALLET_CREATE_TX_BENCHMARK(TPC, TPC, 10000, 20)
+WALLET_CREATE_TX_BENCHMARK(TOKEN_TRANSFER, TokenTransfer, 10000, 20)
+WALLET_CREATE_TX_BENCHMARK(TOKEN_ISSUE, TokenIssue, 10000, 20)
+WALLET_CREATE_TX_BENCHMARK(MIXED, Mixed, 10000, 20)
+
+WALLET_CREATE_TX_BENCHMARK(TPC, TPC, 100000, 2)
+WALLET_CREATE_TX_BENCHMARK(TOKEN_TRANSFER, TokenTransfer, 100000, 2)
+WALLET_CREATE_TX_BENCHMARK(TOKEN_ISSUE, TokenIssue, 100000, 2)
+WALLET_CREATE_TX_BENCHMARK(MIXED, Mixed, 100000, 2)
+
+WALLET_CREATE_TX_BENCHMARK(TPC, TPC, 1000000, 1)
+WALLET_CREATE_TX_BENCHMARK(TOKEN_TRANSFER, TokenTransfer, 1000000, 1)
+WALLET_CREATE_TX_BENCHMARK(TOKEN_ISSUE, TokenIssue, 1000000, 1)
+WALLET_CREATE_TX_BENCHMARK(MIXED, Mixed, 1000000, 1)
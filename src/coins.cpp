@@ -149,6 +149,13 @@ bool CCoinsViewCache::HaveCoinInCache(const COutPoint &outpoint) const {
     return (it != cacheCoins.end() && !it->second.coin.IsSpent());
 }
 
+bool CCoinsViewCache::PeekCoin(const COutPoint &outpoint, Coin &coin) const {
+    CCoinsMap::const_iterator it = cacheCoins.find(outpoint);
+    if (it == cacheCoins.end()) return false;
+    coin = it->second.coin;
+    return true;
+}
+
 uint256 CCoinsViewCache::GetBestBlock() const {
     if (hashBlock.IsNull())
         hashBlock = base->GetBestBlock();
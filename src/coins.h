@@ -238,6 +238,14 @@ public:
      */
     bool HaveCoinInCache(const COutPoint &outpoint) const;
 
+    /**
+     * Look up a coin in this cache only, without calling the backing view.
+     * Returns false if the cache holds no entry for outpoint. Otherwise the
+     * entry is copied to coin; it is spent if the outpoint was spent since
+     * the last flush, in which case the backing view must not be asked.
+     */
+    bool PeekCoin(const COutPoint &outpoint, Coin &coin) const;
+
     /**
      * Return a reference to Coin in the cache, or a pruned one if not found. This is
      * more efficient than GetCoin.
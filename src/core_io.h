@@ -13,6 +13,7 @@
 class CBlock;
 class CScript;
 class CTransaction;
+class JSONWriter;
 struct CMutableTransaction;
 struct PartiallySignedTransaction;
 class uint256;
@@ -36,5 +37,7 @@ std::string SighashToStr(unsigned char sighash_type);
 void ScriptPubKeyToUniv(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
 void ScriptToUniv(const CScript& script, UniValue& out, bool include_address);
 void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry, bool include_hex = true, int serialize_flags = 0);
+/** Write the same object as TxToUniv() without building a UniValue */
+void WriteTxJSON(const CTransaction& tx, const uint256& hashBlock, JSONWriter& writer, bool include_hex = true, int serialize_flags = 0);
 
 #endif // BITCOIN_CORE_IO_H
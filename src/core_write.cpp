@@ -7,6 +7,7 @@
 
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <jsonwriter.h>
 #include <key_io.h>
 #include <script/script.h>
 #include <script/standard.h>
@@ -78,26 +79,19 @@ std::string SighashToStr(unsigned char sighash_type)
     return it->second;
 }
 
-/**
- * Create the assembly string representation of a CScript object.
- * @param[in] script    CScript object to convert into the asm string representation.
- * @param[in] fAttemptSighashDecode    Whether to attempt to decode sighash types on data within the script that matches the format
- *                                     of a signature. Only pass true for scripts you believe could contain signatures. For example,
- *                                     pass false, or omit the this argument (defaults to false), for scriptPubKeys.
- */
-std::string ScriptToAsmStr(const CScript& script, const bool fAttemptSighashDecode)
+/** Append the assembly string representation of a CScript object to str, see ScriptToAsmStr. */
+static void ScriptToAsm(const CScript& script, const bool fAttemptSighashDecode, std::string& str)
 {
-    std::string str;
     opcodetype opcode;
     std::vector<unsigned char> vch;
     CScript::const_iterator pc = script.begin();
     while (pc < script.end()) {
-        if (!str.empty()) {
+        if (pc != script.begin()) {
             str += " ";
         }
         if (!script.GetOp(pc, opcode, vch)) {
             str += "[error]";
-            return str;
+            return;
         }
         if (0 <= opcode && opcode <= OP_PUSHDATA4) {
             if (vch.size() <= static_cast<std::vector<unsigned char>::size_type>(4)) {
@@ -128,6 +122,19 @@ std::string ScriptToAsmStr(const CScript& script, const bool fAttemptSighashDeco
             str += GetOpName(opcode);
         }
     }
+}
+
+/**
+ * Create the assembly string representation of a CScript object.
+ * @param[in] script    CScript object to convert into the asm string representation.
+ * @param[in] fAttemptSighashDecode    Whether to attempt to decode sighash types on data within the script that matches the format
+ *                                     of a signature. Only pass true for scripts you believe could contain signatures. For example,
+ *                                     pass false, or omit the this argument (defaults to false), for scriptPubKeys.
+ */
+std::string ScriptToAsmStr(const CScript& script, const bool fAttemptSighashDecode)
+{
+    std::string str;
+    ScriptToAsm(script, fAttemptSighashDecode, str);
     return str;
 }
 
@@ -232,3 +239,137 @@ void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry,
         entry.pushKV("hex", EncodeHexTx(tx, serialize_flags)); // The hex-encoded transaction. Used the name "hex" to be consistent with the verbose output of "getrawtransaction".
     }
 }
+
+/** Write an amount the way ValueFromAmount() shows it. */
+static void AmountToJSON(const CAmount& amount, JSONWriter& writer)
+{
+    bool sign = amount < 0;
+    int64_t n_abs = (sign ? -amount : amount);
+    std::string remainder = std::to_string(n_abs % COIN);
+    std::string& out = writer.BeginValue();
+    if (sign) out += '-';
+    out += std::to_string(n_abs / COIN);
+    out += '.';
+    out.append(8 - remainder.size(), '0');
+    out += remainder;
+    writer.EndValue();
+}
+
+/** Write an asm string, see ScriptToAsmStr(). It never needs escaping. */
+static void ScriptToAsmJSON(const CScript& script, const bool fAttemptSighashDecode, JSONWriter& writer)
+{
+    std::string& out = writer.BeginValue();
+    out += '"';
+    ScriptToAsm(script, fAttemptSighashDecode, out);
+    out += '"';
+    writer.EndValue();
+}
+
+static void ScriptPubKeyToJSON(const CScript& scriptPubKey, JSONWriter& writer)
+{
+    txnouttype type;
+    std::vector<CTxDestination> addresses;
+    int nRequired;
+
+    writer.BeginObject();
+    writer.Key("asm");
+    ScriptToAsmJSON(scriptPubKey, false, writer);
+    writer.Key("hex");
+    writer.Hex(scriptPubKey.begin(), scriptPubKey.end());
+
+    if (!ExtractDestinations(scriptPubKey, type, addresses, nRequired)) {
+        writer.Key("type");
+        writer.String(GetTxnOutputType(type));
+        writer.EndObject();
+        return;
+    }
+
+    writer.Key("reqSigs");
+    writer.Int(nRequired);
+    writer.Key("type");
+    writer.String(GetTxnOutputType(type));
+    writer.Key("addresses");
+    writer.BeginArray();
+    for (const CTxDestination& addr : addresses) {
+        writer.String(EncodeDestination(addr));
+    }
+    writer.EndArray();
+    writer.EndObject();
+}
+
+void WriteTxJSON(const CTransaction& tx, const uint256& hashBlock, JSONWriter& writer, bool include_hex, int serialize_flags)
+{
+    writer.BeginObject();
+    writer.Key("txid");
+    writer.Hash(tx.GetHashMalFix());
+    writer.Key("hash");
+    writer.Hash(tx.GetWitnessHash());
+    writer.Key("features");
+    writer.Int(tx.nFeatures);
+    writer.Key("size");
+    writer.Int((int)::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION));
+    writer.Key("locktime");
+    writer.Int((int64_t)tx.nLockTime);
+
+    writer.Key("vin");
+    writer.BeginArray();
+    for (const CTxIn& txin : tx.vin) {
+        writer.BeginObject();
+        if (tx.IsCoinBase()) {
+            writer.Key("coinbase");
+            writer.Hex(txin.scriptSig.begin(), txin.scriptSig.end());
+        } else {
+            writer.Key("txid");
+            writer.Hash(txin.prevout.hashMalFix);
+            writer.Key("vout");
+            writer.Int((int64_t)txin.prevout.n);
+            writer.Key("scriptSig");
+            writer.BeginObject();
+            writer.Key("asm");
+            ScriptToAsmJSON(txin.scriptSig, true, writer);
+            writer.Key("hex");
+            writer.Hex(txin.scriptSig.begin(), txin.scriptSig.end());
+            writer.EndObject();
+        }
+        writer.Key("sequence");
+        writer.Int((int64_t)txin.nSequence);
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.Key("vout");
+    writer.BeginArray();
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        const CTxOut& txout = tx.vout[i];
+
+        writer.BeginObject();
+        ColorIdentifier colorId(GetColorIdFromScript(txout.scriptPubKey));
+        writer.Key("token");
+        writer.String(colorId.toHexString());
+        writer.Key("value");
+        if (colorId.type == TokenTypes::NONE) {
+            AmountToJSON(txout.nValue, writer);
+        } else {
+            writer.Int(txout.nValue);
+        }
+        writer.Key("n");
+        writer.Int((int64_t)i);
+        writer.Key("scriptPubKey");
+        ScriptPubKeyToJSON(txout.scriptPubKey, writer);
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    if (!hashBlock.IsNull()) {
+        writer.Key("blockhash");
+        writer.Hash(hashBlock);
+    }
+
+    if (include_hex) {
+        CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION | serialize_flags);
+        ssTx << tx;
+        writer.Key("hex");
+        writer.Hex(ssTx.begin(), ssTx.end());
+    }
+    writer.EndObject();
+}
@@ -142,10 +142,28 @@ public:
  * User Must Guarantee:
  *
  * 1) Write Requires synchronized access (e.g., a lock)
- * 2) Read Requires no concurrent Write, synchronized with the last insert.
- * 3) Erase requires no concurrent Write, synchronized with last insert.
+ * 2) Read Requires no concurrent Write, synchronized with the last insert,
+ *    unless Element is safe to copy, assign and compare while other threads
+ *    do the same (e.g. it is made of relaxed atomics, as the signature cache
+ *    entries are).
+ * 3) Erase requires no concurrent Write, synchronized with last insert, with
+ *    the same exception as Read.
  * 4) An Erase caller must release all memory before allowing a new Writer.
  *
+ * When Read or Erase does run concurrently with a Write under the exception
+ * of 2) and 3), it is free of data races, but:
+ *   - contains() may miss an element that is in the cache, as insert() moves
+ *     elements between their slots and an element is in none of them for a
+ *     moment. It may also compare against a slot that is half overwritten;
+ *     Element must make such a torn value unequal to anything looked up
+ *     (e.g. with independently keyed hash halves).
+ *   - contains(*, true) may set the erase flag of the slot its element was
+ *     just moved out of, so that the element moved in is collected early and
+ *     the element looked up is not, and insert() may clear a flag that was
+ *     just set. Either way an element is only kept or collected too soon.
+ * So a concurrent Read is only as reliable as a cache needs to be: a miss
+ * costs a recomputation and never a wrong result.
+ *
  *
  * Note on function names:
  *   - The name "allow_erase" is used because the real discard happens later.
@@ -260,7 +278,8 @@ private:
     }
 
     /** allow_erase marks the element at index n as discardable. Threadsafe
-     * without any concurrent insert.
+     * without any concurrent insert; see the class comment for what a
+     * concurrent insert may do to the mark.
      * @param n the index to allow erasure of
      */
     inline void allow_erase(uint32_t n) const
@@ -2,10 +2,16 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <dbwrapper.h>
 
 #include <memory>
+#include <memorydb.h>
 #include <random.h>
+#include <sync.h>
 
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
@@ -13,6 +19,7 @@
 #include <memenv.h>
 #include <stdint.h>
 #include <algorithm>
+#include <set>
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -97,13 +104,92 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static const DBProfile DB_PROFILES[] = {
+    // Balanced read and write performance, used unless stated otherwise.
+    {"default", 0.5, 0.25, 2 << 20, 4 << 10, false},
+    // Write heavy loads such as initial sync or a reindex of the chainstate: most
+    // of the cache goes to the write buffers and larger table files are written,
+    // so flushes produce fewer level-0 tables and less compaction work.
+    {"bulkload", 0.25, 0.375, 32 << 20, 4 << 10, false},
+#if USE_SNAPPY
+    // Read-mostly indexes: larger, compressed blocks shrink the files on disk. Only
+    // offered when LevelDB is built with snappy, as uncompressed 16 KiB blocks would
+    // just make point lookups slower.
+    {"compressed", 0.5, 0.25, 2 << 20, 16 << 10, true},
+#endif
+};
+
+#if USE_SNAPPY
+const std::string DEFAULT_INDEX_DB_PROFILE = "compressed";
+#else
+const std::string DEFAULT_INDEX_DB_PROFILE = DEFAULT_DB_PROFILE;
+#endif
+
+const DBProfile* LookupDBProfile(const std::string& name)
+{
+    for (const DBProfile& profile : DB_PROFILES) {
+        if (profile.name == name) {
+            return &profile;
+        }
+    }
+    return nullptr;
+}
+
+std::string ListDBProfiles()
+{
+    std::string ret;
+    for (const DBProfile& profile : DB_PROFILES) {
+        if (!ret.empty()) ret += ", ";
+        ret += profile.name;
+    }
+    return ret;
+}
+
+const DBProfile& GetDBProfile(const std::string& db_name, const std::string& default_profile)
+{
+    const DBProfile* profile = LookupDBProfile(default_profile);
+    assert(profile);
+    for (const std::string& arg : gArgs.GetArgs("-dbprofile")) {
+        const size_t pos = arg.find(':');
+        if (pos != std::string::npos && arg.substr(0, pos) == db_name) {
+            if (const DBProfile* selected = LookupDBProfile(arg.substr(pos + 1))) {
+                profile = selected;
+            }
+        }
+    }
+    return *profile;
+}
+
+bool CheckDBProfileArgs(std::string& error)
+{
+    for (const std::string& arg : gArgs.GetArgs("-dbprofile")) {
+        const size_t pos = arg.find(':');
+        if (pos == 0 || pos == std::string::npos) {
+            error = strprintf("Invalid -dbprofile '%s', expected <db>:<profile>", arg);
+            return false;
+        }
+        if (!LookupDBProfile(arg.substr(pos + 1))) {
+            error = strprintf("Unknown database profile '%s' (available: %s)", arg.substr(pos + 1), ListDBProfiles());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsValidDBBackend(const std::string& name)
+{
+    return name == "leveldb" || name == "memory";
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize, const DBProfile& profile)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
+    options.block_cache = leveldb::NewLRUCache(nCacheSize * profile.block_cache_ratio);
+    options.write_buffer_size = nCacheSize * profile.write_buffer_ratio; // up to two write buffers may be held in memory simultaneously
+    options.max_file_size = profile.max_file_size;
+    options.block_size = profile.block_size;
     options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
+    options.compression = profile.compression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
@@ -114,31 +200,49 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
-    : m_name(path.stem().string())
+static Mutex g_dbwrappers_mutex;
+static std::set<const CDBWrapper*> g_dbwrappers GUARDED_BY(g_dbwrappers_mutex);
+
+void ForEachDBWrapper(const std::function<void(const CDBWrapper&)>& fn)
+{
+    LOCK(g_dbwrappers_mutex);
+    for (const CDBWrapper* db : g_dbwrappers) {
+        fn(*db);
+    }
+}
+
+CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate, const std::string& default_profile)
+    : m_name(path.stem().string()), m_profile(GetDBProfile(m_name, default_profile)), m_cache_size(nCacheSize),
+      m_backend(gArgs.GetArg("-dbbackend", DEFAULT_DB_BACKEND))
 {
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, m_profile);
     options.create_if_missing = true;
-    if (fMemory) {
-        penv = leveldb::NewMemEnv(leveldb::Env::Default());
-        options.env = penv;
+    if (m_backend == "memory") {
+        // Starts out empty every time, so there is nothing to wipe.
+        LogPrintf("Opening in-memory database for %s\n", path.string());
+        pdb = NewMemoryDB();
     } else {
-        if (fWipe) {
-            LogPrintf("Wiping LevelDB in %s\n", path.string());
-            leveldb::Status result = leveldb::DestroyDB(path.string(), options);
-            dbwrapper_private::HandleError(result);
+        if (fMemory) {
+            penv = leveldb::NewMemEnv(leveldb::Env::Default());
+            options.env = penv;
+        } else {
+            if (fWipe) {
+                LogPrintf("Wiping LevelDB in %s\n", path.string());
+                leveldb::Status result = leveldb::DestroyDB(path.string(), options);
+                dbwrapper_private::HandleError(result);
+            }
+            TryCreateDirectories(path);
+            LogPrintf("Opening LevelDB in %s (profile %s)\n", path.string(), m_profile.name);
         }
-        TryCreateDirectories(path);
-        LogPrintf("Opening LevelDB in %s\n", path.string());
+        leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
+        dbwrapper_private::HandleError(status);
+        LogPrintf("Opened LevelDB successfully\n");
     }
-    leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
-    dbwrapper_private::HandleError(status);
-    LogPrintf("Opened LevelDB successfully\n");
 
     if (gArgs.GetBoolArg("-forcecompactdb", false)) {
         LogPrintf("Starting database compaction of %s\n", path.string());
@@ -164,10 +268,17 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     }
 
     LogPrintf("Using obfuscation key for %s: %s\n", path.string(), HexStr(obfuscate_key));
+
+    LOCK(g_dbwrappers_mutex);
+    g_dbwrappers.insert(this);
 }
 
 CDBWrapper::~CDBWrapper()
 {
+    {
+        LOCK(g_dbwrappers_mutex);
+        g_dbwrappers.erase(this);
+    }
     delete pdb;
     pdb = nullptr;
     delete options.filter_policy;
@@ -206,6 +317,16 @@ size_t CDBWrapper::DynamicMemoryUsage() const {
     return stoul(memory);
 }
 
+std::vector<int> CDBWrapper::GetFilesPerLevel() const
+{
+    std::vector<int> files;
+    std::string value;
+    while (pdb->GetProperty("leveldb.num-files-at-level" + std::to_string(files.size()), &value)) {
+        files.push_back(std::stoi(value));
+    }
+    return files;
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
@@ -233,6 +354,13 @@ bool CDBWrapper::IsEmpty()
     return !(it->Valid());
 }
 
+CDBSnapshot::CDBSnapshot(const CDBWrapper &_parent) : parent(_parent), psnapshot(_parent.pdb->GetSnapshot()), readoptions(_parent.readoptions)
+{
+    readoptions.snapshot = psnapshot;
+}
+
+CDBSnapshot::~CDBSnapshot() { parent.pdb->ReleaseSnapshot(psnapshot); }
+
 CDBIterator::~CDBIterator() { delete piter; }
 bool CDBIterator::Valid() const { return piter->Valid(); }
 void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
@@ -16,6 +16,8 @@
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
+#include <functional>
+
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 
@@ -27,6 +29,54 @@ public:
 
 class CDBWrapper;
 
+/** LevelDB tuning applied to a CDBWrapper. The built-in profiles are listed by ListDBProfiles(). */
+struct DBProfile
+{
+    //! name of the profile, as accepted by -dbprofile
+    std::string name;
+    //! share of the database cache used for the LevelDB block cache
+    double block_cache_ratio;
+    //! share of the database cache used per write buffer (up to two are held in memory)
+    double write_buffer_ratio;
+    //! size at which LevelDB starts a new table file
+    size_t max_file_size;
+    //! approximate size of the uncompressed data in each table block
+    size_t block_size;
+    //! whether table blocks are snappy compressed
+    bool compression;
+};
+
+static const std::string DEFAULT_DB_PROFILE = "default";
+
+/**
+ * Default profile of the read-mostly txindex and address index: "compressed" when
+ * LevelDB is built with snappy, DEFAULT_DB_PROFILE otherwise.
+ */
+extern const std::string DEFAULT_INDEX_DB_PROFILE;
+
+/** Return the built-in profile called name, or nullptr if there is none. */
+const DBProfile* LookupDBProfile(const std::string& name);
+
+/** Comma separated names of the built-in profiles, for help messages. */
+std::string ListDBProfiles();
+
+/**
+ * Return the profile selected for database db_name with -dbprofile=<db_name>:<profile>,
+ * or default_profile if there is no such setting.
+ */
+const DBProfile& GetDBProfile(const std::string& db_name, const std::string& default_profile = DEFAULT_DB_PROFILE);
+
+static const std::string DEFAULT_DB_BACKEND = "leveldb";
+
+/**
+ * Whether name is a storage engine accepted by -dbbackend: "leveldb", or
+ * "memory" for the in-memory table of memorydb.h which keeps nothing on disk.
+ */
+bool IsValidDBBackend(const std::string& name);
+
+/** Check the -dbprofile settings, returning false and setting error on an invalid one. */
+bool CheckDBProfileArgs(std::string& error);
+
 /** These should be considered an implementation detail of the specific database.
  */
 namespace dbwrapper_private {
@@ -176,6 +226,7 @@ public:
 class CDBWrapper
 {
     friend const std::vector<unsigned char>& dbwrapper_private::GetObfuscateKey(const CDBWrapper &w);
+    friend class CDBSnapshot;
 private:
     //! custom environment this database is using (may be nullptr in case of default environment)
     leveldb::Env* penv;
@@ -201,6 +252,15 @@ private:
     //! the name of this database
     std::string m_name;
 
+    //! the LevelDB tuning this database was opened with
+    const DBProfile& m_profile;
+
+    //! the cache size this database was opened with
+    size_t m_cache_size;
+
+    //! the storage engine behind pdb, see IsValidDBBackend()
+    std::string m_backend;
+
     //! a key used for optional XOR-obfuscation of the database
     std::vector<unsigned char> obfuscate_key;
 
@@ -212,23 +272,8 @@ private:
 
     std::vector<unsigned char> CreateObfuscateKey() const;
 
-public:
-    /**
-     * @param[in] path        Location in the filesystem where leveldb data will be stored.
-     * @param[in] nCacheSize  Configures various leveldb cache settings.
-     * @param[in] fMemory     If true, use leveldb's memory environment.
-     * @param[in] fWipe       If true, remove all existing data.
-     * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
-     *                        with a zero'd byte array.
-     */
-    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
-    ~CDBWrapper();
-
-    CDBWrapper(const CDBWrapper&) = delete;
-    CDBWrapper& operator=(const CDBWrapper&) = delete;
-
     template <typename K, typename V>
-    bool Read(const K& key, V& value) const
+    bool Read(const K& key, V& value, const leveldb::ReadOptions& options) const
     {
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
@@ -236,7 +281,7 @@ public:
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
 
         std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(options, slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -253,6 +298,31 @@ public:
         return true;
     }
 
+public:
+    /**
+     * @param[in] path        Location in the filesystem where leveldb data will be stored.
+     * @param[in] nCacheSize  Configures various leveldb cache settings.
+     * @param[in] fMemory     If true, use leveldb's memory environment. Ignored when -dbbackend
+     *                        selects the in-memory engine, which never touches the disk.
+     * @param[in] fWipe       If true, remove all existing data.
+     * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
+     *                        with a zero'd byte array.
+     * @param[in] default_profile  LevelDB tuning used unless -dbprofile selects another one
+     *                        for this database (named by the last component of path).
+     */
+    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false,
+               const std::string& default_profile = DEFAULT_DB_PROFILE);
+    ~CDBWrapper();
+
+    CDBWrapper(const CDBWrapper&) = delete;
+    CDBWrapper& operator=(const CDBWrapper&) = delete;
+
+    template <typename K, typename V>
+    bool Read(const K& key, V& value) const
+    {
+        return Read(key, value, readoptions);
+    }
+
     template <typename K, typename V>
     bool Write(const K& key, const V& value, bool fSync = false)
     {
@@ -293,6 +363,14 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
+    const std::string& GetName() const { return m_name; }
+    const DBProfile& GetProfile() const { return m_profile; }
+    size_t GetCacheSize() const { return m_cache_size; }
+    const std::string& GetBackend() const { return m_backend; }
+
+    // Number of table files at each LevelDB level.
+    std::vector<int> GetFilesPerLevel() const;
+
     // not available for LevelDB; provide for compatibility with BDB
     bool Flush()
     {
@@ -349,4 +427,33 @@ public:
 
 };
 
+/**
+ * The database as it was when the snapshot was taken, which writes done
+ * since do not change. Reads through it need none of the locks that keep
+ * them in order with the writers.
+ */
+class CDBSnapshot
+{
+private:
+    const CDBWrapper &parent;
+    const leveldb::Snapshot* psnapshot;
+    leveldb::ReadOptions readoptions;
+
+public:
+    explicit CDBSnapshot(const CDBWrapper &_parent);
+    ~CDBSnapshot();
+
+    CDBSnapshot(const CDBSnapshot&) = delete;
+    CDBSnapshot& operator=(const CDBSnapshot&) = delete;
+
+    template <typename K, typename V>
+    bool Read(const K& key, V& value) const
+    {
+        return parent.Read(key, value, readoptions);
+    }
+};
+
+/** Call fn for each open CDBWrapper, with the registry lock held. */
+void ForEachDBWrapper(const std::function<void(const CDBWrapper&)>& fn);
+
 #endif // BITCOIN_DBWRAPPER_H
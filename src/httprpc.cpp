@@ -168,6 +168,7 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
     }
 
     JSONRPCRequest jreq;
+    std::string raw_result;
     jreq.peerAddr = req->GetPeer().ToString();
     if (!RPCAuthorized(authHeader.second, jreq.authUser)) {
         LogPrintf("ThreadRPCServer incorrect password attempt from %s\n", jreq.peerAddr);
@@ -190,6 +191,8 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 
         // Set the URI
         jreq.URI = req->GetURI();
+        // Results are only written into the reply
+        jreq.pRawResult = &raw_result;
 
         std::string strReply;
         bool user_has_whitelist = g_rpc_whitelist.count(jreq.authUser);
@@ -209,7 +212,10 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
             UniValue result = tableRPC.execute(jreq);
 
             // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            if (!raw_result.empty())
+                strReply = JSONRPCRawReplyObj(raw_result, jreq.id) + "\n";
+            else
+                strReply = JSONRPCReply(result, NullUniValue, jreq.id);
 
         // array of requests
         } else if (valRequest.isArray()) {
@@ -246,6 +252,85 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
     return true;
 }
 
+/** Methods that are answered without noticeable work, e.g. by monitoring probes */
+static const std::set<std::string> FAST_RPC_METHODS = {
+    "getbestblockhash",
+    "getblockcount",
+    "getconnectioncount",
+    "getmempoolinfo",
+    "getrpcinfo",
+    "ping",
+    "uptime",
+};
+
+/** Methods that can take minutes */
+static const std::set<std::string> HEAVY_RPC_METHODS = {
+    "dumptxoutset",
+    "dumpwallet",
+    "getaddressutxos",
+    "getblockstatsrange",
+    "gettxoutsetinfo",
+    "importmulti",
+    "importwallet",
+    "rescanblockchain",
+    "savemempool",
+    "verifychain",
+};
+
+/** Bodies larger than this are not parsed on the event loop thread to find their work queue */
+static const size_t MAX_CLASSIFY_BODY_SIZE = 8 * 1024;
+
+/** Only starting a scan takes long; status and abort must not wait behind it */
+static HTTPWorkClass ScanTxOutSetWorkClass(const UniValue& params)
+{
+    const UniValue& action = params.isObject() ? params.find_value("action") : params.isArray() && !params.empty() ? params[0] : NullUniValue;
+    if (action.isStr() && action.get_str() == "start")
+        return HTTPWorkClass::HEAVY;
+    return HTTPWorkClass::FAST;
+}
+
+static HTTPWorkClass RPCMethodWorkClass(const UniValue& request)
+{
+    if (!request.isObject())
+        return HTTPWorkClass::DEFAULT;
+    const UniValue& method = request.find_value("method");
+    if (!method.isStr())
+        return HTTPWorkClass::DEFAULT;
+    if (FAST_RPC_METHODS.count(method.get_str()))
+        return HTTPWorkClass::FAST;
+    if (HEAVY_RPC_METHODS.count(method.get_str()))
+        return HTTPWorkClass::HEAVY;
+    if (method.get_str() == "scantxoutset")
+        return ScanTxOutSetWorkClass(request.find_value("params"));
+    return HTTPWorkClass::DEFAULT;
+}
+
+/**
+ * Choose the work queue from the called method; a batch goes where its slowest call would.
+ * Only the bodies of authorized requests are parsed for that, the others are handled,
+ * and rejected, on the default queue.
+ */
+static HTTPWorkClass HTTPReq_JSONRPCWorkClass(HTTPRequest* req, const std::string &)
+{
+    std::pair<bool, std::string> authHeader = req->GetHeader("authorization");
+    std::string user;
+    if (!authHeader.first || !RPCAuthorized(authHeader.second, user))
+        return HTTPWorkClass::DEFAULT;
+
+    size_t size;
+    const char* body = req->PeekBody(size);
+    UniValue valRequest;
+    if (!body || size > MAX_CLASSIFY_BODY_SIZE || !valRequest.read(body, size))
+        return HTTPWorkClass::DEFAULT;
+    if (!valRequest.isArray())
+        return RPCMethodWorkClass(valRequest);
+
+    HTTPWorkClass work_class = HTTPWorkClass::FAST;
+    for (unsigned int reqIdx = 0; reqIdx < valRequest.size(); reqIdx++)
+        work_class = std::max(work_class, RPCMethodWorkClass(valRequest[reqIdx]));
+    return work_class;
+}
+
 static bool InitRPCAuthentication()
 {
     if (gArgs.GetArg("-rpcpassword", "") == "")
@@ -295,10 +380,10 @@ bool StartHTTPRPC()
     if (!InitRPCAuthentication())
         return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, HTTPReq_JSONRPCWorkClass);
 #ifdef ENABLE_WALLET
     // ifdef can be removed once we switch to better endpoint support and API versioning
-    RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC, HTTPReq_JSONRPCWorkClass);
 #endif
     assert(EventBase());
     httpRPCTimerInterface = MakeUnique<HTTPRPCTimerInterface>(EventBase());
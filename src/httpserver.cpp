@@ -12,6 +12,7 @@
 #include <rpc/protocol.h> // For HTTP status codes
 #include <sync.h>
 #include <ui_interface.h>
+#include <utiltime.h>
 
 #include <deque>
 #include <memory>
@@ -72,13 +73,26 @@ private:
     /** Mutex protects entire object */
     Mutex cs;
     std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
+    /** Items with the time they were enqueued */
+    std::deque<std::pair<int64_t, std::unique_ptr<WorkItem>>> queue;
     bool running;
     size_t maxDepth;
 
+    /** Statistics, see HTTPWorkQueueInfo */
+    size_t nMaxDepthSeen;
+    uint64_t nProcessed;
+    uint64_t nRejected;
+    int64_t nTotalWaitMicros;
+    int64_t nMaxWaitMicros;
+
 public:
     explicit WorkQueue(size_t _maxDepth) : running(true),
-                                 maxDepth(_maxDepth)
+                                 maxDepth(_maxDepth),
+                                 nMaxDepthSeen(0),
+                                 nProcessed(0),
+                                 nRejected(0),
+                                 nTotalWaitMicros(0),
+                                 nMaxWaitMicros(0)
     {
     }
     /** Precondition: worker threads have all stopped (they have been joined).
@@ -91,9 +105,11 @@ public:
     {
         std::unique_lock<std::mutex> lock(cs);
         if (queue.size() >= maxDepth) {
+            nRejected++;
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        queue.emplace_back(GetTimeMicros(), std::unique_ptr<WorkItem>(item));
+        nMaxDepthSeen = std::max(nMaxDepthSeen, queue.size());
         cond.notify_one();
         return true;
     }
@@ -108,12 +124,28 @@ public:
                     cond.wait(lock);
                 if (!running)
                     break;
-                i = std::move(queue.front());
+                const int64_t nWaitMicros = GetTimeMicros() - queue.front().first;
+                i = std::move(queue.front().second);
                 queue.pop_front();
+                nProcessed++;
+                nTotalWaitMicros += nWaitMicros;
+                nMaxWaitMicros = std::max(nMaxWaitMicros, nWaitMicros);
             }
             (*i)();
         }
     }
+    /** Fill in the statistics of info */
+    void GetInfo(HTTPWorkQueueInfo& info)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        info.depth = queue.size();
+        info.max_depth = nMaxDepthSeen;
+        info.limit = maxDepth;
+        info.processed = nProcessed;
+        info.rejected = nRejected;
+        info.total_wait_us = nTotalWaitMicros;
+        info.max_wait_us = nMaxWaitMicros;
+    }
     /** Interrupt and exit loops */
     void Interrupt()
     {
@@ -126,13 +158,14 @@ public:
 struct HTTPPathHandler
 {
     HTTPPathHandler() {}
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPWorkClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPWorkClassifier classifier;
 };
 
 /** HTTP module state */
@@ -143,8 +176,14 @@ static struct event_base* eventBase = nullptr;
 struct evhttp* eventHTTP = nullptr;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static WorkQueue<HTTPClosure>* workQueue = nullptr;
+//! Number of work queues, one per HTTPWorkClass
+static const int NUM_WORK_QUEUES = 3;
+//! Names of the work queues, indexed by HTTPWorkClass
+static const char* const workQueueNames[NUM_WORK_QUEUES] = {"fast", "default", "heavy"};
+//! Work queues for handling longer requests off the event loop thread, indexed by HTTPWorkClass
+static WorkQueue<HTTPClosure>* workQueues[NUM_WORK_QUEUES] = {};
+//! Number of worker threads of each work queue
+static int workQueueThreads[NUM_WORK_QUEUES] = {};
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
@@ -263,12 +302,14 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        const int work_class = static_cast<int>(i->classifier ? i->classifier(hreq.get(), path) : HTTPWorkClass::DEFAULT);
+        WorkQueue<HTTPClosure>* workQueue = workQueues[work_class];
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(workQueue);
         if (workQueue->Enqueue(item.get()))
             item.release(); /* if true, queue took ownership */
         else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+            LogPrintf("WARNING: request rejected because %s http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n", workQueueNames[work_class]);
             item->req->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
         }
     } else {
@@ -401,9 +442,14 @@ bool InitHTTPServer()
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
+    LogPrintf("HTTP: creating work queues of depth %d\n", workQueueDepth);
 
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    workQueueThreads[static_cast<int>(HTTPWorkClass::FAST)] = 1;
+    workQueueThreads[static_cast<int>(HTTPWorkClass::DEFAULT)] = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    workQueueThreads[static_cast<int>(HTTPWorkClass::HEAVY)] = std::max((long)gArgs.GetArg("-rpcheavythreads", DEFAULT_HTTP_HEAVY_THREADS), 1L);
+    for (int i = 0; i < NUM_WORK_QUEUES; i++) {
+        workQueues[i] = new WorkQueue<HTTPClosure>(workQueueDepth);
+    }
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -431,14 +477,15 @@ static std::vector<std::thread> g_thread_http_workers;
 void StartHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
-    int rpcThreads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
     std::packaged_task<bool(event_base*)> task(ThreadHTTP);
     threadResult = task.get_future();
     threadHTTP = std::thread(std::move(task), eventBase);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue);
+    for (int i = 0; i < NUM_WORK_QUEUES; i++) {
+        LogPrintf("HTTP: starting %d worker threads for the %s work queue\n", workQueueThreads[i], workQueueNames[i]);
+        for (int n = 0; n < workQueueThreads[i]; n++) {
+            g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueues[i]);
+        }
     }
 }
 
@@ -453,21 +500,25 @@ void InterruptHTTPServer()
         // Reject requests on current connections
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
     }
-    if (workQueue)
-        workQueue->Interrupt();
+    for (WorkQueue<HTTPClosure>* workQueue : workQueues) {
+        if (workQueue)
+            workQueue->Interrupt();
+    }
 }
 
 void StopHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
-    if (workQueue) {
+    if (workQueues[0]) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
         for (auto& thread: g_thread_http_workers) {
             thread.join();
         }
         g_thread_http_workers.clear();
-        delete workQueue;
-        workQueue = nullptr;
+        for (WorkQueue<HTTPClosure>*& workQueue : workQueues) {
+            delete workQueue;
+            workQueue = nullptr;
+        }
     }
     if (eventBase) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP event thread to exit\n");
@@ -501,6 +552,21 @@ struct event_base* EventBase()
     return eventBase;
 }
 
+std::vector<HTTPWorkQueueInfo> GetHTTPWorkQueueInfo()
+{
+    std::vector<HTTPWorkQueueInfo> infos;
+    for (int i = 0; i < NUM_WORK_QUEUES; i++) {
+        if (!workQueues[i])
+            continue;
+        HTTPWorkQueueInfo info;
+        info.name = workQueueNames[i];
+        info.threads = workQueueThreads[i];
+        workQueues[i]->GetInfo(info);
+        infos.push_back(info);
+    }
+    return infos;
+}
+
 static void httpevent_callback_fn(evutil_socket_t, short, void* data)
 {
     // Static handler: simply call inner handler
@@ -572,6 +638,17 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+const char* HTTPRequest::PeekBody(size_t& size)
+{
+    size = 0;
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return nullptr;
+    size = evbuffer_get_length(buf);
+    // Makes the body contiguous, so ReadBody does not have to do it again
+    return (const char*)evbuffer_pullup(buf, size);
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -651,10 +728,10 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPWorkClassifier &classifier)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
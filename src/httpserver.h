@@ -8,8 +8,10 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
+static const int DEFAULT_HTTP_HEAVY_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
 
@@ -36,13 +38,22 @@ void StopHTTPServer();
  * libevent doesn't support debug logging.*/
 bool UpdateHTTPServerLogging(bool enable);
 
+/** The work queues requests are dispatched to, so that slow calls cannot hold up cheap ones */
+enum class HTTPWorkClass {
+    FAST,    //!< trivially cheap calls such as monitoring probes, served by one thread
+    DEFAULT, //!< everything else, served by -rpcthreads threads
+    HEAVY,   //!< calls that can take minutes such as UTXO set scans, served by -rpcheavythreads threads
+};
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Chooses the work queue of a request to a certain HTTP path. Called on the event loop thread, so it must be quick. */
+typedef std::function<HTTPWorkClass(HTTPRequest* req, const std::string &)> HTTPWorkClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Requests go to the DEFAULT work queue unless a classifier is given.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPWorkClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
@@ -51,6 +62,23 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base* EventBase();
 
+/** Statistics of one HTTP work queue */
+struct HTTPWorkQueueInfo
+{
+    std::string name;
+    int threads;
+    size_t depth;          //!< requests waiting now
+    size_t max_depth;      //!< most requests waiting at once
+    size_t limit;          //!< -rpcworkqueue
+    uint64_t processed;    //!< requests taken by a worker
+    uint64_t rejected;     //!< requests refused because the queue was full
+    int64_t total_wait_us; //!< total time processed requests waited in the queue
+    int64_t max_wait_us;   //!< longest time a request waited in the queue
+};
+
+/** Return the statistics of the HTTP work queues, empty when the server is not running */
+std::vector<HTTPWorkQueueInfo> GetHTTPWorkQueueInfo();
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
@@ -98,6 +126,12 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Get the request body without consuming it. Returns nullptr if the
+     * body is empty. The data stays valid until the body is read.
+     */
+    const char* PeekBody(size_t& size);
+
     /**
      * Write output header.
      *
@@ -0,0 +1,311 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+#include <undo.h>
+#include <util.h>
+#include <validation.h>
+
+#include <algorithm>
+
+constexpr char DB_ADDRESSINDEX = 'a';
+
+//! Entries read before the ones of disconnected blocks are dropped under cs_main
+static const size_t ENTRY_CHECK_BATCH = 1000;
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+namespace {
+
+/**
+ * Database key of an entry. Fixed size and big endian, so that the entries of
+ * a script are next to each other in order of height and position in the block.
+ */
+struct DBAddressKey {
+    uint256 script_hash;
+    int height;
+    uint32_t tx_pos;
+    bool spending;
+    uint32_t n;
+
+    DBAddressKey() : height(0), tx_pos(0), spending(false), n(0) {}
+    explicit DBAddressKey(const uint256& script_hash_in, int height_in = 0, uint32_t tx_pos_in = 0, bool spending_in = false, uint32_t n_in = 0)
+        : script_hash(script_hash_in), height(height_in), tx_pos(tx_pos_in), spending(spending_in), n(n_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        unsigned char buf[46];
+        buf[0] = DB_ADDRESSINDEX;
+        std::copy(script_hash.begin(), script_hash.end(), buf + 1);
+        WriteBE32(buf + 33, height);
+        WriteBE32(buf + 37, tx_pos);
+        buf[41] = spending;
+        WriteBE32(buf + 42, n);
+        s.write((const char*)buf, sizeof(buf));
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        unsigned char buf[46];
+        s.read((char*)buf, sizeof(buf));
+        if (buf[0] != DB_ADDRESSINDEX) {
+            throw std::ios_base::failure("Invalid format for address index DB key");
+        }
+        std::copy(buf + 1, buf + 33, script_hash.begin());
+        height = ReadBE32(buf + 33);
+        tx_pos = ReadBE32(buf + 37);
+        spending = buf[41];
+        n = ReadBE32(buf + 42);
+    }
+};
+
+/** Database value of an entry, the fields of AddressIndexEntry that are not in the key */
+struct DBAddressValue {
+    uint256 block_hash;
+    uint256 txid;
+    CAmount value;
+    ColorIdentifier color;
+    COutPoint prevout;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(block_hash);
+        READWRITE(txid);
+        READWRITE(VARINT(value, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(color);
+        READWRITE(prevout);
+    }
+};
+
+} // namespace
+
+/**
+ * The script an output is indexed under: the script itself, or what follows
+ * a leading <color> OP_COLOR. color is set to the color that was taken off.
+ */
+static CScript IndexedScript(const CScript& script, ColorIdentifier& color)
+{
+    color = ColorIdentifier();
+    if (script.size() > COLOR_IDENTIFIER_SIZE + 2 && script[0] == COLOR_IDENTIFIER_SIZE && script[COLOR_IDENTIFIER_SIZE + 1] == OP_COLOR) {
+        color = GetColorIdFromScript(script);
+        if (color.type != TokenTypes::NONE) {
+            return CScript(script.begin() + COLOR_IDENTIFIER_SIZE + 2, script.end());
+        }
+    }
+    return script;
+}
+
+static uint256 ScriptHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+/**
+ * Access to the address index database (indexes/address/)
+ *
+ * Entries of blocks that are disconnected are not erased. They are skipped
+ * by lookups, whose results only contain entries of the active chain, and
+ * are overwritten if the same transaction is connected again at the same
+ * height and position.
+ */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Write a batch of entries to the DB.
+    bool WriteEntries(const std::vector<std::pair<DBAddressKey, DBAddressValue>>& entries);
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "address", n_cache_size, f_memory, f_wipe, false, DEFAULT_INDEX_DB_PROFILE)
+{}
+
+bool AddressIndex::DB::WriteEntries(const std::vector<std::pair<DBAddressKey, DBAddressValue>>& entries)
+{
+    CDBBatch batch(*this);
+    for (const auto& entry : entries) {
+        batch.Write(entry.first, entry.second);
+    }
+    return WriteBatch(batch);
+}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() {}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The transactions of the genesis block are not connected and cannot be spent.
+    if (pindex->nHeight == 0) {
+        return true;
+    }
+
+    // The block is connected, so its undo data is on disk already.
+    CBlockUndo blockundo;
+    if (!UndoReadFromDisk(blockundo, pindex)) {
+        return error("%s: Failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: Undo data of block %s does not match its transactions", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    std::vector<std::pair<DBAddressKey, DBAddressValue>> entries;
+    auto add_entry = [&](const CScript& script, uint32_t tx_pos, const uint256& txid, bool spending, uint32_t n, CAmount value, const COutPoint& prevout) {
+        ColorIdentifier color;
+        const uint256 script_hash = ScriptHash(IndexedScript(script, color));
+        DBAddressValue entry;
+        entry.block_hash = pindex->GetBlockHash();
+        entry.txid = txid;
+        entry.value = value;
+        entry.color = GetColorIdFromScript(script);
+        entry.prevout = prevout;
+        entries.emplace_back(DBAddressKey(script_hash, pindex->nHeight, tx_pos, spending, n), entry);
+    };
+
+    for (uint32_t tx_pos = 0; tx_pos < block.vtx.size(); ++tx_pos) {
+        const CTransaction& tx = *block.vtx[tx_pos];
+        const uint256 txid = tx.GetHashMalFix();
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& txundo = blockundo.vtxundo[tx_pos - 1];
+            if (txundo.vprevout.size() != tx.vin.size()) {
+                return error("%s: Undo data of block %s does not match its inputs", __func__, pindex->GetBlockHash().ToString());
+            }
+            for (uint32_t n = 0; n < tx.vin.size(); ++n) {
+                const CTxOut& prevout = txundo.vprevout[n].out;
+                add_entry(prevout.scriptPubKey, tx_pos, txid, true, n, prevout.nValue, tx.vin[n].prevout);
+            }
+        }
+        for (uint32_t n = 0; n < tx.vout.size(); ++n) {
+            const CTxOut& out = tx.vout[n];
+            if (out.scriptPubKey.IsUnspendable()) continue;
+            add_entry(out.scriptPubKey, tx_pos, txid, false, n, out.nValue, COutPoint());
+        }
+    }
+    return m_db->WriteEntries(entries);
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::ForEachEntry(const CScript& script, const std::function<bool(const AddressIndexEntry&)>& fn) const
+{
+    ColorIdentifier color;
+    const uint256 script_hash = ScriptHash(IndexedScript(script, color));
+    const bool filter_color = color.type != TokenTypes::NONE;
+
+    std::unique_ptr<CDBIterator> it(m_db->NewIterator());
+    it->Seek(DBAddressKey(script_hash));
+
+    bool more = true;
+    while (more) {
+        std::vector<AddressIndexEntry> batch;
+        while (batch.size() < ENTRY_CHECK_BATCH) {
+            DBAddressKey key;
+            if (!it->Valid() || !it->GetKey(key) || key.script_hash != script_hash) {
+                more = false;
+                break;
+            }
+            DBAddressValue value;
+            if (!it->GetValue(value)) {
+                return error("%s: Failed to read entry of script %s", __func__, script_hash.ToString());
+            }
+            it->Next();
+            if (filter_color && value.color != color) continue;
+
+            AddressIndexEntry entry;
+            entry.height = key.height;
+            entry.block_hash = value.block_hash;
+            entry.tx_pos = key.tx_pos;
+            entry.txid = value.txid;
+            entry.spending = key.spending;
+            entry.n = key.n;
+            entry.value = value.value;
+            entry.color = value.color;
+            entry.prevout = value.prevout;
+            batch.push_back(std::move(entry));
+        }
+
+        {
+            LOCK(cs_main);
+            batch.erase(std::remove_if(batch.begin(), batch.end(), [](const AddressIndexEntry& entry) {
+                const CBlockIndex* pindex = chainActive[entry.height];
+                return !pindex || pindex->GetBlockHash() != entry.block_hash;
+            }), batch.end());
+        }
+        for (const AddressIndexEntry& entry : batch) {
+            if (!fn(entry)) return true;
+        }
+    }
+    return true;
+}
+
+bool AddressIndex::FindHistory(const CScript& script, size_t skip, size_t count, std::vector<AddressIndexEntry>& entries) const
+{
+    entries.clear();
+    if (count == 0) {
+        return true;
+    }
+    return ForEachEntry(script, [&](const AddressIndexEntry& entry) {
+        if (skip > 0) {
+            --skip;
+            return true;
+        }
+        entries.push_back(entry);
+        return entries.size() < count;
+    });
+}
+
+bool AddressIndex::FindUnspent(const CScript& script, size_t skip, size_t count, std::vector<AddressIndexEntry>& entries) const
+{
+    entries.clear();
+    if (count == 0) {
+        return true;
+    }
+    // The input spending an output is indexed after it, so whether an output
+    // is unspent is looked up in the UTXO set instead of reading the whole
+    // history first.
+    std::vector<AddressIndexEntry> outputs;
+    auto check_outputs = [&]() {
+        {
+            LOCK(cs_main);
+            outputs.erase(std::remove_if(outputs.begin(), outputs.end(), [](const AddressIndexEntry& entry) {
+                const COutPoint outpoint(entry.txid, entry.n);
+                const bool cached = pcoinsTip->HaveCoinInCache(outpoint);
+                const bool unspent = pcoinsTip->HaveCoin(outpoint);
+                if (!cached) pcoinsTip->Uncache(outpoint);
+                return !unspent;
+            }), outputs.end());
+        }
+        for (AddressIndexEntry& entry : outputs) {
+            if (skip > 0) {
+                --skip;
+                continue;
+            }
+            entries.push_back(std::move(entry));
+            if (entries.size() >= count) break;
+        }
+        outputs.clear();
+        return entries.size() < count;
+    };
+    if (!ForEachEntry(script, [&](const AddressIndexEntry& entry) {
+            if (entry.spending) return true;
+            outputs.push_back(entry);
+            return outputs.size() < ENTRY_CHECK_BATCH || check_outputs();
+        })) {
+        return false;
+    }
+    check_outputs();
+    return true;
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <coins.h>
+#include <index/base.h>
+#include <script/script.h>
+#include <uint256.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+static const bool DEFAULT_ADDRESSINDEX = false;
+//! Largest number of entries a single address index query may ask for
+static const size_t MAX_ADDRESS_INDEX_COUNT = 10000;
+
+/** An output paying to a script, or an input spending such an output */
+struct AddressIndexEntry
+{
+    int height;
+    uint256 block_hash;
+    //! position of the transaction in its block
+    uint32_t tx_pos;
+    uint256 txid;
+    //! whether this is an input spending an output to the script
+    bool spending;
+    //! index of the output, or of the input if spending
+    uint32_t n;
+    //! amount of the output, funded or spent
+    CAmount value;
+    //! color of the output, none for TPC
+    ColorIdentifier color;
+    //! output spent by the input, null for an output
+    COutPoint prevout;
+};
+
+/**
+ * AddressIndex is used to look up the transaction history and unspent outputs
+ * of a scriptPubKey. For every output and every input of the active chain an
+ * entry is written to a LevelDB database, keyed by the SHA256 hash of the
+ * script paid to and ordered by height and position in the block.
+ *
+ * An output to a colored script with a leading <color> OP_COLOR is indexed
+ * under the script that follows, so that the history of an address contains
+ * its tokens too. Outputs that can never be spent are not indexed.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    /// Read the entries of a script, in key order, that are still in the
+    /// active chain. fn is called for each and returns false to stop.
+    bool ForEachEntry(const CScript& script, const std::function<bool(const AddressIndexEntry&)>& fn) const;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// Look up the outputs paying to a script and the inputs spending them,
+    /// in order of height. A script with a leading <color> OP_COLOR matches
+    /// outputs of that color only; any other script matches its outputs of
+    /// every color.
+    ///
+    /// @param[in]   script  The scriptPubKey to look up.
+    /// @param[in]   skip  Number of leading entries to leave out.
+    /// @param[in]   count  Maximum number of entries to return.
+    /// @param[out]  entries  The entries found.
+    /// @return  false if the database could not be read.
+    bool FindHistory(const CScript& script, size_t skip, size_t count, std::vector<AddressIndexEntry>& entries) const;
+
+    /// Look up the outputs paying to a script that are in the UTXO set of
+    /// the active chain, in order of height. Scripts match as in
+    /// FindHistory. Reading stops after skip + count unspent outputs.
+    bool FindUnspent(const CScript& script, size_t skip, size_t count, std::vector<AddressIndexEntry>& entries) const;
+};
+
+/// The global address index. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
@@ -0,0 +1,260 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockstatsindex.h>
+#include <crypto/common.h>
+#include <undo.h>
+#include <util.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <limits>
+
+constexpr char DB_BLOCKSTATS = 's';
+
+std::unique_ptr<BlockStatsIndex> g_blockstatsindex;
+
+// outpoint (needed for the utxo index) + nHeight + fCoinBase
+static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+
+template<typename T>
+static T CalculateTruncatedMedian(std::vector<T>& scores)
+{
+    size_t size = scores.size();
+    if (size == 0) {
+        return 0;
+    }
+
+    std::sort(scores.begin(), scores.end());
+    if (size % 2 == 0) {
+        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
+    } else {
+        return scores[size / 2];
+    }
+}
+
+void ComputeBlockStats(const CBlock& block, const std::function<const CTxOut&(size_t n_tx, size_t n_in)>& spent_output, BlockStats& stats)
+{
+    const bool loop_inputs = static_cast<bool>(spent_output);
+
+    CAmount minfee = MAX_MONEY;
+    CAmount minfeerate = MAX_MONEY;
+    int64_t mintxsize = std::numeric_limits<int64_t>::max();
+    int64_t utxo_size_inc = 0;
+    std::vector<CAmount> fee_array;
+    std::vector<std::pair<CAmount, int64_t>> feerate_array;
+    std::vector<int64_t> txsize_array;
+
+    stats = BlockStats();
+    stats.txs = block.vtx.size();
+    for (size_t n_tx = 0; n_tx < block.vtx.size(); ++n_tx) {
+        const auto& tx = block.vtx[n_tx];
+        stats.outs += tx->vout.size();
+
+        CAmount tx_total_out = 0;
+        CAmount tx_tpc_out = 0;
+        for (const CTxOut& out : tx->vout) {
+            tx_total_out += out.nValue;
+            if (!out.scriptPubKey.IsColoredScript()) tx_tpc_out += out.nValue;
+            utxo_size_inc += GetSerializeSize(out, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+        }
+
+        if (tx->IsCoinBase()) {
+            continue;
+        }
+
+        stats.ins += tx->vin.size(); // Don't count coinbase's fake input
+        stats.total_out += tx_total_out; // Don't count coinbase reward
+
+        const int64_t tx_size = tx->GetTotalSize();
+        txsize_array.push_back(tx_size);
+        stats.maxtxsize = std::max(stats.maxtxsize, tx_size);
+        mintxsize = std::min(mintxsize, tx_size);
+        stats.total_size += tx_size;
+
+        if (!loop_inputs) {
+            continue;
+        }
+
+        // token amounts spent and created by this transaction
+        std::map<ColorIdentifier, std::pair<CAmount, CAmount>> tx_tokens;
+
+        CAmount tx_tpc_in = 0;
+        for (size_t n_in = 0; n_in < tx->vin.size(); ++n_in) {
+            const CTxOut& prevoutput = spent_output(n_tx, n_in);
+
+            if (!prevoutput.scriptPubKey.IsColoredScript()) tx_tpc_in += prevoutput.nValue;
+            utxo_size_inc -= GetSerializeSize(prevoutput, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+            const ColorIdentifier color = GetColorIdFromScript(prevoutput.scriptPubKey);
+            if (color.type != TokenTypes::NONE) tx_tokens[color].first += prevoutput.nValue;
+        }
+
+        for (const CTxOut& out : tx->vout) {
+            const ColorIdentifier color = GetColorIdFromScript(out.scriptPubKey);
+            if (color.type != TokenTypes::NONE) tx_tokens[color].second += out.nValue;
+        }
+        for (const auto& token : tx_tokens) {
+            TokenStats& ts = stats.tokens[token.first];
+            const CAmount spent = token.second.first;
+            const CAmount created = token.second.second;
+            if (spent > 0 && created > 0) ++ts.transfers;
+            if (created > spent) {
+                ++ts.issuances;
+                ts.issued += created - spent;
+            } else {
+                ts.burned += spent - created;
+            }
+        }
+
+        // Fees are paid in TPC; token amounts would not even be in MoneyRange.
+        CAmount txfee = tx_tpc_in - tx_tpc_out;
+        assert(MoneyRange(txfee));
+        fee_array.push_back(txfee);
+        stats.maxfee = std::max(stats.maxfee, txfee);
+        minfee = std::min(minfee, txfee);
+        stats.totalfee += txfee;
+
+        // New feerate uses tapyrus per byte
+        CAmount feerate = tx_size ? txfee : 0;
+        feerate_array.emplace_back(std::make_pair(feerate, tx_size));
+        stats.maxfeerate = std::max(stats.maxfeerate, feerate);
+        minfeerate = std::min(minfeerate, feerate);
+    }
+
+    stats.mintxsize = mintxsize == std::numeric_limits<int64_t>::max() ? 0 : mintxsize;
+    stats.mediantxsize = CalculateTruncatedMedian(txsize_array);
+    if (loop_inputs) {
+        stats.minfee = minfee == MAX_MONEY ? 0 : minfee;
+        stats.minfeerate = minfeerate == MAX_MONEY ? 0 : minfeerate;
+        stats.medianfee = CalculateTruncatedMedian(fee_array);
+        CalculatePercentilesBySize(stats.feerate_percentiles, feerate_array, stats.total_size);
+        stats.utxo_size_inc = utxo_size_inc;
+    }
+}
+
+namespace {
+
+/** Database key of the statistics at a height, big endian so that heights sort in order. */
+struct DBHeightKey {
+    int height;
+
+    explicit DBHeightKey(int height_in = 0) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        unsigned char buf[5];
+        buf[0] = DB_BLOCKSTATS;
+        WriteBE32(buf + 1, height);
+        s.write((const char*)buf, sizeof(buf));
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        unsigned char buf[5];
+        s.read((char*)buf, sizeof(buf));
+        if (buf[0] != DB_BLOCKSTATS) {
+            throw std::ios_base::failure("Invalid format for block statistics index DB height key");
+        }
+        height = ReadBE32(buf + 1);
+    }
+};
+
+} // namespace
+
+/**
+ * Access to the block statistics database (indexes/blockstats/)
+ *
+ * Statistics are stored by height with the hash of their block. A block
+ * connected at a height replaces the entry of a block disconnected there;
+ * entries above the tip after a reorg to a shorter chain are left in place
+ * and not found by lookups, since their hash does not match.
+ */
+class BlockStatsIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the statistics of the block at a height, with the hash of that block.
+    bool ReadStats(int height, std::pair<uint256, BlockStats>& value) const;
+
+    /// Write the statistics of a block.
+    bool WriteStats(const CBlockIndex* pindex, const BlockStats& stats);
+};
+
+BlockStatsIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "blockstats", n_cache_size, f_memory, f_wipe)
+{}
+
+bool BlockStatsIndex::DB::ReadStats(int height, std::pair<uint256, BlockStats>& value) const
+{
+    return Read(DBHeightKey(height), value);
+}
+
+bool BlockStatsIndex::DB::WriteStats(const CBlockIndex* pindex, const BlockStats& stats)
+{
+    return Write(DBHeightKey(pindex->nHeight), std::make_pair(pindex->GetBlockHash(), stats));
+}
+
+BlockStatsIndex::BlockStatsIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BlockStatsIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+BlockStatsIndex::~BlockStatsIndex() {}
+
+bool BlockStatsIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The block is connected, so its undo data is on disk already. The
+    // genesis block has none, and no inputs to look up either.
+    CBlockUndo blockundo;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(blockundo, pindex)) {
+        return error("%s: Failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    BlockStats stats;
+    try {
+        ComputeBlockStats(block, [&](size_t n_tx, size_t n_in) -> const CTxOut& {
+            // The undo data has no entry for the coinbase.
+            return blockundo.vtxundo.at(n_tx - 1).vprevout.at(n_in).out;
+        }, stats);
+    } catch (const std::out_of_range&) {
+        return error("%s: Undo data of block %s does not match its inputs", __func__, pindex->GetBlockHash().ToString());
+    }
+    return m_db->WriteStats(pindex, stats);
+}
+
+BaseIndex::DB& BlockStatsIndex::GetDB() const { return *m_db; }
+
+bool BlockStatsIndex::LookupStats(const CBlockIndex* pindex, BlockStats& stats) const
+{
+    std::pair<uint256, BlockStats> value;
+    if (!m_db->ReadStats(pindex->nHeight, value) || value.first != pindex->GetBlockHash()) {
+        return false;
+    }
+    stats = std::move(value.second);
+    return true;
+}
+
+size_t BlockStatsIndex::LookupStatsRange(const std::vector<const CBlockIndex*>& blocks, std::vector<BlockStats>& stats) const
+{
+    stats.clear();
+    if (blocks.empty()) {
+        return 0;
+    }
+
+    std::unique_ptr<CDBIterator> it(m_db->NewIterator());
+    it->Seek(DBHeightKey(blocks.front()->nHeight));
+    for (const CBlockIndex* pindex : blocks) {
+        DBHeightKey key;
+        std::pair<uint256, BlockStats> value;
+        if (!it->Valid() || !it->GetKey(key) || key.height != pindex->nHeight ||
+            !it->GetValue(value) || value.first != pindex->GetBlockHash()) {
+            break;
+        }
+        stats.push_back(std::move(value.second));
+        it->Next();
+    }
+    return stats.size();
+}
@@ -0,0 +1,148 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BLOCKSTATSINDEX_H
+#define BITCOIN_INDEX_BLOCKSTATSINDEX_H
+
+#include <amount.h>
+#include <coins.h>
+#include <index/base.h>
+#include <rpc/blockchain.h>
+#include <serialize.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+static const bool DEFAULT_BLOCKSTATSINDEX = false;
+
+/** Token movements of one color, counted over the transactions of a block */
+struct TokenStats
+{
+    //! transactions spending and creating the token
+    int64_t transfers = 0;
+    //! transactions creating more of the token than they spend
+    int64_t issuances = 0;
+    CAmount issued = 0;
+    CAmount burned = 0;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(VARINT(transfers, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(issuances, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(issued, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(burned, VarIntMode::NONNEGATIVE_SIGNED));
+    }
+};
+
+/**
+ * The statistics of a block reported by getblockstats that depend on its
+ * transactions. Averages, the subsidy and the fields of the block header are
+ * derived from these and the block index when they are reported. Minimums
+ * are 0 if there is no transaction to take them from.
+ */
+struct BlockStats
+{
+    int64_t txs = 0;
+    int64_t ins = 0;
+    int64_t outs = 0;
+    int64_t total_size = 0;
+    int64_t mintxsize = 0;
+    int64_t maxtxsize = 0;
+    int64_t mediantxsize = 0;
+    CAmount total_out = 0;
+    CAmount totalfee = 0;
+    CAmount minfee = 0;
+    CAmount maxfee = 0;
+    CAmount medianfee = 0;
+    CAmount minfeerate = 0;
+    CAmount maxfeerate = 0;
+    CAmount feerate_percentiles[NUM_GETBLOCKSTATS_PERCENTILES] = {0};
+    int64_t utxo_size_inc = 0;
+    std::map<ColorIdentifier, TokenStats> tokens;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(VARINT(txs, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(ins, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(outs, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(total_size, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(mintxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(maxtxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(mediantxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(total_out, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(totalfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(minfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(maxfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(medianfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(minfeerate, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(maxfeerate, VarIntMode::NONNEGATIVE_SIGNED));
+        for (CAmount& feerate : feerate_percentiles) {
+            READWRITE(VARINT(feerate, VarIntMode::NONNEGATIVE_SIGNED));
+        }
+        READWRITE(utxo_size_inc);
+        READWRITE(tokens);
+    }
+};
+
+/**
+ * Compute the statistics of a block. spent_output returns the output spent by
+ * input n_in of the transaction at n_tx in the block. If it is empty, inputs
+ * are not looked at and the fee, feerate, utxo_size_inc and token statistics
+ * are left at 0.
+ */
+void ComputeBlockStats(const CBlock& block, const std::function<const CTxOut&(size_t n_tx, size_t n_in)>& spent_output, BlockStats& stats);
+
+/**
+ * BlockStatsIndex keeps the BlockStats of every block of the active chain so
+ * that getblockstats and getblockstatsrange do not need to read blocks and
+ * spent outputs again. The statistics are written to a LevelDB database by
+ * height, together with the hash of the block they were computed from.
+ */
+class BlockStatsIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "blockstatsindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit BlockStatsIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~BlockStatsIndex() override;
+
+    /// Look up the statistics of a block. Returns false if the block is not
+    /// indexed, for instance because the index has not reached it yet.
+    bool LookupStats(const CBlockIndex* pindex, BlockStats& stats) const;
+
+    /// Look up the statistics of blocks of consecutive heights, in one pass
+    /// over the database. Stops at the first block that is not indexed.
+    ///
+    /// @param[in]   blocks  Block index entries, in order of height without gaps.
+    /// @param[out]  stats  The statistics of the leading indexed blocks.
+    /// @return  the number of blocks found, the size of stats.
+    size_t LookupStatsRange(const std::vector<const CBlockIndex*>& blocks, std::vector<BlockStats>& stats) const;
+};
+
+/// The global block statistics index. May be null.
+extern std::unique_ptr<BlockStatsIndex> g_blockstatsindex;
+
+#endif // BITCOIN_INDEX_BLOCKSTATSINDEX_H
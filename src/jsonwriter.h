@@ -0,0 +1,121 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_JSONWRITER_H
+#define BITCOIN_JSONWRITER_H
+
+#include <uint256.h>
+
+#include <iterator>
+#include <stdint.h>
+#include <string>
+
+/**
+ * Appends compact JSON to a string without building a UniValue first. The
+ * output is the same as UniValue::write() without indentation: no spaces,
+ * strings escaped the same way.
+ *
+ * Commas are inserted automatically; the caller is responsible for pairing
+ * Begin/End calls and for writing a Key before every value in an object.
+ */
+class JSONWriter
+{
+public:
+    explicit JSONWriter(std::string& out) : m_out(out), m_need_comma(false) {}
+
+    void BeginObject() { Separate(); m_out += '{'; m_need_comma = false; }
+    void EndObject() { m_out += '}'; m_need_comma = true; }
+    void BeginArray() { Separate(); m_out += '['; m_need_comma = false; }
+    void EndArray() { m_out += ']'; m_need_comma = true; }
+
+    /** Write an object key. Keys are written as given, without escaping. */
+    void Key(const char* key)
+    {
+        Separate();
+        m_out += '"';
+        m_out += key;
+        m_out += "\":";
+        m_need_comma = false;
+    }
+
+    void String(const std::string& str)
+    {
+        Separate();
+        m_out += '"';
+        for (unsigned char ch : str) {
+            if (ch < 0x20 || ch == '"' || ch == '\\' || ch == 0x7f) {
+                Escape(ch);
+            } else {
+                m_out += ch;
+            }
+        }
+        m_out += '"';
+        m_need_comma = true;
+    }
+
+    /** Write a string of characters known not to need escaping. */
+    void PlainString(const std::string& str) { Separate(); m_out += '"'; m_out += str; m_out += '"'; m_need_comma = true; }
+
+    void Int(int64_t n) { Separate(); m_out += std::to_string(n); m_need_comma = true; }
+    void UInt(uint64_t n) { Separate(); m_out += std::to_string(n); m_need_comma = true; }
+    void Bool(bool b) { Separate(); m_out += b ? "true" : "false"; m_need_comma = true; }
+
+    /** Write an already serialized JSON value. */
+    void Raw(const std::string& json) { Separate(); m_out += json; m_need_comma = true; }
+
+    /** Write bytes as a hex string, like HexStr(). */
+    template <typename T>
+    void Hex(const T itbegin, const T itend)
+    {
+        static const char hexmap[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+        Separate();
+        m_out += '"';
+        for (T it = itbegin; it < itend; ++it) {
+            const uint8_t val = (uint8_t)(*it);
+            m_out += hexmap[val >> 4];
+            m_out += hexmap[val & 15];
+        }
+        m_out += '"';
+        m_need_comma = true;
+    }
+
+    /** Write a hash the way uint256::GetHex() shows it. */
+    void Hash(const uint256& hash) { Hex(std::reverse_iterator<const uint8_t*>(hash.end()), std::reverse_iterator<const uint8_t*>(hash.begin())); }
+
+    /**
+     * Start a value and return the output so that the caller can append the
+     * serialized value in place, as is. Finish with EndValue().
+     */
+    std::string& BeginValue() { Separate(); return m_out; }
+    void EndValue() { m_need_comma = true; }
+
+private:
+    std::string& m_out;
+    //! whether the next value or key follows another one in the same container
+    bool m_need_comma;
+
+    void Separate()
+    {
+        if (m_need_comma) m_out += ',';
+    }
+
+    void Escape(unsigned char ch)
+    {
+        static const char hexmap[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+        switch (ch) {
+        case '"': m_out += "\\\""; return;
+        case '\\': m_out += "\\\\"; return;
+        case '\b': m_out += "\\b"; return;
+        case '\t': m_out += "\\t"; return;
+        case '\n': m_out += "\\n"; return;
+        case '\f': m_out += "\\f"; return;
+        case '\r': m_out += "\\r"; return;
+        }
+        m_out += "\\u00";
+        m_out += hexmap[ch >> 4];
+        m_out += hexmap[ch & 15];
+    }
+};
+
+#endif // BITCOIN_JSONWRITER_H
@@ -0,0 +1,349 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <memorydb.h>
+
+#include <sync.h>
+
+#include <leveldb/iterator.h>
+#include <leveldb/write_batch.h>
+
+#include <assert.h>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+
+namespace {
+
+/**
+ * Every version of every key, ordered by key and, for the same key, newest
+ * first. std::string compares bytes as unsigned chars, which is the order of
+ * LevelDB's default bytewise comparator.
+ */
+typedef std::pair<std::string, uint64_t> VersionKey;
+
+struct VersionKeyCompare
+{
+    bool operator()(const VersionKey& a, const VersionKey& b) const
+    {
+        const int c = a.first.compare(b.first);
+        return c < 0 || (c == 0 && a.second > b.second);
+    }
+};
+
+struct Version
+{
+    bool deleted;
+    std::string value;
+};
+
+typedef std::map<VersionKey, Version, VersionKeyCompare> Table;
+
+//! Sequence numbers start at 1, so this sorts after every version of a key
+static const uint64_t SEQ_KEY_END = 0;
+//! Sorts before every version of a key
+static const uint64_t SEQ_KEY_BEGIN = std::numeric_limits<uint64_t>::max();
+
+//! Approximate heap usage of one table entry
+static size_t EntryUsage(const std::string& key, const std::string& value)
+{
+    return sizeof(Table::value_type) + 4 * sizeof(void*) + key.size() + value.size();
+}
+
+class MemoryDB;
+
+class MemorySnapshot : public leveldb::Snapshot
+{
+public:
+    explicit MemorySnapshot(uint64_t seq) : m_seq(seq) {}
+
+    const uint64_t m_seq;
+};
+
+class MemoryIterator : public leveldb::Iterator
+{
+private:
+    MemoryDB& m_db;
+    const uint64_t m_seq;
+    Table::const_iterator m_it;
+    bool m_valid;
+
+public:
+    //! The reader is registered with the database by the caller.
+    MemoryIterator(MemoryDB& db, uint64_t seq, Table::const_iterator end) : m_db(db), m_seq(seq), m_it(end), m_valid(false) {}
+    ~MemoryIterator() override;
+
+    bool Valid() const override { return m_valid; }
+    void SeekToFirst() override;
+    void SeekToLast() override;
+    void Seek(const leveldb::Slice& target) override;
+    void Next() override;
+    void Prev() override;
+
+    // The version an iterator is on cannot be removed while it is alive,
+    // and versions are not modified once written.
+    leveldb::Slice key() const override { return m_it->first.first; }
+    leveldb::Slice value() const override { return m_it->second.value; }
+    leveldb::Status status() const override { return leveldb::Status::OK(); }
+};
+
+/**
+ * Writes add versions under a new sequence number instead of changing the
+ * table, so that iterators and snapshots keep seeing the versions up to
+ * theirs. A version that is replaced, and a deletion, are queued and removed
+ * once no reader that can see them is left.
+ */
+class MemoryDB : public leveldb::DB
+{
+private:
+    friend class MemoryIterator;
+
+    Mutex m_mutex;
+
+    Table m_table GUARDED_BY(m_mutex);
+
+    //! sequence number of the last write
+    uint64_t m_seq GUARDED_BY(m_mutex);
+
+    //! sequence numbers of the live iterators and snapshots
+    std::multiset<uint64_t> m_readers GUARDED_BY(m_mutex);
+
+    //! versions to remove, with the sequence number from which on no reader sees them
+    std::deque<std::pair<uint64_t, VersionKey>> m_obsolete GUARDED_BY(m_mutex);
+
+    //! approximate heap usage of m_table
+    size_t m_usage GUARDED_BY(m_mutex);
+
+    /** Applies the operations of a write batch as versions with sequence number seq. */
+    class BatchApplier : public leveldb::WriteBatch::Handler
+    {
+    private:
+        MemoryDB& m_db;
+        const uint64_t m_seq;
+
+        void Add(const leveldb::Slice& key, bool deleted, const leveldb::Slice& value) EXCLUSIVE_LOCKS_REQUIRED(m_db.m_mutex)
+        {
+            std::string k = key.ToString();
+            auto newest = m_db.m_table.lower_bound(VersionKey(k, SEQ_KEY_BEGIN));
+            const bool exists = newest != m_db.m_table.end() && newest->first.first == k;
+            if (exists && newest->first.second == m_seq) {
+                // Written before in the same batch, which nobody can see yet.
+                m_db.m_usage -= EntryUsage(k, newest->second.value);
+                newest->second.deleted = deleted;
+                newest->second.value.assign(value.data(), value.size());
+                m_db.m_usage += EntryUsage(k, newest->second.value);
+            } else {
+                if (!exists && deleted) return;
+                if (exists) m_db.m_obsolete.emplace_back(m_seq, newest->first);
+                auto it = m_db.m_table.emplace_hint(newest, VersionKey(k, m_seq), Version{deleted, value.ToString()});
+                m_db.m_usage += EntryUsage(k, it->second.value);
+            }
+            if (deleted) m_db.m_obsolete.emplace_back(m_seq, VersionKey(std::move(k), m_seq));
+        }
+
+    public:
+        BatchApplier(MemoryDB& db, uint64_t seq) : m_db(db), m_seq(seq) {}
+
+        void Put(const leveldb::Slice& key, const leveldb::Slice& value) override { Add(key, false, value); }
+        void Delete(const leveldb::Slice& key) override { Add(key, true, leveldb::Slice()); }
+    };
+
+    /** Remove the queued versions that no live reader can see anymore. */
+    void RemoveObsolete() EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        const uint64_t oldest_reader = m_readers.empty() ? std::numeric_limits<uint64_t>::max() : *m_readers.begin();
+        while (!m_obsolete.empty() && m_obsolete.front().first <= oldest_reader) {
+            const VersionKey& key = m_obsolete.front().second;
+            auto it = m_table.find(key);
+            if (it != m_table.end()) {
+                // The newest version of a key is only removed if it is a deletion.
+                const bool newest = it == m_table.lower_bound(VersionKey(key.first, SEQ_KEY_BEGIN));
+                if (!newest || it->second.deleted) {
+                    m_usage -= EntryUsage(it->first.first, it->second.value);
+                    m_table.erase(it);
+                }
+            }
+            m_obsolete.pop_front();
+        }
+    }
+
+    void AddReader(uint64_t seq) EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { m_readers.insert(seq); }
+
+    void RemoveReader(uint64_t seq)
+    {
+        LOCK(m_mutex);
+        m_readers.erase(m_readers.find(seq));
+        RemoveObsolete();
+    }
+
+    /**
+     * Move it forward to the first key from where it is that has a version
+     * visible at seq which is not a deletion, and to that version.
+     */
+    Table::const_iterator SeekVisibleForward(Table::const_iterator it, uint64_t seq) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        while (it != m_table.end()) {
+            const std::string& key = it->first.first;
+            if (it->first.second > seq) {
+                it = m_table.lower_bound(VersionKey(key, seq));
+                if (it == m_table.end() || it->first.first != key) continue;
+            }
+            if (!it->second.deleted) return it;
+            it = m_table.lower_bound(VersionKey(key, SEQ_KEY_END));
+        }
+        return it;
+    }
+
+    /** Like SeekVisibleForward, for the keys before the one of end. */
+    Table::const_iterator SeekVisibleBackward(Table::const_iterator end, uint64_t seq) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        auto first = end;
+        while (first != m_table.begin()) {
+            const std::string& key = std::prev(first)->first.first;
+            first = m_table.lower_bound(VersionKey(key, SEQ_KEY_BEGIN));
+            auto it = m_table.lower_bound(VersionKey(key, seq));
+            if (it != m_table.end() && it->first.first == key && !it->second.deleted) return it;
+        }
+        return m_table.end();
+    }
+
+public:
+    MemoryDB() : m_seq(0), m_usage(0) {}
+
+    leveldb::Status Put(const leveldb::WriteOptions& options, const leveldb::Slice& key, const leveldb::Slice& value) override
+    {
+        leveldb::WriteBatch batch;
+        batch.Put(key, value);
+        return Write(options, &batch);
+    }
+
+    leveldb::Status Delete(const leveldb::WriteOptions& options, const leveldb::Slice& key) override
+    {
+        leveldb::WriteBatch batch;
+        batch.Delete(key);
+        return Write(options, &batch);
+    }
+
+    leveldb::Status Write(const leveldb::WriteOptions& options, leveldb::WriteBatch* updates) override
+    {
+        // options.sync has nothing to flush.
+        LOCK(m_mutex);
+        BatchApplier applier(*this, m_seq + 1);
+        leveldb::Status status = updates->Iterate(&applier);
+        // The versions of the batch become visible together.
+        ++m_seq;
+        RemoveObsolete();
+        return status;
+    }
+
+    leveldb::Status Get(const leveldb::ReadOptions& options, const leveldb::Slice& key, std::string* value) override
+    {
+        LOCK(m_mutex);
+        const uint64_t seq = options.snapshot ? static_cast<const MemorySnapshot*>(options.snapshot)->m_seq : m_seq;
+        const std::string k = key.ToString();
+        auto it = m_table.lower_bound(VersionKey(k, seq));
+        if (it == m_table.end() || it->first.first != k || it->second.deleted) return leveldb::Status::NotFound(leveldb::Slice());
+        *value = it->second.value;
+        return leveldb::Status::OK();
+    }
+
+    leveldb::Iterator* NewIterator(const leveldb::ReadOptions& options) override
+    {
+        LOCK(m_mutex);
+        const uint64_t seq = options.snapshot ? static_cast<const MemorySnapshot*>(options.snapshot)->m_seq : m_seq;
+        AddReader(seq);
+        return new MemoryIterator(*this, seq, m_table.end());
+    }
+
+    const leveldb::Snapshot* GetSnapshot() override
+    {
+        LOCK(m_mutex);
+        AddReader(m_seq);
+        return new MemorySnapshot(m_seq);
+    }
+
+    void ReleaseSnapshot(const leveldb::Snapshot* snapshot) override
+    {
+        const MemorySnapshot* memory_snapshot = static_cast<const MemorySnapshot*>(snapshot);
+        RemoveReader(memory_snapshot->m_seq);
+        delete memory_snapshot;
+    }
+
+    bool GetProperty(const leveldb::Slice& property, std::string* value) override
+    {
+        if (property == "leveldb.approximate-memory-usage") {
+            LOCK(m_mutex);
+            *value = std::to_string(m_usage);
+            return true;
+        }
+        return false;
+    }
+
+    void GetApproximateSizes(const leveldb::Range* range, int n, uint64_t* sizes) override
+    {
+        LOCK(m_mutex);
+        for (int i = 0; i < n; ++i) {
+            sizes[i] = 0;
+            if (range[i].limit.compare(range[i].start) <= 0) continue;
+            auto end = m_table.lower_bound(VersionKey(range[i].limit.ToString(), SEQ_KEY_BEGIN));
+            for (auto it = m_table.lower_bound(VersionKey(range[i].start.ToString(), SEQ_KEY_BEGIN)); it != end; ++it) {
+                sizes[i] += it->first.first.size() + it->second.value.size();
+            }
+        }
+    }
+
+    void CompactRange(const leveldb::Slice* begin, const leveldb::Slice* end) override {}
+};
+
+MemoryIterator::~MemoryIterator()
+{
+    m_db.RemoveReader(m_seq);
+}
+
+void MemoryIterator::SeekToFirst()
+{
+    LOCK(m_db.m_mutex);
+    m_it = m_db.SeekVisibleForward(m_db.m_table.begin(), m_seq);
+    m_valid = m_it != m_db.m_table.end();
+}
+
+void MemoryIterator::SeekToLast()
+{
+    LOCK(m_db.m_mutex);
+    m_it = m_db.SeekVisibleBackward(m_db.m_table.end(), m_seq);
+    m_valid = m_it != m_db.m_table.end();
+}
+
+void MemoryIterator::Seek(const leveldb::Slice& target)
+{
+    LOCK(m_db.m_mutex);
+    m_it = m_db.SeekVisibleForward(m_db.m_table.lower_bound(VersionKey(target.ToString(), SEQ_KEY_BEGIN)), m_seq);
+    m_valid = m_it != m_db.m_table.end();
+}
+
+void MemoryIterator::Next()
+{
+    assert(m_valid);
+    LOCK(m_db.m_mutex);
+    m_it = m_db.SeekVisibleForward(m_db.m_table.lower_bound(VersionKey(m_it->first.first, SEQ_KEY_END)), m_seq);
+    m_valid = m_it != m_db.m_table.end();
+}
+
+void MemoryIterator::Prev()
+{
+    assert(m_valid);
+    LOCK(m_db.m_mutex);
+    m_it = m_db.SeekVisibleBackward(m_db.m_table.lower_bound(VersionKey(m_it->first.first, SEQ_KEY_BEGIN)), m_seq);
+    m_valid = m_it != m_db.m_table.end();
+}
+
+} // namespace
+
+leveldb::DB* NewMemoryDB()
+{
+    return new MemoryDB();
+}
@@ -0,0 +1,24 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MEMORYDB_H
+#define BITCOIN_MEMORYDB_H
+
+#include <leveldb/db.h>
+
+/**
+ * Create a key-value store that implements the leveldb::DB interface on top
+ * of a sorted in-memory table, so that CDBWrapper can use it in place of
+ * LevelDB. Nothing is ever written to disk: there are no log files, no
+ * compactions and sync writes return immediately. All data is lost when
+ * the returned object is deleted.
+ *
+ * Reads and writes are thread safe. Iterators and snapshots see the table
+ * as it was when they were created: writes add new versions of the keys
+ * they change, and the versions no iterator or snapshot can see anymore are
+ * removed.
+ */
+leveldb::DB* NewMemoryDB();
+
+#endif // BITCOIN_MEMORYDB_H
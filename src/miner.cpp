@@ -25,7 +25,9 @@
 #include <validationinterface.h>
 
 #include <algorithm>
+#include <functional>
 #include <queue>
+#include <set>
 #include <utility>
 
 // Unconfirmed transactions in the memory pool often depend on other
@@ -36,6 +38,8 @@
 uint64_t nLastBlockTx = 0;
 uint64_t nLastBlockSize = 0;
 
+std::unique_ptr<BlockTemplateCache> g_block_template_cache;
+
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev)
 {
     int64_t nOldTime = pblock->nTime;
@@ -55,6 +59,7 @@ BlockAssembler::Options::Options() {
 BlockAssembler::BlockAssembler(const CChainParams& params, const Options& options) : chainparams(params)
 {
     blockMinFeeRate = options.blockMinFeeRate;
+    m_use_template_cache = options.use_template_cache;
     nBlockMaxSize = DEFAULT_BLOCK_MAX_SIZE;
     if (gArgs.IsArgSet("-blockmaxsize")) {
         nBlockMaxSize = gArgs.GetArg("-blockmaxsize", DEFAULT_BLOCK_MAX_SIZE);
@@ -74,6 +79,7 @@ static BlockAssembler::Options DefaultOptions()
     } else {
         options.blockMinFeeRate = CFeeRate(DEFAULT_BLOCK_MIN_TX_FEE);
     }
+    options.use_template_cache = true;
     return options;
 }
 
@@ -133,7 +139,25 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
     int nPackagesSelected = 0;
     int nDescendantsUpdated = 0;
-    addPackageTxs(nPackagesSelected, nDescendantsUpdated, required_age_in_secs);
+    bool fFromCache = false;
+    if (m_use_template_cache && g_block_template_cache) {
+        std::vector<CTxMemPool::txiter> selected;
+        fFromCache = g_block_template_cache->Get(pindexPrev, nBlockMaxSize, blockMinFeeRate, selected);
+        if (!fFromCache) {
+            // The cache serves every caller, so select without the age limit
+            // and apply it below.
+            addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+            for (size_t i = 1; i < pblock->vtx.size(); ++i) {
+                selected.push_back(mempool.mapTx.find(pblock->vtx[i]->GetHashMalFix()));
+            }
+            g_block_template_cache->Reset(pindexPrev, nBlockMaxSize, blockMinFeeRate, nLockTimeCutoff, selected);
+        }
+        if (fFromCache || required_age_in_secs) {
+            addCachedTxs(selected, required_age_in_secs);
+        }
+    } else {
+        addPackageTxs(nPackagesSelected, nDescendantsUpdated, required_age_in_secs);
+    }
 
     int64_t nTime1 = GetTimeMicros();
 
@@ -166,7 +190,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     }
     int64_t nTime2 = GetTimeMicros();
 
-    LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+    LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%s, %d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), fFromCache ? "cached" : "selected", nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
 
     return std::move(pblocktemplate);
 }
@@ -227,6 +251,30 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     }
 }
 
+void BlockAssembler::addCachedTxs(const std::vector<CTxMemPool::txiter>& selected, int required_age_in_secs)
+{
+    pblock->vtx.resize(1);
+    pblocktemplate->vTxFees.resize(1);
+    pblocktemplate->vTxSigOpsCost.resize(1);
+    resetBlock();
+
+    const int64_t current_time = GetTime();
+    std::set<uint256> skipped;
+    for (CTxMemPool::txiter it : selected) {
+        // Skip transactions that are under X seconds in mempool, and what spends them
+        bool skip = required_age_in_secs && it->GetTime() > current_time - required_age_in_secs;
+        for (const CTxIn& txin : it->GetTx().vin) {
+            if (skip) break;
+            skip = skipped.count(txin.prevout.hashMalFix);
+        }
+        if (skip) {
+            skipped.insert(it->GetTx().GetHashMalFix());
+            continue;
+        }
+        AddToBlock(it);
+    }
+}
+
 int BlockAssembler::UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded,
         indexed_modified_transaction_set &mapModifiedTx)
 {
@@ -290,8 +338,80 @@ void BlockAssembler::SortForBlock(const CTxMemPool::setEntries& package, std::ve
 // Each time through the loop, we compare the best transaction in
 // mapModifiedTxs with the next transaction in the mempool to decide what
 // transaction package to work on next.
+void BlockAssembler::addClusterTxs(int &nPackagesSelected, int required_age_in_secs)
+{
+    const int64_t current_time = GetTime();
+
+    // The next chunk of every cluster, best feerate on top. Within a cluster
+    // chunk feerates never increase, so the top is always the best chunk
+    // whose ancestors are all in the block already.
+    typedef std::pair<const CTxMemPool::TxCluster*, size_t> ChunkRef;
+    auto compare = [](const ChunkRef& a, const ChunkRef& b) {
+        const CTxMemPool::TxCluster::Chunk& chunk_a = a.first->chunks[a.second];
+        const CTxMemPool::TxCluster::Chunk& chunk_b = b.first->chunks[b.second];
+        return (double)chunk_a.nModFees * chunk_b.nSize < (double)chunk_b.nModFees * chunk_a.nSize;
+    };
+    std::priority_queue<ChunkRef, std::vector<ChunkRef>, decltype(compare)> queue(compare);
+    for (const auto& cluster : mempool.GetClusters()) {
+        queue.emplace(&cluster.second, 0);
+    }
+
+    // Same heuristic as in addPackageTxs to finish quickly when nearly full.
+    const int64_t MAX_CONSECUTIVE_FAILURES = 1000;
+    int64_t nConsecutiveFailed = 0;
+
+    while (!queue.empty()) {
+        const ChunkRef next = queue.top();
+        queue.pop();
+        const CTxMemPool::TxCluster& cluster = *next.first;
+        const CTxMemPool::TxCluster::Chunk& chunk = cluster.chunks[next.second];
+
+        if (chunk.nModFees < blockMinFeeRate.GetFee(chunk.nSize)) {
+            // Everything else we might consider has a lower fee rate
+            return;
+        }
+
+        // A chunk that is left out takes the rest of its cluster with it,
+        // as the later chunks may spend from it.
+        const CTxMemPool::setEntries package(cluster.txs.begin() + cluster.ChunkBegin(next.second), cluster.txs.begin() + chunk.end);
+
+        // Skip transactions that are under X seconds in mempool
+        if (required_age_in_secs && std::any_of(package.begin(), package.end(), [&](CTxMemPool::txiter it) {
+                return it->GetTime() > current_time - required_age_in_secs;
+            })) {
+            continue;
+        }
+
+        if (!TestPackage(chunk.nSize, chunk.nSigOpCost) || !TestPackageTransactions(package)) {
+            ++nConsecutiveFailed;
+            if (nConsecutiveFailed > MAX_CONSECUTIVE_FAILURES && nBlockSize >
+                    nBlockMaxSize - 1000) {
+                // Give up if we're close to full and haven't succeeded in a while
+                break;
+            }
+            continue;
+        }
+        nConsecutiveFailed = 0;
+
+        for (size_t i = cluster.ChunkBegin(next.second); i < chunk.end; ++i) {
+            assert(!inBlock.count(cluster.txs[i]));
+            AddToBlock(cluster.txs[i]);
+        }
+        ++nPackagesSelected;
+
+        if (next.second + 1 < cluster.chunks.size()) {
+            queue.emplace(&cluster, next.second + 1);
+        }
+    }
+}
+
 void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpdated, int required_age_in_secs)
 {
+    if (mempool.IsClusterMode()) {
+        addClusterTxs(nPackagesSelected, required_age_in_secs);
+        return;
+    }
+
     int64_t current_time = GetTime();
     // mapModifiedTx will store sorted packages after they are modified
     // because some of their txs are already in the block
@@ -427,6 +547,147 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
     }
 }
 
+BlockTemplateCache::BlockTemplateCache()
+{
+    m_conn_added = mempool.NotifyEntryAdded.connect(std::bind(&BlockTemplateCache::TransactionAdded, this, std::placeholders::_1));
+    m_conn_removed = mempool.NotifyEntryRemoved.connect(std::bind(&BlockTemplateCache::TransactionRemoved, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+void BlockTemplateCache::Clear()
+{
+    m_valid = false;
+    m_entries.clear();
+    m_txids.clear();
+    m_pending.clear();
+    m_removed.clear();
+}
+
+void BlockTemplateCache::TransactionAdded(CTransactionRef tx)
+{
+    // Called with the pool locked, before the entry is in mapTx.
+    AssertLockHeld(mempool.cs);
+    if (!m_valid) return;
+    if (m_pending.size() >= MAX_BLOCK_TEMPLATE_PENDING) {
+        // Nobody is asking for templates; stop following the mempool.
+        Clear();
+        return;
+    }
+    m_pending.push_back(std::move(tx));
+}
+
+void BlockTemplateCache::TransactionRemoved(CTransactionRef tx, MemPoolRemovalReason reason)
+{
+    // Called with the pool locked, before the entry is erased.
+    AssertLockHeld(mempool.cs);
+    if (!m_valid) return;
+    switch (reason) {
+    case MemPoolRemovalReason::BLOCK:
+    case MemPoolRemovalReason::REORG:
+    case MemPoolRemovalReason::CONFLICT:
+        // The tip is changing, which invalidates the selection anyway.
+        Clear();
+        return;
+    default:
+        // The descendants of tx are removed as well, so what is left of the
+        // selection stays in a valid order.
+        const uint256& hash = tx->GetHashMalFix();
+        if (m_txids.erase(hash)) {
+            m_removed.insert(hash);
+            // Room was made for something that might have been left out.
+            m_dirty = true;
+        }
+    }
+}
+
+bool BlockTemplateCache::TryAppend(CTxMemPool::txiter it)
+{
+    const CTransaction& tx = it->GetTx();
+    if (m_size + it->GetTxSize() >= m_max_size || m_sigops + it->GetSigOpCost() >= GetMaxBlockSigops())
+        return false;
+    if (!IsFinalTx(tx, m_height, m_lock_time_cutoff) || tx.HasWitness())
+        return false;
+    for (const CTxIn& txin : tx.vin) {
+        // A parent that was left out means the package has to be considered as a whole.
+        if (!m_txids.count(txin.prevout.hashMalFix) && mempool.mapTx.count(txin.prevout.hashMalFix))
+            return false;
+    }
+    m_entries.push_back(Entry{tx.GetHashMalFix(), it, (uint64_t)it->GetTxSize(), it->GetSigOpCost()});
+    m_txids.insert(tx.GetHashMalFix());
+    m_size += it->GetTxSize();
+    m_sigops += it->GetSigOpCost();
+    return true;
+}
+
+bool BlockTemplateCache::Get(const CBlockIndex* pindexPrev, uint64_t nBlockMaxSize, const CFeeRate& blockMinFeeRate, std::vector<CTxMemPool::txiter>& selected)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(mempool.cs);
+    if (!m_valid || m_hash_prev != pindexPrev->GetBlockHash() || m_max_size != nBlockMaxSize || m_min_fee_rate != blockMinFeeRate)
+        return false;
+
+    if (!m_removed.empty()) {
+        // The iterators of removed entries are dangling; only their txid is looked at.
+        std::vector<Entry> entries;
+        entries.reserve(m_entries.size());
+        for (Entry& entry : m_entries) {
+            if (m_removed.count(entry.txid)) {
+                m_size -= entry.nSize;
+                m_sigops -= entry.nSigOpCost;
+            } else {
+                entries.push_back(std::move(entry));
+            }
+        }
+        m_entries.swap(entries);
+        m_removed.clear();
+    }
+
+    for (const CTransactionRef& tx : m_pending) {
+        CTxMemPool::txiter it = mempool.mapTx.find(tx->GetHashMalFix());
+        if (it == mempool.mapTx.end() || m_txids.count(tx->GetHashMalFix()))
+            continue;
+        if (it->GetModifiedFee() < m_min_fee_rate.GetFee(it->GetTxSize()))
+            continue;
+        if (!TryAppend(it))
+            m_dirty = true;
+    }
+    m_pending.clear();
+
+    if (m_dirty && GetTime() - m_last_rebuild >= BLOCK_TEMPLATE_REBUILD_INTERVAL)
+        return false;
+
+    selected.clear();
+    selected.reserve(m_entries.size());
+    for (const Entry& entry : m_entries) {
+        selected.push_back(entry.iter);
+    }
+    return true;
+}
+
+void BlockTemplateCache::Reset(const CBlockIndex* pindexPrev, uint64_t nBlockMaxSize, const CFeeRate& blockMinFeeRate, int64_t nLockTimeCutoff, const std::vector<CTxMemPool::txiter>& selected)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(mempool.cs);
+    Clear();
+    m_valid = true;
+    m_dirty = false;
+    m_last_rebuild = GetTime();
+    m_hash_prev = pindexPrev->GetBlockHash();
+    m_height = pindexPrev->nHeight + 1;
+    m_lock_time_cutoff = nLockTimeCutoff;
+    m_max_size = nBlockMaxSize;
+    m_min_fee_rate = blockMinFeeRate;
+
+    // Same reservations for the coinbase as BlockAssembler::resetBlock()
+    m_size = 1000;
+    m_sigops = 100;
+    for (CTxMemPool::txiter it : selected) {
+        m_entries.push_back(Entry{it->GetTx().GetHashMalFix(), it, (uint64_t)it->GetTxSize(), it->GetSigOpCost()});
+        m_txids.insert(it->GetTx().GetHashMalFix());
+        m_size += it->GetTxSize();
+        m_sigops += it->GetSigOpCost();
+    }
+}
+
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce)
 {
     // Update nExtraNonce
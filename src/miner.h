@@ -13,8 +13,11 @@
 
 #include <stdint.h>
 #include <memory>
+#include <unordered_set>
+#include <vector>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/signals2/connection.hpp>
 
 class CBlockIndex;
 class CChainParams;
@@ -23,6 +26,12 @@ class CScript;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Default for -blocktemplatecache, keeping the transaction selection of the last template up to date */
+static const bool DEFAULT_BLOCK_TEMPLATE_CACHE = true;
+/** Seconds after which a cached selection that left out eligible transactions is made again from scratch */
+static const int64_t BLOCK_TEMPLATE_REBUILD_INTERVAL = 30;
+/** Mempool additions remembered between two templates before the cached selection is dropped */
+static const size_t MAX_BLOCK_TEMPLATE_PENDING = 100000;
 
 struct CBlockTemplate
 {
@@ -122,6 +131,72 @@ struct update_for_parent_inclusion
 };
 
 
+/**
+ * The transaction selection of the last block template, kept up to date as
+ * the mempool changes so that the next template does not have to walk the
+ * whole mempool again.
+ *
+ * Mempool changes are only recorded when they happen. When a template is
+ * requested, transactions removed since are dropped from the selection and
+ * new ones are appended if their in-mempool parents are already selected
+ * and they fit. A transaction that cannot be appended marks the selection as
+ * no longer the best one; it is then made again from scratch once it is
+ * BLOCK_TEMPLATE_REBUILD_INTERVAL seconds old. A new tip or different
+ * assembler limits invalidate the selection.
+ */
+class BlockTemplateCache
+{
+public:
+    BlockTemplateCache();
+
+    /** Get the selection for a block on top of pindexPrev, in block order. Returns false if it has to be made again. */
+    bool Get(const CBlockIndex* pindexPrev, uint64_t nBlockMaxSize, const CFeeRate& blockMinFeeRate, std::vector<CTxMemPool::txiter>& selected) EXCLUSIVE_LOCKS_REQUIRED(cs_main, mempool.cs);
+    /** Replace the selection with one made from scratch */
+    void Reset(const CBlockIndex* pindexPrev, uint64_t nBlockMaxSize, const CFeeRate& blockMinFeeRate, int64_t nLockTimeCutoff, const std::vector<CTxMemPool::txiter>& selected) EXCLUSIVE_LOCKS_REQUIRED(cs_main, mempool.cs);
+
+private:
+    struct Entry {
+        uint256 txid;
+        CTxMemPool::txiter iter;
+        uint64_t nSize;
+        int32_t nSigOpCost;
+    };
+
+    boost::signals2::scoped_connection m_conn_added;
+    boost::signals2::scoped_connection m_conn_removed;
+
+    bool m_valid GUARDED_BY(mempool.cs){false};
+    //! Whether an eligible transaction was left out since the last rebuild
+    bool m_dirty GUARDED_BY(mempool.cs){false};
+    int64_t m_last_rebuild GUARDED_BY(mempool.cs){0};
+
+    // What the selection was made for
+    uint256 m_hash_prev GUARDED_BY(mempool.cs);
+    int m_height GUARDED_BY(mempool.cs){0};
+    int64_t m_lock_time_cutoff GUARDED_BY(mempool.cs){0};
+    uint64_t m_max_size GUARDED_BY(mempool.cs){0};
+    CFeeRate m_min_fee_rate GUARDED_BY(mempool.cs);
+
+    std::vector<Entry> m_entries GUARDED_BY(mempool.cs);
+    std::unordered_set<uint256, SaltedTxidHasher> m_txids GUARDED_BY(mempool.cs);
+    uint64_t m_size GUARDED_BY(mempool.cs){0};
+    int32_t m_sigops GUARDED_BY(mempool.cs){0};
+
+    //! Added to the mempool since the selection was last brought up to date, in order
+    std::vector<CTransactionRef> m_pending GUARDED_BY(mempool.cs);
+    //! Selected transactions removed from the mempool since
+    std::unordered_set<uint256, SaltedTxidHasher> m_removed GUARDED_BY(mempool.cs);
+
+    void TransactionAdded(CTransactionRef tx);
+    void TransactionRemoved(CTransactionRef tx, MemPoolRemovalReason reason);
+    void Clear() EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+    /** Append a new mempool transaction to the selection if it can go at the end */
+    bool TryAppend(CTxMemPool::txiter it) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+};
+
+/** The template cache used by BlockAssemblers with default options, if -blocktemplatecache is set */
+extern std::unique_ptr<BlockTemplateCache> g_block_template_cache;
+
 /** Generate a new block, without valid proof-of-work */
 class BlockAssembler
 {
@@ -134,6 +209,7 @@ private:
     // Configuration parameters for the block size
     unsigned int nBlockMaxSize;
     CFeeRate blockMinFeeRate;
+    bool m_use_template_cache;
 
     // Information on the current status of the block
     uint64_t nBlockSize;
@@ -152,6 +228,8 @@ public:
         Options();
         size_t nBlockMaxSize;
         CFeeRate blockMinFeeRate;
+        //! Take the transactions from g_block_template_cache
+        bool use_template_cache{false};
     };
 
     explicit BlockAssembler(const CChainParams& params);
@@ -166,8 +244,12 @@ private:
     void resetBlock();
     /** Add a tx to the block */
     void AddToBlock(CTxMemPool::txiter iter);
+    /** Add the selection of the template cache, leaving out transactions younger than the required age and their descendants */
+    void addCachedTxs(const std::vector<CTxMemPool::txiter>& selected, int required_age_in_secs) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 
     // Methods for how to add transactions to a block.
+    /** Add the chunks of the mempool clusters by feerate, in cluster mode */
+    void addClusterTxs(int &nPackagesSelected, int required_age_in_secs) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
     /** Add transactions based on feerate including unconfirmed ancestors
       * Increments nPackagesSelected / nDescendantsUpdated with corresponding
       * statistics from the package selection (for logging statistics). */
@@ -11,6 +11,7 @@
 #include <blockencodings.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <core_memusage.h>
 #include <hash.h>
 #include <validation.h>
 #include <merkleblock.h>
@@ -46,6 +47,8 @@
 static constexpr int64_t ORPHAN_TX_EXPIRE_TIME = 20 * 60;
 /** Minimum time between orphan transactions expire time checks in seconds */
 static constexpr int64_t ORPHAN_TX_EXPIRE_INTERVAL = 5 * 60;
+/** Maximum number of orphans accepted or rejected in one ProcessOrphanTx call */
+static constexpr unsigned int MAX_ORPHANS_PROCESSED_PER_CALL = 100;
 /** How long a transaction has to be in the mempool before it can unconditionally be relayed (even when not in mapRelay). */
 static constexpr std::chrono::seconds UNCONDITIONAL_RELAY_DELAY = std::chrono::minutes{2};
 /** Headers download timeout expressed in microseconds
@@ -82,6 +85,8 @@ struct COrphanTx {
     CTransactionRef tx;
     NodeId fromPeer;
     int64_t nTimeExpire;
+    size_t nUsage;   //!< memory accounted to the orphan pool and fromPeer
+    size_t list_pos; //!< position in the orphan list of fromPeer
 };
 static RecursiveMutex g_cs_orphans;
 std::map<uint256, COrphanTx> mapOrphanTransactions GUARDED_BY(g_cs_orphans);
@@ -202,6 +207,16 @@ namespace {
     };
     std::map<COutPoint, std::set<std::map<uint256, COrphanTx>::iterator, IteratorComparator>> mapOrphanTransactionsByPrev GUARDED_BY(g_cs_orphans);
 
+    /** The orphans a peer sent us and the memory they use */
+    struct OrphanPeer {
+        size_t nUsage = 0;
+        std::vector<std::map<uint256, COrphanTx>::iterator> orphans;
+    };
+    std::map<NodeId, OrphanPeer> mapOrphanPeers GUARDED_BY(g_cs_orphans);
+    size_t nOrphanUsage GUARDED_BY(g_cs_orphans) = 0;
+    //! Counters reported by GetOrphanPoolStats
+    OrphanPoolStats g_orphan_stats GUARDED_BY(g_cs_orphans);
+
     static size_t vExtraTxnForCompactIt GUARDED_BY(g_cs_orphans) = 0;
     static std::vector<std::pair<uint256, CTransactionRef>> vExtraTxnForCompact GUARDED_BY(g_cs_orphans);
 } // namespace
@@ -776,16 +791,24 @@ bool AddOrphanTx(const CTransactionRef& tx, NodeId peer) EXCLUSIVE_LOCKS_REQUIRE
         return false;
     }
 
-    auto ret = mapOrphanTransactions.emplace(hash, COrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME});
+    const size_t nUsage = RecursiveDynamicUsage(tx) + memusage::IncrementalDynamicUsage(mapOrphanTransactions) +
+                          tx->vin.size() * memusage::IncrementalDynamicUsage(mapOrphanTransactionsByPrev);
+    auto ret = mapOrphanTransactions.emplace(hash, COrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME, nUsage, 0});
     assert(ret.second);
     for (const CTxIn& txin : tx->vin) {
         mapOrphanTransactionsByPrev[txin.prevout].insert(ret.first);
     }
+    OrphanPeer& orphanPeer = mapOrphanPeers[peer];
+    ret.first->second.list_pos = orphanPeer.orphans.size();
+    orphanPeer.orphans.push_back(ret.first);
+    orphanPeer.nUsage += nUsage;
+    nOrphanUsage += nUsage;
+    ++g_orphan_stats.nAdded;
 
     AddToCompactExtraTransactions(tx);
 
-    LogPrint(BCLog::MEMPOOL, "stored orphan tx %s (mapsz %u outsz %u)\n", hash.ToString(),
-             mapOrphanTransactions.size(), mapOrphanTransactionsByPrev.size());
+    LogPrint(BCLog::MEMPOOL, "stored orphan tx %s (mapsz %u outsz %u, %u kB)\n", hash.ToString(),
+             mapOrphanTransactions.size(), mapOrphanTransactionsByPrev.size(), nOrphanUsage / 1000);
     return true;
 }
 
@@ -803,6 +826,24 @@ int static EraseOrphanTx(uint256 hash) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
         if (itPrev->second.empty())
             mapOrphanTransactionsByPrev.erase(itPrev);
     }
+
+    // Fill the gap in the peer's orphan list with its last entry.
+    auto itPeer = mapOrphanPeers.find(it->second.fromPeer);
+    assert(itPeer != mapOrphanPeers.end());
+    std::vector<std::map<uint256, COrphanTx>::iterator>& orphans = itPeer->second.orphans;
+    const size_t old_pos = it->second.list_pos;
+    assert(orphans[old_pos] == it);
+    if (old_pos + 1 != orphans.size()) {
+        orphans[old_pos] = orphans.back();
+        orphans[old_pos]->second.list_pos = old_pos;
+    }
+    orphans.pop_back();
+    itPeer->second.nUsage -= it->second.nUsage;
+    if (orphans.empty()) {
+        mapOrphanPeers.erase(itPeer);
+    }
+    nOrphanUsage -= it->second.nUsage;
+
     mapOrphanTransactions.erase(it);
     return 1;
 }
@@ -810,21 +851,23 @@ int static EraseOrphanTx(uint256 hash) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
 void EraseOrphansFor(NodeId peer)
 {
     LOCK(g_cs_orphans);
+    auto itPeer = mapOrphanPeers.find(peer);
+    if (itPeer == mapOrphanPeers.end()) return;
+
+    std::vector<uint256> vOrphanErase;
+    for (const auto& orphan : itPeer->second.orphans) {
+        vOrphanErase.push_back(orphan->first);
+    }
     int nErased = 0;
-    std::map<uint256, COrphanTx>::iterator iter = mapOrphanTransactions.begin();
-    while (iter != mapOrphanTransactions.end())
-    {
-        std::map<uint256, COrphanTx>::iterator maybeErase = iter++; // increment to avoid iterator becoming invalid
-        if (maybeErase->second.fromPeer == peer)
-        {
-            nErased += EraseOrphanTx(maybeErase->second.tx->GetHashMalFix());
-        }
+    for (const uint256& hash : vOrphanErase) {
+        nErased += EraseOrphanTx(hash);
     }
+    g_orphan_stats.nPeerErased += nErased;
     if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx from peer=%d\n", nErased, peer);
 }
 
 
-unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans)
+unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans, size_t nMaxUsage)
 {
     LOCK(g_cs_orphans);
 
@@ -847,21 +890,52 @@ unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans)
         }
         // Sweep again 5 minutes after the next entry that expires in order to batch the linear scan.
         nNextSweep = nMinExpTime + ORPHAN_TX_EXPIRE_INTERVAL;
+        g_orphan_stats.nExpired += nErased;
         if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx due to expiration\n", nErased);
     }
-    while (mapOrphanTransactions.size() > nMaxOrphans)
+    while (mapOrphanTransactions.size() > nMaxOrphans || nOrphanUsage > nMaxUsage)
     {
-        // Evict a random orphan:
-        uint256 randomhash = GetRandHash();
-        std::map<uint256, COrphanTx>::iterator it = mapOrphanTransactions.lower_bound(randomhash);
-        if (it == mapOrphanTransactions.end())
-            it = mapOrphanTransactions.begin();
-        EraseOrphanTx(it->first);
+        // Evict a random orphan of the peer whose orphans use the most
+        // memory, so that a peer flooding us mostly displaces its own.
+        auto itPeer = std::max_element(mapOrphanPeers.begin(), mapOrphanPeers.end(),
+            [](const std::pair<const NodeId, OrphanPeer>& a, const std::pair<const NodeId, OrphanPeer>& b) {
+                return a.second.nUsage < b.second.nUsage;
+            });
+        const std::vector<std::map<uint256, COrphanTx>::iterator>& orphans = itPeer->second.orphans;
+        EraseOrphanTx(orphans[GetRand(orphans.size())]->first);
         ++nEvicted;
     }
+    g_orphan_stats.nEvicted += nEvicted;
     return nEvicted;
 }
 
+/**
+ * Queue the orphans spending any output of tx. mapOrphanTransactionsByPrev
+ * is ordered by outpoint, so they are found with a single lookup.
+ */
+static void AddChildrenToWorkSet(const CTransaction& tx, std::set<uint256>& orphan_work_set) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
+{
+    const uint256& hash = tx.GetHashMalFix();
+    for (auto it = mapOrphanTransactionsByPrev.lower_bound(COutPoint(hash, 0));
+         it != mapOrphanTransactionsByPrev.end() && it->first.hashMalFix == hash; ++it) {
+        for (const auto& elem : it->second) {
+            orphan_work_set.insert(elem->first);
+        }
+    }
+}
+
+OrphanPoolStats GetOrphanPoolStats()
+{
+    LOCK(g_cs_orphans);
+    OrphanPoolStats stats = g_orphan_stats;
+    stats.nOrphans = mapOrphanTransactions.size();
+    stats.nUsage = nOrphanUsage;
+    for (const auto& peer : mapOrphanPeers) {
+        stats.mapPeers.emplace(peer.first, std::make_pair(peer.second.orphans.size(), peer.second.nUsage));
+    }
+    return stats;
+}
+
 /**
  * Mark a misbehaving peer to be banned depending upon the value of `-banscore`.
  */
@@ -955,6 +1029,7 @@ void PeerLogicValidation::BlockConnected(const std::shared_ptr<const CBlock>& pb
         for (uint256 &orphanHash : vOrphanErase) {
             nErased += EraseOrphanTx(orphanHash);
         }
+        g_orphan_stats.nBlockErased += nErased;
         LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx included or conflicted by block\n", nErased);
     }
 
@@ -1256,7 +1331,7 @@ void static ProcessGetBlockData(CNode* pfrom, const CInv& inv, CConnman* connman
         } else {
             // Send block from disk
             std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-            if (!ReadBlockFromDisk(*pblockRead, pindex))
+            if (!ReadBlockFromDisk(*pblockRead, pindex, true, true))
                 assert(!"cannot load block from disk");
             pblock = pblockRead;
         }
@@ -1647,8 +1722,11 @@ void static ProcessOrphanTx(CConnman *connman, std::set<uint256>& orphan_work_se
     AssertLockHeld(cs_main);
     AssertLockHeld(g_cs_orphans);
     std::set<NodeId> setMisbehaving;
-    bool done = false;
-    while (!done && !orphan_work_set.empty()) {
+    // Orphans whose parent was just accepted are queued behind it, so a chain
+    // of orphans is resolved parent first. An orphan tried before a sibling it
+    // depends on is queued again once that sibling is accepted.
+    unsigned int nProcessed = 0;
+    while (nProcessed < MAX_ORPHANS_PROCESSED_PER_CALL && !orphan_work_set.empty()) {
         const uint256 orphanHash = *orphan_work_set.begin();
         orphan_work_set.erase(orphan_work_set.begin());
 
@@ -1665,16 +1743,10 @@ void static ProcessOrphanTx(CConnman *connman, std::set<uint256>& orphan_work_se
         if (AcceptToMemoryPool(porphanTx, opt)) {
             LogPrint(BCLog::MEMPOOL, "   accepted orphan tx %s\n", orphanHash.ToString());
             RelayTransaction(orphanTx, connman);
-            for (unsigned int i = 0; i < orphanTx.vout.size(); i++) {
-                auto it_by_prev = mapOrphanTransactionsByPrev.find(COutPoint(orphanHash, i));
-                if (it_by_prev != mapOrphanTransactionsByPrev.end()) {
-                    for (const auto& elem : it_by_prev->second) {
-                        orphan_work_set.insert(elem->first);
-                    }
-                }
-            }
+            AddChildrenToWorkSet(orphanTx, orphan_work_set);
             EraseOrphanTx(orphanHash);
-            done = true;
+            ++g_orphan_stats.nResolved;
+            ++nProcessed;
         } else if (!opt.missingInputs.size()) {
             int nDos = 0;
             if (opt.state.IsInvalid(nDos) && nDos > 0) {
@@ -1694,7 +1766,8 @@ void static ProcessOrphanTx(CConnman *connman, std::set<uint256>& orphan_work_se
                 recentRejects->insert(orphanHash);
             }
             EraseOrphanTx(orphanHash);
-            done = true;
+            ++g_orphan_stats.nRejected;
+            ++nProcessed;
         }
         mempool.check(pcoinsTip.get());
 
@@ -2262,7 +2335,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         }
 
         CBlock block;
-        bool ret = ReadBlockFromDisk(block, pindex);
+        bool ret = ReadBlockFromDisk(block, pindex, true, true);
         assert(ret);
 
         SendBlockTransactions(block, req, pfrom, connman);
@@ -2354,6 +2427,14 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         CInv inv(MSG_TX, tx.GetHashMalFix());
         pfrom->AddInventoryKnown(inv);
 
+        // Verify the signatures before taking cs_main for the admission,
+        // unless the transaction is known or was recently rejected, which is
+        // looked up under the lock the pre-check takes anyway.
+        PreCheckMempoolTransaction(ptx, [&](const CTransaction&) {
+            AssertLockHeld(cs_main);
+            return AlreadyHave(inv);
+        });
+
         LOCK2(cs_main, g_cs_orphans);
 
         pfrom->setAskFor.erase(inv.hash);
@@ -2364,14 +2445,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             AcceptToMemoryPool(ptx, opt)) {
             mempool.check(pcoinsTip.get());
             RelayTransaction(tx, connman);
-            for (unsigned int i = 0; i < tx.vout.size(); i++) {
-                auto it_by_prev = mapOrphanTransactionsByPrev.find(COutPoint(inv.hash, i));
-                if (it_by_prev != mapOrphanTransactionsByPrev.end()) {
-                    for (const auto& elem : it_by_prev->second) {
-                        pfrom->orphan_work_set.insert(elem->first);
-                    }
-                }
-            }
+            AddChildrenToWorkSet(tx, pfrom->orphan_work_set);
 
             pfrom->nLastTXTime = GetTime();
 
@@ -2402,7 +2476,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
 
                 // DoS prevention: do not allow mapOrphanTransactions to grow unbounded
                 unsigned int nMaxOrphanTx = (unsigned int)std::max((int64_t)0, gArgs.GetArg("-maxorphantx", DEFAULT_MAX_ORPHAN_TRANSACTIONS));
-                unsigned int nEvicted = LimitOrphanTxSize(nMaxOrphanTx);
+                size_t nMaxOrphanUsage = (size_t)std::max((int64_t)0, gArgs.GetArg("-maxorphansize", DEFAULT_MAX_ORPHAN_SIZE)) * 1000000;
+                unsigned int nEvicted = LimitOrphanTxSize(nMaxOrphanTx, nMaxOrphanUsage);
                 if (nEvicted > 0) {
                     LogPrint(BCLog::MEMPOOL, "mapOrphan overflow, removed %u tx\n", nEvicted);
                 }
@@ -3596,7 +3671,7 @@ bool PeerLogicValidation::SendMessages(CNode* pto)
                     }
                     if (!fGotBlockFromCache) {
                         CBlock block;
-                        bool ret = ReadBlockFromDisk(block, pBestIndex);
+                        bool ret = ReadBlockFromDisk(block, pBestIndex, true, true);
                         assert(ret);
                         CBlockHeaderAndShortTxIDs cmpctblock(block);
                         connman->PushMessage(pto, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
@@ -3933,5 +4008,7 @@ public:
         // orphan transactions
         mapOrphanTransactions.clear();
         mapOrphanTransactionsByPrev.clear();
+        mapOrphanPeers.clear();
+        nOrphanUsage = 0;
     }
 } instance_of_cnetprocessingcleanup;
@@ -11,8 +11,12 @@
 #include <validationinterface.h>
 #include <consensus/params.h>
 
+#include <map>
+
 /** Default for -maxorphantx, maximum number of orphan transactions kept in memory */
-static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
+static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 10000;
+/** Default for -maxorphansize, maximum memory used by orphan transactions in megabytes */
+static const unsigned int DEFAULT_MAX_ORPHAN_SIZE = 10;
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
 /** Maximum number of outstanding CMPCTBLOCK requests for the same block. */
@@ -85,6 +89,26 @@ struct CNodeStateStats {
 /** Get statistics from node state */
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
 
+struct OrphanPoolStats {
+    size_t nOrphans = 0;
+    //! Estimated memory usage of the orphans, counted against -maxorphansize
+    size_t nUsage = 0;
+    //! Number of orphans and their memory usage by the peer that sent them
+    std::map<NodeId, std::pair<size_t, size_t>> mapPeers;
+
+    // Totals since startup
+    uint64_t nAdded = 0;
+    uint64_t nResolved = 0;    //!< accepted to the mempool once their parents arrived
+    uint64_t nRejected = 0;    //!< found invalid once their parents arrived
+    uint64_t nExpired = 0;
+    uint64_t nEvicted = 0;     //!< removed to stay within -maxorphantx and -maxorphansize
+    uint64_t nPeerErased = 0;  //!< removed because the sending peer disconnected
+    uint64_t nBlockErased = 0; //!< included or conflicted by a block
+};
+
+/** Get statistics from the orphan transaction pool */
+OrphanPoolStats GetOrphanPoolStats();
+
 /** Relay a transaction to all our peers*/
 void RelayTransaction(const CTransaction& tx, CConnman* connman);
 
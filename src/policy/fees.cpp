@@ -14,6 +14,22 @@
 #include <util.h>
 
 static constexpr double INF_FEERATE = 1e99;
+/** Smallest accumulated decay before TxConfirmStats folds it into its averages */
+static constexpr double MIN_DECAY_FACTOR = 1e-8;
+
+/**
+ * Whether a transaction is tracked by the token stats: it issues or
+ * transfers tokens, or burns them, in which case it may have no colored
+ * output left.
+ */
+static bool IsTokenTx(const CTxMemPoolEntry& entry)
+{
+    if (entry.GetSpendsToken()) return true;
+    for (const CTxOut& txout : entry.GetTx().vout) {
+        if (txout.scriptPubKey.IsColoredScript()) return true;
+    }
+    return false;
+}
 
 std::string StringForFeeEstimateHorizon(FeeEstimateHorizon horizon) {
     static const std::map<FeeEstimateHorizon, std::string> horizon_strings = {
@@ -99,6 +115,12 @@ private:
 
     double decay;
 
+    // The moving averages above are stored divided by decayFactor, the
+    // product of all decays applied since they were last normalized. Decaying
+    // every average then only takes one multiplication per block, and data
+    // points are recorded scaled up by 1/decayFactor instead.
+    double decayFactor;
+
     // Resolution (# of blocks) with which confirmations are tracked
     unsigned int scale;
 
@@ -111,6 +133,9 @@ private:
 
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Fold decayFactor into the stored moving averages */
+    void Normalize();
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -179,6 +204,7 @@ TxConfirmStats::TxConfirmStats(const std::vector<double>& defaultBuckets,
     : buckets(defaultBuckets), bucketMap(defaultBucketMap)
 {
     decay = _decay;
+    decayFactor = 1;
     assert(_scale != 0 && "_scale must be non-zero");
     scale = _scale;
     confAvg.resize(maxPeriods);
@@ -205,6 +231,19 @@ void TxConfirmStats::resizeInMemoryCounters(size_t newbuckets) {
     oldUnconfTxs.resize(newbuckets);
 }
 
+void TxConfirmStats::Normalize()
+{
+    for (unsigned int j = 0; j < avg.size(); j++) {
+        for (unsigned int i = 0; i < confAvg.size(); i++)
+            confAvg[i][j] = confAvg[i][j] * decayFactor;
+        for (unsigned int i = 0; i < failAvg.size(); i++)
+            failAvg[i][j] = failAvg[i][j] * decayFactor;
+        avg[j] = avg[j] * decayFactor;
+        txCtAvg[j] = txCtAvg[j] * decayFactor;
+    }
+    decayFactor = 1;
+}
+
 // Roll the unconfirmed txs circular buffer
 void TxConfirmStats::ClearCurrent(unsigned int nBlockHeight)
 {
@@ -222,22 +261,21 @@ void TxConfirmStats::Record(int blocksToConfirm, double val)
         return;
     int periodsToConfirm = (blocksToConfirm + scale - 1)/scale;
     unsigned int bucketindex = bucketMap.lower_bound(val)->second;
+    const double weight = 1 / decayFactor;
     for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+        confAvg[i - 1][bucketindex] += weight;
     }
-    txCtAvg[bucketindex]++;
-    avg[bucketindex] += val;
+    txCtAvg[bucketindex] += weight;
+    avg[bucketindex] += val * weight;
 }
 
 void TxConfirmStats::UpdateMovingAverages()
 {
-    for (unsigned int j = 0; j < buckets.size(); j++) {
-        for (unsigned int i = 0; i < confAvg.size(); i++)
-            confAvg[i][j] = confAvg[i][j] * decay;
-        for (unsigned int i = 0; i < failAvg.size(); i++)
-            failAvg[i][j] = failAvg[i][j] * decay;
-        avg[j] = avg[j] * decay;
-        txCtAvg[j] = txCtAvg[j] * decay;
+    decayFactor *= decay;
+    // Keep the stored values well inside double range; with the longest
+    // half-life this walks the buckets about once every 27000 blocks.
+    if (decayFactor < MIN_DECAY_FACTOR) {
+        Normalize();
     }
 }
 
@@ -286,9 +324,9 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
-        totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
+        nConf += confAvg[periodTarget - 1][bucket] * decayFactor;
+        totalNum += txCtAvg[bucket] * decayFactor;
+        failNum += failAvg[periodTarget - 1][bucket] * decayFactor;
         for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
             extraNum += unconfTxs[(nBlockHeight - confct)%bins][bucket];
         extraNum += oldUnconfTxs[bucket];
@@ -346,13 +384,13 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     unsigned int minBucket = std::min(bestNearBucket, bestFarBucket);
     unsigned int maxBucket = std::max(bestNearBucket, bestFarBucket);
     for (unsigned int j = minBucket; j <= maxBucket; j++) {
-        txSum += txCtAvg[j];
+        txSum += txCtAvg[j] * decayFactor;
     }
     if (foundAnswer && txSum != 0) {
         txSum = txSum / 2;
         for (unsigned int j = minBucket; j <= maxBucket; j++) {
-            if (txCtAvg[j] < txSum)
-                txSum -= txCtAvg[j];
+            if (txCtAvg[j] * decayFactor < txSum)
+                txSum -= txCtAvg[j] * decayFactor;
             else { // we're in the right bucket
                 median = avg[j] / txCtAvg[j];
                 break;
@@ -396,12 +434,15 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
 
 void TxConfirmStats::Write(CAutoFile& fileout) const
 {
+    // The file holds the actual averages, so write a normalized copy.
+    TxConfirmStats normalized(*this);
+    normalized.Normalize();
     fileout << decay;
     fileout << scale;
-    fileout << avg;
-    fileout << txCtAvg;
-    fileout << confAvg;
-    fileout << failAvg;
+    fileout << normalized.avg;
+    fileout << normalized.txCtAvg;
+    fileout << normalized.confAvg;
+    fileout << normalized.failAvg;
 }
 
 void TxConfirmStats::Read(CAutoFile& filein, int nFileVersion, size_t numBuckets)
@@ -420,6 +461,7 @@ void TxConfirmStats::Read(CAutoFile& filein, int nFileVersion, size_t numBuckets
     if (scale == 0) {
         throw std::runtime_error("Corrupt estimates file. Scale must be non-zero");
     }
+    decayFactor = 1;
 
     filein >> avg;
     if (avg.size() != numBuckets) {
@@ -500,7 +542,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+            failAvg[i][bucketindex] += 1 / decayFactor;
         }
     }
 }
@@ -518,6 +560,11 @@ bool CBlockPolicyEstimator::removeTx(uint256 hash, bool inBlock)
         feeStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         shortStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         longStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
+        if (pos->second.token) {
+            tokenFeeStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
+            tokenShortStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
+            tokenLongStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
+        }
         mapMemPoolTxs.erase(hash);
         return true;
     } else {
@@ -541,6 +588,9 @@ CBlockPolicyEstimator::CBlockPolicyEstimator()
     feeStats = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, bucketMap, MED_BLOCK_PERIODS, MED_DECAY, MED_SCALE));
     shortStats = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, bucketMap, SHORT_BLOCK_PERIODS, SHORT_DECAY, SHORT_SCALE));
     longStats = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, bucketMap, LONG_BLOCK_PERIODS, LONG_DECAY, LONG_SCALE));
+    tokenFeeStats = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, bucketMap, MED_BLOCK_PERIODS, MED_DECAY, MED_SCALE));
+    tokenShortStats = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, bucketMap, SHORT_BLOCK_PERIODS, SHORT_DECAY, SHORT_SCALE));
+    tokenLongStats = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, bucketMap, LONG_BLOCK_PERIODS, LONG_DECAY, LONG_SCALE));
 }
 
 CBlockPolicyEstimator::~CBlockPolicyEstimator()
@@ -584,10 +634,19 @@ void CBlockPolicyEstimator::processTransaction(const CTxMemPoolEntry& entry, boo
     assert(bucketIndex == bucketIndex2);
     unsigned int bucketIndex3 = longStats->NewTx(txHeight, (double)feeRate.GetFeePerK());
     assert(bucketIndex == bucketIndex3);
+
+    if (IsTokenTx(entry)) {
+        mapMemPoolTxs[hash].token = true;
+        tokenFeeStats->NewTx(txHeight, (double)feeRate.GetFeePerK());
+        tokenShortStats->NewTx(txHeight, (double)feeRate.GetFeePerK());
+        tokenLongStats->NewTx(txHeight, (double)feeRate.GetFeePerK());
+    }
 }
 
 bool CBlockPolicyEstimator::processBlockTx(unsigned int nBlockHeight, const CTxMemPoolEntry* entry)
 {
+    auto pos = mapMemPoolTxs.find(entry->GetTx().GetHashMalFix());
+    const bool token = pos != mapMemPoolTxs.end() && pos->second.token;
     if (!removeTx(entry->GetTx().GetHashMalFix(), true)) {
         // This transaction wasn't being tracked for fee estimation
         return false;
@@ -610,6 +669,11 @@ bool CBlockPolicyEstimator::processBlockTx(unsigned int nBlockHeight, const CTxM
     feeStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
     shortStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
     longStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
+    if (token) {
+        tokenFeeStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
+        tokenShortStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
+        tokenLongStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
+    }
     return true;
 }
 
@@ -635,11 +699,17 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
     feeStats->ClearCurrent(nBlockHeight);
     shortStats->ClearCurrent(nBlockHeight);
     longStats->ClearCurrent(nBlockHeight);
+    tokenFeeStats->ClearCurrent(nBlockHeight);
+    tokenShortStats->ClearCurrent(nBlockHeight);
+    tokenLongStats->ClearCurrent(nBlockHeight);
 
     // Decay all exponential averages
     feeStats->UpdateMovingAverages();
     shortStats->UpdateMovingAverages();
     longStats->UpdateMovingAverages();
+    tokenFeeStats->UpdateMovingAverages();
+    tokenShortStats->UpdateMovingAverages();
+    tokenLongStats->UpdateMovingAverages();
 
     unsigned int countedTxs = 0;
     // Update averages with data points from current block
@@ -755,32 +825,35 @@ unsigned int CBlockPolicyEstimator::MaxUsableEstimate() const
  * time horizon which tracks confirmations up to the desired target.  If
  * checkShorterHorizon is requested, also allow short time horizon estimates
  * for a lower target to reduce the given answer */
-double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const
+double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, bool token, EstimationResult *result) const
 {
+    const TxConfirmStats* short_stats = token ? tokenShortStats.get() : shortStats.get();
+    const TxConfirmStats* fee_stats = token ? tokenFeeStats.get() : feeStats.get();
+    const TxConfirmStats* long_stats = token ? tokenLongStats.get() : longStats.get();
     double estimate = -1;
-    if (confTarget >= 1 && confTarget <= longStats->GetMaxConfirms()) {
+    if (confTarget >= 1 && confTarget <= long_stats->GetMaxConfirms()) {
         // Find estimate from shortest time horizon possible
-        if (confTarget <= shortStats->GetMaxConfirms()) { // short horizon
-            estimate = shortStats->EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, true, nBestSeenHeight, result);
+        if (confTarget <= short_stats->GetMaxConfirms()) { // short horizon
+            estimate = short_stats->EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, true, nBestSeenHeight, result);
         }
-        else if (confTarget <= feeStats->GetMaxConfirms()) { // medium horizon
-            estimate = feeStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, true, nBestSeenHeight, result);
+        else if (confTarget <= fee_stats->GetMaxConfirms()) { // medium horizon
+            estimate = fee_stats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, true, nBestSeenHeight, result);
         }
         else { // long horizon
-            estimate = longStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, true, nBestSeenHeight, result);
+            estimate = long_stats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, true, nBestSeenHeight, result);
         }
         if (checkShorterHorizon) {
             EstimationResult tempResult;
             // If a lower confTarget from a more recent horizon returns a lower answer use it.
-            if (confTarget > feeStats->GetMaxConfirms()) {
-                double medMax = feeStats->EstimateMedianVal(feeStats->GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, true, nBestSeenHeight, &tempResult);
+            if (confTarget > fee_stats->GetMaxConfirms()) {
+                double medMax = fee_stats->EstimateMedianVal(fee_stats->GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, true, nBestSeenHeight, &tempResult);
                 if (medMax > 0 && (estimate == -1 || medMax < estimate)) {
                     estimate = medMax;
                     if (result) *result = tempResult;
                 }
             }
-            if (confTarget > shortStats->GetMaxConfirms()) {
-                double shortMax = shortStats->EstimateMedianVal(shortStats->GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, true, nBestSeenHeight, &tempResult);
+            if (confTarget > short_stats->GetMaxConfirms()) {
+                double shortMax = short_stats->EstimateMedianVal(short_stats->GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, true, nBestSeenHeight, &tempResult);
                 if (shortMax > 0 && (estimate == -1 || shortMax < estimate)) {
                     estimate = shortMax;
                     if (result) *result = tempResult;
@@ -794,15 +867,18 @@ double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, doubl
 /** Ensure that for a conservative estimate, the DOUBLE_SUCCESS_PCT is also met
  * at 2 * target for any longer time horizons.
  */
-double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result) const
+double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget, bool token, EstimationResult *result) const
 {
+    const TxConfirmStats* short_stats = token ? tokenShortStats.get() : shortStats.get();
+    const TxConfirmStats* fee_stats = token ? tokenFeeStats.get() : feeStats.get();
+    const TxConfirmStats* long_stats = token ? tokenLongStats.get() : longStats.get();
     double estimate = -1;
     EstimationResult tempResult;
-    if (doubleTarget <= shortStats->GetMaxConfirms()) {
-        estimate = feeStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, true, nBestSeenHeight, result);
+    if (doubleTarget <= short_stats->GetMaxConfirms()) {
+        estimate = fee_stats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, true, nBestSeenHeight, result);
     }
-    if (doubleTarget <= feeStats->GetMaxConfirms()) {
-        double longEstimate = longStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, true, nBestSeenHeight, &tempResult);
+    if (doubleTarget <= fee_stats->GetMaxConfirms()) {
+        double longEstimate = long_stats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, true, nBestSeenHeight, &tempResult);
         if (longEstimate > estimate) {
             estimate = longEstimate;
             if (result) *result = tempResult;
@@ -818,11 +894,23 @@ double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget,
  * estimates, however, required the 95% threshold at 2 * target be met for any
  * longer time horizons also.
  */
-CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative, bool token) const
 {
     LOCK(cs_feeEstimator);
 
+    if (token) {
+        CFeeRate tokenRate = estimateStatsFee(confTarget, feeCalc, conservative, true);
+        if (tokenRate != CFeeRate(0)) return tokenRate;
+    }
+    return estimateStatsFee(confTarget, feeCalc, conservative, false);
+}
+
+CFeeRate CBlockPolicyEstimator::estimateStatsFee(int confTarget, FeeCalculation *feeCalc, bool conservative, bool token) const
+{
+    AssertLockHeld(cs_feeEstimator);
+
     if (feeCalc) {
+        feeCalc->token = token;
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
     }
@@ -857,13 +945,13 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
      * the purpose of conservative estimates is not to let short term
      * fluctuations lower our estimates by too much.
      */
-    double halfEst = estimateCombinedFee(confTarget/2, HALF_SUCCESS_PCT, true, &tempResult);
+    double halfEst = estimateCombinedFee(confTarget/2, HALF_SUCCESS_PCT, true, token, &tempResult);
     if (feeCalc) {
         feeCalc->est = tempResult;
         feeCalc->reason = FeeReason::HALF_ESTIMATE;
     }
     median = halfEst;
-    double actualEst = estimateCombinedFee(confTarget, SUCCESS_PCT, true, &tempResult);
+    double actualEst = estimateCombinedFee(confTarget, SUCCESS_PCT, true, token, &tempResult);
     if (actualEst > median) {
         median = actualEst;
         if (feeCalc) {
@@ -871,7 +959,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
             feeCalc->reason = FeeReason::FULL_ESTIMATE;
         }
     }
-    double doubleEst = estimateCombinedFee(2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, &tempResult);
+    double doubleEst = estimateCombinedFee(2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, token, &tempResult);
     if (doubleEst > median) {
         median = doubleEst;
         if (feeCalc) {
@@ -881,7 +969,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
     }
 
     if (conservative || median == -1) {
-        double consEst =  estimateConservativeFee(2 * confTarget, &tempResult);
+        double consEst =  estimateConservativeFee(2 * confTarget, token, &tempResult);
         if (consEst > median) {
             median = consEst;
             if (feeCalc) {
@@ -901,7 +989,7 @@ bool CBlockPolicyEstimator::Write(CAutoFile& fileout) const
 {
     try {
         LOCK(cs_feeEstimator);
-        fileout << ESTIMATOR_FILE_VERSION; // version required to read: 0.14.99 or later
+        fileout << TOKEN_ESTIMATOR_FILE_VERSION; // version required to read: 0.14.99 or later
         fileout << CLIENT_VERSION; // version that wrote the file
         fileout << nBestSeenHeight;
         if (BlockSpan() > HistoricalBlockSpan()/2) {
@@ -914,6 +1002,9 @@ bool CBlockPolicyEstimator::Write(CAutoFile& fileout) const
         feeStats->Write(fileout);
         shortStats->Write(fileout);
         longStats->Write(fileout);
+        tokenFeeStats->Write(fileout);
+        tokenShortStats->Write(fileout);
+        tokenLongStats->Write(fileout);
     }
     catch (const std::exception&) {
         LogPrintf("CBlockPolicyEstimator::Write(): unable to write policy estimator data (non-fatal)\n");
@@ -955,6 +1046,16 @@ bool CBlockPolicyEstimator::Read(CAutoFile& filein)
             fileShortStats->Read(filein, nVersionThatWrote, numBuckets);
             fileLongStats->Read(filein, nVersionThatWrote, numBuckets);
 
+            std::unique_ptr<TxConfirmStats> fileTokenFeeStats, fileTokenShortStats, fileTokenLongStats;
+            if (nVersionRequired >= TOKEN_ESTIMATOR_FILE_VERSION) {
+                fileTokenFeeStats.reset(new TxConfirmStats(buckets, bucketMap, MED_BLOCK_PERIODS, MED_DECAY, MED_SCALE));
+                fileTokenShortStats.reset(new TxConfirmStats(buckets, bucketMap, SHORT_BLOCK_PERIODS, SHORT_DECAY, SHORT_SCALE));
+                fileTokenLongStats.reset(new TxConfirmStats(buckets, bucketMap, LONG_BLOCK_PERIODS, LONG_DECAY, LONG_SCALE));
+                fileTokenFeeStats->Read(filein, nVersionThatWrote, numBuckets);
+                fileTokenShortStats->Read(filein, nVersionThatWrote, numBuckets);
+                fileTokenLongStats->Read(filein, nVersionThatWrote, numBuckets);
+            }
+
             // Fee estimates file parsed correctly
             // Copy buckets from file and refresh our bucketmap
             buckets = fileBuckets;
@@ -963,10 +1064,20 @@ bool CBlockPolicyEstimator::Read(CAutoFile& filein)
                 bucketMap[buckets[i]] = i;
             }
 
+            // Older files have no token stats, which then start out empty
+            if (!fileTokenFeeStats) {
+                fileTokenFeeStats.reset(new TxConfirmStats(buckets, bucketMap, MED_BLOCK_PERIODS, MED_DECAY, MED_SCALE));
+                fileTokenShortStats.reset(new TxConfirmStats(buckets, bucketMap, SHORT_BLOCK_PERIODS, SHORT_DECAY, SHORT_SCALE));
+                fileTokenLongStats.reset(new TxConfirmStats(buckets, bucketMap, LONG_BLOCK_PERIODS, LONG_DECAY, LONG_SCALE));
+            }
+
             // Destroy old TxConfirmStats and point to new ones that already reference buckets and bucketMap
             feeStats = std::move(fileFeeStats);
             shortStats = std::move(fileShortStats);
             longStats = std::move(fileLongStats);
+            tokenFeeStats = std::move(fileTokenFeeStats);
+            tokenShortStats = std::move(fileTokenShortStats);
+            tokenLongStats = std::move(fileTokenLongStats);
 
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
@@ -74,6 +74,12 @@ class TxConfirmStats;
  */
 const int ESTIMATOR_FILE_VERSION = 1000000;
 
+/* Files written with this version or later carry the token-bearing
+ * transaction stats after the aggregate ones. Readers that only know
+ * ESTIMATOR_FILE_VERSION stop before them, so the file stays readable there.
+ */
+const int TOKEN_ESTIMATOR_FILE_VERSION = 1000100;
+
 /* Identifier for each of the 3 different TxConfirmStats which will track
  * history over different time horizons. */
 enum class FeeEstimateHorizon {
@@ -135,12 +141,18 @@ struct FeeCalculation
     FeeReason reason = FeeReason::NONE;
     int desiredTarget = 0;
     int returnedTarget = 0;
+    //! whether the estimate came from the token-bearing transaction stats
+    bool token = false;
 };
 
 /**
  *  We want to be able to estimate feerates that are needed on tx's to be included in
  * a certain number of blocks.  Every time a block is added to the best chain, this class records
  * stats on the transactions included in that block
+ *
+ * Transactions with a colored input or output are also tracked in a second
+ * set of stats, since their size profile and token fee requirements differ from
+ * plain TPC transfers and would otherwise be hidden by them.
  */
 class CBlockPolicyEstimator
 {
@@ -214,9 +226,11 @@ public:
     /** Estimate feerate needed to get be included in a block within confTarget
      *  blocks. If no answer can be given at confTarget, return an estimate at
      *  the closest target where one can be given.  'conservative' estimates are
-     *  valid over longer time horizons also.
+     *  valid over longer time horizons also. 'token' estimates are based on
+     *  transactions with colored inputs or outputs only, and fall back to all
+     *  transactions when there is not enough token data yet.
      */
-    CFeeRate estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const;
+    CFeeRate estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative, bool token = false) const;
 
     /** Return a specific fee estimate calculation with a given success
      * threshold and time horizon, and optionally return detailed data about
@@ -246,7 +260,8 @@ private:
     {
         unsigned int blockHeight;
         unsigned int bucketIndex;
-        TxStatsInfo() : blockHeight(0), bucketIndex(0) {}
+        bool token;
+        TxStatsInfo() : blockHeight(0), bucketIndex(0), token(false) {}
     };
 
     // map of txids to information about that transaction
@@ -256,6 +271,10 @@ private:
     std::unique_ptr<TxConfirmStats> feeStats;
     std::unique_ptr<TxConfirmStats> shortStats;
     std::unique_ptr<TxConfirmStats> longStats;
+    /** Same for transactions with colored inputs or outputs only */
+    std::unique_ptr<TxConfirmStats> tokenFeeStats;
+    std::unique_ptr<TxConfirmStats> tokenShortStats;
+    std::unique_ptr<TxConfirmStats> tokenLongStats;
 
     unsigned int trackedTxs;
     unsigned int untrackedTxs;
@@ -269,9 +288,11 @@ private:
     bool processBlockTx(unsigned int nBlockHeight, const CTxMemPoolEntry* entry);
 
     /** Helper for estimateSmartFee */
-    double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const;
+    CFeeRate estimateStatsFee(int confTarget, FeeCalculation *feeCalc, bool conservative, bool token) const;
+    /** Helper for estimateSmartFee */
+    double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, bool token, EstimationResult *result) const;
     /** Helper for estimateSmartFee */
-    double estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result) const;
+    double estimateConservativeFee(unsigned int doubleTarget, bool token, EstimationResult *result) const;
     /** Number of blocks of data recorded while fee estimates have been running */
     unsigned int BlockSpan() const;
     /** Number of blocks of recorded fee estimate data represented in saved data file */
@@ -3,16 +3,25 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <core_io.h>
 #include <policy/packages.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
+#include <rpc/server.h>
 #include <txmempool.h>
 #include <validation.h>
 #include <validationinterface.h>
+#include <workerpool.h>
 #include <uint256.h>
+#include <util.h>
 #include <numeric>
 #include <net_processing.h>
 
+#include <functional>
+#include <map>
+#include <queue>
+#include <set>
+
 
 bool CheckPackage(const Package& txns, CValidationState& state)
 {
@@ -122,4 +131,115 @@ bool SubmitPackageToMempool(const Package& package,
 
     }
     return ArePackageTransactionsAccepted(results);
-}
\ No newline at end of file
+}
+std::vector<CTransactionRef> DecodeTransactionBatch(const std::vector<std::string>& hex_txs)
+{
+    std::vector<CTransactionRef> txns(hex_txs.size());
+    const size_t max_threads = std::min<size_t>(std::max(GetNumCores(), 1), hex_txs.size() / BATCH_DECODE_PER_THREAD + 1);
+    g_rpc_workers.ForEach(hex_txs.size(), max_threads, [&](size_t i) {
+        CMutableTransaction mtx;
+        if (DecodeHexTx(mtx, hex_txs[i]))
+            txns[i] = MakeTransactionRef(std::move(mtx));
+    });
+    return txns;
+}
+
+std::vector<size_t> SortBatchByDependency(const std::vector<CTransactionRef>& txns)
+{
+    // Kahn's algorithm, always taking the lowest ready index so that
+    // unrelated transactions stay in the order they were given.
+    std::map<uint256, size_t> index_of;
+    for (size_t i = 0; i < txns.size(); ++i) {
+        if (txns[i]) index_of.emplace(txns[i]->GetHashMalFix(), i);
+    }
+
+    std::vector<std::vector<size_t>> children(txns.size());
+    std::vector<size_t> num_parents(txns.size(), 0);
+    for (size_t i = 0; i < txns.size(); ++i) {
+        if (!txns[i]) continue;
+        std::set<size_t> parents;
+        for (const CTxIn& txin : txns[i]->vin) {
+            auto it = index_of.find(txin.prevout.hashMalFix);
+            if (it != index_of.end() && it->second != i) parents.insert(it->second);
+        }
+        for (size_t parent : parents) {
+            children[parent].push_back(i);
+        }
+        num_parents[i] = parents.size();
+    }
+
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ready;
+    for (size_t i = 0; i < txns.size(); ++i) {
+        if (num_parents[i] == 0) ready.push(i);
+    }
+
+    std::vector<size_t> order;
+    order.reserve(txns.size());
+    while (!ready.empty()) {
+        const size_t i = ready.top();
+        ready.pop();
+        order.push_back(i);
+        for (size_t child : children[i]) {
+            if (--num_parents[child] == 0) ready.push(child);
+        }
+    }
+
+    // A dependency cycle cannot be built from valid txids; whatever is left
+    // keeps its place at the end and is rejected for missing inputs.
+    if (order.size() < txns.size()) {
+        for (size_t i = 0; i < txns.size(); ++i) {
+            if (num_parents[i] > 0) order.push_back(i);
+        }
+    }
+    return order;
+}
+
+std::vector<BatchTxResult> SubmitTransactionBatch(const std::vector<CTransactionRef>& txns, CAmount nAbsurdFee)
+{
+    std::vector<BatchTxResult> results(txns.size());
+    const std::vector<size_t> order = SortBatchByDependency(txns);
+
+    std::vector<CTransactionRef> sorted;
+    sorted.reserve(txns.size());
+    for (size_t i : order) {
+        if (txns[i]) {
+            sorted.push_back(txns[i]);
+            results[i].txid = txns[i]->GetHashMalFix();
+        } else {
+            results[i].state.Invalid(false, REJECT_INVALID, "tx-decode-failed");
+        }
+    }
+
+    PreCheckMempoolTransactions(sorted);
+
+    std::vector<CTransactionRef> accepted;
+    for (size_t chunk_start = 0; chunk_start < order.size(); chunk_start += BATCH_ADMISSION_CHUNK) {
+        const size_t chunk_end = std::min(order.size(), chunk_start + BATCH_ADMISSION_CHUNK);
+        LOCK(cs_main);
+        for (size_t pos = chunk_start; pos < chunk_end; ++pos) {
+            const CTransactionRef& tx = txns[order[pos]];
+            BatchTxResult& result = results[order[pos]];
+            if (!tx) continue;
+            if (mempool.exists(result.txid)) {
+                result.accepted = true;
+                continue;
+            }
+            CTxMempoolAcceptanceOptions opt;
+            opt.nAbsurdFee = nAbsurdFee;
+            if (AcceptToMemoryPool(tx, opt)) {
+                result.accepted = true;
+                accepted.push_back(tx);
+            } else {
+                result.state = opt.state;
+                result.state.missingInputs = opt.missingInputs.size() > 0;
+            }
+        }
+    }
+
+    if (g_connman) {
+        for (const CTransactionRef& tx : accepted) {
+            RelayTransaction(*tx, g_connman.get());
+        }
+    }
+    return results;
+}
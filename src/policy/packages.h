@@ -12,6 +12,7 @@
 #include <primitives/transaction.h>
 #include <validation.h>
 #include <cstdint>
+#include <string>
 #include <vector>
 
 /** Default maximum number of transactions in a package. */
@@ -71,4 +72,52 @@ bool SubmitPackageToMempool(const Package& package,
  */
 bool ArePackageTransactionsAccepted(const PackageValidationState& results);
 
+/** Maximum number of transactions in a batch given to sendrawtransactions. */
+static constexpr uint32_t MAX_BATCH_COUNT{10000};
+/** Number of batch transactions admitted to the mempool per cs_main acquisition. */
+static constexpr size_t BATCH_ADMISSION_CHUNK{500};
+/** Minimum number of hex transactions decoded per thread by DecodeTransactionBatch(). */
+static constexpr size_t BATCH_DECODE_PER_THREAD{250};
+
+/** Outcome of one transaction submitted with SubmitTransactionBatch(). */
+struct BatchTxResult {
+    //! Hash of the transaction, null if it could not be decoded
+    uint256 txid;
+    //! Whether the transaction is in the mempool now, including when it already was
+    bool accepted{false};
+    //! Rejection state when not accepted; missingInputs is set for orphans
+    CValidationState state;
+};
+
+/**
+ * Decode a list of hex-encoded transactions, spreading the work over
+ * the RPC worker threads when the list is long. The entries of transactions that
+ * fail to decode are null.
+ */
+std::vector<CTransactionRef> DecodeTransactionBatch(const std::vector<std::string>& hex_txs);
+
+/**
+ * Order a batch so that every transaction comes after the transactions of the
+ * batch whose outputs it spends. Unrelated transactions keep their relative
+ * order. Returns indexes into txns.
+ */
+std::vector<size_t> SortBatchByDependency(const std::vector<CTransactionRef>& txns);
+
+/**
+ * SubmitTransactionBatch adds a batch of independent or chained transactions
+ * to the mempool and relays those accepted. Unlike a package, the batch may
+ * be large and in any order, and each transaction is accepted or rejected on
+ * its own; a transaction spending a rejected one ends with missing inputs.
+ *
+ * The scripts of the whole batch are verified on the mempool script check
+ * threads before cs_main is taken (see PreCheckMempoolTransactions()). The
+ * transactions are then admitted in dependency order, taking cs_main once
+ * per BATCH_ADMISSION_CHUNK transactions.
+ *
+ * @param txns The transactions; null entries are reported as undecodable.
+ * @param nAbsurdFee Reject transactions paying more than this fee, 0 to allow any fee.
+ * @return One result per transaction, in the order of txns.
+ */
+std::vector<BatchTxResult> SubmitTransactionBatch(const std::vector<CTransactionRef>& txns, CAmount nAbsurdFee) LOCKS_EXCLUDED(cs_main);
+
 #endif // TAPYRUS_POLICY_PACKAGES_H
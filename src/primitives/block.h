@@ -10,6 +10,7 @@
 #include <primitives/transaction.h>
 #include <primitives/xfield.h>
 #include <serialize.h>
+#include <support/allocators/arena.h>
 #include <uint256.h>
 #include <key.h>
 
@@ -158,6 +159,35 @@ public:
     uint32_t GetHeight() const;
 };
 
+//! Room reserved in a block's arena per transaction, for it and its reference counts
+static const size_t BLOCK_ARENA_BYTES_PER_TX = sizeof(CTransaction) + 64;
+//! Largest chunk a block's arena is started with, however many transactions it claims to have
+static const size_t MAX_BLOCK_ARENA_CHUNK_SIZE = 1 << 20;
+
+/**
+ * Read a block like operator>> does, with its transactions and their
+ * reference counts allocated in one arena instead of one heap allocation
+ * each. Their inputs, outputs and scripts are allocated as usual.
+ *
+ * The arena is freed with the last of the transactions, so this is for
+ * blocks whose transactions are not kept after the block is used: a single
+ * transaction kept holds the memory of all others.
+ */
+template <typename Stream>
+void UnserializeBlockInArena(Stream& s, CBlock& block)
+{
+    block.SetNull();
+    s >> static_cast<CBlockHeader&>(block);
+    const uint64_t n_tx = ReadCompactSize(s);
+    auto arena = std::make_shared<MonotonicArena>(std::min<uint64_t>(n_tx * BLOCK_ARENA_BYTES_PER_TX, MAX_BLOCK_ARENA_CHUNK_SIZE));
+    const arena_allocator<CTransaction> alloc(arena);
+    // Limit the reservation so a bogus count won't cause out of memory
+    block.vtx.reserve(std::min<uint64_t>(n_tx, 5000000 / sizeof(CTransactionRef)));
+    for (uint64_t i = 0; i < n_tx; ++i) {
+        block.vtx.push_back(std::allocate_shared<const CTransaction>(alloc, deserialize, s));
+    }
+}
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
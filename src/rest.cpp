@@ -6,24 +6,38 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <index/addressindex.h>
 #include <index/txindex.h>
+#include <policy/packages.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <validation.h>
 #include <httpserver.h>
+#include <jsonwriter.h>
 #include <rpc/blockchain.h>
+#include <rpc/mempool.h>
 #include <rpc/server.h>
 #include <streams.h>
 #include <sync.h>
 #include <txmempool.h>
+#include <util.h>
 #include <utilstrencodings.h>
 #include <version.h>
+#include <workerpool.h>
 
 #include <boost/algorithm/string.hpp>
 
 #include <univalue.h>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+//! Largest number of txids in one /rest/batch request
+static const size_t MAX_BATCH_LOOKUPS = 10000;
+//! Largest number of outpoints in one /rest/batch request, each of which may be a database read
+static const size_t MAX_BATCH_UTXO_LOOKUPS = 1000;
+//! Lookups of a batch per read thread; smaller batches use fewer threads
+static const size_t BATCH_LOOKUPS_PER_THREAD = 250;
+//! Most threads reading for one batch request
+static const size_t MAX_BATCH_READ_THREADS = 8;
 
 enum class RetFormat {
     UNDEF,
@@ -220,7 +234,7 @@ static bool rest_block(HTTPRequest* req,
         if (IsBlockPruned(pblockindex))
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-        if (!ReadBlockFromDisk(block, pblockindex))
+        if (!ReadBlockFromDisk(block, pblockindex, true, true))
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
 
@@ -243,12 +257,13 @@ static bool rest_block(HTTPRequest* req,
     }
 
     case RetFormat::JSON: {
-        UniValue objBlock;
+        std::string strJSON;
         {
             LOCK(cs_main);
-            objBlock = blockToJSON(block, pblockindex, showTxDetails);
+            JSONWriter writer(strJSON);
+            blockToJSON(block, pblockindex, showTxDetails, writer);
         }
-        std::string strJSON = objBlock.write() + "\n";
+        strJSON += "\n";
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strJSON);
         return true;
@@ -325,19 +340,129 @@ static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPar
     std::string param;
     const RetFormat rf = ParseDataFormat(param, strURIPart);
 
+    // An optional page, /rest/mempool/contents/<count>[/<cursor>].<ext>
+    const bool paged = !param.empty();
+    uint64_t count = std::numeric_limits<uint64_t>::max();
+    MempoolCursor cursor;
+    bool has_cursor = false;
+    if (paged) {
+        std::vector<std::string> path;
+        boost::split(path, param, boost::is_any_of("/"));
+        has_cursor = path.size() == 3;
+        if ((path.size() != 2 && !has_cursor) || !path[0].empty() || !ParseUInt64(path[1], &count) || count == 0 ||
+            (has_cursor && !cursor.SetString(path[2])))
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid page. Use /rest/mempool/contents/<count>[/<cursor>].<ext>.");
+    }
+
+    if (rf != RetFormat::BINARY && rf != RetFormat::HEX && rf != RetFormat::JSON)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    // Only the copying is done under mempool.cs, the reply is built afterwards.
+    const MempoolSnapshot snapshot = SnapshotMempool(has_cursor ? &cursor : nullptr, count);
+
     switch (rf) {
-    case RetFormat::JSON: {
-        UniValue mempoolObject = mempoolToJSON(true);
+    case RetFormat::BINARY:
+    case RetFormat::HEX: {
+        CDataStream ssMempool(SER_NETWORK, PROTOCOL_VERSION);
+        ssMempool << snapshot.total << snapshot.mempool_sequence << snapshot.entries;
 
-        std::string strJSON = mempoolObject.write() + "\n";
+        if (rf == RetFormat::BINARY) {
+            std::string strBinary = ssMempool.str();
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, strBinary);
+        } else {
+            std::string strHex = HexStr(ssMempool.begin(), ssMempool.end()) + "\n";
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, strHex);
+        }
+        return true;
+    }
+    default: {
+        // Write the entries one at a time instead of building one UniValue
+        // holding all of them; the result is the same as mempoolToJSON(true),
+        // or mempoolPageToJSON(true, ...) for a page.
+        std::string strJSON = paged ? "{\"transactions\":{" : "{";
+        bool first = true;
+        for (const MempoolEntrySnapshot& e : snapshot.entries) {
+            UniValue info(UniValue::VOBJ);
+            MempoolEntryToJSON(info, e);
+            if (!first) strJSON += ',';
+            first = false;
+            strJSON += '"' + e.txid.ToString() + "\":";
+            strJSON += info.write();
+        }
+        strJSON += "}";
+        if (paged) {
+            MempoolCursor next;
+            if (!snapshot.entries.empty()) {
+                next.entry_sequence = snapshot.entries.back().entry_sequence;
+            }
+            strJSON += ",\"mempool_sequence\":" + UniValue(snapshot.mempool_sequence).write();
+            strJSON += ",\"next\":" + (snapshot.more ? UniValue(next.ToString()) : NullUniValue).write() + "}";
+        }
+        strJSON += "\n";
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strJSON);
         return true;
     }
-    default: {
-        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
     }
+}
+
+/** Reply to /rest/address/history/ or, if utxos is set, /rest/address/utxos/ */
+static bool rest_address(HTTPRequest* req, const std::string& strURIPart, bool utxos)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+
+    // <address>.json with an optional page, <address>/<skip>/<count>.json
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+    uint64_t skip = 0;
+    uint64_t count = 1000;
+    if ((path.size() != 1 && path.size() != 3) ||
+        (path.size() == 3 && (!ParseUInt64(path[1], &skip) || !ParseUInt64(path[2], &count))))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/address/<history|utxos>/<address>[/<skip>/<count>].json");
+    if (count > MAX_ADDRESS_INDEX_COUNT)
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Count larger than %u", MAX_ADDRESS_INDEX_COUNT));
+
+    CScript script;
+    if (!ParseAddressOrScript(path[0], script))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address or script: " + path[0]);
+
+    if (rf != RetFormat::JSON)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+
+    if (!g_addressindex)
+        return RESTERR(req, HTTP_NOT_FOUND, "Address index not enabled (use -addressindex)");
+    g_addressindex->BlockUntilSyncedToCurrentChain();
+
+    std::vector<AddressIndexEntry> entries;
+    const bool found = utxos ? g_addressindex->FindUnspent(script, skip, count, entries)
+                             : g_addressindex->FindHistory(script, skip, count, entries);
+    if (!found)
+        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Failed to read the address index");
+
+    std::string strJSON = "[";
+    for (const AddressIndexEntry& entry : entries) {
+        if (strJSON.size() > 1) strJSON += ',';
+        strJSON += AddressIndexEntryToJSON(entry).write();
     }
+    strJSON += "]\n";
+    req->WriteHeader("Content-Type", "application/json");
+    req->WriteReply(HTTP_OK, strJSON);
+    return true;
+}
+
+static bool rest_address_history(HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_address(req, strURIPart, false);
+}
+
+static bool rest_address_utxos(HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_address(req, strURIPart, true);
 }
 
 static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
@@ -379,9 +504,10 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
     }
 
     case RetFormat::JSON: {
-        UniValue objTx(UniValue::VOBJ);
-        TxToUniv(*tx, hashBlock, objTx);
-        std::string strJSON = objTx.write() + "\n";
+        std::string strJSON;
+        JSONWriter writer(strJSON);
+        WriteTxJSON(*tx, hashBlock, writer);
+        strJSON += "\n";
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strJSON);
         return true;
@@ -490,6 +616,8 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     std::vector<CCoin> outs;
     std::string bitmapStringRepresentation;
     std::vector<bool> hits;
+    // the tip the coins were looked up at, taken while cs_main is held
+    std::shared_ptr<const ChainTipSnapshot> tip;
     bitmap.resize((vOutPoints.size() + 7) / 8);
     {
         auto process_utxos = [&vOutPoints, &outs, &hits](const CCoinsView& view, const CTxMemPool& mempool) {
@@ -507,9 +635,11 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
             CCoinsViewCache& viewChain = *pcoinsTip;
             CCoinsViewMemPool viewMempool(&viewChain, mempool);
             process_utxos(viewMempool, mempool);
+            tip = GetChainTipSnapshot();
         } else {
             LOCK(cs_main);  // no need to lock mempool!
             process_utxos(*pcoinsTip, CTxMemPool());
+            tip = GetChainTipSnapshot();
         }
 
         for (size_t i = 0; i < hits.size(); ++i) {
@@ -524,7 +654,7 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
         // serialize data
         // use exact same output as mentioned in Bip64
         CDataStream ssGetUTXOResponse(SER_NETWORK, PROTOCOL_VERSION);
-        ssGetUTXOResponse << chainActive.Height() << chainActive.Tip()->GetBlockHash() << bitmap << outs;
+        ssGetUTXOResponse << tip->height << tip->hash << bitmap << outs;
         std::string ssGetUTXOResponseString = ssGetUTXOResponse.str();
 
         req->WriteHeader("Content-Type", "application/octet-stream");
@@ -534,7 +664,7 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
 
     case RetFormat::HEX: {
         CDataStream ssGetUTXOResponse(SER_NETWORK, PROTOCOL_VERSION);
-        ssGetUTXOResponse << chainActive.Height() << chainActive.Tip()->GetBlockHash() << bitmap << outs;
+        ssGetUTXOResponse << tip->height << tip->hash << bitmap << outs;
         std::string strHex = HexStr(ssGetUTXOResponse.begin(), ssGetUTXOResponse.end()) + "\n";
 
         req->WriteHeader("Content-Type", "text/plain");
@@ -547,8 +677,8 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
 
         // pack in some essentials
         // use more or less the same output as mentioned in Bip64
-        objGetUTXOResponse.pushKV("chainHeight", chainActive.Height());
-        objGetUTXOResponse.pushKV("chaintipHash", chainActive.Tip()->GetBlockHash().GetHex());
+        objGetUTXOResponse.pushKV("chainHeight", tip->height);
+        objGetUTXOResponse.pushKV("chaintipHash", tip->hash.GetHex());
         objGetUTXOResponse.pushKV("bitmap", bitmapStringRepresentation);
 
         UniValue utxos(UniValue::VARR);
@@ -579,24 +709,256 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     }
 }
 
+static bool rest_sendtxs(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    if (req->GetRequestMethod() != HTTPRequest::POST)
+        return RESTERR(req, HTTP_BAD_METHOD, "Transactions must be POSTed");
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!param.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/sendtxs.<bin|hex|json>");
+
+    std::string strRequest = req->ReadBody();
+    if (strRequest.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+
+    // input-format: .bin is a serialized vector of transactions, .hex the same
+    // hex-encoded and .json an array of hex-encoded transactions; the result
+    // is JSON in every case.
+    std::vector<CTransactionRef> txns;
+    switch (rf) {
+    case RetFormat::HEX: {
+        // convert hex to bin, continue then with bin part
+        std::vector<unsigned char> strRequestV = ParseHex(strRequest);
+        strRequest.assign(strRequestV.begin(), strRequestV.end());
+    }
+
+    case RetFormat::BINARY: {
+        try {
+            CDataStream ssTxs(strRequest.data(), strRequest.data() + strRequest.size(), SER_NETWORK, PROTOCOL_VERSION);
+            ssTxs >> txns;
+            if (!ssTxs.empty())
+                return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        } catch (const std::ios_base::failure& e) {
+            // abort in case of unreadable binary data
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+        break;
+    }
+
+    case RetFormat::JSON: {
+        UniValue raw_transactions;
+        if (!raw_transactions.read(strRequest) || !raw_transactions.isArray())
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        std::vector<std::string> hex_txs;
+        for (const UniValue& rawtx : raw_transactions.getValues()) {
+            if (!rawtx.isStr())
+                return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+            hex_txs.push_back(rawtx.get_str());
+        }
+        if (hex_txs.size() > MAX_BATCH_COUNT)
+            return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max transactions exceeded (max: %d, tried: %d)", MAX_BATCH_COUNT, hex_txs.size()));
+        txns = DecodeTransactionBatch(hex_txs);
+        break;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    if (txns.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    if (txns.size() > MAX_BATCH_COUNT)
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max transactions exceeded (max: %d, tried: %d)", MAX_BATCH_COUNT, txns.size()));
+
+    const std::vector<BatchTxResult> results = SubmitTransactionBatch(txns, ::maxTxFee);
+
+    std::string strJSON = BatchResultsToJSON(results).write() + "\n";
+    req->WriteHeader("Content-Type", "application/json");
+    req->WriteReply(HTTP_OK, strJSON);
+    return true;
+}
+
+/** Call read(i) for every i below count, on several threads if count is large. */
+static void ParallelBatchRead(size_t count, const std::function<void(size_t)>& read)
+{
+    g_rpc_workers.ForEach(count, std::min(MAX_BATCH_READ_THREADS, count / BATCH_LOOKUPS_PER_THREAD + 1), read);
+}
+
+/** Check that a batch request was POSTed to /rest/batch/<name>.bin and read its body. */
+static bool ReadBatchBody(HTTPRequest* req, const std::string& strURIPart, const std::string& name, std::string& body)
+{
+    if (!CheckWarmup(req))
+        return false;
+    if (req->GetRequestMethod() != HTTPRequest::POST)
+        return RESTERR(req, HTTP_BAD_METHOD, "Batch requests must be POSTed");
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!param.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/batch/" + name + ".bin");
+    if (rf != RetFormat::BINARY)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin)");
+
+    body = req->ReadBody();
+    if (body.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    return true;
+}
+
+static void WriteBatchReply(HTTPRequest* req, const CDataStream& ssReply)
+{
+    std::string strBinary = ssReply.str();
+    req->WriteHeader("Content-Type", "application/octet-stream");
+    req->WriteReply(HTTP_OK, strBinary);
+}
+
+static bool rest_batch_utxos(HTTPRequest* req, const std::string& strURIPart)
+{
+    std::string strRequest;
+    if (!ReadBatchBody(req, strURIPart, "utxos", strRequest))
+        return false;
+
+    bool fCheckMemPool;
+    std::vector<COutPoint> vOutPoints;
+    try {
+        CDataStream ssRequest(strRequest.data(), strRequest.data() + strRequest.size(), SER_NETWORK, PROTOCOL_VERSION);
+        ssRequest >> fCheckMemPool >> vOutPoints;
+        if (!ssRequest.empty())
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+    } catch (const std::ios_base::failure& e) {
+        // abort in case of unreadable binary data
+        return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+    }
+    if (vOutPoints.size() > MAX_BATCH_UTXO_LOOKUPS)
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max outpoints exceeded (max: %d, tried: %d)", MAX_BATCH_UTXO_LOOKUPS, vOutPoints.size()));
+
+    // One serialized CCoin per outpoint, empty when it is not unspent.
+    std::vector<std::string> entries(vOutPoints.size());
+    auto set_coin = [&entries](size_t i, Coin&& coin) {
+        CDataStream ssCoin(SER_NETWORK, PROTOCOL_VERSION);
+        ssCoin << CCoin(std::move(coin));
+        entries[i] = ssCoin.str();
+    };
+
+    std::shared_ptr<const ChainTipSnapshot> tip;
+    // The coins the cache does not have are read from a snapshot of the
+    // database taken with them, so that they are as of tip too while cs_main
+    // is released for the reads.
+    std::unique_ptr<CDBSnapshot> db_snapshot;
+    std::vector<size_t> uncached;
+    {
+        LOCK(cs_main);
+        tip = GetChainTipSnapshot();
+        db_snapshot = pcoinsdbview->GetSnapshot();
+
+        // Answer what the mempool and the coins cache know right away and
+        // leave the rest to the database reads below.
+        {
+            LOCK(mempool.cs);
+            for (size_t i = 0; i < vOutPoints.size(); ++i) {
+                const COutPoint& outpoint = vOutPoints[i];
+                if (fCheckMemPool) {
+                    if (mempool.isSpent(outpoint)) continue;
+                    CTransactionRef ptx = mempool.get(outpoint.hashMalFix);
+                    if (ptx) {
+                        if (outpoint.n < ptx->vout.size()) set_coin(i, Coin(ptx->vout[outpoint.n], MEMPOOL_HEIGHT, false));
+                        continue;
+                    }
+                }
+                Coin coin;
+                if (pcoinsTip->PeekCoin(outpoint, coin)) {
+                    if (!coin.IsSpent()) set_coin(i, std::move(coin));
+                } else {
+                    uncached.push_back(i);
+                }
+            }
+        }
+
+    }
+
+    ParallelBatchRead(uncached.size(), [&](size_t j) {
+        Coin coin;
+        if (pcoinsdbview->GetCoin(*db_snapshot, vOutPoints[uncached[j]], coin)) set_coin(uncached[j], std::move(coin));
+    });
+
+    CDataStream ssReply(SER_NETWORK, PROTOCOL_VERSION);
+    ssReply << tip->height << tip->hash << entries;
+    WriteBatchReply(req, ssReply);
+    return true;
+}
+
+static bool rest_batch_txs(HTTPRequest* req, const std::string& strURIPart)
+{
+    std::string strRequest;
+    if (!ReadBatchBody(req, strURIPart, "txs", strRequest))
+        return false;
+
+    std::vector<uint256> txids;
+    try {
+        CDataStream ssRequest(strRequest.data(), strRequest.data() + strRequest.size(), SER_NETWORK, PROTOCOL_VERSION);
+        ssRequest >> txids;
+        if (!ssRequest.empty())
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+    } catch (const std::ios_base::failure& e) {
+        // abort in case of unreadable binary data
+        return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+    }
+    if (txids.size() > MAX_BATCH_LOOKUPS)
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max txids exceeded (max: %d, tried: %d)", MAX_BATCH_LOOKUPS, txids.size()));
+
+    if (g_txindex) {
+        g_txindex->BlockUntilSyncedToCurrentChain();
+    }
+
+    // One serialized block hash and transaction per txid, empty when it is
+    // unknown. The mempool and the txindex are thread safe on their own, so
+    // unlike GetTransaction() the reads do not hold cs_main.
+    const int serialize_flags = RPCSerializationFlags();
+    std::vector<std::string> entries(txids.size());
+    ParallelBatchRead(txids.size(), [&](size_t i) {
+        uint256 hashBlock;
+        CTransactionRef tx = mempool.get(txids[i]);
+        if (!tx && !(g_txindex && g_txindex->FindTx(txids[i], hashBlock, tx))) return;
+        CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION | serialize_flags);
+        ssTx << hashBlock << tx;
+        entries[i] = ssTx.str();
+    });
+
+    CDataStream ssReply(SER_NETWORK, PROTOCOL_VERSION);
+    ssReply << entries;
+    WriteBatchReply(req, ssReply);
+    return true;
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
+    HTTPWorkClass work_class;
 } uri_prefixes[] = {
-      {"/rest/tx/", rest_tx},
-      {"/rest/block/notxdetails/", rest_block_notxdetails},
-      {"/rest/block/", rest_block_extended},
-      {"/rest/chaininfo", rest_chaininfo},
-      {"/rest/mempool/info", rest_mempool_info},
-      {"/rest/mempool/contents", rest_mempool_contents},
-      {"/rest/headers/", rest_headers},
-      {"/rest/getutxos", rest_getutxos},
+      {"/rest/tx/", rest_tx, HTTPWorkClass::DEFAULT},
+      {"/rest/block/notxdetails/", rest_block_notxdetails, HTTPWorkClass::DEFAULT},
+      {"/rest/block/", rest_block_extended, HTTPWorkClass::DEFAULT},
+      {"/rest/chaininfo", rest_chaininfo, HTTPWorkClass::FAST},
+      {"/rest/mempool/info", rest_mempool_info, HTTPWorkClass::FAST},
+      {"/rest/mempool/contents", rest_mempool_contents, HTTPWorkClass::DEFAULT},
+      {"/rest/headers/", rest_headers, HTTPWorkClass::DEFAULT},
+      {"/rest/getutxos", rest_getutxos, HTTPWorkClass::DEFAULT},
+      {"/rest/sendtxs", rest_sendtxs, HTTPWorkClass::DEFAULT},
+      {"/rest/address/history/", rest_address_history, HTTPWorkClass::DEFAULT},
+      {"/rest/address/utxos/", rest_address_utxos, HTTPWorkClass::HEAVY},
+      {"/rest/batch/utxos", rest_batch_utxos, HTTPWorkClass::HEAVY},
+      {"/rest/batch/txs", rest_batch_txs, HTTPWorkClass::HEAVY},
 };
 
 bool StartREST()
 {
-    for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++)
-        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler);
+    for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++) {
+        const HTTPWorkClass work_class = uri_prefixes[i].work_class;
+        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler,
+                            [work_class](HTTPRequest*, const std::string&) { return work_class; });
+    }
     return true;
 }
 
@@ -12,16 +12,21 @@
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <coins.h>
+#include <core_memusage.h>
 #include <consensus/validation.h>
 #include <validation.h>
 #include <core_io.h>
+#include <index/addressindex.h>
+#include <index/blockstatsindex.h>
 #include <index/txindex.h>
+#include <jsonwriter.h>
 #include <key_io.h>
 #include <policy/feerate.h>
 #include <policy/packages.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
 #include <primitives/xfield.h>
+#include <random.h>
 #include <rpc/server.h>
 #include <script/descriptor.h>
 #include <shutdown.h>
@@ -29,12 +34,14 @@
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <undo.h>
 #include <util.h>
 #include <utilstrencodings.h>
 #include <utxo_snapshot.h>
 #include <hash.h>
 #include <validationinterface.h>
 #include <warnings.h>
+#include <workerpool.h>
 #include <xfieldhistory.h>
 
 #include <assert.h>
@@ -44,9 +51,15 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
+#include <unordered_map>
 
 struct CUpdatedBlock
 {
@@ -130,6 +143,73 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     return result;
 }
 
+void blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, JSONWriter& writer)
+{
+    AssertLockHeld(cs_main);
+    writer.BeginObject();
+    writer.Key("hash");
+    writer.Hash(blockindex->GetBlockHash());
+    int confirmations = -1;
+    // Only report confirmations if the block is on the prod chain
+    if (chainActive.Contains(blockindex))
+        confirmations = chainActive.Height() - blockindex->nHeight + 1;
+    writer.Key("confirmations");
+    writer.Int(confirmations);
+    writer.Key("size");
+    writer.Int((int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+    writer.Key("height");
+    writer.Int(blockindex->nHeight);
+    writer.Key("features");
+    writer.Int(block.nFeatures);
+    writer.Key("featuresHex");
+    writer.PlainString(strprintf("%08x", block.nFeatures));
+    writer.Key("merkleroot");
+    writer.Hash(block.hashMerkleRoot);
+    writer.Key("immutablemerkleroot");
+    writer.Hash(block.hashImMerkleRoot);
+    writer.Key("tx");
+    writer.BeginArray();
+    for(const auto& tx : block.vtx)
+    {
+        if(txDetails)
+            WriteTxJSON(*tx, uint256(), writer, true, RPCSerializationFlags());
+        else
+            writer.Hash(tx->GetHashMalFix());
+    }
+    writer.EndArray();
+    writer.Key("time");
+    writer.Int(block.GetBlockTime());
+    writer.Key("mediantime");
+    writer.Int((int64_t)blockindex->GetMedianTimePast());
+    writer.Key("xfield");
+    writer.String(blockindex->xfield.ToString());
+    writer.Key("proof");
+    writer.Hex(block.proof.begin(), block.proof.end());
+    writer.Key("nTx");
+    writer.UInt((uint64_t)blockindex->nTx);
+
+    if (blockindex->pprev) {
+        writer.Key("previousblockhash");
+        writer.Hash(blockindex->pprev->GetBlockHash());
+    }
+    CBlockIndex *pnext = chainActive.Next(blockindex);
+    if (pnext) {
+        writer.Key("nextblockhash");
+        writer.Hash(pnext->GetBlockHash());
+    }
+    writer.EndObject();
+}
+
+/** Return the current chain tip snapshot, for calls that answer without cs_main. */
+static std::shared_ptr<const ChainTipSnapshot> GetTipSnapshot()
+{
+    std::shared_ptr<const ChainTipSnapshot> snapshot = GetChainTipSnapshot();
+    if (!snapshot) {
+        throw JSONRPCError(RPC_IN_WARMUP, "Chain tip is not loaded");
+    }
+    return snapshot;
+}
+
 static UniValue getblockcount(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -143,8 +223,7 @@ static UniValue getblockcount(const JSONRPCRequest& request)
             + HelpExampleRpc("getblockcount", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Height();
+    return GetTipSnapshot()->height;
 }
 
 static UniValue getbestblockhash(const JSONRPCRequest& request)
@@ -160,8 +239,7 @@ static UniValue getbestblockhash(const JSONRPCRequest& request)
             + HelpExampleRpc("getbestblockhash", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Tip()->GetBlockHash().GetHex();
+    return GetTipSnapshot()->hash.GetHex();
 }
 
 void RPCNotifyBlockChange(bool ibd, const CBlockIndex * pindex)
@@ -339,35 +417,65 @@ static std::string EntryDescriptionString()
            "       ... ]\n";
 }
 
-static void entryToJSON(UniValue &info, const CTxMemPoolEntry &e) EXCLUSIVE_LOCKS_REQUIRED(::mempool.cs)
+static void SnapshotEntry(MempoolEntrySnapshot& snapshot, CTxMemPool::txiter it) EXCLUSIVE_LOCKS_REQUIRED(::mempool.cs)
 {
     AssertLockHeld(mempool.cs);
 
+    const CTxMemPoolEntry& e = *it;
+    snapshot.txid = mempool.vTxHashes[e.vTxHashesIdx].first;
+    snapshot.size = e.GetTxSize();
+    snapshot.fee = e.GetFee();
+    snapshot.modified_fee = e.GetModifiedFee();
+    snapshot.time = e.GetTime();
+    snapshot.height = e.GetHeight();
+    snapshot.entry_sequence = e.GetEntrySequence();
+    snapshot.descendant_count = e.GetCountWithDescendants();
+    snapshot.descendant_size = e.GetSizeWithDescendants();
+    snapshot.descendant_fees = e.GetModFeesWithDescendants();
+    snapshot.ancestor_count = e.GetCountWithAncestors();
+    snapshot.ancestor_size = e.GetSizeWithAncestors();
+    snapshot.ancestor_fees = e.GetModFeesWithAncestors();
+
+    const CTxMemPool::setEntries& setParents = mempool.GetMemPoolParents(it);
+    snapshot.depends.clear();
+    snapshot.depends.reserve(setParents.size());
+    for (const CTxMemPool::txiter& parentIt : setParents) {
+        snapshot.depends.push_back(parentIt->GetTx().GetHashMalFix());
+    }
+
+    const CTxMemPool::setEntries& setChildren = mempool.GetMemPoolChildren(it);
+    snapshot.spentby.clear();
+    snapshot.spentby.reserve(setChildren.size());
+    for (const CTxMemPool::txiter& childIt : setChildren) {
+        snapshot.spentby.push_back(childIt->GetTx().GetHashMalFix());
+    }
+}
+
+void MempoolEntryToJSON(UniValue& info, const MempoolEntrySnapshot& e)
+{
     UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", ValueFromAmount(e.GetFee()));
-    fees.pushKV("modified", ValueFromAmount(e.GetModifiedFee()));
-    fees.pushKV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
-    fees.pushKV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
+    fees.pushKV("base", ValueFromAmount(e.fee));
+    fees.pushKV("modified", ValueFromAmount(e.modified_fee));
+    fees.pushKV("ancestor", ValueFromAmount(e.ancestor_fees));
+    fees.pushKV("descendant", ValueFromAmount(e.descendant_fees));
     info.pushKV("fees", fees);
 
-    info.pushKV("size", (int)e.GetTxSize());
-    info.pushKV("fee", ValueFromAmount(e.GetFee()));
-    info.pushKV("modifiedfee", ValueFromAmount(e.GetModifiedFee()));
-    info.pushKV("time", e.GetTime());
-    info.pushKV("height", (int)e.GetHeight());
-    info.pushKV("descendantcount", e.GetCountWithDescendants());
-    info.pushKV("descendantsize", e.GetSizeWithDescendants());
-    info.pushKV("descendantfees", e.GetModFeesWithDescendants());
-    info.pushKV("ancestorcount", e.GetCountWithAncestors());
-    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
-    info.pushKV("ancestorfees", e.GetModFeesWithAncestors());
-    info.pushKV("txid", mempool.vTxHashes[e.vTxHashesIdx].first.ToString());
-    const CTransaction& tx = e.GetTx();
+    info.pushKV("size", (int)e.size);
+    info.pushKV("fee", ValueFromAmount(e.fee));
+    info.pushKV("modifiedfee", ValueFromAmount(e.modified_fee));
+    info.pushKV("time", e.time);
+    info.pushKV("height", (int)e.height);
+    info.pushKV("descendantcount", e.descendant_count);
+    info.pushKV("descendantsize", e.descendant_size);
+    info.pushKV("descendantfees", e.descendant_fees);
+    info.pushKV("ancestorcount", e.ancestor_count);
+    info.pushKV("ancestorsize", e.ancestor_size);
+    info.pushKV("ancestorfees", e.ancestor_fees);
+    info.pushKV("txid", e.txid.ToString());
+
     std::set<std::string> setDepends;
-    for (const CTxIn& txin : tx.vin)
-    {
-        if (mempool.exists(txin.prevout.hashMalFix))
-            setDepends.insert(txin.prevout.hashMalFix.ToString());
+    for (const uint256& parent : e.depends) {
+        setDepends.insert(parent.ToString());
     }
 
     UniValue depends(UniValue::VARR);
@@ -379,52 +487,157 @@ static void entryToJSON(UniValue &info, const CTxMemPoolEntry &e) EXCLUSIVE_LOCK
     info.pushKV("depends", depends);
 
     UniValue spent(UniValue::VARR);
-    const CTxMemPool::txiter &it = mempool.mapTx.find(tx.GetHashMalFix());
-    const CTxMemPool::setEntries &setChildren = mempool.GetMemPoolChildren(it);
-    for (const CTxMemPool::txiter &childiter : setChildren) {
-        spent.push_back(childiter->GetTx().GetHashMalFix().ToString());
+    for (const uint256& child : e.spentby) {
+        spent.push_back(child.ToString());
     }
 
     info.pushKV("spentby", spent);
 }
 
-UniValue mempoolToJSON(bool fVerbose)
+static void entryToJSON(UniValue &info, const CTxMemPoolEntry &e) EXCLUSIVE_LOCKS_REQUIRED(::mempool.cs)
+{
+    AssertLockHeld(mempool.cs);
+
+    MempoolEntrySnapshot snapshot;
+    SnapshotEntry(snapshot, mempool.mapTx.find(e.GetTx().GetHashMalFix()));
+    MempoolEntryToJSON(info, snapshot);
+}
+
+std::string MempoolCursor::ToString() const
+{
+    return strprintf("%u", entry_sequence);
+}
+
+bool MempoolCursor::SetString(const std::string& str)
+{
+    return ParseUInt64(str, &entry_sequence);
+}
+
+/** The first entry after the cursor in entry_sequence order, found in O(log n) */
+static CTxMemPool::indexed_transaction_set::index<entry_sequence>::type::const_iterator MempoolPageBegin(const MempoolCursor* after) EXCLUSIVE_LOCKS_REQUIRED(::mempool.cs)
+{
+    const auto& index = mempool.mapTx.get<entry_sequence>();
+    return after ? index.upper_bound(after->entry_sequence) : index.begin();
+}
+
+MempoolSnapshot SnapshotMempool(const MempoolCursor* after, size_t count)
+{
+    MempoolSnapshot snapshot;
+    LOCK(mempool.cs);
+    snapshot.total = mempool.mapTx.size();
+    snapshot.mempool_sequence = mempool.GetSequence();
+
+    const auto& index = mempool.mapTx.get<entry_sequence>();
+    auto it = MempoolPageBegin(after);
+    for (; it != index.end() && snapshot.entries.size() < count; ++it) {
+        snapshot.entries.emplace_back();
+        SnapshotEntry(snapshot.entries.back(), mempool.mapTx.project<0>(it));
+    }
+    snapshot.more = it != index.end();
+    return snapshot;
+}
+
+UniValue mempoolToJSON(bool fVerbose, bool include_mempool_sequence)
 {
     if (fVerbose)
     {
-        LOCK(mempool.cs);
+        if (include_mempool_sequence) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Verbose results cannot contain mempool sequence values.");
+        }
+        // Only the copying is done under mempool.cs
+        const MempoolSnapshot snapshot = SnapshotMempool();
         UniValue o(UniValue::VOBJ);
-        for (const CTxMemPoolEntry& e : mempool.mapTx)
+        for (const MempoolEntrySnapshot& e : snapshot.entries)
         {
-            const uint256& hash = e.GetTx().GetHashMalFix();
             UniValue info(UniValue::VOBJ);
-            entryToJSON(info, e);
-            o.pushKV(hash.ToString(), info);
+            MempoolEntryToJSON(info, e);
+            o.pushKV(e.txid.ToString(), info);
         }
         return o;
     }
     else
     {
         std::vector<uint256> vtxid;
-        mempool.queryHashes(vtxid);
+        uint64_t mempool_sequence;
+        {
+            LOCK(mempool.cs);
+            mempool.queryHashes(vtxid);
+            mempool_sequence = mempool.GetSequence();
+        }
 
         UniValue a(UniValue::VARR);
         for (const uint256& hash : vtxid)
             a.push_back(hash.ToString());
 
-        return a;
+        if (!include_mempool_sequence) {
+            return a;
+        }
+        UniValue o(UniValue::VOBJ);
+        o.pushKV("txids", a);
+        o.pushKV("mempool_sequence", mempool_sequence);
+        return o;
     }
 }
 
+UniValue mempoolPageToJSON(bool fVerbose, const MempoolCursor* after, size_t count)
+{
+    UniValue o(UniValue::VOBJ);
+    MempoolCursor next;
+    bool more;
+    uint64_t mempool_sequence;
+    if (fVerbose) {
+        // Only the copying is done under mempool.cs
+        const MempoolSnapshot snapshot = SnapshotMempool(after, count);
+        UniValue txs(UniValue::VOBJ);
+        for (const MempoolEntrySnapshot& e : snapshot.entries) {
+            UniValue info(UniValue::VOBJ);
+            MempoolEntryToJSON(info, e);
+            txs.pushKV(e.txid.ToString(), info);
+        }
+        o.pushKV("transactions", txs);
+        if (!snapshot.entries.empty()) {
+            next.entry_sequence = snapshot.entries.back().entry_sequence;
+        }
+        more = snapshot.more;
+        mempool_sequence = snapshot.mempool_sequence;
+    } else {
+        std::vector<uint256> vtxid;
+        {
+            LOCK(mempool.cs);
+            const auto& index = mempool.mapTx.get<entry_sequence>();
+            auto it = MempoolPageBegin(after);
+            for (; it != index.end() && vtxid.size() < count; ++it) {
+                vtxid.push_back(it->GetTx().GetHashMalFix());
+                next.entry_sequence = it->GetEntrySequence();
+            }
+            more = it != index.end();
+            mempool_sequence = mempool.GetSequence();
+        }
+        UniValue a(UniValue::VARR);
+        for (const uint256& hash : vtxid)
+            a.push_back(hash.ToString());
+        o.pushKV("txids", a);
+    }
+    o.pushKV("mempool_sequence", mempool_sequence);
+    o.pushKV("next", more ? UniValue(next.ToString()) : NullUniValue);
+    return o;
+}
+
 static UniValue getrawmempool(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() > 1)
+    if (request.fHelp || request.params.size() > 4)
         throw std::runtime_error(
-            "getrawmempool ( verbose )\n"
+            "getrawmempool ( verbose mempool_sequence count cursor )\n"
             "\nReturns all transaction ids in memory pool as a json array of string transaction ids.\n"
             "\nHint: use getmempoolentry to fetch a specific transaction from the mempool.\n"
             "\nArguments:\n"
-            "1. verbose (boolean, optional, default=false) True for a json object, false for array of transaction ids\n"
+            "1. verbose          (boolean, optional, default=false) True for a json object, false for array of transaction ids\n"
+            "2. mempool_sequence (boolean, optional, default=false) If verbose=false, returns a json object with transaction list and\n"
+            "                    mempool sequence number attached, to be matched against -zmqpubsequence notifications\n"
+            "3. count            (numeric, optional) Return a page of at most this many transactions, in the order they\n"
+            "                    entered the mempool. Transactions added or removed between pages are never repeated or skipped\n"
+            "4. cursor           (string, optional) Return the page after the one that gave this \"next\" value.\n"
+            "                    Cursors are only valid until the node restarts\n"
             "\nResult: (for verbose = false):\n"
             "[                     (json array of string)\n"
             "  \"transactionid\"     (string) The transaction id\n"
@@ -436,8 +649,25 @@ static UniValue getrawmempool(const JSONRPCRequest& request)
             + EntryDescriptionString()
             + "  }, ...\n"
             "}\n"
+            "\nResult: (for verbose = false and mempool_sequence = true):\n"
+            "{                           (json object)\n"
+            "  \"txids\" : [               (json array of string)\n"
+            "    \"transactionid\"         (string) The transaction id\n"
+            "    ,...\n"
+            "  ],\n"
+            "  \"mempool_sequence\" : n    (numeric) The mempool sequence value the next addition or removal will get\n"
+            "}\n"
+            "\nResult: (when count or cursor is given):\n"
+            "{                           (json object)\n"
+            "  \"txids\" : [...],          (json array of string) The transaction ids, for verbose = false\n"
+            "  \"transactions\" : {...},   (json object) The transactions as for verbose = true, for verbose = true\n"
+            "  \"mempool_sequence\" : n,   (numeric) The mempool sequence value the next addition or removal will get\n"
+            "  \"next\" : \"cursor\"         (string) The cursor of the next page, null after the last page\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getrawmempool", "true")
+            + HelpExampleCli("getrawmempool", "true false 1000")
+            + HelpExampleCli("getrawmempool", "true false 1000 \"12345\"")
             + HelpExampleRpc("getrawmempool", "true")
         );
 
@@ -445,7 +675,30 @@ static UniValue getrawmempool(const JSONRPCRequest& request)
     if (!request.params[0].isNull())
         fVerbose = request.params[0].get_bool();
 
-    return mempoolToJSON(fVerbose);
+    bool include_mempool_sequence = false;
+    if (!request.params[1].isNull()) {
+        include_mempool_sequence = request.params[1].get_bool();
+    }
+
+    if (request.params[2].isNull() && request.params[3].isNull()) {
+        return mempoolToJSON(fVerbose, include_mempool_sequence);
+    }
+
+    size_t count = std::numeric_limits<size_t>::max();
+    if (!request.params[2].isNull()) {
+        const int64_t n = request.params[2].get_int64();
+        if (n < 1) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid count, must be positive");
+        }
+        count = n;
+    }
+
+    MempoolCursor cursor;
+    if (!request.params[3].isNull() && !cursor.SetString(request.params[3].get_str())) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+
+    return mempoolPageToJSON(fVerbose, request.params[3].isNull() ? nullptr : &cursor, count);
 }
 
 static UniValue getmempoolancestors(const JSONRPCRequest& request)
@@ -700,7 +953,7 @@ static CBlock GetBlockChecked(const CBlockIndex* pblockindex)
         throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
     }
 
-    if (!ReadBlockFromDisk(block, pblockindex)) {
+    if (!ReadBlockFromDisk(block, pblockindex, true, true)) {
         // Block not found on disk. This could be because we have the block
         // header in our index but don't have the block (for example if a
         // non-whitelisted node sends us an unrequested long chain of valid
@@ -790,6 +1043,14 @@ static UniValue getblock(const JSONRPCRequest& request)
         return strHex;
     }
 
+    if (request.pRawResult) {
+        // Skip building the UniValue tree, which takes much longer than
+        // reading the block for verbosity 2.
+        JSONWriter writer(*request.pRawResult);
+        blockToJSON(block, pblockindex, verbosity >= 2, writer);
+        return NullUniValue;
+    }
+
     return blockToJSON(block, pblockindex, verbosity >= 2);
 }
 
@@ -1112,22 +1373,29 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
             + HelpExampleRpc("getblockchaininfo", "")
         );
 
-    LOCK(cs_main);
+    // The tip fields come from the published snapshot; cs_main is only
+    // taken for the best header and, when pruning, the prune height.
+    std::shared_ptr<const ChainTipSnapshot> snapshot = GetTipSnapshot();
+    int headers;
+    {
+        LOCK(cs_main);
+        headers = pindexBestHeader ? pindexBestHeader->nHeight : -1;
+    }
 
     UniValue obj(UniValue::VOBJ);
     obj.pushKV("chain",                 FederationParams().NetworkIDString());
     obj.pushKV("mode",                  TAPYRUS_MODES::GetChainName(gArgs.GetChainMode()));
-    obj.pushKV("blocks",                (int)chainActive.Height());
-    obj.pushKV("headers",               pindexBestHeader ? pindexBestHeader->nHeight : -1);
-    obj.pushKV("bestblockhash",         chainActive.Tip()->GetBlockHash().GetHex());
-    obj.pushKV("mediantime",            (int64_t)chainActive.Tip()->GetMedianTimePast());
-    obj.pushKV("verificationprogress",  GuessVerificationProgress(Params().TxData(), chainActive.Tip()));
+    obj.pushKV("blocks",                snapshot->height);
+    obj.pushKV("headers",               headers);
+    obj.pushKV("bestblockhash",         snapshot->hash.GetHex());
+    obj.pushKV("mediantime",            snapshot->median_time);
+    obj.pushKV("verificationprogress",  GuessVerificationProgress(Params().TxData(), snapshot->tip));
     obj.pushKV("initialblockdownload",  IsInitialBlockDownload());
     obj.pushKV("size_on_disk",          CalculateCurrentUsage());
     obj.pushKV("pruned",                fPruneMode);
     if (fPruneMode) {
-        CBlockIndex* block = chainActive.Tip();
-        assert(block);
+        LOCK(cs_main);
+        const CBlockIndex* block = snapshot->tip;
         while (block->pprev && (block->pprev->nStatus & BLOCK_HAVE_DATA)) {
             block = block->pprev;
         }
@@ -1143,11 +1411,10 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
     }
     //aggregate pubkey list with block height and block hash
     UniValue xfieldChanges(UniValue::VARR);
-    CXFieldHistory xFieldHistory;
-    for(auto x : XFIELDTYPES_INIT_LIST)
+    for (const auto& changes : snapshot->xfield_changes)
     {
-        xFieldHistory.ToUniValue(x, &xfieldChanges);
-        obj.pushKV(GetXFieldNameForRpc(x), xfieldChanges);
+        XFieldChangesToUniValue(changes.second, &xfieldChanges);
+        obj.pushKV(GetXFieldNameForRpc(changes.first), xfieldChanges);
     }
 
     obj.pushKV("warnings", GetWarnings("statusbar"));
@@ -1282,6 +1549,12 @@ UniValue mempoolInfoToJSON()
     ret.pushKV("maxmempool", (int64_t) maxmempool);
     ret.pushKV("mempoolminfee", ValueFromAmount(std::max(mempool.GetMinFee(maxmempool), ::minRelayTxFee).GetFeePerK()));
     ret.pushKV("minrelaytxfee", ValueFromAmount(::minRelayTxFee.GetFeePerK()));
+    {
+        LOCK(mempool.cs);
+        if (mempool.IsClusterMode()) {
+            ret.pushKV("clusters", (int64_t) mempool.GetClusters().size());
+        }
+    }
 
     return ret;
 }
@@ -1300,6 +1573,7 @@ static UniValue getmempoolinfo(const JSONRPCRequest& request)
             "  \"maxmempool\": xxxxx,         (numeric) Maximum memory usage for the mempool\n"
             "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee rate in " + CURRENCY_UNIT + "/kB for tx to be accepted. Is the maximum of minrelaytxfee and minimum mempool fee\n"
             "  \"minrelaytxfee\": xxxxx       (numeric) Current minimum relay fee for transactions\n"
+            "  \"clusters\": xxxxx            (numeric) Number of clusters of dependent transactions, only with -clustermempool\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmempoolinfo", "")
@@ -1506,22 +1780,6 @@ static UniValue getchaintxstats(const JSONRPCRequest& request)
     return ret;
 }
 
-template<typename T>
-static T CalculateTruncatedMedian(std::vector<T>& scores)
-{
-    size_t size = scores.size();
-    if (size == 0) {
-        return 0;
-    }
-
-    std::sort(scores.begin(), scores.end());
-    if (size % 2 == 0) {
-        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
-    } else {
-        return scores[size / 2];
-    }
-}
-
 void CalculatePercentilesBySize(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_size)
 {
     if (scores.empty()) {
@@ -1559,8 +1817,96 @@ static inline bool SetHasKeys(const std::set<T>& set, const Tk& key, const Args&
     return (set.count(key) != 0) || SetHasKeys(set, args...);
 }
 
-// outpoint (needed for the utxo index) + nHeight + fCoinBase
-static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+/** Whether one of the selected statistics is computed from the outputs spent by the block */
+static bool StatsNeedInputs(const std::set<std::string>& stats)
+{
+    return stats.empty() || SetHasKeys(stats, "utxo_size_inc", "totalfee", "avgfee", "avgfeerate", "minfee", "maxfee",
+                                       "minfeerate", "maxfeerate", "medianfee", "feerate_percentiles", "tokens");
+}
+
+/**
+ * Report the statistics selected by getblockstats and getblockstatsrange.
+ * The "tokens" statistic is part of the default selection only if
+ * tokens_by_default is set.
+ *
+ * Nothing here needs cs_main, so that ranges can be evaluated in parallel.
+ */
+static UniValue BlockStatsToJSON(const BlockStats& block_stats, const CBlockIndex* pindex, const std::set<std::string>& stats, bool tokens_by_default)
+{
+    const bool do_all = stats.size() == 0; // Report everything if nothing selected (default)
+    const int64_t txs = block_stats.txs;
+
+    UniValue feerates_res(UniValue::VARR);
+    for (int64_t i = 0; i < NUM_GETBLOCKSTATS_PERCENTILES; i++) {
+        feerates_res.push_back(block_stats.feerate_percentiles[i]);
+    }
+
+    UniValue ret_all(UniValue::VOBJ);
+    ret_all.pushKV("avgfee", (txs > 1) ? block_stats.totalfee / (txs - 1) : 0);
+    ret_all.pushKV("avgfeerate", block_stats.total_size > 0 ? block_stats.totalfee / block_stats.total_size : 0); // Unit: tap/byte
+    ret_all.pushKV("avgtxsize", (txs > 1) ? block_stats.total_size / (txs - 1) : 0);
+    ret_all.pushKV("blockhash", pindex->GetBlockHash().GetHex());
+    ret_all.pushKV("feerate_percentiles", feerates_res);
+    ret_all.pushKV("height", (int64_t)pindex->nHeight);
+    ret_all.pushKV("ins", block_stats.ins);
+    ret_all.pushKV("maxfee", block_stats.maxfee);
+    ret_all.pushKV("maxfeerate", block_stats.maxfeerate);
+    ret_all.pushKV("maxtxsize", block_stats.maxtxsize);
+    ret_all.pushKV("medianfee", block_stats.medianfee);
+    ret_all.pushKV("mediantime", pindex->GetMedianTimePast());
+    ret_all.pushKV("mediantxsize", block_stats.mediantxsize);
+    ret_all.pushKV("minfee", block_stats.minfee);
+    ret_all.pushKV("minfeerate", block_stats.minfeerate);
+    ret_all.pushKV("mintxsize", block_stats.mintxsize);
+    ret_all.pushKV("outs", block_stats.outs);
+    ret_all.pushKV("subsidy", GetBlockSubsidy(pindex->nHeight, Params().GetConsensus()));
+    ret_all.pushKV("time", pindex->GetBlockTime());
+    if ((do_all && tokens_by_default) || stats.count("tokens")) {
+        UniValue tokens(UniValue::VOBJ);
+        for (const auto& token : block_stats.tokens) {
+            UniValue ts(UniValue::VOBJ);
+            ts.pushKV("transfers", token.second.transfers);
+            ts.pushKV("issuances", token.second.issuances);
+            ts.pushKV("issued", token.second.issued);
+            ts.pushKV("burned", token.second.burned);
+            tokens.pushKV(token.first.toHexString(), ts);
+        }
+        ret_all.pushKV("tokens", tokens);
+    }
+    ret_all.pushKV("total_out", block_stats.total_out);
+    ret_all.pushKV("total_size", block_stats.total_size);
+    ret_all.pushKV("totalfee", block_stats.totalfee);
+    ret_all.pushKV("txs", txs);
+    ret_all.pushKV("utxo_increase", block_stats.outs - block_stats.ins);
+    ret_all.pushKV("utxo_size_inc", block_stats.utxo_size_inc);
+
+    if (do_all) {
+        return ret_all;
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    for (const std::string& stat : stats) {
+        const UniValue& value = ret_all[stat];
+        if (value.isNull()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid selected statistic %s", stat));
+        }
+        ret.pushKV(stat, value);
+    }
+    return ret;
+}
+
+static std::set<std::string> ParseSelectedStats(const UniValue& param)
+{
+    std::set<std::string> stats;
+    if (!param.isNull()) {
+        const UniValue stats_univalue = param.get_array();
+        for (unsigned int i = 0; i < stats_univalue.size(); i++) {
+            const std::string stat = stats_univalue[i].get_str();
+            stats.insert(stat);
+        }
+    }
+    return stats;
+}
 
 static UniValue getblockstats(const JSONRPCRequest& request)
 {
@@ -1569,7 +1915,8 @@ static UniValue getblockstats(const JSONRPCRequest& request)
             "getblockstats hash_or_height ( stats )\n"
             "\nCompute per block statistics for a given window. All amounts are in tapyrus.\n"
             "It won't work for some heights with pruning.\n"
-            "It won't work without -txindex for utxo_size_inc, *fee or *feerate stats.\n"
+            "It won't work without -txindex for utxo_size_inc, *fee, *feerate or tokens stats,\n"
+            "unless -blockstatsindex is enabled and has indexed the block.\n"
             "\nArguments:\n"
             "1. \"hash_or_height\"     (string or numeric, required) The block hash or height of the target block\n"
             "2. \"stats\"              (array,  optional) Values to plot, by default all values (see result below)\n"
@@ -1605,6 +1952,14 @@ static UniValue getblockstats(const JSONRPCRequest& request)
             "  \"outs\": xxxxx,            (numeric) The number of outputs\n"
             "  \"subsidy\": xxxxx,         (numeric) The block subsidy\n"
             "  \"time\": xxxxx,            (numeric) The block time\n"
+            "  \"tokens\": {               (json object) Only when selected: token movements by color\n"
+            "    \"color\": {              (json object) The color identifier\n"
+            "      \"transfers\": xxxxx,   (numeric) Number of transactions spending and creating the token\n"
+            "      \"issuances\": xxxxx,   (numeric) Number of transactions creating more of the token than they spend\n"
+            "      \"issued\": xxxxx,      (numeric) Amount issued\n"
+            "      \"burned\": xxxxx,      (numeric) Amount spent and not created again\n"
+            "    }, ...\n"
+            "  },\n"
             "  \"total_out\": xxxxx,       (numeric) Total amount in all outputs (excluding coinbase and thus reward [ie subsidy + totalfee])\n"
             "  \"total_size\": xxxxx,      (numeric) Total size of all non-coinbase transactions\n"
             "  \"totalfee\": xxxxx,        (numeric) The fee total\n"
@@ -1646,158 +2001,154 @@ static UniValue getblockstats(const JSONRPCRequest& request)
 
     assert(pindex != nullptr);
 
-    std::set<std::string> stats;
-    if (!request.params[1].isNull()) {
-        const UniValue stats_univalue = request.params[1].get_array();
-        for (unsigned int i = 0; i < stats_univalue.size(); i++) {
-            const std::string stat = stats_univalue[i].get_str();
-            stats.insert(stat);
-        }
+    const std::set<std::string> stats = ParseSelectedStats(request.params[1]);
+
+    BlockStats block_stats;
+    if (g_blockstatsindex && g_blockstatsindex->LookupStats(pindex, block_stats)) {
+        return BlockStatsToJSON(block_stats, pindex, stats, false);
     }
 
     const CBlock block = GetBlockChecked(pindex);
 
-    const bool do_all = stats.size() == 0; // Calculate everything if nothing selected (default)
-    const bool do_mediantxsize = do_all || stats.count("mediantxsize") != 0;
-    const bool do_medianfee = do_all || stats.count("medianfee") != 0;
-    const bool do_feerate_percentiles = do_all || stats.count("feerate_percentiles") != 0;
-    const bool loop_inputs = do_all || do_medianfee || do_feerate_percentiles ||
-        SetHasKeys(stats, "utxo_size_inc", "totalfee", "avgfee", "avgfeerate", "minfee", "maxfee", "minfeerate", "maxfeerate");
-    const bool loop_outputs = do_all || loop_inputs || stats.count("total_out");
-    const bool do_calculate_size = do_all || do_mediantxsize ||
-        SetHasKeys(stats, "total_size", "avgtxsize", "mintxsize", "maxtxsize", "avgfeerate", "feerate_percentiles", "minfeerate", "maxfeerate");
-
-    CAmount maxfee = 0;
-    CAmount maxfeerate = 0;
-    CAmount minfee = MAX_MONEY;
-    CAmount minfeerate = MAX_MONEY;
-    CAmount total_out = 0;
-    CAmount totalfee = 0;
-    int64_t inputs = 0;
-    int64_t maxtxsize = 0;
-    int64_t mintxsize = GetCurrentMaxBlockSize();
-    int64_t outputs = 0;
-    int64_t total_size = 0;
-    int64_t utxo_size_inc = 0;
-    std::vector<CAmount> fee_array;
-    std::vector<std::pair<CAmount, int64_t>> feerate_array;
-    std::vector<int64_t> txsize_array;
-
-    for (const auto& tx : block.vtx) {
-        outputs += tx->vout.size();
-
-        CAmount tx_total_out = 0;
-        if (loop_outputs) {
-            for (const CTxOut& out : tx->vout) {
-                tx_total_out += out.nValue;
-                utxo_size_inc += GetSerializeSize(out, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+    CTransactionRef tx_in;
+    std::function<const CTxOut&(size_t, size_t)> spent_output;
+    if (StatsNeedInputs(stats)) {
+        spent_output = [&](size_t n_tx, size_t n_in) -> const CTxOut& {
+            if (!g_txindex) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "One or more of the selected stats requires -txindex enabled");
             }
-        }
+            const COutPoint& prevout = block.vtx[n_tx]->vin[n_in].prevout;
+            uint256 hashBlock;
+            if (!GetTransaction(prevout.hashMalFix, tx_in, Params().GetConsensus(), hashBlock, false)) {
+                throw JSONRPCError(RPC_INTERNAL_ERROR, std::string("Unexpected internal error (tx index seems corrupt)"));
+            }
+            return tx_in->vout[prevout.n];
+        };
+    }
+    ComputeBlockStats(block, spent_output, block_stats);
+    return BlockStatsToJSON(block_stats, pindex, stats, false);
+}
 
-        if (tx->IsCoinBase()) {
-            continue;
-        }
+//! Most blocks getblockstatsrange evaluates in one call; longer ranges are requested in parts
+static const int MAX_BLOCKSTATS_RANGE = 1000;
 
-        inputs += tx->vin.size(); // Don't count coinbase's fake input
-        total_out += tx_total_out; // Don't count coinbase reward
+static UniValue getblockstatsrange(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 2 || request.params.size() > 3) {
+        throw std::runtime_error(
+            "getblockstatsrange start_height end_height ( stats )\n"
+            "\nCompute the statistics of getblockstats for every block of the active chain from start_height to end_height,\n"
+            "evaluating blocks in parallel. Inputs are read from the undo data, so -txindex is not needed,\n"
+            "but it won't work for pruned blocks. Blocks indexed by -blockstatsindex are not read again.\n"
+            "At most " + std::to_string(MAX_BLOCKSTATS_RANGE) + " blocks are evaluated in one call; longer ranges are requested in parts.\n"
+            "All amounts are in tapyrus.\n"
+            "\nArguments:\n"
+            "1. start_height           (numeric, required) The height of the first block\n"
+            "2. end_height             (numeric, required) The height of the last block\n"
+            "3. \"stats\"                (array,  optional) Values to plot, by default all values including tokens (see getblockstats)\n"
+            "    [\n"
+            "      \"height\",         (string, optional) Selected statistic\n"
+            "      \"tokens\",         (string, optional) Selected statistic\n"
+            "      ,...\n"
+            "    ]\n"
+            "\nResult:\n"
+            "[                         (json array) One object per block, in order of height, as returned by getblockstats\n"
+            "  {...}, ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblockstatsrange", "1000 2000 '[\"height\",\"totalfee\",\"tokens\"]'")
+            + HelpExampleRpc("getblockstatsrange", "1000, 2000, [\"height\",\"totalfee\",\"tokens\"]")
+        );
+    }
 
-        int64_t tx_size = 0;
-        if (do_calculate_size) {
+    const int start_height = request.params[0].get_int();
+    const int end_height = request.params[1].get_int();
+    const std::set<std::string> stats = ParseSelectedStats(request.params[2]);
 
-            tx_size = tx->GetTotalSize();
-            if (do_mediantxsize) {
-                txsize_array.push_back(tx_size);
+    // Only the block index entries are taken under cs_main; blocks and undo
+    // data are read by the workers.
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(cs_main);
+        const int current_tip = chainActive.Height();
+        if (start_height < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", start_height));
+        }
+        if (start_height > end_height) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Start height %d is after end height %d", start_height, end_height));
+        }
+        if (end_height - start_height >= MAX_BLOCKSTATS_RANGE) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Range of %d blocks is longer than %d blocks", end_height - start_height + 1, MAX_BLOCKSTATS_RANGE));
+        }
+        if (end_height > current_tip) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", end_height, current_tip));
+        }
+        for (int height = start_height; height <= end_height; ++height) {
+            const CBlockIndex* pindex = chainActive[height];
+            if (IsBlockPruned(pindex)) {
+                throw JSONRPCError(RPC_MISC_ERROR, strprintf("Block %d not available (pruned data)", height));
             }
-            maxtxsize = std::max(maxtxsize, tx_size);
-            mintxsize = std::min(mintxsize, tx_size);
-            total_size += tx_size;
+            blocks.push_back(pindex);
         }
+    }
 
-        if (loop_inputs) {
+    // Blocks covered by -blockstatsindex are not read at all. The index is
+    // filled in order of height, so it covers a leading part of the range.
+    std::vector<BlockStats> block_stats;
+    const size_t num_indexed = g_blockstatsindex ? g_blockstatsindex->LookupStatsRange(blocks, block_stats) : 0;
+    block_stats.resize(blocks.size());
 
-            if (!g_txindex) {
-                throw JSONRPCError(RPC_INVALID_PARAMETER, "One or more of the selected stats requires -txindex enabled");
+    const bool write_only = request.pRawResult != nullptr;
+    std::vector<UniValue> results(write_only ? 0 : blocks.size());
+    std::vector<std::string> results_json(write_only ? blocks.size() : 0);
+    // The first error stops the remaining blocks and is thrown from here.
+    g_rpc_workers.ForEach(blocks.size(), std::max(GetNumCores(), 1), [&](size_t i) {
+        if (ShutdownRequested() || !IsRPCRunning()) {
+            throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, "Shutting down");
+        }
+        const CBlockIndex* pindex = blocks[i];
+        if (i >= num_indexed) {
+            // The blocks are in the validated index already; their hash
+            // is still checked, but their proof is not verified again.
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pindex, false, true)) {
+                throw JSONRPCError(RPC_MISC_ERROR, strprintf("Block %d not found on disk", pindex->nHeight));
             }
-            CAmount tx_total_in = 0;
-            for (const CTxIn& in : tx->vin) {
-                CTransactionRef tx_in;
-                uint256 hashBlock;
-                if (!GetTransaction(in.prevout.hashMalFix, tx_in, Params().GetConsensus(), hashBlock, false)) {
-                    throw JSONRPCError(RPC_INTERNAL_ERROR, std::string("Unexpected internal error (tx index seems corrupt)"));
-                }
-
-                CTxOut prevoutput = tx_in->vout[in.prevout.n];
-
-                tx_total_in += prevoutput.nValue;
-                utxo_size_inc -= GetSerializeSize(prevoutput, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+            CBlockUndo blockundo;
+            if (pindex->nHeight > 0 && !UndoReadFromDisk(blockundo, pindex)) {
+                throw JSONRPCError(RPC_MISC_ERROR, strprintf("Undo data of block %d not found on disk", pindex->nHeight));
             }
 
-            CAmount txfee = tx_total_in - tx_total_out;
-            assert(MoneyRange(txfee));
-            if (do_medianfee) {
-                fee_array.push_back(txfee);
-            }
-            maxfee = std::max(maxfee, txfee);
-            minfee = std::min(minfee, txfee);
-            totalfee += txfee;
-
-            // New feerate uses tapyrus per byte
-            CAmount feerate = tx_size ? txfee : 0;
-            if (do_feerate_percentiles) {
-                feerate_array.emplace_back(std::make_pair(feerate, tx_size));
-            }
-            maxfeerate = std::max(maxfeerate, feerate);
-            minfeerate = std::min(minfeerate, feerate);
+            ComputeBlockStats(block, [&](size_t n_tx, size_t n_in) -> const CTxOut& {
+                // The undo data has no entry for the coinbase.
+                return blockundo.vtxundo.at(n_tx - 1).vprevout.at(n_in).out;
+            }, block_stats[i]);
         }
-    }
-
-    CAmount feerate_percentiles[NUM_GETBLOCKSTATS_PERCENTILES] = { 0 };
-    CalculatePercentilesBySize(feerate_percentiles, feerate_array, total_size);
 
-    UniValue feerates_res(UniValue::VARR);
-    for (int64_t i = 0; i < NUM_GETBLOCKSTATS_PERCENTILES; i++) {
-        feerates_res.push_back(feerate_percentiles[i]);
-    }
-
-    UniValue ret_all(UniValue::VOBJ);
-    ret_all.pushKV("avgfee", (block.vtx.size() > 1) ? totalfee / (block.vtx.size() - 1) : 0);
-    ret_all.pushKV("avgfeerate", total_size > 0 ? totalfee / total_size : 0); // Unit: tap/byte
-    ret_all.pushKV("avgtxsize", (block.vtx.size() > 1) ? total_size / (block.vtx.size() - 1) : 0);
-    ret_all.pushKV("blockhash", pindex->GetBlockHash().GetHex());
-    ret_all.pushKV("feerate_percentiles", feerates_res);
-    ret_all.pushKV("height", (int64_t)pindex->nHeight);
-    ret_all.pushKV("ins", inputs);
-    ret_all.pushKV("maxfee", maxfee);
-    ret_all.pushKV("maxfeerate", maxfeerate);
-    ret_all.pushKV("maxtxsize", maxtxsize);
-    ret_all.pushKV("medianfee", CalculateTruncatedMedian(fee_array));
-    ret_all.pushKV("mediantime", pindex->GetMedianTimePast());
-    ret_all.pushKV("mediantxsize", CalculateTruncatedMedian(txsize_array));
-    ret_all.pushKV("minfee", (minfee == MAX_MONEY) ? 0 : minfee);
-    ret_all.pushKV("minfeerate", (minfeerate == MAX_MONEY) ? 0 : minfeerate);
-    ret_all.pushKV("mintxsize", mintxsize == GetCurrentMaxBlockSize() ? 0 : mintxsize);
-    ret_all.pushKV("outs", outputs);
-    ret_all.pushKV("subsidy", GetBlockSubsidy(pindex->nHeight, Params().GetConsensus()));
-    ret_all.pushKV("time", pindex->GetBlockTime());
-    ret_all.pushKV("total_out", total_out);
-    ret_all.pushKV("total_size", total_size);
-    ret_all.pushKV("totalfee", totalfee);
-    ret_all.pushKV("txs", (int64_t)block.vtx.size());
-    ret_all.pushKV("utxo_increase", outputs - inputs);
-    ret_all.pushKV("utxo_size_inc", utxo_size_inc);
-
-    if (do_all) {
-        return ret_all;
-    }
-
-    UniValue ret(UniValue::VOBJ);
-    for (const std::string& stat : stats) {
-        const UniValue& value = ret_all[stat];
-        if (value.isNull()) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid selected statistic %s", stat));
+        // Over HTTP each block is written out by its worker right away.
+        UniValue result = BlockStatsToJSON(block_stats[i], pindex, stats, true);
+        if (write_only) {
+            results_json[i] = result.write();
+        } else {
+            results[i] = std::move(result);
         }
-        ret.pushKV(stat, value);
+    });
+
+    // Requests answered over HTTP get the blocks written one by one instead
+    // of one UniValue holding all of them.
+    if (write_only) {
+        std::string json = "[";
+        for (const std::string& result : results_json) {
+            if (json.size() > 1) json += ',';
+            json += result;
+        }
+        json += ']';
+        *request.pRawResult = std::move(json);
+        return NullUniValue;
     }
+
+    UniValue ret(UniValue::VARR);
+    ret.push_backV(results);
     return ret;
 }
 
@@ -1824,65 +2175,302 @@ static UniValue savemempool(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
-//! Search for a given set of pubkey scripts
-bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>& should_abort, int64_t& count, CCoinsViewCursor* cursor, const std::set<CScript>& needles, std::map<COutPoint, Coin>& out_results) {
-    scan_progress = 0;
-    count = 0;
+/** Hashes scripts for the lookup of every coin during a UTXO set scan */
+class SaltedScriptHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedScriptHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+    size_t operator()(const CScript& script) const {
+        return CSipHasher(k0, k1).Write(script.data(), script.size()).Finalize();
+    }
+};
+
+/** A scantxoutset request, waiting for a pass over the UTXO set or taking part in one */
+struct UTXOSetScan
+{
+    std::vector<CScript> scripts;
+    //! colors all of whose outputs are looked for
+    std::set<ColorIdentifier> colors;
+
+    std::map<COutPoint, Coin> results;
+    int64_t searched_items = 0;
+    //! number of scans searched in the same pass, this one included
+    size_t pass_scans = 0;
+    bool success = false;
+    bool done = false;
+};
+
+/**
+ * The scripts and colors of all scans taking part in a pass, each mapped to
+ * the scans looking for it.
+ */
+class UTXOSetScanMatcher
+{
+private:
+    std::unordered_map<CScript, std::vector<size_t>, SaltedScriptHasher> m_scripts;
+    std::map<ColorIdentifier, std::vector<size_t>> m_colors;
+
+public:
+    explicit UTXOSetScanMatcher(const std::vector<std::shared_ptr<UTXOSetScan>>& scans)
+    {
+        for (size_t i = 0; i < scans.size(); ++i) {
+            for (const CScript& script : scans[i]->scripts) {
+                std::vector<size_t>& matches = m_scripts[script];
+                if (matches.empty() || matches.back() != i) matches.push_back(i);
+            }
+            for (const ColorIdentifier& color : scans[i]->colors) {
+                m_colors[color].push_back(i);
+            }
+        }
+    }
+
+    //! Add the coin to the results of each scan it matches
+    void Match(const COutPoint& outpoint, const Coin& coin, std::vector<std::map<COutPoint, Coin>>& results) const
+    {
+        auto it = m_scripts.find(coin.out.scriptPubKey);
+        if (it != m_scripts.end()) {
+            for (size_t i : it->second) results[i].emplace(outpoint, coin);
+        }
+        if (!m_colors.empty() && coin.out.scriptPubKey.IsColoredScript()) {
+            auto it_color = m_colors.find(GetColorIdFromScript(coin.out.scriptPubKey));
+            if (it_color != m_colors.end()) {
+                for (size_t i : it_color->second) results[i].emplace(outpoint, coin);
+            }
+        }
+    }
+};
+
+//! Number of ranges of txid prefixes a pass is split into
+static const uint32_t SCAN_PREFIX_RANGE = 0x10000;
+
+static std::mutex g_utxosetscan;
+static std::condition_variable g_utxosetscan_cv;
+//! scans waiting for the next pass
+static std::vector<std::shared_ptr<UTXOSetScan>> g_scans_pending;
+//! number of scans taking part in the current pass
+static size_t g_scans_running = 0;
+static bool g_scan_in_progress = false;
+static std::atomic<int> g_scan_progress;
+static std::atomic<uint32_t> g_scan_prefixes_done;
+static std::atomic<bool> g_should_abort_scan;
+
+/**
+ * Search the coins whose txid starts with a 16 bit prefix before prefix_end,
+ * from where the cursor is, and add those matching to the results.
+ */
+static bool ScanUTXOSetRange(CCoinsViewCursor* cursor, uint32_t prefix_begin, uint32_t prefix_end, const UTXOSetScanMatcher& matcher, int64_t& count, std::vector<std::map<COutPoint, Coin>>& results)
+{
+    uint32_t prefix_reported = prefix_begin;
+    auto report_progress = [&](uint32_t prefix) {
+        if (prefix > prefix_reported) {
+            const uint32_t done = g_scan_prefixes_done += prefix - prefix_reported;
+            prefix_reported = prefix;
+            g_scan_progress = (int)(done * 100.0 / SCAN_PREFIX_RANGE + 0.5);
+        }
+    };
+
     while (cursor->Valid()) {
         COutPoint key;
         Coin coin;
-        if (!cursor->GetKey(key) || !cursor->GetValue(coin)) return false;
+        if (!cursor->GetKey(key)) return false;
+        const uint32_t prefix = 0x100 * *key.hashMalFix.begin() + *(key.hashMalFix.begin() + 1);
+        if (prefix >= prefix_end) break;
+        if (!cursor->GetValue(coin)) return false;
         if (++count % 8192 == 0) {
-            if (should_abort) {
+            if (g_should_abort_scan) {
                 // allow to abort the scan via the abort reference
                 return false;
             }
         }
         if (count % 256 == 0) {
             // update progress reference every 256 item
-            uint32_t high = 0x100 * *key.hashMalFix.begin() + *(key.hashMalFix.begin() + 1);
-            scan_progress = (int)(high * 100.0 / 65536.0 + 0.5);
-        }
-        if (needles.count(coin.out.scriptPubKey)) {
-            out_results.emplace(key, coin);
+            report_progress(prefix);
         }
+        matcher.Match(key, coin, results);
         cursor->Next();
     }
-    scan_progress = 100;
+    report_progress(prefix_end);
     return true;
 }
 
-/** RAII object to prevent concurrency issue when scanning the txout set */
-static std::mutex g_utxosetscan;
-static std::atomic<int> g_scan_progress;
-static std::atomic<bool> g_scan_in_progress;
-static std::atomic<bool> g_should_abort_scan;
-class CoinsViewScanReserver
+/**
+ * Make one pass over the UTXO set for all the scans, with the txid prefixes
+ * split into ranges that are searched in parallel by the RPC workers.
+ */
+static void ScanUTXOSet(const std::vector<std::shared_ptr<UTXOSetScan>>& scans)
 {
-private:
-    bool m_could_reserve;
-public:
-    explicit CoinsViewScanReserver() : m_could_reserve(false) {}
+    const UTXOSetScanMatcher matcher(scans);
+    const size_t num_ranges = std::max(GetNumCores(), 1);
 
-    bool reserve() {
-        assert (!m_could_reserve);
-        std::lock_guard<std::mutex> lock(g_utxosetscan);
+    // Lets tests start scans while a pass runs
+    MilliSleep(gArgs.GetArg("-testscanpassdelay", 0));
+
+    // The cursors are all created under cs_main, so that they read the same
+    // state of the database.
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    std::vector<uint32_t> prefixes;
+    {
+        LOCK(cs_main);
+        FlushStateToDisk();
+        for (size_t n = 0; n < num_ranges; ++n) {
+            const uint32_t prefix = SCAN_PREFIX_RANGE * n / num_ranges;
+            uint256 hash_start;
+            *hash_start.begin() = prefix >> 8;
+            *(hash_start.begin() + 1) = prefix & 0xff;
+            cursors.emplace_back(pcoinsdbview->Cursor(hash_start));
+            assert(cursors.back());
+            prefixes.push_back(prefix);
+        }
+    }
+    prefixes.push_back(SCAN_PREFIX_RANGE);
+
+    std::vector<std::vector<std::map<COutPoint, Coin>>> results(num_ranges, std::vector<std::map<COutPoint, Coin>>(scans.size()));
+    std::vector<int64_t> counts(num_ranges, 0);
+    std::atomic<bool> failed(false);
+    g_rpc_workers.ForEach(num_ranges, num_ranges, [&](size_t n) {
+        try {
+            if (!ScanUTXOSetRange(cursors[n].get(), prefixes[n], prefixes[n + 1], matcher, counts[n], results[n])) {
+                failed = true;
+            }
+        } catch (const std::exception& e) {
+            LogPrintf("%s: %s\n", __func__, e.what());
+            failed = true;
+        }
+    });
+
+    int64_t count = 0;
+    for (size_t n = 0; n < num_ranges; ++n) {
+        count += counts[n];
+        for (size_t i = 0; i < scans.size(); ++i) {
+            scans[i]->results.insert(results[n][i].begin(), results[n][i].end());
+        }
+    }
+    for (const auto& scan : scans) {
+        scan->searched_items = count;
+        scan->pass_scans = scans.size();
+        scan->success = !failed;
+    }
+}
+
+/**
+ * Run a scan. Scans requested while a pass is running wait for it to end and
+ * are then searched together in one pass, made by one of their threads.
+ */
+static void RunUTXOSetScan(const std::shared_ptr<UTXOSetScan>& scan)
+{
+    std::unique_lock<std::mutex> lock(g_utxosetscan);
+    g_scans_pending.push_back(scan);
+    while (!scan->done) {
         if (g_scan_in_progress) {
-            return false;
+            g_utxosetscan_cv.wait(lock);
+            continue;
         }
+
+        std::vector<std::shared_ptr<UTXOSetScan>> scans;
+        scans.swap(g_scans_pending);
+        g_scans_running = scans.size();
         g_scan_in_progress = true;
-        m_could_reserve = true;
-        return true;
-    }
+        g_should_abort_scan = false;
+        g_scan_prefixes_done = 0;
+        g_scan_progress = 0;
+        lock.unlock();
 
-    ~CoinsViewScanReserver() {
-        if (m_could_reserve) {
-            std::lock_guard<std::mutex> lock(g_utxosetscan);
+        try {
+            ScanUTXOSet(scans);
+        } catch (...) {
+            lock.lock();
+            for (const auto& s : scans) s->done = true;
             g_scan_in_progress = false;
+            g_utxosetscan_cv.notify_all();
+            throw;
         }
+
+        lock.lock();
+        for (const auto& s : scans) s->done = true;
+        g_scan_in_progress = false;
+        g_utxosetscan_cv.notify_all();
     }
+}
+
+//! Maximum memory used by the scripts of the descriptors kept
+static const size_t MAX_SCAN_DESCRIPTOR_CACHE_USAGE = 64 << 20;
+
+struct ScanDescriptorCacheEntry
+{
+    std::shared_ptr<const std::vector<CScript>> scripts;
+    size_t usage;
+    //! position in g_scan_descriptor_lru
+    std::list<uint256>::iterator lru;
 };
 
+static Mutex g_scan_descriptor_cache_mutex;
+//! scripts expanded from a descriptor, by hash of the descriptor and range
+static std::map<uint256, ScanDescriptorCacheEntry> g_scan_descriptor_cache GUARDED_BY(g_scan_descriptor_cache_mutex);
+//! keys of g_scan_descriptor_cache, most recently used first
+static std::list<uint256> g_scan_descriptor_lru GUARDED_BY(g_scan_descriptor_cache_mutex);
+static size_t g_scan_descriptor_cache_usage GUARDED_BY(g_scan_descriptor_cache_mutex) = 0;
+
+/**
+ * The scripts of a descriptor, up to child index range if it is ranged.
+ * Deriving the scripts of a ranged descriptor is the bulk of the work before
+ * a scan starts, so they are kept for the next scans of the same descriptor,
+ * unless the descriptor holds private keys.
+ */
+static std::shared_ptr<const std::vector<CScript>> ExpandScanDescriptor(const std::string& desc_str, int range)
+{
+    uint256 key;
+    CSHA256().Write((const unsigned char*)desc_str.data(), desc_str.size()).Write((const unsigned char*)&range, sizeof(range)).Finalize(key.begin());
+    {
+        LOCK(g_scan_descriptor_cache_mutex);
+        auto it = g_scan_descriptor_cache.find(key);
+        if (it != g_scan_descriptor_cache.end()) {
+            g_scan_descriptor_lru.splice(g_scan_descriptor_lru.begin(), g_scan_descriptor_lru, it->second.lru);
+            return it->second.scripts;
+        }
+    }
+
+    FlatSigningProvider provider;
+    auto desc = Parse(desc_str, provider);
+    if (!desc) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Invalid descriptor '%s'", desc_str));
+    }
+    if (!desc->IsRange()) range = 0;
+    auto scripts = std::make_shared<std::vector<CScript>>();
+    for (int i = 0; i <= range; ++i) {
+        std::vector<CScript> expanded;
+        if (!desc->Expand(i, provider, expanded, provider)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Cannot derive script without private keys: '%s'", desc_str));
+        }
+        scripts->insert(scripts->end(), expanded.begin(), expanded.end());
+    }
+
+    // Scripts derived from private keys are not kept beyond the call.
+    if (!provider.keys.empty()) return scripts;
+    size_t usage = memusage::DynamicUsage(*scripts);
+    for (const CScript& script : *scripts) {
+        usage += RecursiveDynamicUsage(script);
+    }
+    if (usage > MAX_SCAN_DESCRIPTOR_CACHE_USAGE) return scripts;
+
+    LOCK(g_scan_descriptor_cache_mutex);
+    if (g_scan_descriptor_cache.count(key)) return scripts;
+    while (g_scan_descriptor_cache_usage + usage > MAX_SCAN_DESCRIPTOR_CACHE_USAGE) {
+        auto oldest = g_scan_descriptor_cache.find(g_scan_descriptor_lru.back());
+        g_scan_descriptor_cache_usage -= oldest->second.usage;
+        g_scan_descriptor_cache.erase(oldest);
+        g_scan_descriptor_lru.pop_back();
+    }
+    g_scan_descriptor_lru.push_front(key);
+    g_scan_descriptor_cache.emplace(key, ScanDescriptorCacheEntry{scripts, usage, g_scan_descriptor_lru.begin()});
+    g_scan_descriptor_cache_usage += usage;
+    return scripts;
+}
+
 UniValue scantxoutset(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
@@ -1901,72 +2489,101 @@ UniValue scantxoutset(const JSONRPCRequest& request)
             "unhardened or hardened child keys.\n"
             "In the latter case, a range needs to be specified by below if different from 1000.\n"
             "For more information on output descriptors, see the documentation in the doc/descriptors.md file.\n"
+            "\nScans requested while a scan is running are searched together in one pass over the set, which starts when the running\n"
+            "scan is done. Each pass reads the set in parallel ranges, one per CPU core, on the -rpcworkerthreads threads.\n"
+            "Only as many scans as -rpcheavythreads run at the same time, so no more than that share a pass.\n"
             "\nArguments:\n"
             "1. \"action\"                       (string, required) The action to execute\n"
             "                                      \"start\" for starting a scan\n"
-            "                                      \"abort\" for aborting the current scan (returns true when abort was successful)\n"
+            "                                      \"abort\" for aborting the current scan and the scans waiting for it (returns true when abort was successful)\n"
             "                                      \"status\" for progress report (in %) of the current scan\n"
             "2. \"scanobjects\"                  (array, required) Array of scan objects\n"
             "    [                             Every scan object is either a string descriptor or an object:\n"
             "        \"descriptor\",             (string, optional) An output descriptor\n"
-            "        {                         (object, optional) An object with output descriptor and metadata\n"
-            "          \"desc\": \"descriptor\",   (string, required) An output descriptor\n"
+            "        {                         (object, optional) An object with output descriptor and metadata, or a color\n"
+            "          \"desc\": \"descriptor\",   (string, optional) An output descriptor\n"
             "          \"range\": n,             (numeric, optional) Up to what child index HD chains should be explored (default: 1000)\n"
+            "          \"color\": \"color\",       (string, optional) The color of a token. With \"desc\", the outputs of the descriptor's scripts\n"
+            "                                  colored with this token; without, all outputs of the token.\n"
             "        },\n"
             "        ...\n"
             "    ]\n"
-            "\nResult:\n"
+            "\nResult (\"start\"):\n"
             "{\n"
+            "  \"success\": true|false,          (boolean) Whether the scan was completed\n"
+            "  \"searched_items\": n,            (numeric) The number of unspent transaction outputs searched\n"
+            "  \"pass_scans\": n,                (numeric) The number of scans searched in the same pass, this one included\n"
             "  \"unspents\": [\n"
             "    {\n"
             "    \"txid\" : \"transactionid\",     (string) The transaction id\n"
             "    \"vout\": n,                    (numeric) the vout value\n"
             "    \"scriptPubKey\" : \"script\",    (string) the script key\n"
-            "    \"amount\" : x.xxx,             (numeric) The total amount in " + CURRENCY_UNIT + " of the unspent output\n"
+            "    \"token\" : \"color\",            (string) The token of the unspent output, " + CURRENCY_UNIT + " if none\n"
+            "    \"amount\" : x.xxx,             (numeric) The total amount in " + CURRENCY_UNIT + " or in tokens of the unspent output\n"
             "    \"height\" : n,                 (numeric) Height of the unspent transaction output\n"
             "   }\n"
             "   ,...], \n"
-            " \"total_amount\" : x.xxx,          (numeric) The total amount of all found unspent outputs in " + CURRENCY_UNIT + "\n"
-            "]\n"
+            " \"total_amount\" : {               (json object) The total amount of all found unspent outputs, by token\n"
+            "   \"token\": x.xxx,\n"
+            "   ...\n"
+            " }\n"
+            "}\n"
+            "\nResult (\"status\"):\n"
+            "{\n"
+            "  \"progress\": n,                  (numeric) The progress of the current pass in %\n"
+            "  \"scans\": n,                     (numeric) The number of scans in the current pass and waiting for the next one\n"
+            "}\n"
         );
 
     RPCTypeCheck(request.params, {UniValue::VSTR, UniValue::VARR});
 
     UniValue result(UniValue::VOBJ);
     if (request.params[0].get_str() == "status") {
-        CoinsViewScanReserver reserver;
-        if (reserver.reserve()) {
+        std::lock_guard<std::mutex> lock(g_utxosetscan);
+        if (!g_scan_in_progress) {
             // no scan in progress
             return NullUniValue;
         }
         result.pushKV("progress", g_scan_progress);
+        result.pushKV("scans", (uint64_t)(g_scans_running + g_scans_pending.size()));
         return result;
     } else if (request.params[0].get_str() == "abort") {
-        CoinsViewScanReserver reserver;
-        if (reserver.reserve()) {
-            // reserve was possible which means no scan was running
+        std::lock_guard<std::mutex> lock(g_utxosetscan);
+        if (!g_scan_in_progress && g_scans_pending.empty()) {
+            // no scan was running
             return false;
         }
-        // set the abort flag
+        // set the abort flag, and end the scans that would be next
         g_should_abort_scan = true;
+        for (const auto& scan : g_scans_pending) scan->done = true;
+        g_scans_pending.clear();
+        g_utxosetscan_cv.notify_all();
         return true;
     } else if (request.params[0].get_str() == "start") {
-        CoinsViewScanReserver reserver;
-        if (!reserver.reserve()) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, "Scan already in progress, use action \"abort\" or \"status\"");
-        }
-        std::set<CScript> needles;
+        auto scan = std::make_shared<UTXOSetScan>();
         TxColoredCoinBalancesMap total_in;
 
         // loop through the scan objects
         for (const UniValue& scanobject : request.params[1].get_array().getValues()) {
             std::string desc_str;
             int range = 1000;
+            ColorIdentifier color;
             if (scanobject.isStr()) {
                 desc_str = scanobject.get_str();
             } else if (scanobject.isObject()) {
                 UniValue desc_uni = scanobject.find_value("desc");
-                if (desc_uni.isNull()) throw JSONRPCError(RPC_INVALID_PARAMETER, "Descriptor needs to be provided in scan object");
+                UniValue color_uni = scanobject.find_value("color");
+                if (desc_uni.isNull() && color_uni.isNull()) throw JSONRPCError(RPC_INVALID_PARAMETER, "Descriptor or color needs to be provided in scan object");
+                if (!color_uni.isNull()) {
+                    const std::vector<unsigned char> color_bytes(ParseHexV(color_uni, "color"));
+                    if (color_bytes.size() != COLOR_IDENTIFIER_SIZE) throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid color");
+                    color = ColorIdentifier(color_bytes);
+                    if (color.type == TokenTypes::NONE) throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid color");
+                    if (desc_uni.isNull()) {
+                        scan->colors.insert(color);
+                        continue;
+                    }
+                }
                 desc_str = desc_uni.get_str();
                 UniValue range_uni = scanobject.find_value("range");
                 if (!range_uni.isNull()) {
@@ -1977,38 +2594,26 @@ UniValue scantxoutset(const JSONRPCRequest& request)
                 throw JSONRPCError(RPC_INVALID_PARAMETER, "Scan object needs to be either a string or an object");
             }
 
-            FlatSigningProvider provider;
-            auto desc = Parse(desc_str, provider);
-            if (!desc) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Invalid descriptor '%s'", desc_str));
-            }
-            if (!desc->IsRange()) range = 0;
-            for (int i = 0; i <= range; ++i) {
-                std::vector<CScript> scripts;
-                if (!desc->Expand(i, provider, scripts, provider)) {
-                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Cannot derive script without private keys: '%s'", desc_str));
+            const auto scripts = ExpandScanDescriptor(desc_str, range);
+            if (color.type == TokenTypes::NONE) {
+                scan->scripts.insert(scan->scripts.end(), scripts->begin(), scripts->end());
+            } else {
+                for (const CScript& script : *scripts) {
+                    CScript colored = CScript() << color.toVector() << OP_COLOR;
+                    colored.insert(colored.end(), script.begin(), script.end());
+                    scan->scripts.push_back(std::move(colored));
                 }
-                needles.insert(scripts.begin(), scripts.end());
             }
         }
 
         // Scan the unspent transaction output set for inputs
         UniValue unspents(UniValue::VARR);
         std::vector<CTxOut> input_txos;
-        std::map<COutPoint, Coin> coins;
-        g_should_abort_scan = false;
-        g_scan_progress = 0;
-        int64_t count = 0;
-        std::unique_ptr<CCoinsViewCursor> pcursor;
-        {
-            LOCK(cs_main);
-            FlushStateToDisk();
-            pcursor = std::unique_ptr<CCoinsViewCursor>(pcoinsdbview->Cursor());
-            assert(pcursor);
-        }
-        bool res = FindScriptPubKey(g_scan_progress, g_should_abort_scan, count, pcursor.get(), needles, coins);
-        result.pushKV("success", res);
-        result.pushKV("searched_items", count);
+        RunUTXOSetScan(scan);
+        const std::map<COutPoint, Coin>& coins = scan->results;
+        result.pushKV("success", scan->success);
+        result.pushKV("searched_items", scan->searched_items);
+        result.pushKV("pass_scans", (uint64_t)scan->pass_scans);
 
         for (const auto& it : coins) {
             const COutPoint& outpoint = it.first;
@@ -2275,12 +2880,172 @@ static UniValue dumptxoutset(const JSONRPCRequest& request)
     return result;
 }
 
+bool ParseAddressOrScript(const std::string& str, CScript& script)
+{
+    const CTxDestination dest = DecodeDestination(str);
+    if (IsValidDestination(dest)) {
+        script = GetScriptForDestination(dest);
+        return true;
+    }
+    if (!str.empty() && IsHex(str)) {
+        const std::vector<unsigned char> data(ParseHex(str));
+        script = CScript(data.begin(), data.end());
+        return true;
+    }
+    return false;
+}
+
+UniValue AddressIndexEntryToJSON(const AddressIndexEntry& entry)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("txid", entry.txid.GetHex());
+    obj.pushKV(entry.spending ? "vin" : "vout", (int64_t)entry.n);
+    obj.pushKV("category", entry.spending ? "send" : "receive");
+    obj.pushKV("token", entry.color.toHexString());
+    obj.pushKV("amount", entry.color.type == TokenTypes::NONE ? ValueFromAmount(entry.value) : entry.value);
+    if (entry.spending) {
+        obj.pushKV("prevout_txid", entry.prevout.hashMalFix.GetHex());
+        obj.pushKV("prevout_vout", (int64_t)entry.prevout.n);
+    }
+    obj.pushKV("height", entry.height);
+    obj.pushKV("blockhash", entry.block_hash.GetHex());
+    return obj;
+}
+
+/** Parse the arguments shared by getaddresshistory and getaddressutxos */
+static void ParseAddressIndexQuery(const JSONRPCRequest& request, CScript& script, size_t& skip, size_t& count)
+{
+    if (!g_addressindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Requires -addressindex enabled");
+    }
+    if (!ParseAddressOrScript(request.params[0].get_str(), script)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or script");
+    }
+    int n_skip = 0;
+    int n_count = 1000;
+    if (!request.params[1].isNull()) {
+        n_skip = request.params[1].get_int();
+    }
+    if (!request.params[2].isNull()) {
+        n_count = request.params[2].get_int();
+    }
+    if (n_count < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
+    }
+    if ((size_t)n_count > MAX_ADDRESS_INDEX_COUNT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Count larger than %u", MAX_ADDRESS_INDEX_COUNT));
+    }
+    if (n_skip < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative skip");
+    }
+    skip = n_skip;
+    count = n_count;
+
+    g_addressindex->BlockUntilSyncedToCurrentChain();
+}
+
+static UniValue getaddresshistory(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getaddresshistory \"address\" ( skip count )\n"
+            "\nReturns the outputs paying to an address and the inputs spending them, in order of height.\n"
+            "Requires -addressindex. Only transactions in blocks are included.\n"
+            "A colored address returns its token only; any other address returns its outputs of every token.\n"
+            "\nArguments:\n"
+            "1. \"address\"         (string, required) The address, or a hex encoded scriptPubKey\n"
+            "2. skip              (numeric, optional, default=0) The number of entries to skip\n"
+            "3. count             (numeric, optional, default=1000) The maximum number of entries to return, at most " + std::to_string(MAX_ADDRESS_INDEX_COUNT) + "\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"txid\" : \"id\",         (string) The transaction id\n"
+            "    \"vout\" : n,            (numeric) The output index, for category receive\n"
+            "    \"vin\" : n,             (numeric) The input index, for category send\n"
+            "    \"category\" : \"name\",   (string) receive for an output, send for an input spending one\n"
+            "    \"token\" : \"color\",     (string) The token of the output, " + CURRENCY_UNIT + " if not colored\n"
+            "    \"amount\" : x.xxx,      (numeric) The amount received or spent\n"
+            "    \"prevout_txid\" : \"id\", (string) The transaction id of the output spent, for category send\n"
+            "    \"prevout_vout\" : n,    (numeric) The index of the output spent, for category send\n"
+            "    \"height\" : n,          (numeric) The height of the block\n"
+            "    \"blockhash\" : \"hash\",  (string) The hash of the block\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddresshistory", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\" 0 100")
+            + HelpExampleRpc("getaddresshistory", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\", 0, 100")
+        );
+
+    CScript script;
+    size_t skip, count;
+    ParseAddressIndexQuery(request, script, skip, count);
+
+    std::vector<AddressIndexEntry> entries;
+    if (!g_addressindex->FindHistory(script, skip, count, entries)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the address index");
+    }
+
+    UniValue ret(UniValue::VARR);
+    for (const AddressIndexEntry& entry : entries) {
+        ret.push_back(AddressIndexEntryToJSON(entry));
+    }
+    return ret;
+}
+
+static UniValue getaddressutxos(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getaddressutxos \"address\" ( skip count )\n"
+            "\nReturns the unspent outputs paying to an address, in order of height.\n"
+            "Requires -addressindex. Outputs spent by transactions in the mempool are still included.\n"
+            "A colored address returns its token only; any other address returns its outputs of every token.\n"
+            "\nArguments:\n"
+            "1. \"address\"         (string, required) The address, or a hex encoded scriptPubKey\n"
+            "2. skip              (numeric, optional, default=0) The number of outputs to skip\n"
+            "3. count             (numeric, optional, default=1000) The maximum number of outputs to return, at most " + std::to_string(MAX_ADDRESS_INDEX_COUNT) + "\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"txid\" : \"id\",         (string) The transaction id\n"
+            "    \"vout\" : n,            (numeric) The output index\n"
+            "    \"category\" : \"receive\",\n"
+            "    \"token\" : \"color\",     (string) The token of the output, " + CURRENCY_UNIT + " if not colored\n"
+            "    \"amount\" : x.xxx,      (numeric) The amount of the output\n"
+            "    \"height\" : n,          (numeric) The height of the block\n"
+            "    \"blockhash\" : \"hash\",  (string) The hash of the block\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressutxos", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"")
+            + HelpExampleRpc("getaddressutxos", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"")
+        );
+
+    CScript script;
+    size_t skip, count;
+    ParseAddressIndexQuery(request, script, skip, count);
+
+    std::vector<AddressIndexEntry> entries;
+    if (!g_addressindex->FindUnspent(script, skip, count, entries)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the address index");
+    }
+
+    UniValue ret(UniValue::VARR);
+    for (const AddressIndexEntry& entry : entries) {
+        ret.push_back(AddressIndexEntryToJSON(entry));
+    }
+    return ret;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
     { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {} },
     { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"} },
     { "blockchain",         "getblockstats",          &getblockstats,          {"hash_or_height", "stats"} },
+    { "blockchain",         "getblockstatsrange",     &getblockstatsrange,     {"start_height", "end_height", "stats"} },
     { "blockchain",         "getbestblockhash",       &getbestblockhash,       {} },
     { "blockchain",         "getblockcount",          &getblockcount,          {} },
     { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"} },
@@ -2291,7 +3056,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"} },
     { "blockchain",         "getmempoolentry",        &getmempoolentry,        {"txid"} },
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {} },
-    { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
+    { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose", "mempool_sequence", "count", "cursor"} },
     { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
@@ -2302,6 +3067,8 @@ static const CRPCCommand commands[] =
     { "blockchain",         "scantxoutset",           &scantxoutset,           {"action", "scanobjects"} },
     { "blockchain",         "getcolor",                   &getcolor,               {"type","txid","index"} },
     { "blockchain",         "dumptxoutset",           &dumptxoutset,               {"path"} },
+    { "blockchain",         "getaddresshistory",      &getaddresshistory,      {"address", "skip", "count"} },
+    { "blockchain",         "getaddressutxos",        &getaddressutxos,        {"address", "skip", "count"} },
 
     /* Not shown in help */
     { "hidden",             "invalidateblock",        &invalidateblock,        {"blockhash"} },
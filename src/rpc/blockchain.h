@@ -6,13 +6,20 @@
 #ifndef BITCOIN_RPC_BLOCKCHAIN_H
 #define BITCOIN_RPC_BLOCKCHAIN_H
 
+#include <limits>
+#include <string>
 #include <vector>
 #include <stdint.h>
 #include <amount.h>
 #include <primitives/xfield.h>
+#include <serialize.h>
+#include <uint256.h>
 
+struct AddressIndexEntry;
 class CBlock;
 class CBlockIndex;
+class CScript;
+class JSONWriter;
 class UniValue;
 
 static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
@@ -23,11 +30,98 @@ void RPCNotifyBlockChange(bool ibd, const CBlockIndex *);
 /** Block description to JSON */
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
 
+/** Write the same object as blockToJSON() without building a UniValue */
+void blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, JSONWriter& writer);
+
 /** Mempool information to JSON */
 UniValue mempoolInfoToJSON();
 
+/**
+ * The fields of a mempool entry reported by getrawmempool and
+ * /rest/mempool/contents. They are copied while mempool.cs is held so that
+ * the output can be built after it is released.
+ */
+struct MempoolEntrySnapshot
+{
+    uint256 txid;
+    uint32_t size;
+    CAmount fee;
+    CAmount modified_fee;
+    int64_t time;
+    uint32_t height;
+    uint64_t entry_sequence; //!< order of entering the mempool, the cursor of the page ending with it
+    uint64_t descendant_count;
+    uint64_t descendant_size;
+    CAmount descendant_fees;
+    uint64_t ancestor_count;
+    uint64_t ancestor_size;
+    CAmount ancestor_fees;
+    std::vector<uint256> depends; //!< in-mempool parents
+    std::vector<uint256> spentby; //!< in-mempool children
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(txid);
+        READWRITE(size);
+        READWRITE(fee);
+        READWRITE(modified_fee);
+        READWRITE(time);
+        READWRITE(height);
+        READWRITE(descendant_count);
+        READWRITE(descendant_size);
+        READWRITE(descendant_fees);
+        READWRITE(ancestor_count);
+        READWRITE(ancestor_size);
+        READWRITE(ancestor_fees);
+        READWRITE(depends);
+        READWRITE(spentby);
+        READWRITE(entry_sequence);
+    }
+};
+
+/** A page of the mempool contents, see SnapshotMempool */
+struct MempoolSnapshot
+{
+    std::vector<MempoolEntrySnapshot> entries;
+    uint64_t total = 0;            //!< number of transactions in the mempool
+    uint64_t mempool_sequence = 0; //!< mempool sequence number the snapshot is consistent with
+    bool more = false;             //!< whether more transactions follow the page
+};
+
+/**
+ * A position in the order transactions entered the mempool: just after the
+ * transaction with this entry sequence, which may have left the mempool
+ * since. Transactions added later always follow it, so pages continued from
+ * a cursor neither skip nor repeat transactions when others are added or
+ * removed in between. Entry sequences start over when the node restarts.
+ */
+struct MempoolCursor
+{
+    uint64_t entry_sequence = 0;
+
+    //! The entry sequence in decimal
+    std::string ToString() const;
+    bool SetString(const std::string& str);
+};
+
+/**
+ * Copy up to count mempool entries that follow the cursor, or from the
+ * start if there is none, in the order they entered the mempool.
+ * mempool.cs is only held while copying.
+ */
+MempoolSnapshot SnapshotMempool(const MempoolCursor* after = nullptr, size_t count = std::numeric_limits<size_t>::max());
+
+/** Mempool entry snapshot to JSON, the value getrawmempool reports for it */
+void MempoolEntryToJSON(UniValue& info, const MempoolEntrySnapshot& e);
+
 /** Mempool to JSON */
-UniValue mempoolToJSON(bool fVerbose = false);
+UniValue mempoolToJSON(bool fVerbose = false, bool include_mempool_sequence = false);
+
+/** A page of the mempool to JSON, the result of getrawmempool with a count or cursor */
+UniValue mempoolPageToJSON(bool fVerbose, const MempoolCursor* after, size_t count);
 
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* blockindex);
@@ -35,6 +129,12 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex);
 /** String name of Xfield in block header */
 std::string GetXFieldNameForRpc(TAPYRUS_XFIELDTYPES x);
 
+/** Parse an address or a hex encoded scriptPubKey, as accepted by getaddresshistory and /rest/address/ */
+bool ParseAddressOrScript(const std::string& str, CScript& script);
+
+/** Address index entry to JSON, as returned by getaddresshistory and getaddressutxos */
+UniValue AddressIndexEntryToJSON(const AddressIndexEntry& entry);
+
 /** Used by getblockstats to get feerates at different percentiles by size  */
 void CalculatePercentilesBySize(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_size);
 
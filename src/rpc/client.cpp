@@ -119,10 +119,20 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "verifychain", 1, "nblocks" },
     { "getblockstats", 0, "hash_or_height" },
     { "getblockstats", 1, "stats" },
+    { "getblockstatsrange", 0, "start_height" },
+    { "getblockstatsrange", 1, "end_height" },
+    { "getblockstatsrange", 2, "stats" },
+    { "getaddresshistory", 1, "skip" },
+    { "getaddresshistory", 2, "count" },
+    { "getaddressutxos", 1, "skip" },
+    { "getaddressutxos", 2, "count" },
     { "pruneblockchain", 0, "height" },
     { "keypoolrefill", 0, "newsize" },
     { "getrawmempool", 0, "verbose" },
+    { "getrawmempool", 1, "mempool_sequence" },
+    { "getrawmempool", 2, "count" },
     { "estimatesmartfee", 0, "conf_target" },
+    { "estimatesmartfee", 2, "token" },
     { "estimaterawfee", 0, "conf_target" },
     { "estimaterawfee", 1, "threshold" },
     { "setban", 2, "bantime" },
@@ -159,6 +169,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "transfertoken", 1, "value"},
     { "submitpackage", 0, "rawtxs" },
     { "submitpackage", 1, "allowhighfees" },
+    { "sendrawtransactions", 0, "rawtxs" },
+    { "sendrawtransactions", 1, "allowhighfees" },
 };
 
 class CRPCConvertTable
@@ -8,8 +8,11 @@
 #include <rpc/mempool.h>
 #include <rpc/server.h>
 #include <rpc/client.h>
+#include <net.h>
 #include <txmempool.h>
 #include <utilstrencodings.h>
+#include <validation.h>
+#include <validationinterface.h>
 
 #include <stdint.h>
 
@@ -189,6 +192,84 @@ static UniValue submitpackage(const JSONRPCRequest& request)
 
     return result;
 }
+UniValue BatchResultsToJSON(const std::vector<BatchTxResult>& results)
+{
+    UniValue result(UniValue::VARR);
+    for (const BatchTxResult& r : results) {
+        UniValue entry(UniValue::VOBJ);
+        if (!r.txid.IsNull()) {
+            entry.pushKV("txid", r.txid.GetHex());
+        }
+        entry.pushKV("allowed", r.accepted);
+        if (!r.accepted) {
+            if (r.state.missingInputs && r.state.IsValid()) {
+                entry.pushKV("reject-reason", "missing-inputs");
+            } else {
+                entry.pushKV("reject-reason", strprintf("%i: %s", r.state.GetRejectCode(), r.state.GetRejectReason()));
+            }
+        }
+        result.push_back(entry);
+    }
+    return result;
+}
+
+static UniValue sendrawtransactions(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "sendrawtransactions [\"rawtxs\"] ( allowhighfees )\n"
+            "\nSubmits a batch of raw transactions (serialized, hex-encoded) to local node and network.\n"
+            "\nThe transactions may be independent or spend each other, in any order; they are\n"
+            "\nadmitted parents first. Each transaction is accepted or rejected on its own, a\n"
+            "\ntransaction spending a rejected one is rejected for missing inputs.\n"
+            "\nSee sendrawtransaction call.\n"
+            "\nArguments:\n"
+            "1. [\"rawtxs\"]        (array, required) An array of hex strings of raw transactions, at most " + std::to_string(MAX_BATCH_COUNT) + ".\n"
+            "2. allowhighfees    (boolean, optional, default=false) Allow high fees\n"
+            "\nResult:\n"
+            "[                   (array) One result per raw transaction, in the order of the input array.\n"
+            " {\n"
+            "  \"txid\"            (string) The transaction id in hex (absent if the transaction could not be decoded)\n"
+            "  \"allowed\"         (boolean) If the transaction is in the mempool, including when it already was\n"
+            "  \"reject-reason\"   (string) Rejection string (only present when 'allowed' is false)\n"
+            " }\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("sendrawtransactions", "\"[\\\"signedhex1\\\",\\\"signedhex2\\\"]\"") +
+            "\nAs a json rpc call\n"
+            + HelpExampleRpc("sendrawtransactions", "[\"signedhex1\",\"signedhex2\"]")
+        );
+
+    RPCTypeCheck(request.params, {UniValue::VARR, UniValue::VBOOL});
+
+    const UniValue& raw_transactions = request.params[0].get_array();
+    if (raw_transactions.size() < 1 || raw_transactions.size() > MAX_BATCH_COUNT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER,
+                            strprintf("Batch must contain between 1 and %u transactions", MAX_BATCH_COUNT));
+    }
+
+    std::vector<std::string> hex_txs;
+    hex_txs.reserve(raw_transactions.size());
+    for (const auto& rawtx : raw_transactions.getValues()) {
+        hex_txs.push_back(rawtx.get_str());
+    }
+
+    CAmount max_raw_tx_fee = ::maxTxFee;
+    if (!request.params[1].isNull() && request.params[1].get_bool()) {
+        max_raw_tx_fee = 0;
+    }
+
+    if (!g_connman)
+        throw JSONRPCError(RPC_CLIENT_P2P_DISABLED, "Error: Peer-to-peer functionality missing or disabled");
+
+    std::vector<BatchTxResult> results = SubmitTransactionBatch(DecodeTransactionBatch(hex_txs), max_raw_tx_fee);
+
+    // As in sendrawtransaction, let the wallet see the new transactions
+    // before returning.
+    SyncWithValidationInterfaceQueue();
+
+    return BatchResultsToJSON(results);
+}
 
 
 static const CRPCCommand commands[] =
@@ -196,6 +277,7 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------        -----------------------     ----------
     { "packages",        "testmempoolaccept",           &testmempoolaccept,         {"rawtxs","allowhighfees"} },
     { "packages",           "submitpackage",                    &submitpackage,             {"rawtxs","allowhighfees"} },
+    { "rawtransactions",    "sendrawtransactions",              &sendrawtransactions,       {"rawtxs","allowhighfees"} },
 };
 
 void RegisterMempoolRPCCommands(CRPCTable &t)
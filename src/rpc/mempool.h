@@ -5,6 +5,13 @@
 #ifndef TAPYRUS_RPC_MEMPOOL_H
 #define TAPYRUS_RPC_MEMPOOL_H
 
+#include <policy/packages.h>
 
+#include <vector>
+
+class UniValue;
+
+/** Per-transaction results of sendrawtransactions, also used by the REST interface */
+UniValue BatchResultsToJSON(const std::vector<BatchTxResult>& results);
 
 #endif // TAPYRUS_RPC_MEMPOOL_H
@@ -676,9 +676,9 @@ static UniValue estimatefee(const JSONRPCRequest& request)
 
 static UniValue estimatesmartfee(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
         throw std::runtime_error(
-            "estimatesmartfee conf_target (\"estimate_mode\")\n"
+            "estimatesmartfee conf_target (\"estimate_mode\" token)\n"
             "\nEstimates the approximate fee per kilobyte needed for a transaction to begin\n"
             "confirmation within conf_target blocks if possible and return the number of blocks\n"
             "for which the estimate is valid.\n"
@@ -693,11 +693,15 @@ static UniValue estimatesmartfee(const JSONRPCRequest& request)
             "       \"UNSET\" (defaults to CONSERVATIVE)\n"
             "       \"ECONOMICAL\"\n"
             "       \"CONSERVATIVE\"\n"
+            "3. token           (boolean, optional, default=false) Estimate for a transaction that issues, transfers or burns tokens,\n"
+            "                   based on the confirmation history of other token transactions. Falls back to\n"
+            "                   all transactions if not enough token transactions have been observed.\n"
             "\nResult:\n"
             "{\n"
             "  \"feerate\" : x.x,     (numeric, optional) estimate fee rate in " + CURRENCY_UNIT + "/kB\n"
             "  \"errors\": [ str... ] (json array of strings, optional) Errors encountered during processing\n"
             "  \"blocks\" : n         (numeric) block number where estimate was found\n"
+            "  \"token\" : true|false (boolean, only with token=true) whether the estimate is based on token transactions\n"
             "}\n"
             "\n"
             "The request target will be clamped between 2 and the highest target\n"
@@ -706,9 +710,10 @@ static UniValue estimatesmartfee(const JSONRPCRequest& request)
             "have been observed to make an estimate for any number of blocks.\n"
             "\nExample:\n"
             + HelpExampleCli("estimatesmartfee", "6")
+            + HelpExampleCli("estimatesmartfee", "6 \"ECONOMICAL\" true")
             );
 
-    RPCTypeCheck(request.params, {UniValue::VNUM, UniValue::VSTR});
+    RPCTypeCheck(request.params, {UniValue::VNUM, UniValue::VSTR, UniValue::VBOOL});
     RPCTypeCheckArgument(request.params[0], UniValue::VNUM);
     unsigned int conf_target = ParseConfirmTarget(request.params[0]);
     bool conservative = true;
@@ -719,11 +724,12 @@ static UniValue estimatesmartfee(const JSONRPCRequest& request)
         }
         if (fee_mode == FeeEstimateMode::ECONOMICAL) conservative = false;
     }
+    bool token = !request.params[2].isNull() && request.params[2].get_bool();
 
     UniValue result(UniValue::VOBJ);
     UniValue errors(UniValue::VARR);
     FeeCalculation feeCalc;
-    CFeeRate feeRate = ::feeEstimator.estimateSmartFee(conf_target, &feeCalc, conservative);
+    CFeeRate feeRate = ::feeEstimator.estimateSmartFee(conf_target, &feeCalc, conservative, token);
     if (feeRate != CFeeRate(0)) {
         result.pushKV("feerate", ValueFromAmount(feeRate.GetFeePerK()));
     } else {
@@ -731,6 +737,9 @@ static UniValue estimatesmartfee(const JSONRPCRequest& request)
         result.pushKV("errors", errors);
     }
     result.pushKV("blocks", feeCalc.returnedTarget);
+    if (token) {
+        result.pushKV("token", feeCalc.token);
+    }
     return result;
 }
 
@@ -955,7 +964,7 @@ static const CRPCCommand commands[] =
     { "generating",         "getnewblock",            &getnewblock,            {"address", "required_age"} },
 
     { "hidden",             "estimatefee",            &estimatefee,            {} },
-    { "util",               "estimatesmartfee",       &estimatesmartfee,       {"conf_target", "estimate_mode"} },
+    { "util",               "estimatesmartfee",       &estimatesmartfee,       {"conf_target", "estimate_mode", "token"} },
 
     { "hidden",             "estimaterawfee",         &estimaterawfee,         {"conf_target", "threshold"} },
     { "mining",             "combineblocksigs",       &combineblocksigs,       {"block_hex", "signature_list"} },
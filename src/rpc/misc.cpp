@@ -7,6 +7,7 @@
 #include <clientversion.h>
 #include <core_io.h>
 #include <crypto/ripemd160.h>
+#include <dbwrapper.h>
 #include <key_io.h>
 #include <validation.h>
 #include <httpserver.h>
@@ -298,6 +299,31 @@ static std::string RPCMallocInfo()
 }
 #endif
 
+static UniValue RPCLevelDBInfo()
+{
+    UniValue obj(UniValue::VOBJ);
+    ForEachDBWrapper([&obj](const CDBWrapper& db) {
+        const DBProfile& profile = db.GetProfile();
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("backend", db.GetBackend());
+        entry.pushKV("profile", profile.name);
+        entry.pushKV("cache_size", (uint64_t)db.GetCacheSize());
+        entry.pushKV("block_cache", (uint64_t)(db.GetCacheSize() * profile.block_cache_ratio));
+        entry.pushKV("write_buffer", (uint64_t)(db.GetCacheSize() * profile.write_buffer_ratio));
+        entry.pushKV("max_file_size", (uint64_t)profile.max_file_size);
+        entry.pushKV("block_size", (uint64_t)profile.block_size);
+        entry.pushKV("compression", profile.compression);
+        entry.pushKV("memory_usage", (uint64_t)db.DynamicMemoryUsage());
+        UniValue files(UniValue::VARR);
+        for (int n : db.GetFilesPerLevel()) {
+            files.push_back(n);
+        }
+        entry.pushKV("files_per_level", files);
+        obj.pushKV(db.GetName(), entry);
+    });
+    return obj;
+}
+
 static UniValue getmemoryinfo(const JSONRPCRequest& request)
 {
     /* Please, avoid using the word "pool" here in the RPC interface or help,
@@ -311,6 +337,7 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
             "1. \"mode\" determines what kind of information is returned. This argument is optional, the default mode is \"stats\".\n"
             "  - \"stats\" returns general statistics about memory usage in the daemon.\n"
             "  - \"mallocinfo\" returns an XML string describing low-level heap state (only available if compiled with glibc 2.10+).\n"
+            "  - \"leveldb\" returns the storage engine, tuning and memory usage of each open database.\n"
             "\nResult (mode \"stats\"):\n"
             "{\n"
             "  \"locked\": {               (json object) Information about locked memory manager\n"
@@ -324,6 +351,21 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
             "\"<malloc version=\"1\">...\"\n"
+            "\nResult (mode \"leveldb\"):\n"
+            "{\n"
+            "  \"name\": {                 (json object) Database name, e.g. chainstate, index or txindex\n"
+            "    \"backend\": \"xxxx\",      (string) Storage engine, see -dbbackend\n"
+            "    \"profile\": \"xxxx\",      (string) LevelDB tuning profile, see -dbprofile\n"
+            "    \"cache_size\": xxxxx,    (numeric) Database cache in bytes\n"
+            "    \"block_cache\": xxxxx,   (numeric) Bytes of the cache used as block cache\n"
+            "    \"write_buffer\": xxxxx,  (numeric) Bytes per write buffer\n"
+            "    \"max_file_size\": xxxxx, (numeric) Size of the table files in bytes\n"
+            "    \"block_size\": xxxxx,    (numeric) Size of the table blocks in bytes\n"
+            "    \"compression\": true|false, (boolean) Whether table blocks are snappy compressed\n"
+            "    \"memory_usage\": xxxxx,  (numeric) Approximate memory used by LevelDB in bytes\n"
+            "    \"files_per_level\": [ n, ... ] (array) Number of table files at each level\n"
+            "  }, ...\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmemoryinfo", "")
             + HelpExampleRpc("getmemoryinfo", "")
@@ -340,6 +382,8 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
 #else
         throw JSONRPCError(RPC_INVALID_PARAMETER, "mallocinfo is only available when compiled with glibc 2.10+");
 #endif
+    } else if (mode == "leveldb") {
+        return RPCLevelDBInfo();
     } else {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "unknown mode " + mode);
     }
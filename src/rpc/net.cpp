@@ -397,6 +397,63 @@ static UniValue getnettotals(const JSONRPCRequest& request)
     return obj;
 }
 
+static UniValue getorphaninfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getorphaninfo\n"
+            "\nReturns information about the orphan transaction pool, which holds transactions whose inputs are not known yet.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"size\": xxxxx,               (numeric) Current number of orphan transactions\n"
+            "  \"usage\": xxxxx,              (numeric) Estimated memory usage of the orphans in bytes\n"
+            "  \"maxusage\": xxxxx,           (numeric) Memory usage the pool is kept below, see -maxorphansize\n"
+            "  \"added\": xxxxx,              (numeric) Orphans stored since startup\n"
+            "  \"resolved\": xxxxx,           (numeric) Orphans accepted to the mempool once their parents arrived\n"
+            "  \"rejected\": xxxxx,           (numeric) Orphans found invalid once their parents arrived\n"
+            "  \"expired\": xxxxx,            (numeric) Orphans removed after waiting too long for their parents\n"
+            "  \"evicted\": xxxxx,            (numeric) Orphans removed to keep the pool within its limits\n"
+            "  \"peer_disconnected\": xxxxx,  (numeric) Orphans removed because the peer that sent them disconnected\n"
+            "  \"block\": xxxxx,              (numeric) Orphans removed because a block included or conflicted with them\n"
+            "  \"peers\": [                   (array) Peers that sent the current orphans\n"
+            "    {\n"
+            "      \"id\": n,                 (numeric) Peer index, as in getpeerinfo\n"
+            "      \"size\": n,               (numeric) Number of orphans sent by this peer\n"
+            "      \"usage\": n               (numeric) Estimated memory usage of those orphans in bytes\n"
+            "    }\n"
+            "    ,...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getorphaninfo", "")
+            + HelpExampleRpc("getorphaninfo", "")
+        );
+
+    const OrphanPoolStats stats = GetOrphanPoolStats();
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("size", (uint64_t)stats.nOrphans);
+    obj.pushKV("usage", (uint64_t)stats.nUsage);
+    obj.pushKV("maxusage", std::max((int64_t)0, gArgs.GetArg("-maxorphansize", DEFAULT_MAX_ORPHAN_SIZE)) * 1000000);
+    obj.pushKV("added", stats.nAdded);
+    obj.pushKV("resolved", stats.nResolved);
+    obj.pushKV("rejected", stats.nRejected);
+    obj.pushKV("expired", stats.nExpired);
+    obj.pushKV("evicted", stats.nEvicted);
+    obj.pushKV("peer_disconnected", stats.nPeerErased);
+    obj.pushKV("block", stats.nBlockErased);
+    UniValue peers(UniValue::VARR);
+    for (const auto& peer : stats.mapPeers) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("id", peer.first);
+        entry.pushKV("size", (uint64_t)peer.second.first);
+        entry.pushKV("usage", (uint64_t)peer.second.second);
+        peers.push_back(entry);
+    }
+    obj.pushKV("peers", peers);
+    return obj;
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -638,6 +695,7 @@ static const CRPCCommand commands[] =
     { "network",            "getaddednodeinfo",       &getaddednodeinfo,       {"node"} },
     { "network",            "getnettotals",           &getnettotals,           {} },
     { "network",            "getnetworkinfo",         &getnetworkinfo,         {} },
+    { "network",            "getorphaninfo",          &getorphaninfo,          {} },
     { "network",            "setban",                 &setban,                 {"subnet", "command", "bantime", "absolute"} },
     { "network",            "listbanned",             &listbanned,             {} },
     { "network",            "clearbanned",            &clearbanned,            {} },
@@ -50,6 +50,12 @@ std::string JSONRPCReply(const UniValue& result, const UniValue& error, const Un
     return reply.write() + "\n";
 }
 
+std::string JSONRPCRawReplyObj(const std::string& result, const UniValue& id)
+{
+    // Written like JSONRPCReplyObj(...).write() with no error
+    return "{\"result\":" + result + ",\"error\":null,\"id\":" + id.write() + "}";
+}
+
 UniValue JSONRPCError(int code, const std::string& message)
 {
     UniValue error(UniValue::VOBJ);
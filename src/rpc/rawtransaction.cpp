@@ -10,6 +10,7 @@
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <index/txindex.h>
+#include <jsonwriter.h>
 #include <keystore.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -280,7 +281,7 @@ static UniValue gettxoutproof(const JSONRPCRequest& request)
     }
 
     CBlock block;
-    if(!ReadBlockFromDisk(block, pblockindex))
+    if(!ReadBlockFromDisk(block, pblockindex, true, true))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
 
     unsigned int ntxFound = 0;
@@ -573,6 +574,12 @@ static UniValue decoderawtransaction(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "TX decode failed");
     }
 
+    if (request.pRawResult) {
+        JSONWriter writer(*request.pRawResult);
+        WriteTxJSON(CTransaction(std::move(mtx)), uint256(), writer, false);
+        return NullUniValue;
+    }
+
     UniValue result(UniValue::VOBJ);
     TxToUniv(CTransaction(std::move(mtx)), uint256(), result, false);
 
@@ -1119,6 +1126,9 @@ static UniValue sendrawtransaction(const JSONRPCRequest& request)
     if (!request.params[1].isNull() && request.params[1].get_bool())
         nMaxRawTxFee = 0;
 
+    // Verify the signatures before taking cs_main for the admission.
+    PreCheckMempoolTransaction(tx);
+
     { // cs_main scope
     LOCK(cs_main);
     CCoinsViewCache &view = *pcoinsTip;
@@ -7,6 +7,7 @@
 #include <rpc/server.h>
 
 #include <fs.h>
+#include <httpserver.h>
 #include <key_io.h>
 #include <random.h>
 #include <shutdown.h>
@@ -14,6 +15,7 @@
 #include <ui_interface.h>
 #include <util.h>
 #include <utilstrencodings.h>
+#include <workerpool.h>
 
 #include <boost/signals2/signal.hpp>
 #include <boost/algorithm/string/case_conv.hpp> // for to_upper()
@@ -21,12 +23,25 @@
 #include <boost/algorithm/string/split.hpp>
 
 #include <memory> // for unique_ptr
+#include <set>
 #include <unordered_map>
 
+CWorkerPool g_rpc_workers;
+
 static Mutex cs_rpcWarmup;
 static bool fRPCRunning = false;
 static bool fRPCInWarmup GUARDED_BY(cs_rpcWarmup) = true;
 static std::string rpcWarmupStatus GUARDED_BY(cs_rpcWarmup) = "RPC server started";
+/** Execution statistics of one RPC method, see getrpcinfo */
+struct RPCMethodStats
+{
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    int64_t total_us = 0;
+    int64_t max_us = 0;
+};
+static Mutex cs_rpcStats;
+static std::map<std::string, RPCMethodStats> g_rpc_method_stats GUARDED_BY(cs_rpcStats);
 /* Timer-creating functions */
 static RPCTimerInterface* timerInterface = nullptr;
 /* Map of name to timer. */
@@ -267,6 +282,75 @@ static UniValue uptime(const JSONRPCRequest& jsonRequest)
     return GetTime() - GetStartupTime();
 }
 
+static UniValue getrpcinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 0)
+        throw std::runtime_error(
+            "getrpcinfo\n"
+            "\nReturns statistics of the HTTP work queues and of the RPC methods called since startup.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"queues\" : [              (json array) The HTTP work queues, empty without HTTP server\n"
+            "    {\n"
+            "      \"name\" : \"name\",      (string) fast, default or heavy\n"
+            "      \"threads\" : n,         (numeric) The number of worker threads\n"
+            "      \"depth\" : n,           (numeric) The number of requests waiting now\n"
+            "      \"max_depth\" : n,       (numeric) The most requests that waited at once\n"
+            "      \"limit\" : n,           (numeric) The maximum depth, see -rpcworkqueue\n"
+            "      \"processed\" : n,       (numeric) The number of requests taken by a worker\n"
+            "      \"rejected\" : n,        (numeric) The number of requests refused because the queue was full\n"
+            "      \"total_wait_us\" : n,   (numeric) The total time processed requests waited, in microseconds\n"
+            "      \"max_wait_us\" : n      (numeric) The longest time a request waited, in microseconds\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"methods\" : {\n"
+            "    \"method\" : {            (json object) One entry per method called\n"
+            "      \"calls\" : n,           (numeric) The number of calls\n"
+            "      \"errors\" : n,          (numeric) The number of calls that returned an error\n"
+            "      \"total_time_us\" : n,   (numeric) The total execution time, in microseconds\n"
+            "      \"max_time_us\" : n      (numeric) The longest execution time, in microseconds\n"
+            "    }, ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getrpcinfo", "")
+            + HelpExampleRpc("getrpcinfo", "")
+        );
+
+    UniValue queues(UniValue::VARR);
+    for (const HTTPWorkQueueInfo& info : GetHTTPWorkQueueInfo()) {
+        UniValue queue(UniValue::VOBJ);
+        queue.pushKV("name", info.name);
+        queue.pushKV("threads", info.threads);
+        queue.pushKV("depth", (uint64_t)info.depth);
+        queue.pushKV("max_depth", (uint64_t)info.max_depth);
+        queue.pushKV("limit", (uint64_t)info.limit);
+        queue.pushKV("processed", info.processed);
+        queue.pushKV("rejected", info.rejected);
+        queue.pushKV("total_wait_us", info.total_wait_us);
+        queue.pushKV("max_wait_us", info.max_wait_us);
+        queues.push_back(queue);
+    }
+
+    UniValue methods(UniValue::VOBJ);
+    {
+        LOCK(cs_rpcStats);
+        for (const auto& entry : g_rpc_method_stats) {
+            UniValue method(UniValue::VOBJ);
+            method.pushKV("calls", entry.second.calls);
+            method.pushKV("errors", entry.second.errors);
+            method.pushKV("total_time_us", entry.second.total_us);
+            method.pushKV("max_time_us", entry.second.max_us);
+            methods.pushKV(entry.first, method);
+        }
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("queues", queues);
+    result.pushKV("methods", methods);
+    return result;
+}
+
 /**
  * Call Table
  */
@@ -277,6 +361,7 @@ static const CRPCCommand vRPCCommands[] =
     { "control",            "help",                   &help,                   {"command"}  },
     { "control",            "stop",                   &stop,                   {}  },
     { "control",            "uptime",                 &uptime,                 {}  },
+    { "control",            "getrpcinfo",             &getrpcinfo,             {}  },
 };
 
 CRPCTable::CRPCTable()
@@ -317,6 +402,7 @@ void StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
     fRPCRunning = true;
+    g_rpc_workers.Start("rpcworker", std::max<int64_t>(gArgs.GetArg("-rpcworkerthreads", DEFAULT_RPC_WORKER_THREADS), 0));
     g_rpcSignals.Started();
 }
 
@@ -331,6 +417,7 @@ void StopRPC()
 {
     LogPrint(BCLog::RPC, "Stopping RPC\n");
     deadlineTimers.clear();
+    g_rpc_workers.Stop();
     DeleteAuthCookie();
     g_rpcSignals.Stopped();
 }
@@ -401,14 +488,18 @@ bool IsDeprecatedRPCEnabled(const std::string& method)
     return find(enabled_methods.begin(), enabled_methods.end(), method) != enabled_methods.end();
 }
 
-static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
+static std::string JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
 {
     UniValue rpc_result(UniValue::VOBJ);
+    std::string raw_result;
+    if (jreq.pRawResult) jreq.pRawResult = &raw_result;
 
     try {
         jreq.parse(req);
 
         UniValue result = tableRPC.execute(jreq);
+        if (!raw_result.empty())
+            return JSONRPCRawReplyObj(raw_result, jreq.id);
         rpc_result = JSONRPCReplyObj(result, NullUniValue, jreq.id);
     }
     catch (const UniValue& objError)
@@ -421,16 +512,74 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
                                      JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
     }
 
-    return rpc_result;
+    return rpc_result.write();
+}
+
+/**
+ * Methods that only read node state. Consecutive calls to them in a batch
+ * are executed in parallel.
+ */
+static const std::set<std::string> PARALLEL_BATCH_METHODS = {
+    "decoderawtransaction",
+    "decodescript",
+    "estimatesmartfee",
+    "getbestblockhash",
+    "getblock",
+    "getblockchaininfo",
+    "getblockcount",
+    "getblockhash",
+    "getblockheader",
+    "getblockstats",
+    "getchaintips",
+    "getmempoolancestors",
+    "getmempooldescendants",
+    "getmempoolentry",
+    "getmempoolinfo",
+    "getrawmempool",
+    "getrawtransaction",
+    "gettxout",
+    "gettxoutproof",
+    "validateaddress",
+    "verifytxoutproof",
+};
+
+static bool IsParallelBatchRequest(const UniValue& req)
+{
+    if (!req.isObject())
+        return false;
+    const UniValue& method = req.find_value("method");
+    return method.isStr() && PARALLEL_BATCH_METHODS.count(method.get_str());
 }
 
 std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    const size_t max_threads = std::max<int64_t>(gArgs.GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), 1);
+
+    std::vector<std::string> results(vReq.size());
+    size_t begin = 0;
+    while (begin < vReq.size()) {
+        // A run of read-only calls is spread over up to max_threads threads,
+        // this one and free shared workers; any other call runs alone, after
+        // the calls before it are done.
+        size_t end = begin + 1;
+        if (IsParallelBatchRequest(vReq[begin])) {
+            while (end < vReq.size() && IsParallelBatchRequest(vReq[end]))
+                end++;
+        }
+
+        g_rpc_workers.ForEach(end - begin, max_threads, [&](size_t i) {
+            results[begin + i] = JSONRPCExecOne(jreq, vReq[begin + i]);
+        });
+        begin = end;
+    }
 
-    return ret.write() + "\n";
+    // The replies are written already, some with a pre-serialized result.
+    std::string ret = "[";
+    for (const std::string& result : results) {
+        if (ret.size() > 1) ret += ',';
+        ret += result;
+    }
+    return ret + "]\n";
 }
 
 /**
@@ -499,14 +648,34 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
 
     g_rpcSignals.PreCommand(*pcmd);
 
+    // Record the execution time however the call ends
+    struct CallTimer {
+        const std::string& method;
+        const int64_t start = GetTimeMicros();
+        bool success = false;
+        ~CallTimer()
+        {
+            const int64_t elapsed = GetTimeMicros() - start;
+            LOCK(cs_rpcStats);
+            RPCMethodStats& stats = g_rpc_method_stats[method];
+            stats.calls++;
+            if (!success) stats.errors++;
+            stats.total_us += elapsed;
+            stats.max_us = std::max(stats.max_us, elapsed);
+        }
+    } timer{pcmd->name};
+
     try
     {
         // Execute, convert arguments to array if necessary
+        UniValue result;
         if (request.params.isObject()) {
-            return pcmd->actor(transformNamedArguments(request, pcmd->argNames));
+            result = pcmd->actor(transformNamedArguments(request, pcmd->argNames));
         } else {
-            return pcmd->actor(request);
+            result = pcmd->actor(request);
         }
+        timer.success = true;
+        return result;
     }
     catch (const std::exception& e)
     {
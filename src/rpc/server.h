@@ -18,7 +18,19 @@
 #include <univalue.h>
 #include <primitives/transaction.h>
 
+//! Default for -rpcbatchthreads
+static const int DEFAULT_RPC_BATCH_THREADS = 4;
+//! Default for -rpcworkerthreads
+static const int DEFAULT_RPC_WORKER_THREADS = 4;
+
 class CRPCCommand;
+class CWorkerPool;
+
+/**
+ * Threads for the RPC and REST requests that split their work into items,
+ * running from StartRPC() to StopRPC().
+ */
+extern CWorkerPool g_rpc_workers;
 
 namespace RPCServer
 {
@@ -45,8 +57,14 @@ public:
     std::string URI;
     std::string authUser;
     std::string peerAddr;
+    /**
+     * Set when the result is only written out as JSON, as by the HTTP
+     * server. A handler may then store its result here already serialized
+     * and return null; the reply holds this result instead.
+     */
+    std::string* pRawResult;
 
-    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false) {}
+    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false), pRawResult(nullptr) {}
     void parse(const UniValue& valRequest);
 };
 
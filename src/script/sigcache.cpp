@@ -5,6 +5,7 @@
 
 #include <script/sigcache.h>
 
+#include <hash.h>
 #include <memusage.h>
 #include <pubkey.h>
 #include <random.h>
@@ -13,51 +14,129 @@
 
 #include <cuckoocache.h>
 
-#include <thread>
-#include <shared_mutex>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <mutex>
 
 namespace {
+/**
+ * Entry of the signature cache: a salted 128 bit SipHash-2-4 of
+ * (signature hash || public key || signature).
+ *
+ * Both halves are atomics so that lookups can run without taking any lock
+ * while another thread inserts into the same shard. A lookup racing with an
+ * insert may observe one half of the old and one half of the new entry; that
+ * can only cause a spurious miss (the signature is then verified again), as
+ * the halves are outputs of independently keyed hashes unknown to an attacker.
+ */
+class SignatureCacheEntry
+{
+private:
+    std::atomic<uint64_t> m_a{0};
+    std::atomic<uint64_t> m_b{0};
+
+public:
+    SignatureCacheEntry() {}
+    SignatureCacheEntry(uint64_t a, uint64_t b) : m_a(a), m_b(b) {}
+    SignatureCacheEntry(const SignatureCacheEntry& other) : m_a(other.A()), m_b(other.B()) {}
+    SignatureCacheEntry& operator=(const SignatureCacheEntry& other)
+    {
+        m_a.store(other.A(), std::memory_order_relaxed);
+        m_b.store(other.B(), std::memory_order_relaxed);
+        return *this;
+    }
+
+    uint64_t A() const { return m_a.load(std::memory_order_relaxed); }
+    uint64_t B() const { return m_b.load(std::memory_order_relaxed); }
+
+    bool operator==(const SignatureCacheEntry& other) const
+    {
+        return A() == other.A() && B() == other.B();
+    }
+};
+
+/**
+ * Derives the eight CuckooCache hash functions from the two (already random)
+ * halves of an entry by double hashing.
+ */
+class SignatureCacheEntryHasher
+{
+public:
+    template <uint8_t hash_select>
+    uint32_t operator()(const SignatureCacheEntry& key) const
+    {
+        static_assert(hash_select <8, "SignatureCacheEntryHasher only has 8 hashes available.");
+        return (uint32_t)((key.A() + hash_select * key.B()) >> 32);
+    }
+};
+
 /**
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
+ *
+ * The cache is split into SIGCACHE_SHARDS independent CuckooCaches selected
+ * by the low bits of the entry. Lookups take no lock at all; inserts only
+ * lock the shard they write to, so script check threads rarely contend.
  */
 class CSignatureCache
 {
 private:
-     //! Entries are SHA256(nonce || signature hash || public key || signature):
-    uint256 nonce;
-    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
-    map_type setValid;
-    std::shared_mutex cs_sigcache;
+    //! Salted hashers for the two halves of an entry
+    CSipHasher m_hasher_a;
+    CSipHasher m_hasher_b;
+
+    typedef CuckooCache::cache<SignatureCacheEntry, SignatureCacheEntryHasher> map_type;
+    struct Shard {
+        map_type setValid;
+        //! Serializes inserts into this shard
+        std::mutex cs_insert;
+    };
+    std::array<Shard, SIGCACHE_SHARDS> m_shards;
+
+    Shard& GetShard(const SignatureCacheEntry& entry)
+    {
+        return m_shards[entry.B() & (SIGCACHE_SHARDS - 1)];
+    }
 
 public:
-    CSignatureCache()
+    CSignatureCache() : m_hasher_a(GetRand(std::numeric_limits<uint64_t>::max()), GetRand(std::numeric_limits<uint64_t>::max())),
+                        m_hasher_b(GetRand(std::numeric_limits<uint64_t>::max()), GetRand(std::numeric_limits<uint64_t>::max()))
     {
-        GetRandBytes(nonce.begin(), 32);
     }
 
-    void
-    ComputeEntry(uint256& entry, const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
+    SignatureCacheEntry
+    ComputeEntry(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey) const
     {
-        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(&vchSig[0], vchSig.size()).Finalize(entry.begin());
+        CSipHasher hasher_a(m_hasher_a);
+        CSipHasher hasher_b(m_hasher_b);
+        hasher_a.Write(hash.begin(), 32).Write(pubkey.begin(), pubkey.size()).Write(vchSig.data(), vchSig.size());
+        hasher_b.Write(hash.begin(), 32).Write(pubkey.begin(), pubkey.size()).Write(vchSig.data(), vchSig.size());
+        return SignatureCacheEntry(hasher_a.Finalize(), hasher_b.Finalize());
     }
 
     bool
-    Get(const uint256& entry, const bool erase)
+    Get(const SignatureCacheEntry& entry, const bool erase)
     {
-        std::shared_lock<std::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
+        return GetShard(entry).setValid.contains(entry, erase);
     }
 
-    void Set(uint256& entry)
+    void Set(const SignatureCacheEntry& entry)
     {
-        std::unique_lock<std::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
+        Shard& shard = GetShard(entry);
+        std::lock_guard<std::mutex> lock(shard.cs_insert);
+        shard.setValid.insert(entry);
     }
+
+    //! Not thread safe; must be called before the cache is used
     uint32_t setup_bytes(size_t n)
     {
-        return setValid.setup_bytes(n);
+        uint32_t nElems = 0;
+        for (Shard& shard : m_shards) {
+            nElems += shard.setValid.setup_bytes(n / SIGCACHE_SHARDS);
+        }
+        return nElems;
     }
 };
 
@@ -78,14 +157,13 @@ void InitSignatureCache()
     // setup_bytes creates the minimum possible cache (2 elements).
     size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE) / 2), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
     size_t nElems = signatureCache.setup_bytes(nMaxCacheSize);
-    LogPrintf("Using %zu MiB out of %zu/2 requested for signature cache, able to store %zu elements\n",
-            (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
+    LogPrintf("Using %zu MiB out of %zu/2 requested for signature cache (%u shards), able to store %zu elements\n",
+            (nElems*sizeof(SignatureCacheEntry)) >>20, (nMaxCacheSize*2)>>20, SIGCACHE_SHARDS, nElems);
 }
 
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
-    uint256 entry;
-    signatureCache.ComputeEntry(entry, sighash, vchSig, pubkey);
+    const SignatureCacheEntry entry = signatureCache.ComputeEntry(sighash, vchSig, pubkey);
     if (signatureCache.Get(entry, !store))
         return true;
     if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash))
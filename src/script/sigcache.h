@@ -16,6 +16,8 @@
 static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+// Number of independently locked parts the signature cache is split into (power of two)
+static const unsigned int SIGCACHE_SHARDS = 16;
 
 class CPubKey;
 
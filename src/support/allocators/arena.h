@@ -0,0 +1,85 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SUPPORT_ALLOCATORS_ARENA_H
+#define BITCOIN_SUPPORT_ALLOCATORS_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Memory handed out in order from a few large chunks, which are all freed
+ * together when the arena is destroyed. Freeing a single allocation does
+ * nothing.
+ *
+ * Allocation is not thread safe. Objects allocated in the arena may be
+ * destroyed from any thread.
+ */
+class MonotonicArena
+{
+private:
+    std::vector<std::unique_ptr<unsigned char[]>> m_chunks;
+    const size_t m_chunk_size;
+    unsigned char* m_next;
+    size_t m_left;
+
+public:
+    explicit MonotonicArena(size_t chunk_size) : m_chunk_size(std::max<size_t>(chunk_size, 256)), m_next(nullptr), m_left(0) {}
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    void* Allocate(size_t size, size_t align)
+    {
+        size_t pad = (align - reinterpret_cast<uintptr_t>(m_next) % align) % align;
+        if (m_next == nullptr || pad + size > m_left) {
+            // Allocations larger than a chunk get a chunk of their own.
+            const size_t chunk_size = std::max(m_chunk_size, size + align);
+            m_chunks.emplace_back(new unsigned char[chunk_size]);
+            m_next = m_chunks.back().get();
+            m_left = chunk_size;
+            pad = (align - reinterpret_cast<uintptr_t>(m_next) % align) % align;
+        }
+        void* p = m_next + pad;
+        m_next += pad + size;
+        m_left -= pad + size;
+        return p;
+    }
+
+    //! Number of chunks allocated so far
+    size_t ChunkCount() const { return m_chunks.size(); }
+};
+
+/**
+ * Allocator for objects in a MonotonicArena. Every copy keeps the arena
+ * alive, so an object allocated with std::allocate_shared keeps the arena
+ * until its last reference is gone.
+ */
+template <typename T>
+struct arena_allocator {
+    typedef T value_type;
+
+    std::shared_ptr<MonotonicArena> arena;
+
+    explicit arena_allocator(std::shared_ptr<MonotonicArena> arena_in) noexcept : arena(std::move(arena_in)) {}
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(arena->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {}
+
+    template <typename U>
+    bool operator==(const arena_allocator<U>& other) const noexcept { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const arena_allocator<U>& other) const noexcept { return arena != other.arena; }
+};
+
+#endif // BITCOIN_SUPPORT_ALLOCATORS_ARENA_H
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+#include <script/standard.h>
+#include <test/test_tapyrus.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(addressindex_initial_sync, TestChainSetup)
+{
+    AddressIndex index(1 << 20, true);
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // Nothing should be found in the index before it is started.
+    std::vector<AddressIndexEntry> entries;
+    BOOST_CHECK(index.FindHistory(coinbase_script, 0, 100, entries));
+    BOOST_CHECK(entries.empty());
+
+    index.Start();
+
+    // Allow the index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // The coinbase outputs of the blocks before the index started are there, in order.
+    BOOST_CHECK(index.FindHistory(coinbase_script, 0, 100, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), m_coinbase_txns.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        BOOST_CHECK_EQUAL(entries[i].height, (int)i + 1);
+        BOOST_CHECK(entries[i].txid == m_coinbase_txns[i]->GetHashMalFix());
+        BOOST_CHECK(!entries[i].spending);
+        BOOST_CHECK_EQUAL(entries[i].n, 0U);
+        BOOST_CHECK_EQUAL(entries[i].value, m_coinbase_txns[i]->vout[0].nValue);
+        BOOST_CHECK(entries[i].color.type == TokenTypes::NONE);
+    }
+    BOOST_CHECK(index.FindUnspent(coinbase_script, 0, 100, entries));
+    BOOST_CHECK_EQUAL(entries.size(), m_coinbase_txns.size());
+
+    // Pages
+    BOOST_CHECK(index.FindHistory(coinbase_script, 1, 2, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 2U);
+    BOOST_CHECK_EQUAL(entries[0].height, 2);
+    BOOST_CHECK_EQUAL(entries[1].height, 3);
+    BOOST_CHECK(index.FindUnspent(coinbase_script, 4, 100, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 1U);
+    BOOST_CHECK_EQUAL(entries[0].height, 5);
+
+    // Spend the first coinbase output to another script in a new block.
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript other_script = GetScriptForDestination(key.GetPubKey().GetID());
+    const COutPoint spent_outpoint(m_coinbase_txns[0]->GetHashMalFix(), 0);
+    CMutableTransaction spend;
+    spend.nFeatures = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = spent_outpoint;
+    spend.vout.resize(1);
+    spend.vout[0].nValue = m_coinbase_txns[0]->vout[0].nValue - 1000;
+    spend.vout[0].scriptPubKey = other_script;
+    std::vector<unsigned char> sig;
+    uint256 hash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign_ECDSA(hash, sig));
+    sig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << sig;
+    const CBlock block = CreateAndProcessBlock({spend}, coinbase_script);
+    BOOST_REQUIRE_EQUAL(block.vtx.size(), 2U);
+
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+
+    // The new coinbase output comes before the input of the second transaction.
+    BOOST_CHECK(index.FindHistory(coinbase_script, 0, 100, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), m_coinbase_txns.size() + 2);
+    const AddressIndexEntry& funding = entries[entries.size() - 2];
+    const AddressIndexEntry& spending = entries.back();
+    BOOST_CHECK(!funding.spending);
+    BOOST_CHECK(funding.txid == block.vtx[0]->GetHashMalFix());
+    BOOST_CHECK(spending.spending);
+    BOOST_CHECK(spending.txid == block.vtx[1]->GetHashMalFix());
+    BOOST_CHECK_EQUAL(spending.tx_pos, 1U);
+    BOOST_CHECK(spending.prevout == spent_outpoint);
+    BOOST_CHECK_EQUAL(spending.value, m_coinbase_txns[0]->vout[0].nValue);
+    BOOST_CHECK(spending.block_hash == block.GetHash());
+
+    // The spent output is no longer unspent; the new ones are.
+    BOOST_CHECK(index.FindUnspent(coinbase_script, 0, 100, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), m_coinbase_txns.size());
+    BOOST_CHECK_EQUAL(entries[0].height, 2);
+    BOOST_CHECK(entries.back().txid == block.vtx[0]->GetHashMalFix());
+    BOOST_CHECK(index.FindUnspent(coinbase_script, 1, 2, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 2U);
+    BOOST_CHECK_EQUAL(entries[0].height, 3);
+    BOOST_CHECK_EQUAL(entries[1].height, 4);
+    BOOST_CHECK(index.FindUnspent(other_script, 0, 100, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 1U);
+    BOOST_CHECK(entries[0].txid == spend.GetHashMalFix());
+    BOOST_CHECK_EQUAL(entries[0].value, spend.vout[0].nValue);
+
+    index.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_AUTO_TEST_SUITE_END()
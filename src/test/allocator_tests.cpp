@@ -5,8 +5,12 @@
 
 #include <util.h>
 
+#include <primitives/block.h>
+#include <streams.h>
+#include <support/allocators/arena.h>
 #include <support/allocators/secure.h>
 #include <test/test_tapyrus.h>
+#include <version.h>
 
 #include <memory>
 
@@ -234,4 +238,82 @@ BOOST_AUTO_TEST_CASE(lockedpool_tests_live)
     BOOST_CHECK(pool.stats().used == initial.used);
 }
 
+BOOST_AUTO_TEST_CASE(monotonic_arena_tests)
+{
+    MonotonicArena arena(1024);
+    BOOST_CHECK_EQUAL(arena.ChunkCount(), 0U);
+
+    unsigned char* a = static_cast<unsigned char*>(arena.Allocate(1, 1));
+    uint64_t* b = static_cast<uint64_t*>(arena.Allocate(sizeof(uint64_t), alignof(uint64_t)));
+    BOOST_CHECK_EQUAL(arena.ChunkCount(), 1U);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(b) % alignof(uint64_t), 0U);
+    BOOST_CHECK(reinterpret_cast<unsigned char*>(b) > a);
+    *b = 0x1234;
+    BOOST_CHECK(*b == 0x1234);
+
+    // What does not fit in the chunk goes to the next one
+    arena.Allocate(1000, 1);
+    BOOST_CHECK_EQUAL(arena.ChunkCount(), 2U);
+    // Larger than a chunk
+    arena.Allocate(4096, 16);
+    BOOST_CHECK_EQUAL(arena.ChunkCount(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocator_shared_tests)
+{
+    auto arena = std::make_shared<MonotonicArena>(1024);
+    std::weak_ptr<MonotonicArena> arena_ref = arena;
+    std::shared_ptr<const std::string> a = std::allocate_shared<const std::string>(arena_allocator<std::string>(arena), "a");
+    std::shared_ptr<const std::string> b = std::allocate_shared<const std::string>(arena_allocator<std::string>(arena), "b");
+    arena.reset();
+
+    // The arena lives as long as any of the objects in it
+    BOOST_CHECK_EQUAL(*a, "a");
+    a.reset();
+    BOOST_CHECK(!arena_ref.expired());
+    BOOST_CHECK_EQUAL(*b, "b");
+    b.reset();
+    BOOST_CHECK(arena_ref.expired());
+}
+
+BOOST_AUTO_TEST_CASE(arena_block_unserialize)
+{
+    CBlock block;
+    block.nFeatures = 1;
+    block.hashPrevBlock = InsecureRand256();
+    for (int i = 0; i < 3; ++i) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(i + 1);
+        mtx.vin[0].prevout = COutPoint(InsecureRand256(), i);
+        mtx.vin[0].scriptSig = CScript() << std::vector<unsigned char>(72, i) << std::vector<unsigned char>(33, i);
+        mtx.vout.resize(2);
+        mtx.vout[0].nValue = i;
+        mtx.vout[1].scriptPubKey = CScript() << OP_RETURN;
+        block.vtx.push_back(MakeTransactionRef(std::move(mtx)));
+    }
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << block;
+    const std::string serialized = stream.str();
+
+    CBlock arena_block;
+    UnserializeBlockInArena(stream, arena_block);
+    BOOST_CHECK(stream.empty());
+    BOOST_CHECK(arena_block.GetHash() == block.GetHash());
+    BOOST_REQUIRE_EQUAL(arena_block.vtx.size(), block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        BOOST_CHECK(arena_block.vtx[i]->GetHash() == block.vtx[i]->GetHash());
+        BOOST_CHECK(arena_block.vtx[i]->GetHashMalFix() == block.vtx[i]->GetHashMalFix());
+    }
+    CDataStream reserialized(SER_NETWORK, PROTOCOL_VERSION);
+    reserialized << arena_block;
+    BOOST_CHECK(reserialized.str() == serialized);
+
+    // A transaction kept after the block is gone is still intact
+    CTransactionRef tx = arena_block.vtx[2];
+    arena_block.SetNull();
+    BOOST_CHECK(tx->GetHash() == block.vtx[2]->GetHash());
+    BOOST_CHECK(tx->vin[0].scriptSig == block.vtx[2]->vin[0].scriptSig);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,121 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockstatsindex.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <test/test_tapyrus.h>
+#include <undo.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(blockstatsindex_tests)
+
+static std::string SerializeStats(const BlockStats& stats)
+{
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << stats;
+    return ss.str();
+}
+
+static BlockStats StatsFromDisk(const CBlockIndex* pindex)
+{
+    CBlock block;
+    BOOST_REQUIRE(ReadBlockFromDisk(block, pindex));
+    CBlockUndo blockundo;
+    BOOST_REQUIRE(pindex->nHeight == 0 || UndoReadFromDisk(blockundo, pindex));
+
+    BlockStats stats;
+    ComputeBlockStats(block, [&](size_t n_tx, size_t n_in) -> const CTxOut& {
+        return blockundo.vtxundo.at(n_tx - 1).vprevout.at(n_in).out;
+    }, stats);
+    return stats;
+}
+
+BOOST_FIXTURE_TEST_CASE(blockstatsindex_initial_sync, TestChainSetup)
+{
+    BlockStatsIndex index(1 << 20, true);
+
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(cs_main);
+        for (int height = 0; height <= chainActive.Height(); ++height) {
+            blocks.push_back(chainActive[height]);
+        }
+    }
+
+    // Nothing should be found in the index before it is started.
+    BlockStats stats;
+    std::vector<BlockStats> range_stats;
+    BOOST_CHECK(!index.LookupStats(blocks.back(), stats));
+    BOOST_CHECK_EQUAL(index.LookupStatsRange(blocks, range_stats), 0U);
+
+    index.Start();
+
+    // Allow the index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // The index has the statistics of all blocks that were in the chain before it started.
+    BOOST_CHECK_EQUAL(index.LookupStatsRange(blocks, range_stats), blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        BOOST_REQUIRE(index.LookupStats(blocks[i], stats));
+        BOOST_CHECK_EQUAL(stats.txs, 1);
+        BOOST_CHECK_EQUAL(SerializeStats(stats), SerializeStats(StatsFromDisk(blocks[i])));
+        BOOST_CHECK_EQUAL(SerializeStats(range_stats[i]), SerializeStats(stats));
+    }
+
+    // A block that is not the one indexed at its height is not found.
+    const uint256 other_hash = InsecureRand256();
+    CBlockIndex other_block;
+    other_block.nHeight = blocks.back()->nHeight;
+    other_block.phashBlock = &other_hash;
+    BOOST_CHECK(!index.LookupStats(&other_block, stats));
+    std::vector<const CBlockIndex*> other_blocks = blocks;
+    other_blocks.back() = &other_block;
+    BOOST_CHECK_EQUAL(index.LookupStatsRange(other_blocks, range_stats), blocks.size() - 1);
+
+    // A new block spending a coinbase output makes it into the index with its fee.
+    CScript script_pub_key = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.nFeatures = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHashMalFix(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = m_coinbase_txns[0]->vout[0].nValue - 1000;
+    spend.vout[0].scriptPubKey = script_pub_key;
+    std::vector<unsigned char> sig;
+    uint256 hash = SignatureHash(script_pub_key, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign_ECDSA(hash, sig));
+    sig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << sig;
+
+    CreateAndProcessBlock({spend}, script_pub_key);
+    const CBlockIndex* tip;
+    {
+        LOCK(cs_main);
+        tip = chainActive.Tip();
+    }
+    BOOST_REQUIRE_EQUAL(tip->nHeight, blocks.back()->nHeight + 1);
+
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    BOOST_REQUIRE(index.LookupStats(tip, stats));
+    BOOST_CHECK_EQUAL(stats.txs, 2);
+    BOOST_CHECK_EQUAL(stats.ins, 1);
+    BOOST_CHECK_EQUAL(stats.totalfee, 1000);
+    BOOST_CHECK_EQUAL(stats.minfee, 1000);
+    BOOST_CHECK_EQUAL(stats.maxfee, 1000);
+    BOOST_CHECK_EQUAL(SerializeStats(stats), SerializeStats(StatsFromDisk(tip)));
+
+    index.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_AUTO_TEST_SUITE_END()
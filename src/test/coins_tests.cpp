@@ -866,4 +866,33 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_peek)
+{
+    CCoinsViewTest base;
+    const COutPoint in_base(InsecureRand256(), 0);
+    const COutPoint in_cache(InsecureRand256(), 1);
+    const COutPoint spent(InsecureRand256(), 2);
+    {
+        CCoinsViewCache parent(&base);
+        parent.AddCoin(in_base, Coin(CTxOut(VALUE1, CScript() << OP_TRUE), 1, false), false);
+        parent.AddCoin(spent, Coin(CTxOut(VALUE1, CScript() << OP_TRUE), 1, false), false);
+        parent.Flush();
+    }
+
+    CCoinsViewCache cache(&base);
+    cache.AddCoin(in_cache, Coin(CTxOut(VALUE2, CScript() << OP_TRUE), 2, false), false);
+    BOOST_CHECK(cache.SpendCoin(spent));
+
+    // Peeking never pulls coins from the base into the cache.
+    Coin coin;
+    BOOST_CHECK(!cache.PeekCoin(in_base, coin));
+    BOOST_CHECK(!cache.HaveCoinInCache(in_base));
+    BOOST_CHECK(cache.PeekCoin(in_cache, coin));
+    BOOST_CHECK_EQUAL(coin.out.nValue, VALUE2);
+    // A coin spent in the cache is reported, so that the base is not asked.
+    BOOST_CHECK(cache.PeekCoin(spent, coin));
+    BOOST_CHECK(coin.IsSpent());
+    BOOST_CHECK(base.GetCoin(spent, coin) && !coin.IsSpent());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
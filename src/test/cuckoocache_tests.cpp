@@ -10,6 +10,7 @@
 #include <thread>
 #include <shared_mutex>
 #include <deque>
+#include <mutex>
 
 /** Test Suite for CuckooCache
  *
@@ -284,6 +285,90 @@ BOOST_AUTO_TEST_CASE(cuckoocache_erase_parallel_ok)
     test_cache_erase_parallel<CuckooCache::cache<uint256, SignatureCacheHasher>>(megabytes);
 }
 
+/** An element made of two relaxed atomics, like the signature cache's, that
+ * may be looked up while another thread inserts.
+ */
+class AtomicPair
+{
+    std::atomic<uint64_t> m_a{0};
+    std::atomic<uint64_t> m_b{0};
+
+public:
+    AtomicPair() {}
+    AtomicPair(uint64_t a, uint64_t b) : m_a(a), m_b(b) {}
+    AtomicPair(const AtomicPair& other) : m_a(other.A()), m_b(other.B()) {}
+    AtomicPair& operator=(const AtomicPair& other)
+    {
+        m_a.store(other.A(), std::memory_order_relaxed);
+        m_b.store(other.B(), std::memory_order_relaxed);
+        return *this;
+    }
+    uint64_t A() const { return m_a.load(std::memory_order_relaxed); }
+    uint64_t B() const { return m_b.load(std::memory_order_relaxed); }
+    bool operator==(const AtomicPair& other) const { return A() == other.A() && B() == other.B(); }
+};
+
+struct AtomicPairHasher
+{
+    template <uint8_t hash_select>
+    uint32_t operator()(const AtomicPair& key) const
+    {
+        return (uint32_t)((key.A() + hash_select * key.B()) >> 32);
+    }
+};
+
+/* Test that lookups running during inserts never find an element that was
+ * not inserted, and that they find the inserted ones apart from spurious
+ * misses.
+ */
+BOOST_AUTO_TEST_CASE(cuckoocache_concurrent_insert_contains)
+{
+    local_rand_ctx = FastRandomContext(true);
+    CuckooCache::cache<AtomicPair, AtomicPairHasher> set{};
+    const uint32_t n_slots = set.setup_bytes(1 << 20);
+    const uint32_t n_insert = n_slots / 2;
+    std::vector<AtomicPair> inserted, fakes;
+    for (uint32_t i = 0; i < n_insert; ++i) {
+        inserted.emplace_back(local_rand_ctx.rand64(), local_rand_ctx.rand64());
+        fakes.emplace_back(local_rand_ctx.rand64(), local_rand_ctx.rand64());
+    }
+
+    std::mutex cs_insert;
+    std::atomic<uint32_t> n_published{0};
+    std::atomic<size_t> n_hits{0};
+    std::atomic<size_t> n_fake_hits{0};
+    std::vector<std::thread> readers;
+    for (int x = 0; x < 3; ++x) {
+        readers.emplace_back([&, x] {
+            FastRandomContext rng(uint256S(strprintf("%d", x + 1)));
+            uint32_t published;
+            while ((published = n_published.load(std::memory_order_acquire)) < n_insert) {
+                if (published == 0) continue;
+                n_hits += set.contains(inserted[rng.randrange(published)], false);
+                n_fake_hits += set.contains(fakes[rng.randrange(n_insert)], false);
+            }
+        });
+    }
+    for (uint32_t i = 0; i < n_insert; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(cs_insert);
+            set.insert(inserted[i]);
+        }
+        n_published.store(i + 1, std::memory_order_release);
+    }
+    for (std::thread& t : readers) {
+        t.join();
+    }
+
+    BOOST_CHECK_EQUAL(n_fake_hits.load(), 0U);
+    BOOST_CHECK(n_hits.load() > 0);
+    size_t n_contained = 0;
+    for (const AtomicPair& e : inserted) {
+        n_contained += set.contains(e, false);
+    }
+    BOOST_CHECK(n_contained > n_insert * 0.95);
+}
+
 
 template <typename Cache>
 static void test_cache_generations()
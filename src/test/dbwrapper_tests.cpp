@@ -3,6 +3,10 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <dbwrapper.h>
 #include <uint256.h>
 #include <random.h>
@@ -319,5 +323,161 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
 }
 
 
+BOOST_AUTO_TEST_CASE(dbwrapper_profiles)
+{
+    BOOST_CHECK(LookupDBProfile(DEFAULT_DB_PROFILE) != nullptr);
+    BOOST_CHECK(LookupDBProfile("bulkload") != nullptr);
+    BOOST_CHECK(LookupDBProfile("unknown") == nullptr);
+    BOOST_CHECK(!LookupDBProfile(DEFAULT_DB_PROFILE)->compression);
+#if USE_SNAPPY
+    BOOST_CHECK(LookupDBProfile("compressed")->compression);
+    BOOST_CHECK_EQUAL(DEFAULT_INDEX_DB_PROFILE, "compressed");
+#else
+    // Without snappy the profile is not offered, rather than silently storing uncompressed blocks.
+    BOOST_CHECK(LookupDBProfile("compressed") == nullptr);
+    BOOST_CHECK_EQUAL(DEFAULT_INDEX_DB_PROFILE, DEFAULT_DB_PROFILE);
+#endif
+
+    // Without -dbprofile every database uses its default.
+    BOOST_CHECK_EQUAL(GetDBProfile("dbprofile_test").name, DEFAULT_DB_PROFILE);
+    BOOST_CHECK_EQUAL(GetDBProfile("dbprofile_test", "bulkload").name, "bulkload");
+
+    std::string error;
+    gArgs.ForceSetArg("-dbprofile", "dbprofile_test:unknown");
+    BOOST_CHECK(!CheckDBProfileArgs(error));
+    gArgs.ForceSetArg("-dbprofile", "bulkload");
+    BOOST_CHECK(!CheckDBProfileArgs(error));
+
+    gArgs.ForceSetArg("-dbprofile", "dbprofile_test:bulkload");
+    BOOST_CHECK(CheckDBProfileArgs(error));
+    BOOST_CHECK_EQUAL(GetDBProfile("dbprofile_test", DEFAULT_DB_PROFILE).name, "bulkload");
+    BOOST_CHECK_EQUAL(GetDBProfile("chainstate").name, DEFAULT_DB_PROFILE);
+    {
+        // The database is selected by the last component of its path and shows up in the registry.
+        fs::path ph = SetDataDir("dbwrapper_profiles") / "dbprofile_test";
+        CDBWrapper dbw(ph, (1 << 20), true, false, false);
+        BOOST_CHECK_EQUAL(dbw.GetProfile().name, "bulkload");
+        BOOST_CHECK_EQUAL(dbw.GetCacheSize(), 1U << 20);
+        BOOST_CHECK(dbw.Write('k', InsecureRand256()));
+        BOOST_CHECK(!dbw.GetFilesPerLevel().empty());
+
+        int found = 0;
+        ForEachDBWrapper([&](const CDBWrapper& db) {
+            if (&db == &dbw) ++found;
+        });
+        BOOST_CHECK_EQUAL(found, 1);
+    }
+    ForEachDBWrapper([&](const CDBWrapper& db) {
+        BOOST_CHECK(db.GetName() != "dbprofile_test");
+    });
+    gArgs.ForceSetArg("-dbprofile", "dbprofile_test:default");
+}
+
+#if USE_SNAPPY
+BOOST_AUTO_TEST_CASE(dbwrapper_compressed_profile)
+{
+    // Write enough compressible data to an on-disk database to get table files,
+    // then read it back after reopening.
+    fs::path ph = SetDataDir("dbwrapper_compressed_profile") / "dbprofile_compressed";
+    const std::vector<unsigned char> value(1000, 'x');
+    {
+        CDBWrapper dbw(ph, (1 << 20), false, true, false, "compressed");
+        BOOST_CHECK(dbw.GetProfile().compression);
+        for (uint32_t i = 0; i < 10000; ++i) {
+            BOOST_CHECK(dbw.Write(std::make_pair('k', i), value));
+        }
+        dbw.CompactRange('k', 'l');
+    }
+    CDBWrapper dbw(ph, (1 << 20), false, false, false, "compressed");
+    for (uint32_t i = 0; i < 10000; i += 97) {
+        std::vector<unsigned char> res;
+        BOOST_CHECK(dbw.Read(std::make_pair('k', i), res));
+        BOOST_CHECK(res == value);
+    }
+    // About 10 MB of values take far less space once compressed.
+    BOOST_CHECK_LT(dbw.EstimateSize('k', 'l'), 1000000U);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(dbwrapper_memory_backend)
+{
+    gArgs.ForceSetArg("-dbbackend", "memory");
+    {
+        fs::path ph = SetDataDir("dbwrapper_memory_backend") / "db";
+        CDBWrapper dbw(ph, (1 << 20), false, false, true);
+        BOOST_CHECK_EQUAL(dbw.GetBackend(), "memory");
+        // Nothing is created on disk.
+        BOOST_CHECK(!fs::exists(ph));
+        BOOST_CHECK(!is_null_key(dbwrapper_private::GetObfuscateKey(dbw)));
+
+        CDBBatch batch(dbw);
+        for (uint8_t x = 0; x < 10; ++x) {
+            batch.Write(x, uint32_t(x * x));
+        }
+        BOOST_CHECK(dbw.WriteBatch(batch, true));
+        BOOST_CHECK(dbw.Erase(uint8_t(3)));
+        BOOST_CHECK(!dbw.Exists(uint8_t(3)));
+        BOOST_CHECK(dbw.Write(uint8_t(4), uint32_t(17)));
+        BOOST_CHECK(dbw.EstimateSize(uint8_t(0), uint8_t(10)) > 0);
+        BOOST_CHECK(dbw.DynamicMemoryUsage() > 0);
+
+        // Iterators see the database as it was when they were created.
+        const size_t usage_before = dbw.DynamicMemoryUsage();
+        std::unique_ptr<CDBIterator> it(dbw.NewIterator());
+        BOOST_CHECK(dbw.Write(uint8_t(5), uint32_t(0)));
+        BOOST_CHECK(dbw.Erase(uint8_t(6)));
+        // The versions the iterator can see are kept until it is gone.
+        BOOST_CHECK(dbw.DynamicMemoryUsage() > usage_before);
+
+        it->Seek(uint8_t(2));
+        for (uint8_t x : {2, 4, 5, 6, 7, 8, 9}) {
+            uint8_t key;
+            uint32_t value;
+            BOOST_REQUIRE(it->Valid());
+            BOOST_CHECK(it->GetKey(key));
+            BOOST_CHECK(it->GetValue(value));
+            BOOST_CHECK_EQUAL(key, x);
+            BOOST_CHECK_EQUAL(value, x == 4 ? 17U : uint32_t(x * x));
+            it->Next();
+        }
+        BOOST_CHECK(!it->Valid());
+        it.reset();
+        BOOST_CHECK(dbw.DynamicMemoryUsage() < usage_before);
+
+        uint32_t value;
+        BOOST_CHECK(dbw.Read(uint8_t(5), value));
+        BOOST_CHECK_EQUAL(value, 0U);
+        BOOST_CHECK(!dbw.Exists(uint8_t(6)));
+    }
+    gArgs.ForceSetArg("-dbbackend", DEFAULT_DB_BACKEND);
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_snapshot)
+{
+    for (const std::string& backend : std::vector<std::string>{DEFAULT_DB_BACKEND, "memory"}) {
+        gArgs.ForceSetArg("-dbbackend", backend);
+        fs::path ph = SetDataDir("dbwrapper_snapshot_" + backend);
+        CDBWrapper dbw(ph, (1 << 20), true, false, true);
+        BOOST_CHECK(dbw.Write(uint8_t(1), uint32_t(1)));
+        BOOST_CHECK(dbw.Write(uint8_t(2), uint32_t(2)));
+
+        // Reads through a snapshot do not see the writes done after it.
+        CDBSnapshot snapshot(dbw);
+        BOOST_CHECK(dbw.Write(uint8_t(1), uint32_t(10)));
+        BOOST_CHECK(dbw.Erase(uint8_t(2)));
+        BOOST_CHECK(dbw.Write(uint8_t(3), uint32_t(3)));
+
+        uint32_t value;
+        BOOST_CHECK(snapshot.Read(uint8_t(1), value));
+        BOOST_CHECK_EQUAL(value, 1U);
+        BOOST_CHECK(snapshot.Read(uint8_t(2), value));
+        BOOST_CHECK_EQUAL(value, 2U);
+        BOOST_CHECK(!snapshot.Read(uint8_t(3), value));
+        BOOST_CHECK(dbw.Read(uint8_t(1), value));
+        BOOST_CHECK_EQUAL(value, 10U);
+        BOOST_CHECK(!dbw.Exists(uint8_t(2)));
+    }
+    gArgs.ForceSetArg("-dbbackend", DEFAULT_DB_BACKEND);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -17,19 +17,22 @@
 #include <test/test_tapyrus.h>
 
 #include <stdint.h>
+#include <limits>
 
 #include <boost/test/unit_test.hpp>
 
 // Tests these internal-to-net_processing.cpp methods:
 extern bool AddOrphanTx(const CTransactionRef& tx, NodeId peer);
 extern void EraseOrphansFor(NodeId peer);
-extern unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans);
+extern unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans, size_t nMaxUsage);
 extern void Misbehaving(NodeId nodeid, int howmuch, const std::string& message="");
 
 struct COrphanTx {
     CTransactionRef tx;
     NodeId fromPeer;
     int64_t nTimeExpire;
+    size_t nUsage;
+    size_t list_pos;
 };
 extern std::map<uint256, COrphanTx> mapOrphanTransactions;
 
@@ -408,12 +411,57 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
     }
 
     // Test LimitOrphanTxSize() function:
-    LimitOrphanTxSize(40);
+    const size_t nMaxUsage = std::numeric_limits<size_t>::max();
+    LimitOrphanTxSize(40, nMaxUsage);
     BOOST_CHECK(mapOrphanTransactions.size() <= 40);
-    LimitOrphanTxSize(10);
+    LimitOrphanTxSize(10, nMaxUsage);
     BOOST_CHECK(mapOrphanTransactions.size() <= 10);
-    LimitOrphanTxSize(0);
+    LimitOrphanTxSize(0, nMaxUsage);
     BOOST_CHECK(mapOrphanTransactions.empty());
+    BOOST_CHECK_EQUAL(GetOrphanPoolStats().nUsage, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(DoS_mapOrphans_usage)
+{
+    // Peer 0 floods the pool, peer 1 sends a single orphan.
+    for (int i = 0; i < 101; i++)
+    {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout.n = 0;
+        tx.vin[0].prevout.hashMalFix = InsecureRand256();
+        tx.vin[0].scriptSig << OP_1;
+        tx.vout.resize(1);
+        tx.vout[0].nValue = 1*CENT;
+        BOOST_CHECK(AddOrphanTx(MakeTransactionRef(tx), i < 100 ? 0 : 1));
+    }
+
+    OrphanPoolStats stats = GetOrphanPoolStats();
+    BOOST_CHECK_EQUAL(stats.nOrphans, 101U);
+    BOOST_CHECK_EQUAL(stats.mapPeers.size(), 2U);
+    BOOST_CHECK_EQUAL(stats.mapPeers[0].first, 100U);
+    BOOST_CHECK_EQUAL(stats.mapPeers[1].first, 1U);
+    BOOST_CHECK_EQUAL(stats.mapPeers[0].second + stats.mapPeers[1].second, stats.nUsage);
+
+    // Halving the memory limit only evicts orphans of the peer using the most.
+    LOCK(cs_main);
+    const size_t nMaxUsage = stats.nUsage / 2;
+    const unsigned int nEvicted = LimitOrphanTxSize(std::numeric_limits<unsigned int>::max(), nMaxUsage);
+    BOOST_CHECK(nEvicted > 0);
+    stats = GetOrphanPoolStats();
+    BOOST_CHECK(stats.nUsage <= nMaxUsage);
+    BOOST_CHECK_EQUAL(stats.mapPeers[1].first, 1U);
+    BOOST_CHECK_EQUAL(stats.mapPeers[0].first, 100U - nEvicted);
+
+    // Disconnecting a peer removes all its orphans.
+    EraseOrphansFor(0);
+    stats = GetOrphanPoolStats();
+    BOOST_CHECK_EQUAL(stats.nOrphans, 1U);
+    BOOST_CHECK_EQUAL(stats.mapPeers.count(0), 0U);
+    EraseOrphansFor(1);
+    stats = GetOrphanPoolStats();
+    BOOST_CHECK_EQUAL(stats.nOrphans, 0U);
+    BOOST_CHECK_EQUAL(stats.nUsage, 0U);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -758,6 +758,127 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTests)
     BOOST_CHECK_EQUAL(descendants, 6ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolClusterTest)
+{
+    CTxMemPool pool;
+    LOCK(pool.cs);
+    pool.SetClusterMode(true, 100);
+    TestMemPoolEntryHelper entry;
+
+    auto MakeTx = [](const std::vector<COutPoint>& prevouts, int n) {
+        CMutableTransaction tx;
+        for (const COutPoint& prevout : prevouts) {
+            tx.vin.emplace_back(prevout);
+            tx.vin.back().scriptSig = CScript() << n;
+        }
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << n << OP_EQUAL;
+        tx.vout[0].nValue = 10 * COIN;
+        return tx;
+    };
+
+    CMutableTransaction tx1 = MakeTx({COutPoint(InsecureRand256(), 0)}, 1);
+    pool.addUnchecked(tx1.GetHashMalFix(), entry.Fee(1000LL).FromTx(tx1));
+    CMutableTransaction tx2 = MakeTx({COutPoint(InsecureRand256(), 0)}, 2);
+    pool.addUnchecked(tx2.GetHashMalFix(), entry.Fee(5000LL).FromTx(tx2));
+
+    // A parent paying nothing and a child paying for both form one chunk.
+    CMutableTransaction parent = MakeTx({COutPoint(InsecureRand256(), 0)}, 3);
+    pool.addUnchecked(parent.GetHashMalFix(), entry.Fee(0LL).FromTx(parent));
+    CMutableTransaction child = MakeTx({COutPoint(parent.GetHashMalFix(), 0)}, 4);
+    pool.addUnchecked(child.GetHashMalFix(), entry.Fee(20000LL).FromTx(child));
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 3U);
+    {
+        const CTxMemPool::TxCluster& cluster = pool.GetCluster(pool.mapTx.find(child.GetHashMalFix()));
+        BOOST_CHECK_EQUAL(cluster.txs.size(), 2U);
+        BOOST_CHECK(cluster.txs[0]->GetTx().GetHashMalFix() == parent.GetHashMalFix());
+        BOOST_CHECK_EQUAL(cluster.chunks.size(), 1U);
+        BOOST_CHECK_EQUAL(cluster.chunks[0].nModFees, 20000);
+    }
+
+    // A grandchild paying nothing gets a chunk of its own, after the others.
+    CMutableTransaction grandchild = MakeTx({COutPoint(child.GetHashMalFix(), 0)}, 5);
+    pool.addUnchecked(grandchild.GetHashMalFix(), entry.Fee(0LL).FromTx(grandchild));
+    {
+        const CTxMemPool::TxCluster& cluster = pool.GetCluster(pool.mapTx.find(grandchild.GetHashMalFix()));
+        BOOST_CHECK_EQUAL(cluster.txs.size(), 3U);
+        BOOST_CHECK_EQUAL(cluster.chunks.size(), 2U);
+        BOOST_CHECK_EQUAL(cluster.ChunkBegin(1), 2U);
+        BOOST_CHECK(cluster.txs[2]->GetTx().GetHashMalFix() == grandchild.GetHashMalFix());
+    }
+
+    // Size limiting evicts the chunk with the lowest feerate first.
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1);
+    BOOST_CHECK(!pool.exists(grandchild.GetHashMalFix()));
+    BOOST_CHECK(pool.exists(parent.GetHashMalFix()));
+    BOOST_CHECK(pool.exists(child.GetHashMalFix()));
+    BOOST_CHECK(pool.exists(tx1.GetHashMalFix()));
+    BOOST_CHECK_EQUAL(pool.GetCluster(pool.mapTx.find(child.GetHashMalFix())).txs.size(), 2U);
+
+    // A transaction spending from two clusters merges them...
+    CMutableTransaction merge = MakeTx({COutPoint(tx1.GetHashMalFix(), 0), COutPoint(tx2.GetHashMalFix(), 0)}, 6);
+    pool.addUnchecked(merge.GetHashMalFix(), entry.Fee(1000LL).FromTx(merge));
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 2U);
+    BOOST_CHECK_EQUAL(pool.GetCluster(pool.mapTx.find(merge.GetHashMalFix())).txs.size(), 3U);
+    BOOST_CHECK(pool.GetCluster(pool.mapTx.find(merge.GetHashMalFix())).txs[0]->GetTx().GetHashMalFix() == tx2.GetHashMalFix());
+    BOOST_CHECK_EQUAL(pool.CalculateClusterSize({pool.mapTx.find(tx1.GetHashMalFix()), pool.mapTx.find(child.GetHashMalFix())}), 6U);
+
+    // ... and removing it splits them again.
+    pool.removeRecursive(merge);
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 3U);
+    BOOST_CHECK_EQUAL(pool.GetCluster(pool.mapTx.find(tx1.GetHashMalFix())).txs.size(), 1U);
+
+    pool.SetClusterMode(false, 100);
+    BOOST_CHECK(pool.GetClusters().empty());
+}
+
+BOOST_AUTO_TEST_CASE(MempoolClusterLimitTest)
+{
+    CTxMemPool pool;
+    LOCK(pool.cs);
+    pool.SetClusterMode(true, 3);
+    TestMemPoolEntryHelper entry;
+
+    CMutableTransaction parent;
+    parent.vin.emplace_back(COutPoint(InsecureRand256(), 0));
+    parent.vout.resize(2);
+    for (int i = 0; i < 2; ++i) {
+        parent.vout[i].scriptPubKey = CScript() << i << OP_EQUAL;
+        parent.vout[i].nValue = 10 * COIN;
+    }
+    CMutableTransaction sibling;
+    sibling.vin.emplace_back(COutPoint(parent.GetHashMalFix(), 0));
+    sibling.vout.resize(1);
+    sibling.vout[0].scriptPubKey = CScript() << 2 << OP_EQUAL;
+    sibling.vout[0].nValue = 10 * COIN;
+    CMutableTransaction child;
+    child.vin.emplace_back(COutPoint(parent.GetHashMalFix(), 1));
+    child.vout.resize(1);
+    child.vout[0].scriptPubKey = CScript() << 3 << OP_EQUAL;
+    child.vout[0].nValue = 10 * COIN;
+    CMutableTransaction grandchild;
+    grandchild.vin.emplace_back(COutPoint(child.GetHashMalFix(), 0));
+    grandchild.vout.resize(1);
+    grandchild.vout[0].scriptPubKey = CScript() << 4 << OP_EQUAL;
+    grandchild.vout[0].nValue = 10 * COIN;
+
+    // The child and grandchild are in the mempool while their parent and its
+    // other child are in a block that is disconnected.
+    pool.addUnchecked(child.GetHashMalFix(), entry.Fee(1000LL).FromTx(child));
+    pool.addUnchecked(grandchild.GetHashMalFix(), entry.Fee(1000LL).FromTx(grandchild));
+    pool.addUnchecked(parent.GetHashMalFix(), entry.Fee(1000LL).FromTx(parent));
+    pool.addUnchecked(sibling.GetHashMalFix(), entry.Fee(1000LL).FromTx(sibling));
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 2U);
+
+    // Linking them would make a cluster of four, so the transaction with the
+    // most ancestors goes.
+    pool.UpdateTransactionsFromBlock({parent.GetHashMalFix(), sibling.GetHashMalFix()});
+    BOOST_CHECK_EQUAL(pool.size(), 3U);
+    BOOST_CHECK(!pool.exists(grandchild.GetHashMalFix()));
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 1U);
+    BOOST_CHECK_EQUAL(pool.GetCluster(pool.mapTx.find(child.GetHashMalFix())).txs.size(), 3U);
+}
+
 BOOST_AUTO_TEST_CASE(comparator_tests)
 {
     CTxMemPool pool;
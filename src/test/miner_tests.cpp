@@ -627,4 +627,75 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_required_age_in_secs)
     BOOST_CHECK(pblocktemplate->block.vtx[1]->GetHashMalFix() == hashPastTimeTx);
 }
 
+
+BOOST_AUTO_TEST_CASE(CreateNewBlock_template_cache)
+{
+    CKey aggregateKey;
+    aggregateKey.Set(validAggPrivateKey, validAggPrivateKey + 32, true);
+    CPubKey aggPubkey;
+    aggPubkey.Set(validAggPubKey, validAggPubKey + 33);
+
+    auto chainParams = FederationParams();
+    chainParams.ReadGenesisBlock(getTestGenesisBlockHex(aggPubkey, aggregateKey));
+    std::unique_ptr<CBlockTemplate> pblocktemplate;
+    int baseheight = 0;
+    std::vector<CTransactionRef> txFirst;
+    CreateBlocks(Params(), pblocktemplate, baseheight, txFirst);
+
+    g_block_template_cache = MakeUnique<BlockTemplateCache>();
+    BlockAssembler::Options options;
+    options.nBlockMaxSize = GetCurrentMaxBlockSize();
+    options.blockMinFeeRate = blockMinFeeRate;
+    options.use_template_cache = true;
+
+    // The first template fills the cache from the empty mempool.
+    BOOST_CHECK(pblocktemplate = BlockAssembler(Params(), options).CreateNewBlock(scriptPubKey));
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1U);
+
+    TestMemPoolEntryHelper entry;
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig = CScript() << OP_1;
+    tx.vin[0].prevout.hashMalFix = txFirst[0]->GetHashMalFix();
+    tx.vin[0].prevout.n = 0;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 5000000000LL - 1000;
+    const uint256 hashParent = tx.GetHashMalFix();
+
+    CMutableTransaction child;
+    child.vin.resize(1);
+    child.vin[0].scriptSig = CScript() << OP_1;
+    child.vin[0].prevout.hashMalFix = hashParent;
+    child.vin[0].prevout.n = 0;
+    child.vout.resize(1);
+    child.vout[0].nValue = 5000000000LL - 2000;
+    const uint256 hashChild = child.GetHashMalFix();
+    {
+        LOCK(::mempool.cs);
+        mempool.addUnchecked(hashParent, entry.Fee(1000).Time(GetTime()).SpendsCoinbase(true).FromTx(tx));
+        mempool.addUnchecked(hashChild, entry.Fee(1000).Time(GetTime()).SpendsCoinbase(false).FromTx(child));
+    }
+
+    // Transactions added since are appended to the cached selection.
+    BOOST_CHECK(pblocktemplate = BlockAssembler(Params(), options).CreateNewBlock(scriptPubKey));
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 3U);
+    BOOST_CHECK(pblocktemplate->block.vtx[1]->GetHashMalFix() == hashParent);
+    BOOST_CHECK(pblocktemplate->block.vtx[2]->GetHashMalFix() == hashChild);
+
+    // The required age still applies to cached transactions.
+    BOOST_CHECK(pblocktemplate = BlockAssembler(Params(), options).CreateNewBlock(scriptPubKey, 60));
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1U);
+
+    // Removing the parent drops both from the selection.
+    {
+        LOCK(::mempool.cs);
+        mempool.removeRecursive(CTransaction(tx));
+    }
+    BOOST_CHECK(pblocktemplate = BlockAssembler(Params(), options).CreateNewBlock(scriptPubKey));
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1U);
+
+    g_block_template_cache.reset();
+    mempool.clear();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
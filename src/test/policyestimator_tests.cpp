@@ -3,8 +3,13 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <clientversion.h>
+#include <fs.h>
+#include <key.h>
 #include <policy/policy.h>
 #include <policy/fees.h>
+#include <script/standard.h>
+#include <streams.h>
 #include <txmempool.h>
 #include <uint256.h>
 #include <util.h>
@@ -181,4 +186,100 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     }
 }
 
+BOOST_AUTO_TEST_CASE(BlockPolicyEstimatesToken)
+{
+    CBlockPolicyEstimator feeEst;
+    CTxMemPool mpool(&feeEst);
+    LOCK(mpool.cs);
+    TestMemPoolEntryHelper entry;
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript scriptTPC = GetScriptForDestination(key.GetPubKey().GetID());
+    const CScript scriptToken = GetScriptForDestination(CColorKeyID(key.GetPubKey().GetID(), ColorIdentifier(scriptTPC)));
+    BOOST_CHECK(scriptToken.IsColoredScript());
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1000;
+    tx.vout[0].scriptPubKey = scriptTPC;
+    CMutableTransaction tokenTx(tx);
+    tokenTx.vout[0].scriptPubKey = scriptToken;
+    // A burn spends tokens and has no colored output left
+    CMutableTransaction burnTx(tx);
+
+    // TPC transactions pay a low fee, token transactions a much higher one,
+    // and both are always mined in the next block.
+    const CFeeRate tpcRate(2000, GetTransactionSize(tx));
+    const CFeeRate tokenRate(16000, GetTransactionSize(tokenTx));
+    const CAmount burnFee = tokenRate.GetFee(GetTransactionSize(burnTx));
+    std::vector<CTransactionRef> block;
+    int blocknum = 0;
+    while (blocknum < 100) {
+        for (int k = 0; k < 4; k++) {
+            tx.vin[0].prevout.n = 10000 * blocknum + k;
+            mpool.addUnchecked(tx.GetHashMalFix(), entry.Fee(2000).Height(blocknum).SpendsToken(false).FromTx(tx));
+            block.push_back(mpool.get(tx.GetHashMalFix()));
+            if (k % 2) {
+                burnTx.vin[0].prevout.n = 10000 * blocknum + 100 + k;
+                mpool.addUnchecked(burnTx.GetHashMalFix(), entry.Fee(burnFee).Height(blocknum).SpendsToken(true).FromTx(burnTx));
+                block.push_back(mpool.get(burnTx.GetHashMalFix()));
+            } else {
+                tokenTx.vin[0].prevout.n = 10000 * blocknum + 100 + k;
+                mpool.addUnchecked(tokenTx.GetHashMalFix(), entry.Fee(16000).Height(blocknum).SpendsToken(false).FromTx(tokenTx));
+                block.push_back(mpool.get(tokenTx.GetHashMalFix()));
+            }
+        }
+        mpool.removeForBlock(block, ++blocknum);
+        block.clear();
+    }
+
+    // Estimates from all transactions are dominated by the cheap TPC ones
+    FeeCalculation feeCalc;
+    CFeeRate allEstimate = feeEst.estimateSmartFee(2, &feeCalc, false);
+    BOOST_CHECK(!feeCalc.token);
+    BOOST_CHECK(allEstimate.GetFeePerK() < tpcRate.GetFeePerK() * 11 / 10);
+    BOOST_CHECK(allEstimate.GetFeePerK() > tpcRate.GetFeePerK() * 9 / 10);
+
+    CFeeRate tokenEstimate = feeEst.estimateSmartFee(2, &feeCalc, false, true);
+    BOOST_CHECK(feeCalc.token);
+    BOOST_CHECK(tokenEstimate.GetFeePerK() < tokenRate.GetFeePerK() * 11 / 10);
+    BOOST_CHECK(tokenEstimate.GetFeePerK() > tokenRate.GetFeePerK() * 9 / 10);
+
+    // The token stats survive a round trip through the estimates file
+    fs::path path = GetDataDir() / "fee_estimates_token_test.dat";
+    {
+        CAutoFile fileout(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK(feeEst.Write(fileout));
+    }
+    CBlockPolicyEstimator readEst;
+    {
+        CAutoFile filein(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK(readEst.Read(filein));
+    }
+    fs::remove(path);
+    BOOST_CHECK(readEst.estimateSmartFee(2, &feeCalc, false, true) == tokenEstimate);
+    BOOST_CHECK(feeCalc.token);
+    BOOST_CHECK(readEst.estimateSmartFee(2, &feeCalc, false) == allEstimate);
+
+    // Without token transactions, token estimates fall back to all transactions
+    CBlockPolicyEstimator tpcEst;
+    CTxMemPool tpcPool(&tpcEst);
+    LOCK(tpcPool.cs);
+    blocknum = 0;
+    while (blocknum < 100) {
+        for (int k = 0; k < 4; k++) {
+            tx.vin[0].prevout.n = 10000 * blocknum + k;
+            tpcPool.addUnchecked(tx.GetHashMalFix(), entry.Fee(2000).Height(blocknum).FromTx(tx));
+            block.push_back(tpcPool.get(tx.GetHashMalFix()));
+        }
+        tpcPool.removeForBlock(block, ++blocknum);
+        block.clear();
+    }
+    BOOST_CHECK(tpcEst.estimateSmartFee(2, &feeCalc, false, true) == tpcEst.estimateSmartFee(2, nullptr, false));
+    BOOST_CHECK(tpcEst.estimateSmartFee(2, nullptr, false) != CFeeRate(0));
+    BOOST_CHECK(!feeCalc.token);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -6,7 +6,10 @@
 #include <rpc/server.h>
 #include <rpc/client.h>
 
+#include <coloridentifier.h>
 #include <core_io.h>
+#include <jsonwriter.h>
+#include <key.h>
 #include <key_io.h>
 #include <netbase.h>
 
@@ -78,6 +81,68 @@ BOOST_AUTO_TEST_CASE(rpc_rawparams)
     BOOST_CHECK_THROW(CallRPC(std::string("sendrawtransaction ")+rawtx+" extra"), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_json_writer)
+{
+    // JSONWriter output has to be byte for byte what UniValue::write() gives
+    std::string rawtx = "0100000001a15d57094aa7a21a28cb20b59aab8fc7d1149a3bdbcddba9c622e4f5f6a99ece010000006c493046022100f93bb0e7d8db7bd46e40132d1f8242026e045f03a0efe71bbb8e3f475e970d790221009337cd7f1f929f00cc6ff01f03729b069a7c21b59b1736ddfee5db5946c5da8c0121033b9b137ee87d5a812d6f506efdd37f0affa7ffc310711c06c7f3e097c9447c52ffffffff0100e1f505000000001976a9140389035a9225b3839e2bbf32d826a1e222031fd888ac00000000";
+    CMutableTransaction mtx;
+    BOOST_CHECK(DecodeHexTx(mtx, rawtx));
+    // a token output, an output with an odd amount and an unparsable script
+    CKey key;
+    key.MakeNewKey(true);
+    const ColorIdentifier color(CScript() << 1);
+    mtx.vout.emplace_back(1234, GetScriptForDestination(CColorKeyID(key.GetPubKey().GetID(), color)));
+    mtx.vout.emplace_back(COIN + 1, CScript() << OP_RETURN << std::vector<unsigned char>(3, 0x22));
+    mtx.vout.emplace_back(0, CScript() << OP_DUP << std::vector<unsigned char>(10));
+    mtx.vout.back().scriptPubKey.resize(mtx.vout.back().scriptPubKey.size() - 1);
+    const CTransaction tx(mtx);
+
+    for (bool include_hex : {false, true}) {
+        for (const uint256& hashBlock : {uint256(), tx.GetHashMalFix()}) {
+            UniValue entry(UniValue::VOBJ);
+            TxToUniv(tx, hashBlock, entry, include_hex);
+            std::string json;
+            JSONWriter writer(json);
+            WriteTxJSON(tx, hashBlock, writer, include_hex);
+            BOOST_CHECK_EQUAL(json, entry.write());
+        }
+    }
+
+    std::string str("plain \"quoted\" back\\slash\n\t\x01\x1f\x7f \xc3\xa9");
+    std::string json;
+    JSONWriter writer(json);
+    writer.BeginArray();
+    writer.String(str);
+    writer.BeginObject();
+    writer.Key("n");
+    writer.Int(-1);
+    writer.Key("empty");
+    writer.BeginArray();
+    writer.EndArray();
+    writer.EndObject();
+    writer.Bool(false);
+    writer.EndArray();
+    UniValue expected(UniValue::VARR);
+    expected.push_back(str);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("n", -1);
+    obj.pushKV("empty", UniValue(UniValue::VARR));
+    expected.push_back(obj);
+    expected.push_back(false);
+    BOOST_CHECK_EQUAL(json, expected.write());
+
+    // Handlers only return pre-serialized JSON to the HTTP server
+    JSONRPCRequest request;
+    request.strMethod = "decoderawtransaction";
+    request.params = RPCConvertValues(request.strMethod, {rawtx});
+    const UniValue result = tableRPC[request.strMethod]->actor(request);
+    BOOST_CHECK(result.isObject());
+    std::string raw_result;
+    request.pRawResult = &raw_result;
+    BOOST_CHECK(tableRPC[request.strMethod]->actor(request).isNull());
+    BOOST_CHECK_EQUAL(raw_result, result.write());
+}
+
 BOOST_AUTO_TEST_CASE(rpc_togglenetwork)
 {
     UniValue r;
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <consensus/validation.h>
+#include <core_io.h>
 #include <key_io.h>
 #include <policy/packages.h>
 #include <policy/policy.h>
@@ -683,4 +684,97 @@ BOOST_FIXTURE_TEST_CASE(package_submission_tests, PackageTestSetup)
 
 }
 
+BOOST_AUTO_TEST_CASE(batch_sort_tests)
+{
+    // grandchild, unrelated, child, parent
+    CMutableTransaction mtx_parent = create_placeholder_tx(1, 1);
+    CMutableTransaction mtx_child = create_placeholder_tx(1, 1);
+    mtx_child.vin[0].prevout = COutPoint(mtx_parent.GetHashMalFix(), 0);
+    CMutableTransaction mtx_gchild = create_placeholder_tx(2, 1);
+    mtx_gchild.vin[0].prevout = COutPoint(mtx_child.GetHashMalFix(), 0);
+    mtx_gchild.vin[1].prevout = COutPoint(mtx_parent.GetHashMalFix(), 1);
+    CMutableTransaction mtx_unrelated = create_placeholder_tx(1, 1);
+
+    std::vector<CTransactionRef> batch{MakeTransactionRef(mtx_gchild), MakeTransactionRef(mtx_unrelated), nullptr, MakeTransactionRef(mtx_child), MakeTransactionRef(mtx_parent)};
+    const std::vector<size_t> order = SortBatchByDependency(batch);
+    const std::vector<size_t> expected{1, 2, 4, 3, 0};
+    BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+
+    // Already sorted batches are left alone.
+    std::vector<CTransactionRef> sorted{MakeTransactionRef(mtx_parent), MakeTransactionRef(mtx_unrelated), MakeTransactionRef(mtx_child)};
+    const std::vector<size_t> order_sorted = SortBatchByDependency(sorted);
+    const std::vector<size_t> expected_sorted{0, 1, 2};
+    BOOST_CHECK_EQUAL_COLLECTIONS(order_sorted.begin(), order_sorted.end(), expected_sorted.begin(), expected_sorted.end());
+
+    // Decoding keeps the positions of the transactions that fail.
+    const std::vector<std::string> hex_txs{EncodeHexTx(CTransaction(mtx_parent)), "00", EncodeHexTx(CTransaction(mtx_child))};
+    const std::vector<CTransactionRef> decoded = DecodeTransactionBatch(hex_txs);
+    BOOST_CHECK_EQUAL(decoded.size(), 3);
+    BOOST_CHECK(decoded[0] && decoded[0]->GetHashMalFix() == mtx_parent.GetHashMalFix());
+    BOOST_CHECK(!decoded[1]);
+    BOOST_CHECK(decoded[2] && decoded[2]->GetHashMalFix() == mtx_child.GetHashMalFix());
+}
+
+BOOST_FIXTURE_TEST_CASE(batch_submission_tests, PackageTestSetup)
+{
+    CKey spend_key;
+    spend_key.MakeNewKey(true);
+    CScript spend_script = GetScriptForDestination(spend_key.GetPubKey().GetID());
+
+    unsigned int initialPoolSize = mempool.size();
+    unsigned long index_cb = m_coinbase_txns.size();//init this index before refilling coinbase
+
+    refillCoinbase(50);
+
+    std::vector<unsigned char> vchSig;
+    COutPoint spend_cb(m_coinbase_txns[index_cb]->GetHashMalFix(), 0);
+    auto mtx_parent = CreateValidTransaction(spend_cb, CAmount(49 * COIN), {CScript() << OP_TRUE << OP_EQUAL});
+    Sign(vchSig, coinbaseKey, m_coinbase_txns[index_cb]->vout[0].scriptPubKey, 0, mtx_parent, 0);
+    mtx_parent.vin[0].scriptSig = CScript() << vchSig;
+
+    //this tx has so many outputs as workaround for "tx-size-small" error when only one/two outputs are given
+    COutPoint spend_parent(mtx_parent.GetHashMalFix(), 0);
+    auto mtx_child = CreateValidTransaction(spend_parent, CAmount(44 * COIN), {CScript() << OP_TRUE << OP_EQUAL});
+    for(int x = 0; x < 4; ++x)
+        mtx_child.vout.push_back(CTxOut(CAmount(1 * COIN), {CScript() << OP_TRUE << OP_EQUAL}));
+    mtx_child.vin[0].scriptSig = CScript() << OP_TRUE;
+
+    COutPoint spend_child(mtx_child.GetHashMalFix(), 0);
+    auto mtx_gchild = CreateValidTransaction(spend_child, CAmount(39 * COIN), spend_script);
+    mtx_gchild.vin[0].scriptSig = CScript() << OP_TRUE;
+
+    // spends a coin that does not exist, and so does its child
+    COutPoint spend_unknown(InsecureRand256(), 0);
+    auto mtx_orphan = CreateValidTransaction(spend_unknown, CAmount(1 * COIN), {CScript() << OP_TRUE << OP_EQUAL});
+    mtx_orphan.vin[0].scriptSig = CScript() << OP_TRUE;
+    COutPoint spend_orphan(mtx_orphan.GetHashMalFix(), 0);
+    auto mtx_orphan_child = CreateValidTransaction(spend_orphan, CAmount(1 * COIN), spend_script);
+    mtx_orphan_child.vin[0].scriptSig = CScript() << OP_TRUE;
+
+    // children first
+    std::vector<CTransactionRef> batch{MakeTransactionRef(mtx_gchild), MakeTransactionRef(mtx_orphan_child), nullptr,
+                                       MakeTransactionRef(mtx_child), MakeTransactionRef(mtx_orphan), MakeTransactionRef(mtx_parent)};
+    std::vector<BatchTxResult> results = SubmitTransactionBatch(batch, 0);
+
+    BOOST_CHECK_EQUAL(results.size(), batch.size());
+    BOOST_CHECK(results[0].accepted);
+    BOOST_CHECK(results[0].txid == mtx_gchild.GetHashMalFix());
+    BOOST_CHECK(!results[1].accepted);
+    BOOST_CHECK(results[1].state.missingInputs);
+    BOOST_CHECK(!results[2].accepted);
+    BOOST_CHECK(results[2].txid.IsNull());
+    BOOST_CHECK_EQUAL(results[2].state.GetRejectReason(), "tx-decode-failed");
+    BOOST_CHECK(results[3].accepted);
+    BOOST_CHECK(!results[4].accepted);
+    BOOST_CHECK(results[4].state.missingInputs);
+    BOOST_CHECK(results[5].accepted);
+    BOOST_CHECK_EQUAL(mempool.size(), initialPoolSize + 3);
+
+    // Submitting again reports the transactions already in the mempool as accepted.
+    results = SubmitTransactionBatch({MakeTransactionRef(mtx_parent), MakeTransactionRef(mtx_child)}, 0);
+    BOOST_CHECK(results[0].accepted);
+    BOOST_CHECK(results[1].accepted);
+    BOOST_CHECK_EQUAL(mempool.size(), initialPoolSize + 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <key.h>
 #include <validation.h>
@@ -108,6 +109,114 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_block_doublespend, TestChainSetup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(mempool_precheck, TestChainSetup)
+{
+    // Pre-checking the scripts outside cs_main must not change what
+    // AcceptToMemoryPool decides.
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.nFeatures = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout.hashMalFix = m_coinbase_txns[0]->GetHashMalFix();
+    spend.vin[0].prevout.n = 0;
+    spend.vout.resize(1);
+    spend.vout[0].nValue = 11*CENT;
+    spend.vout[0].scriptPubKey = scriptPubKey;
+
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign_Schnorr(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+
+    CMutableTransaction bad_spend(spend);
+    std::vector<unsigned char> vchBadSig(vchSig);
+    vchBadSig[10] ^= 1;
+    bad_spend.vin[0].scriptSig << vchBadSig;
+    spend.vin[0].scriptSig << vchSig;
+
+    PreCheckMempoolTransaction(MakeTransactionRef(bad_spend));
+    {
+        LOCK(cs_main);
+        CTxMempoolAcceptanceOptions opt;
+        BOOST_CHECK(!AcceptToMemoryPool(MakeTransactionRef(bad_spend), opt));
+        BOOST_CHECK(opt.state.GetRejectReason().find("mandatory-script-verify-flag-failed") == 0);
+    }
+
+    PreCheckMempoolTransaction(MakeTransactionRef(spend));
+    BOOST_CHECK(ToMemPool(spend));
+    BOOST_CHECK(mempool.exists(spend.GetHashMalFix()));
+
+    // Transactions already in the mempool and ones with unknown inputs are left alone.
+    PreCheckMempoolTransaction(MakeTransactionRef(spend));
+    CMutableTransaction orphan(spend);
+    orphan.vin[0].prevout.hashMalFix = InsecureRand256();
+    PreCheckMempoolTransaction(MakeTransactionRef(orphan));
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(!pcoinsTip->HaveCoinInCache(orphan.vin[0].prevout));
+    }
+    mempool.clear();
+}
+
+BOOST_FIXTURE_TEST_CASE(mempool_reload, TestChainSetup)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction parent;
+    parent.nFeatures = 1;
+    parent.vin.resize(1);
+    parent.vin[0].prevout.hashMalFix = m_coinbase_txns[0]->GetHashMalFix();
+    parent.vin[0].prevout.n = 0;
+    parent.vout.resize(1);
+    parent.vout[0].nValue = 11*CENT;
+    parent.vout[0].scriptPubKey = scriptPubKey;
+
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, parent, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign_Schnorr(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    parent.vin[0].scriptSig << vchSig;
+
+    CMutableTransaction child;
+    child.nFeatures = 1;
+    child.vin.resize(1);
+    child.vin[0].prevout.hashMalFix = parent.GetHashMalFix();
+    child.vin[0].prevout.n = 0;
+    child.vout.resize(1);
+    child.vout[0].nValue = 10*CENT;
+    child.vout[0].scriptPubKey = scriptPubKey;
+    vchSig.clear();
+    hash = SignatureHash(scriptPubKey, child, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign_Schnorr(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    child.vin[0].scriptSig << vchSig;
+
+    BOOST_CHECK(ToMemPool(parent));
+    BOOST_CHECK(ToMemPool(child));
+    BOOST_CHECK(DumpMempool());
+
+    auto check_reloaded = [&]() {
+        LOCK(mempool.cs);
+        BOOST_CHECK_EQUAL(mempool.size(), 2U);
+        auto it = mempool.mapTx.find(child.GetHashMalFix());
+        BOOST_CHECK(it != mempool.mapTx.end());
+        BOOST_CHECK_EQUAL(it->GetFee(), 1*CENT);
+        BOOST_CHECK_EQUAL(it->GetCountWithAncestors(), 2U);
+        BOOST_CHECK_EQUAL(mempool.mapTx.find(parent.GetHashMalFix())->GetCountWithDescendants(), 2U);
+    };
+
+    // Same tip: the entries are rebuilt from the cached data.
+    mempool.clear();
+    BOOST_CHECK(LoadMempool());
+    check_reloaded();
+
+    // Another tip: the transactions are validated again.
+    mempool.clear();
+    CreateAndProcessBlock({}, scriptPubKey);
+    BOOST_CHECK(LoadMempool());
+    check_reloaded();
+    mempool.clear();
+}
+
 // Run CheckInputs (using pcoinsTip) on the given transaction, for all script
 // flags.  Test that CheckInputs passes for all flags that don't overlap with
 // the failing_flags argument, but otherwise fails.
@@ -381,4 +490,37 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, TestChainSetup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(proposal_validation_cache, TestChainSetup)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptPubKey);
+    CBlock& block = pblocktemplate->block;
+
+    LOCK(cs_main);
+    CBlockIndex* tip = chainActive.Tip();
+
+    // CreateNewBlock validated the proposal before its merkle root was set.
+    BOOST_CHECK(IsProposalValidated(tip->GetBlockHash(), BlockMerkleRoot(block)));
+
+    // Other transactions are a different proposal.
+    CMutableTransaction coinbase(*block.vtx[0]);
+    coinbase.vout[0].nValue -= 1;
+    block.vtx[0] = MakeTransactionRef(coinbase);
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    BOOST_CHECK(!IsProposalValidated(tip->GetBlockHash(), block.hashMerkleRoot));
+
+    CValidationState state;
+    BOOST_CHECK(TestBlockValidity(state, block, tip, false, true));
+    BOOST_CHECK(IsProposalValidated(tip->GetBlockHash(), block.hashMerkleRoot));
+    // It is only valid on top of the parent it was checked on.
+    BOOST_CHECK(!IsProposalValidated(tip->pprev->GetBlockHash(), block.hashMerkleRoot));
+
+    // Invalid proposals are not remembered.
+    coinbase.vout[0].nValue += 2;
+    block.vtx[0] = MakeTransactionRef(coinbase);
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    BOOST_CHECK(!TestBlockValidity(state, block, tip, false, true));
+    BOOST_CHECK(!IsProposalValidated(tip->GetBlockHash(), block.hashMerkleRoot));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
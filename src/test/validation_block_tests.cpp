@@ -199,4 +199,53 @@ BOOST_AUTO_TEST_CASE(processnewblock_signals_ordering)
     BOOST_CHECK(chainActive.Tip()->nHeight != 0);
 }
 
+BOOST_AUTO_TEST_CASE(chain_tip_snapshot)
+{
+    std::vector<std::shared_ptr<const CBlock>> blocks;
+    while (blocks.size() < 50) {
+        blocks.clear();
+        BuildChain(FederationParams().GenesisBlock().GetHash(), 1, 15, 10, 500, blocks);
+    }
+
+    bool ignored;
+    ProcessNewBlock(std::make_shared<CBlock>(FederationParams().GenesisBlock()), true, &ignored);
+    {
+        LOCK(cs_main);
+        std::shared_ptr<const ChainTipSnapshot> snapshot = GetChainTipSnapshot();
+        BOOST_REQUIRE(snapshot);
+        BOOST_CHECK(snapshot->tip == chainActive.Tip());
+    }
+
+    // Readers never take cs_main; every snapshot they see has to describe one block.
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&done]() {
+            while (!done) {
+                std::shared_ptr<const ChainTipSnapshot> snapshot = GetChainTipSnapshot();
+                assert(snapshot);
+                assert(snapshot->hash == snapshot->tip->GetBlockHash());
+                assert(snapshot->height == snapshot->tip->nHeight);
+                assert(snapshot->median_time == snapshot->tip->GetMedianTimePast());
+                assert(snapshot->xfield_changes.size() == XFIELDTYPES_INIT_LIST.size());
+            }
+        });
+    }
+    for (auto block : blocks) {
+        ProcessNewBlock(block, true, &ignored);
+    }
+    done = true;
+    for (auto& thread: readers) {
+        thread.join();
+    }
+
+    LOCK(cs_main);
+    std::shared_ptr<const ChainTipSnapshot> snapshot = GetChainTipSnapshot();
+    BOOST_CHECK(snapshot->tip == chainActive.Tip());
+    BOOST_CHECK_EQUAL(snapshot->height, chainActive.Height());
+    XFieldMaxBlockSize maxBlockSize;
+    CXFieldHistory().GetLatest(TAPYRUS_XFIELDTYPES::MAXBLOCKSIZE, maxBlockSize);
+    BOOST_CHECK_EQUAL(snapshot->max_block_size, maxBlockSize.data);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
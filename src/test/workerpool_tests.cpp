@@ -0,0 +1,62 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <workerpool.h>
+
+#include <test/test_tapyrus.h>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(workerpool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(workerpool_foreach)
+{
+    CWorkerPool pool;
+
+    // Without threads, the items are done by the caller
+    std::vector<int> done(100, 0);
+    const std::thread::id caller = std::this_thread::get_id();
+    pool.ForEach(done.size(), 8, [&](size_t i) {
+        BOOST_CHECK(std::this_thread::get_id() == caller);
+        done[i]++;
+    });
+    BOOST_CHECK(std::all_of(done.begin(), done.end(), [](int n) { return n == 1; }));
+
+    // Several callers at once share the threads, each item is done once
+    pool.Start("worker", 3);
+    std::vector<std::vector<int>> done_by(4, std::vector<int>(1000, 0));
+    std::vector<std::thread> callers;
+    for (std::vector<int>& d : done_by) {
+        callers.emplace_back([&pool, &d] {
+            pool.ForEach(d.size(), 4, [&](size_t i) { d[i]++; });
+        });
+    }
+    for (std::thread& t : callers) {
+        t.join();
+    }
+    for (const std::vector<int>& d : done_by) {
+        BOOST_CHECK(std::all_of(d.begin(), d.end(), [](int n) { return n == 1; }));
+    }
+
+    // The first exception skips the rest and is rethrown to the caller
+    std::atomic<size_t> calls{0};
+    BOOST_CHECK_THROW(pool.ForEach(1000, 4, [&](size_t i) {
+        calls++;
+        if (i == 10) throw std::runtime_error("failed");
+    }), std::runtime_error);
+    BOOST_CHECK(calls < 1000);
+
+    // After Stop() the caller does the items again
+    pool.Stop();
+    size_t count = 0;
+    pool.ForEach(50, 4, [&](size_t) { count++; });
+    BOOST_CHECK_EQUAL(count, 50U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
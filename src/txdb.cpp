@@ -55,7 +55,7 @@ struct CoinEntry {
 
 }
 
-CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true)
+CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe, const std::string& default_profile) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true, default_profile)
 {
 }
 
@@ -63,6 +63,14 @@ bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return db.Read(CoinEntry(&outpoint), coin);
 }
 
+bool CCoinsViewDB::GetCoin(const CDBSnapshot &snapshot, const COutPoint &outpoint, Coin &coin) const {
+    return snapshot.Read(CoinEntry(&outpoint), coin);
+}
+
+std::unique_ptr<CDBSnapshot> CCoinsViewDB::GetSnapshot() const {
+    return MakeUnique<CDBSnapshot>(db);
+}
+
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
     return db.Exists(CoinEntry(&outpoint));
 }
@@ -192,12 +200,18 @@ bool CBlockTreeDB::RewriteXField(std::vector<XFieldChange>& xFieldChanges) {
 }
 
 CCoinsViewCursor *CCoinsViewDB::Cursor() const
+{
+    return Cursor(uint256());
+}
+
+CCoinsViewCursor *CCoinsViewDB::Cursor(const uint256 &hash_start) const
 {
     CCoinsViewDBCursor *i = new CCoinsViewDBCursor(const_cast<CDBWrapper&>(db).NewIterator(), GetBestBlock());
     /* It seems that there are no "const iterators" for LevelDB.  Since we
        only need read operations on it, use a const-cast to get around
        that restriction.  */
-    i->pcursor->Seek(DB_COIN);
+    const COutPoint start(hash_start, 0);
+    i->pcursor->Seek(CoinEntry(&start));
     // Cache key of first record
     if (i->pcursor->Valid()) {
         CoinEntry entry(&i->keyTmp.second);
@@ -77,6 +77,10 @@ static const int64_t nMaxBlockDBCache = 2;
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
 static const int64_t nMaxTxIndexCache = 1024;
+//! Max memory allocated to block statistics index DB specific cache, if -blockstatsindex (MiB)
+static const int64_t nMaxBlockStatsIndexCache = 16;
+//! Max memory allocated to address index DB specific cache, if -addressindex (MiB)
+static const int64_t nMaxAddressIndexCache = 256;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
@@ -86,14 +90,20 @@ class CCoinsViewDB final : public CCoinsView
 protected:
     CDBWrapper db;
 public:
-    explicit CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    explicit CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false, const std::string& default_profile = DEFAULT_DB_PROFILE);
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    //! Look up a coin as of when the snapshot was taken, see GetSnapshot()
+    bool GetCoin(const CDBSnapshot &snapshot, const COutPoint &outpoint, Coin &coin) const;
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
+    //! Cursor starting at the first coin whose txid is not before hash_start in key order
+    CCoinsViewCursor *Cursor(const uint256 &hash_start) const;
+    //! The coins as they are now, for reads that must not see later BatchWrite()s
+    std::unique_ptr<CDBSnapshot> GetSnapshot() const;
 
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
@@ -21,9 +21,9 @@
 
 CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee,
                                  int64_t _nTime, unsigned int _entryHeight,
-                                 bool _spendsCoinbase, int32_t _sigOpsCost, LockPoints lp):
+                                 bool _spendsCoinbase, bool _spendsToken, int32_t _sigOpsCost, LockPoints lp):
     tx(_tx), nFee(_nFee), nTime(_nTime), entryHeight(_entryHeight),
-    spendsCoinbase(_spendsCoinbase), sigOpCost(_sigOpsCost), lockPoints(lp)
+    spendsCoinbase(_spendsCoinbase), spendsToken(_spendsToken), sigOpCost(_sigOpsCost), lockPoints(lp)
 {
     nTxSize = GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
     nUsageSize = RecursiveDynamicUsage(tx);
@@ -148,6 +148,21 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256> &vHashes
         }
         UpdateForDescendants(it, mapMemPoolDescendantsToUpdate, setAlreadyIncluded);
     }
+
+    // The new links may join clusters, which the ancestor check in
+    // AcceptToMemoryPool could not see coming, so they may exceed the limit.
+    std::vector<txiter> vClusterSeeds;
+    for (const uint256 &hash : vHashesToUpdate) {
+        txiter it = mapTx.find(hash);
+        if (it != mapTx.end()) {
+            vClusterSeeds.push_back(it);
+        }
+    }
+    setEntries setExcess;
+    UpdateClusters(vClusterSeeds, &setExcess);
+    if (!setExcess.empty()) {
+        RemoveStaged(setExcess, false, MemPoolRemovalReason::SIZELIMIT);
+    }
 }
 
 bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntries &setAncestors, uint64_t limitAncestorCount, uint64_t limitAncestorSize, uint64_t limitDescendantCount, uint64_t limitDescendantSize, std::string &errString, bool fSearchForParents /* = true */) const
@@ -362,7 +377,9 @@ void CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     // Add to memory pool without checking anything.
     // Used by AcceptToMemoryPool(), which DOES do
     // all the appropriate checks.
-    indexed_transaction_set::iterator newit = mapTx.insert(entry).first;
+    CTxMemPoolEntry new_entry(entry);
+    new_entry.SetEntrySequence(m_next_entry_sequence++);
+    indexed_transaction_set::iterator newit = mapTx.insert(new_entry).first;
     mapLinks.insert(make_pair(newit, TxLinks()));
 
     // Update transaction for any feeDelta created by PrioritiseTransaction
@@ -411,6 +428,8 @@ void CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     vTxHashes.emplace_back(tx.GetHashMalFix(), newit);
     newit->vTxHashesIdx = vTxHashes.size() - 1;
 
+    AddToClusters(newit);
+
     TRACE3(mempool, added,
         entry.GetTx().GetHashMalFix().begin(),
         entry.GetTxSize(),
@@ -420,7 +439,7 @@ void CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
 
 void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 {
-    NotifyEntryRemoved(it->GetSharedTx(), reason);
+    NotifyEntryRemoved(it->GetSharedTx(), reason, GetAndIncrementSequence());
 
     TRACE5(mempool, removed,
         it->GetTx().GetHashMalFix().begin(),
@@ -602,6 +621,9 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
 
 void CTxMemPool::_clear()
 {
+    mapClusters.clear();
+    setClustersByWorstChunk.clear();
+    cachedClusterUsage = 0;
     mapLinks.clear();
     mapTx.clear();
     mapNextTx.clear();
@@ -747,6 +769,38 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
 
     assert(totalTxSize == checkTotal);
     assert(innerUsage == cachedInnerUsage);
+
+    if (m_cluster_mode) {
+        size_t nClusterTxs = 0;
+        uint64_t clusterUsage = 0;
+        for (const auto& cluster : mapClusters) {
+            const TxCluster& c = cluster.second;
+            assert(!c.txs.empty() && !c.chunks.empty());
+            assert(c.chunks.back().end == c.txs.size());
+            nClusterTxs += c.txs.size();
+            clusterUsage += memusage::DynamicUsage(c.txs) + memusage::DynamicUsage(c.chunks);
+            // Every transaction follows its parents, which are in the same cluster.
+            setEntries setSeen;
+            for (txiter it : c.txs) {
+                assert(mapLinks.at(it).cluster == cluster.first);
+                for (txiter parent : GetMemPoolParents(it)) {
+                    assert(setSeen.count(parent));
+                }
+                setSeen.insert(it);
+            }
+            for (size_t i = 1; i < c.chunks.size(); ++i) {
+                assert(c.chunks[i].end > c.chunks[i - 1].end);
+                assert((double)c.chunks[i].nModFees * c.chunks[i - 1].nSize <= (double)c.chunks[i - 1].nModFees * c.chunks[i].nSize);
+            }
+        }
+        assert(nClusterTxs == mapTx.size());
+        assert(clusterUsage == cachedClusterUsage);
+        assert(setClustersByWorstChunk.size() == mapClusters.size());
+        for (const auto& worst : setClustersByWorstChunk) {
+            const TxCluster& c = mapClusters.at(worst.second);
+            assert(worst.first == c.ChunkFeeRate(c.chunks.size() - 1));
+        }
+    }
 }
 
 bool CTxMemPool::CompareDepthAndScore(const uint256& hasha, const uint256& hashb)
@@ -813,7 +867,8 @@ void CTxMemPool::queryHashes(std::vector<uint256>& vtxid)
 }
 
 static TxMempoolInfo GetInfo(CTxMemPool::indexed_transaction_set::const_iterator it) {
-    return TxMempoolInfo{it->GetSharedTx(), it->GetTime(), CFeeRate(it->GetFee(), it->GetTxSize()), it->GetModifiedFee() - it->GetFee()};
+    return TxMempoolInfo{it->GetSharedTx(), it->GetTime(), CFeeRate(it->GetFee(), it->GetTxSize()), it->GetModifiedFee() - it->GetFee(),
+                         it->GetFee(), it->GetHeight(), it->GetSigOpCost(), it->GetCountWithAncestors()};
 }
 
 std::vector<TxMempoolInfo> CTxMemPool::infoAll() const
@@ -872,6 +927,7 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
             for (txiter descendantIt : setDescendants) {
                 mapTx.modify(descendantIt, update_ancestor_state(0, nFeeDelta, 0, 0));
             }
+            UpdateClusters({it});
             ++nTransactionsUpdated;
         }
     }
@@ -925,15 +981,51 @@ bool CCoinsViewMemPool::GetCoin(const COutPoint &outpoint, Coin &coin) const {
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 12 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage +
+           memusage::DynamicUsage(mapClusters) + memusage::DynamicUsage(setClustersByWorstChunk) + cachedClusterUsage;
 }
 
 void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason) {
     AssertLockHeld(cs);
+    // What remains of the clusters losing transactions keeps its order,
+    // which still has every transaction after its parents, but may fall
+    // apart into several clusters.
+    std::vector<std::vector<txiter>> vRemaining;
+    if (m_cluster_mode) {
+        std::set<uint64_t> setClusters;
+        for (txiter it : stage) {
+            const TxLinks& links = mapLinks.at(it);
+            setClusters.insert(links.cluster);
+            // Transactions UpdateClusters left out of an oversized cluster
+            // have none; the cluster of their parents may split.
+            if (!links.cluster) {
+                for (txiter parent : links.parents) {
+                    setClusters.insert(mapLinks.at(parent).cluster);
+                }
+            }
+        }
+        for (uint64_t id : setClusters) {
+            auto cluster = mapClusters.find(id);
+            if (cluster == mapClusters.end()) continue;
+            std::vector<txiter> remaining;
+            for (txiter member : cluster->second.txs) {
+                if (!stage.count(member)) {
+                    remaining.push_back(member);
+                }
+            }
+            if (!remaining.empty()) {
+                vRemaining.push_back(std::move(remaining));
+            }
+            EraseCluster(id);
+        }
+    }
     UpdateForRemoveFromMempool(stage, updateDescendants);
     for (const txiter& it : stage) {
         removeUnchecked(it, reason);
     }
+    for (const std::vector<txiter>& remaining : vRemaining) {
+        SplitCluster(remaining);
+    }
 }
 
 int CTxMemPool::Expire(int64_t time) {
@@ -997,6 +1089,331 @@ const CTxMemPool::setEntries & CTxMemPool::GetMemPoolChildren(txiter entry) cons
     return it->second.children;
 }
 
+void CTxMemPool::SetClusterMode(bool enable, uint64_t limit)
+{
+    LOCK(cs);
+    m_cluster_limit = limit;
+    if (enable == m_cluster_mode) return;
+    m_cluster_mode = enable;
+    if (!enable) {
+        for (auto& links : mapLinks) {
+            links.second.cluster = 0;
+        }
+        mapClusters.clear();
+        setClustersByWorstChunk.clear();
+        cachedClusterUsage = 0;
+        return;
+    }
+    std::vector<txiter> vClusterSeeds;
+    for (txiter it = mapTx.begin(); it != mapTx.end(); ++it) {
+        vClusterSeeds.push_back(it);
+    }
+    setEntries setExcess;
+    UpdateClusters(vClusterSeeds, &setExcess);
+    if (!setExcess.empty()) {
+        RemoveStaged(setExcess, false, MemPoolRemovalReason::SIZELIMIT);
+    }
+}
+
+const CTxMemPool::TxCluster& CTxMemPool::GetCluster(txiter entry) const
+{
+    AssertLockHeld(cs);
+    auto it = mapClusters.find(mapLinks.at(entry).cluster);
+    assert(it != mapClusters.end());
+    return it->second;
+}
+
+uint64_t CTxMemPool::CalculateClusterSize(const setEntries& setAncestors) const
+{
+    AssertLockHeld(cs);
+    // All ancestors of a transaction are in the clusters of its parents.
+    std::set<uint64_t> setClusters;
+    uint64_t nCount = 1;
+    for (txiter it : setAncestors) {
+        const uint64_t id = mapLinks.at(it).cluster;
+        if (setClusters.insert(id).second) {
+            nCount += mapClusters.at(id).txs.size();
+        }
+    }
+    return nCount;
+}
+
+void CTxMemPool::AddCluster(TxCluster&& cluster)
+{
+    const uint64_t id = ++nLastClusterId;
+    for (txiter member : cluster.txs) {
+        mapLinks.at(member).cluster = id;
+    }
+    cachedClusterUsage += memusage::DynamicUsage(cluster.txs) + memusage::DynamicUsage(cluster.chunks);
+    setClustersByWorstChunk.emplace(cluster.ChunkFeeRate(cluster.chunks.size() - 1), id);
+    mapClusters.emplace(id, std::move(cluster));
+}
+
+void CTxMemPool::EraseCluster(uint64_t id)
+{
+    auto it = mapClusters.find(id);
+    if (it == mapClusters.end()) return;
+    for (txiter member : it->second.txs) {
+        mapLinks.at(member).cluster = 0;
+    }
+    cachedClusterUsage -= memusage::DynamicUsage(it->second.txs) + memusage::DynamicUsage(it->second.chunks);
+    setClustersByWorstChunk.erase(std::make_pair(it->second.ChunkFeeRate(it->second.chunks.size() - 1), id));
+    mapClusters.erase(it);
+}
+
+void CTxMemPool::AddToClusters(txiter entry)
+{
+    AssertLockHeld(cs);
+    if (!m_cluster_mode) return;
+
+    std::vector<const TxCluster*> vParentClusters;
+    std::set<uint64_t> setIds;
+    for (txiter parent : mapLinks.at(entry).parents) {
+        const uint64_t id = mapLinks.at(parent).cluster;
+        if (setIds.insert(id).second) {
+            vParentClusters.push_back(&mapClusters.at(id));
+        }
+    }
+
+    // Merge the chunks of the parents' clusters best feerate first, as block
+    // building would take them. The clusters are independent, so this keeps
+    // every transaction after its parents, and so does appending the new
+    // transaction, which nothing in the mempool spends yet.
+    TxCluster merged;
+    std::vector<size_t> vNextChunk(vParentClusters.size(), 0);
+    while (true) {
+        size_t best = vParentClusters.size();
+        for (size_t i = 0; i < vParentClusters.size(); ++i) {
+            if (vNextChunk[i] == vParentClusters[i]->chunks.size()) continue;
+            if (best == vParentClusters.size()) {
+                best = i;
+                continue;
+            }
+            const TxCluster::Chunk& chunk = vParentClusters[i]->chunks[vNextChunk[i]];
+            const TxCluster::Chunk& best_chunk = vParentClusters[best]->chunks[vNextChunk[best]];
+            if ((double)chunk.nModFees * best_chunk.nSize > (double)best_chunk.nModFees * chunk.nSize) {
+                best = i;
+            }
+        }
+        if (best == vParentClusters.size()) break;
+        const TxCluster& cluster = *vParentClusters[best];
+        merged.txs.insert(merged.txs.end(), cluster.txs.begin() + cluster.ChunkBegin(vNextChunk[best]), cluster.txs.begin() + cluster.chunks[vNextChunk[best]].end);
+        ++vNextChunk[best];
+    }
+    merged.txs.push_back(entry);
+
+    for (uint64_t id : setIds) {
+        EraseCluster(id);
+    }
+    ChunkCluster(merged);
+    AddCluster(std::move(merged));
+}
+
+void CTxMemPool::SplitCluster(const std::vector<txiter>& remaining)
+{
+    AssertLockHeld(cs);
+    // Number the connected parts; the links of the remaining transactions
+    // only lead to each other.
+    std::map<txiter, size_t, CompareIteratorByHash> mapPart;
+    size_t nParts = 0;
+    std::vector<txiter> walk;
+    for (txiter start : remaining) {
+        if (!mapPart.emplace(start, nParts).second) continue;
+        walk.assign(1, start);
+        for (size_t j = 0; j < walk.size(); ++j) {
+            const TxLinks& links = mapLinks.at(walk[j]);
+            for (txiter parent : links.parents) {
+                if (mapPart.emplace(parent, nParts).second) walk.push_back(parent);
+            }
+            for (txiter child : links.children) {
+                if (mapPart.emplace(child, nParts).second) walk.push_back(child);
+            }
+        }
+        ++nParts;
+    }
+
+    std::vector<TxCluster> vParts(nParts);
+    for (txiter it : remaining) {
+        vParts[mapPart.at(it)].txs.push_back(it);
+    }
+    for (TxCluster& part : vParts) {
+        ChunkCluster(part);
+        AddCluster(std::move(part));
+    }
+}
+
+void CTxMemPool::UpdateClusters(const std::vector<txiter>& seeds, setEntries* pExcess)
+{
+    AssertLockHeld(cs);
+    if (!m_cluster_mode) return;
+
+    // Collect the connected components around the seeds. Each old cluster
+    // met on the way is dropped and its transactions are added to the
+    // seeds, so that any part of it that is no longer connected to the rest
+    // becomes a cluster of its own.
+    std::vector<txiter> work(seeds);
+    setEntries setVisited;
+    std::vector<std::vector<txiter>> components;
+    for (size_t i = 0; i < work.size(); ++i) {
+        if (!setVisited.insert(work[i]).second) continue;
+        std::vector<txiter> component{work[i]};
+        for (size_t j = 0; j < component.size(); ++j) {
+            const TxLinks& links = mapLinks.at(component[j]);
+            if (links.cluster) {
+                const TxCluster& old = mapClusters.at(links.cluster);
+                work.insert(work.end(), old.txs.begin(), old.txs.end());
+                EraseCluster(links.cluster);
+            }
+            for (txiter parent : links.parents) {
+                if (setVisited.insert(parent).second) component.push_back(parent);
+            }
+            for (txiter child : links.children) {
+                if (setVisited.insert(child).second) component.push_back(child);
+            }
+        }
+        components.push_back(std::move(component));
+    }
+
+    for (std::vector<txiter>& component : components) {
+        if (pExcess && component.size() > m_cluster_limit) {
+            // A transaction has more ancestors than any of them, so the
+            // transactions past the limit include all their descendants
+            // and those kept include all their ancestors.
+            std::sort(component.begin(), component.end(), [](txiter a, txiter b) {
+                return a->GetCountWithAncestors() < b->GetCountWithAncestors();
+            });
+            pExcess->insert(component.begin() + m_cluster_limit, component.end());
+            component.resize(m_cluster_limit);
+            // Removing the excess may leave what is kept in several parts,
+            // which RemoveStaged splits into clusters.
+        }
+        if (!component.empty()) {
+            AddCluster(LinearizeCluster(component));
+        }
+    }
+}
+
+CTxMemPool::TxCluster CTxMemPool::LinearizeCluster(const std::vector<txiter>& component) const
+{
+    AssertLockHeld(cs);
+    const size_t n = component.size();
+    std::map<txiter, size_t, CompareIteratorByHash> mapIndex;
+    for (size_t i = 0; i < n; ++i) {
+        mapIndex.emplace(component[i], i);
+    }
+    std::vector<std::vector<size_t>> parents(n), children(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (txiter parent : mapLinks.at(component[i]).parents) {
+            const size_t p = mapIndex.at(parent);
+            parents[i].push_back(p);
+            children[p].push_back(i);
+        }
+    }
+
+    // Walks the not yet linearized ancestors or descendants of a transaction,
+    // itself included. Marks are generation numbers so they need no clearing.
+    std::vector<bool> vDone(n, false);
+    std::vector<uint64_t> vMark(n, 0);
+    uint64_t nGeneration = 0;
+    std::vector<size_t> walk;
+    auto Walk = [&](size_t start, const std::vector<std::vector<size_t>>& edges) {
+        ++nGeneration;
+        walk.assign(1, start);
+        vMark[start] = nGeneration;
+        for (size_t j = 0; j < walk.size(); ++j) {
+            for (size_t next : edges[walk[j]]) {
+                if (!vDone[next] && vMark[next] != nGeneration) {
+                    vMark[next] = nGeneration;
+                    walk.push_back(next);
+                }
+            }
+        }
+    };
+
+    // Fees and sizes of each transaction with its not yet linearized ancestors
+    std::vector<CAmount> vAncFees(n, 0);
+    std::vector<uint64_t> vAncSize(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        Walk(i, parents);
+        for (size_t a : walk) {
+            vAncFees[i] += component[a]->GetModifiedFee();
+            vAncSize[i] += component[a]->GetTxSize();
+        }
+    }
+
+    TxCluster cluster;
+    cluster.txs.reserve(n);
+    std::vector<size_t> vTake;
+    std::vector<std::pair<size_t, size_t>> stack;
+    while (cluster.txs.size() < n) {
+        // Pick the best remaining transaction by feerate with ancestors.
+        size_t best = n;
+        for (size_t i = 0; i < n; ++i) {
+            if (vDone[i]) continue;
+            if (best == n) {
+                best = i;
+                continue;
+            }
+            const double f1 = (double)vAncFees[i] * vAncSize[best];
+            const double f2 = (double)vAncFees[best] * vAncSize[i];
+            if (f1 > f2 || (f1 == f2 && vAncSize[i] < vAncSize[best])) {
+                best = i;
+            }
+        }
+
+        // Take it with its remaining ancestors, parents first.
+        vTake.clear();
+        ++nGeneration;
+        stack.assign(1, std::make_pair(best, 0));
+        vMark[best] = nGeneration;
+        while (!stack.empty()) {
+            std::pair<size_t, size_t>& top = stack.back();
+            if (top.second < parents[top.first].size()) {
+                const size_t parent = parents[top.first][top.second++];
+                if (!vDone[parent] && vMark[parent] != nGeneration) {
+                    vMark[parent] = nGeneration;
+                    stack.emplace_back(parent, 0);
+                }
+            } else {
+                vTake.push_back(top.first);
+                stack.pop_back();
+            }
+        }
+        for (size_t t : vTake) {
+            Walk(t, children);
+            for (size_t d : walk) {
+                vAncFees[d] -= component[t]->GetModifiedFee();
+                vAncSize[d] -= component[t]->GetTxSize();
+            }
+            vDone[t] = true;
+            cluster.txs.push_back(component[t]);
+        }
+    }
+
+    ChunkCluster(cluster);
+    return cluster;
+}
+
+void CTxMemPool::ChunkCluster(TxCluster& cluster)
+{
+    // Merge a chunk into the one before it whenever it pays a higher feerate.
+    cluster.chunks.clear();
+    for (size_t i = 0; i < cluster.txs.size(); ++i) {
+        const CTxMemPoolEntry& entry = *cluster.txs[i];
+        cluster.chunks.push_back({i + 1, entry.GetModifiedFee(), (uint64_t)entry.GetTxSize(), entry.GetSigOpCost()});
+        while (cluster.chunks.size() > 1) {
+            TxCluster::Chunk& last = cluster.chunks.back();
+            TxCluster::Chunk& prev = cluster.chunks[cluster.chunks.size() - 2];
+            if ((double)last.nModFees * prev.nSize <= (double)prev.nModFees * last.nSize) break;
+            prev.end = last.end;
+            prev.nModFees += last.nModFees;
+            prev.nSize += last.nSize;
+            prev.nSigOpCost += last.nSigOpCost;
+            cluster.chunks.pop_back();
+        }
+    }
+}
+
 CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
     LOCK(cs);
     if (!blockSinceLastRollingFeeBump || rollingMinimumFeeRate == 0)
@@ -1035,19 +1452,29 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
     while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+        setEntries stage;
+        CFeeRate removed;
+        if (m_cluster_mode) {
+            // Evict the chunk that block building would take last. The last
+            // chunk of a cluster has its lowest feerate and holds every
+            // descendant of its own transactions.
+            const TxCluster* worst = &mapClusters.at(setClustersByWorstChunk.begin()->second);
+            removed = worst->ChunkFeeRate(worst->chunks.size() - 1);
+            stage.insert(worst->txs.begin() + worst->ChunkBegin(worst->chunks.size() - 1), worst->txs.end());
+        } else {
+            indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+            removed = CFeeRate(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+            CalculateDescendants(mapTx.project<0>(it), stage);
+        }
 
         // We set the new mempool min fee to the feerate of the removed set, plus the
         // "minimum reasonable fee rate" (ie some value under which we consider txn
         // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
         // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
         removed += incrementalRelayFee;
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
 
-        setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
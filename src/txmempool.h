@@ -73,6 +73,7 @@ private:
     int64_t nTime;             //!< Local time when entering the mempool
     unsigned int entryHeight;  //!< Chain height when entering the mempool
     bool spendsCoinbase;       //!< keep track of transactions that spend a coinbase
+    bool spendsToken;          //!< keep track of transactions that spend colored coins
     int32_t sigOpCost;         //!< Total sigop cost
     int64_t feeDelta;          //!< Used for determining the priority of the transaction for mining in a block
     LockPoints lockPoints;     //!< Track the height and time at which tx was final
@@ -90,10 +91,12 @@ private:
     CAmount nModFeesWithAncestors;
     int32_t nSigOpCostWithAncestors;
 
+    uint64_t m_entry_sequence{0}; //!< Order of entering the mempool, set by CTxMemPool::addUnchecked
+
 public:
     CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee,
                     int64_t _nTime, unsigned int _entryHeight,
-                    bool spendsCoinbase,
+                    bool spendsCoinbase, bool spendsToken,
                     int32_t nSigOpsCost, LockPoints lp);
 
     const CTransaction& GetTx() const { return *this->tx; }
@@ -106,6 +109,7 @@ public:
     int64_t GetModifiedFee() const { return nFee + feeDelta; }
     size_t DynamicMemoryUsage() const { return nUsageSize; }
     const LockPoints& GetLockPoints() const { return lockPoints; }
+    uint64_t GetEntrySequence() const { return m_entry_sequence; }
 
     // Adjusts the descendant state.
     void UpdateDescendantState(int32_t modifySize, CAmount modifyFee, int64_t modifyCount);
@@ -116,12 +120,15 @@ public:
     void UpdateFeeDelta(int64_t feeDelta);
     // Update the LockPoints after a reorg
     void UpdateLockPoints(const LockPoints& lp);
+    // Set the order of entering the mempool, before the entry is added
+    void SetEntrySequence(uint64_t entry_sequence) { m_entry_sequence = entry_sequence; }
 
     uint64_t GetCountWithDescendants() const { return nCountWithDescendants; }
     int64_t GetSizeWithDescendants() const { return nSizeWithDescendants; }
     CAmount GetModFeesWithDescendants() const { return nModFeesWithDescendants; }
 
     bool GetSpendsCoinbase() const { return spendsCoinbase; }
+    bool GetSpendsToken() const { return spendsToken; }
 
     uint64_t GetCountWithAncestors() const { return nCountWithAncestors; }
     int64_t GetSizeWithAncestors() const { return nSizeWithAncestors; }
@@ -198,6 +205,16 @@ struct mempoolentry_Imtxid
     }
 };
 
+// extracts the order of entering the mempool from a CTxMemPoolEntry
+struct mempoolentry_entry_sequence
+{
+    typedef uint64_t result_type;
+    result_type operator() (const CTxMemPoolEntry &entry) const
+    {
+        return entry.GetEntrySequence();
+    }
+};
+
 /** \class CompareTxMemPoolEntryByDescendantScore
  *
  *  Sort an entry by max(score/size of entry's tx, score/size with all descendants).
@@ -317,6 +334,7 @@ public:
 // Multi_index tag names
 struct descendant_score {};
 struct entry_time {};
+struct entry_sequence {};
 struct ancestor_score {};
 
 class CBlockPolicyEstimator;
@@ -337,6 +355,18 @@ struct TxMempoolInfo
 
     /** The fee delta. */
     int64_t nFeeDelta;
+
+    /** Fee paid by the transaction, without the delta. */
+    CAmount nFee{0};
+
+    /** Chain height when the transaction entered the mempool. */
+    unsigned int nHeight{0};
+
+    /** Total sigop cost. */
+    int32_t nSigOpCost{0};
+
+    /** Number of in-mempool ancestors, including the transaction itself. */
+    uint64_t nCountWithAncestors{0};
 };
 
 /** Reason why a transaction was removed from the mempool,
@@ -383,11 +413,12 @@ public:
  *
  * CTxMemPool::mapTx, and CTxMemPoolEntry bookkeeping:
  *
- * mapTx is a boost::multi_index that sorts the mempool on 4 criteria:
+ * mapTx is a boost::multi_index that sorts the mempool on 5 criteria:
  * - transaction hash
  * - descendant feerate [we use max(feerate of tx, feerate of tx with all descendants)]
  * - time in mempool
  * - ancestor feerate [we use min(feerate of tx, feerate of tx with all unconfirmed ancestors)]
+ * - order of entering the mempool, which unlike the time never ties
  *
  * Note: the term "descendant" refers to in-mempool transactions that depend on
  * this one, while "ancestor" refers to in-mempool transactions that a given
@@ -454,6 +485,11 @@ private:
     mutable bool blockSinceLastRollingFeeBump GUARDED_BY(cs);
     mutable double rollingMinimumFeeRate GUARDED_BY(cs); //!< minimum fee to get into the pool, decreases exponentially
 
+    //! Sequence number of the next mempool addition or removal, published with -zmqpubsequence
+    uint64_t m_sequence_number GUARDED_BY(cs){1};
+    //! Entry sequence of the next transaction added, see CTxMemPoolEntry::GetEntrySequence
+    uint64_t m_next_entry_sequence GUARDED_BY(cs){1};
+
     void trackPackageRemoved(const CFeeRate& rate) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
 public:
@@ -482,6 +518,11 @@ public:
                 boost::multi_index::tag<ancestor_score>,
                 boost::multi_index::identity<CTxMemPoolEntry>,
                 CompareTxMemPoolEntryByAncestorFee
+            >,
+            // sorted by order of entering the mempool
+            boost::multi_index::ordered_unique<
+                boost::multi_index::tag<entry_sequence>,
+                mempoolentry_entry_sequence
             >
         >
     > indexed_transaction_set;
@@ -498,6 +539,40 @@ public:
     };
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
 
+    /**
+     * A cluster is a connected component of the graph of in-mempool
+     * transactions and their in-mempool parents. Its transactions are kept in
+     * a linearization: an order in which every transaction follows its
+     * parents, built by repeatedly taking the remaining transaction with the
+     * highest feerate including its remaining ancestors.
+     *
+     * The linearization is cut into chunks, the groups of transactions that
+     * are best included together; chunk feerates never increase along it.
+     * Block building takes the best chunks of all clusters first and size
+     * limiting evicts the last chunks first, so both use the same order.
+     *
+     * Clusters are only linearized from scratch when they are formed by a
+     * reorg or a fee delta changes. A new transaction is appended to the
+     * merged chunks of its parents' clusters, and removing transactions
+     * keeps the order of the rest; both only need the chunks recomputed.
+     * No cluster has more than the limit given to SetClusterMode().
+     */
+    struct TxCluster {
+        struct Chunk {
+            size_t end; //!< one past the last transaction of the chunk in txs
+            CAmount nModFees;
+            uint64_t nSize;
+            int64_t nSigOpCost;
+        };
+        std::vector<txiter> txs;
+        std::vector<Chunk> chunks;
+
+        //! Index of the first transaction of a chunk in txs
+        size_t ChunkBegin(size_t chunk) const { return chunk ? chunks[chunk - 1].end : 0; }
+        CFeeRate ChunkFeeRate(size_t chunk) const { return CFeeRate(chunks[chunk].nModFees, chunks[chunk].nSize); }
+    };
+    typedef std::map<uint64_t, TxCluster> clusterMap;
+
     const setEntries & GetMemPoolParents(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
     const setEntries & GetMemPoolChildren(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
     uint64_t CalculateDescendantMaximum(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
@@ -507,14 +582,43 @@ private:
     struct TxLinks {
         setEntries parents;
         setEntries children;
+        uint64_t cluster = 0; //!< key in mapClusters, 0 when clusters are not tracked
     };
 
     typedef std::map<txiter, TxLinks, CompareIteratorByHash> txlinksMap;
     txlinksMap mapLinks;
 
+    bool m_cluster_mode GUARDED_BY(cs){false};
+    uint64_t m_cluster_limit GUARDED_BY(cs){0}; //!< max number of transactions in a cluster
+    clusterMap mapClusters GUARDED_BY(cs);
+    //! Clusters by the feerate of their last chunk, lowest first, so size limiting finds the worst chunk quickly
+    std::set<std::pair<CFeeRate, uint64_t>> setClustersByWorstChunk GUARDED_BY(cs);
+    uint64_t nLastClusterId GUARDED_BY(cs){0};
+    uint64_t cachedClusterUsage GUARDED_BY(cs){0}; //!< dynamic memory usage of the vectors in mapClusters
+
     void UpdateParent(txiter entry, txiter parent, bool add);
     void UpdateChild(txiter entry, txiter child, bool add);
 
+    /**
+     * Rebuild the clusters containing the given transactions from scratch,
+     * merging or splitting them as the links changed. If pExcess is given,
+     * clusters larger than the limit only keep the transactions with the
+     * fewest ancestors; the others are added to *pExcess for removal.
+     */
+    void UpdateClusters(const std::vector<txiter>& seeds, setEntries* pExcess = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Add a new transaction, which has no in-mempool children, to the end of the clusters of its parents, merging them */
+    void AddToClusters(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Make clusters of the connected parts of what is left of a cluster, keeping its order */
+    void SplitCluster(const std::vector<txiter>& remaining) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Store a chunked cluster under a new id */
+    void AddCluster(TxCluster&& cluster) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Drop a cluster, leaving its transactions without one until they are added to another */
+    void EraseCluster(uint64_t id) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Linearize and chunk a set of transactions that includes the in-mempool parents of each */
+    TxCluster LinearizeCluster(const std::vector<txiter>& component) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Cut the linearization of a cluster into chunks */
+    static void ChunkCluster(TxCluster& cluster);
+
     std::vector<indexed_transaction_set::const_iterator> GetSortedDepthAndScore() const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
 public:
@@ -534,6 +638,17 @@ public:
     void check(const CCoinsViewCache *pcoins) const;
     void setSanityCheck(double dFrequency = 1.0) { LOCK(cs); nCheckFrequency = static_cast<uint32_t>(dFrequency * 4294967295.0); }
 
+    /** Start or stop tracking clusters of at most limit transactions, see TxCluster. */
+    void SetClusterMode(bool enable, uint64_t limit);
+    bool IsClusterMode() const EXCLUSIVE_LOCKS_REQUIRED(cs) { return m_cluster_mode; }
+    uint64_t GetClusterLimit() const EXCLUSIVE_LOCKS_REQUIRED(cs) { return m_cluster_limit; }
+    /** All clusters, when in cluster mode */
+    const clusterMap& GetClusters() const EXCLUSIVE_LOCKS_REQUIRED(cs) { return mapClusters; }
+    /** The cluster a transaction belongs to, when in cluster mode */
+    const TxCluster& GetCluster(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Number of transactions in the cluster a new transaction with these in-mempool ancestors would join, including itself */
+    uint64_t CalculateClusterSize(const setEntries& setAncestors) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     // addUnchecked must updated state for all ancestors of a given transaction,
     // to track size/count of descendant transactions.  First version of
     // addUnchecked can be used to have it call CalculateMemPoolAncestors(), and
@@ -556,6 +671,11 @@ public:
     bool isSpent(const COutPoint& outpoint) const;
     unsigned int GetTransactionsUpdated() const;
     void AddTransactionsUpdated(unsigned int n);
+
+    /** Return the sequence number for a mempool addition or removal and advance it */
+    uint64_t GetAndIncrementSequence() EXCLUSIVE_LOCKS_REQUIRED(cs) { return m_sequence_number++; }
+    /** Return the sequence number the next mempool addition or removal will get */
+    uint64_t GetSequence() const EXCLUSIVE_LOCKS_REQUIRED(cs) { return m_sequence_number; }
     /**
      * Check that none of this transactions inputs are in the mempool, and thus
      * the tx is not dependent on other mempool transactions to be included in a block.
@@ -585,6 +705,8 @@ public:
      *  child transactions present in vHashesToUpdate, which are already accounted
      *  for).  Note: vHashesToUpdate should be the set of transactions from the
      *  disconnected block that have been accepted back into the mempool.
+     *  In cluster mode, transactions whose cluster grows beyond the limit this
+     *  way are removed, keeping those with the fewest ancestors.
      */
     void UpdateTransactionsFromBlock(const std::vector<uint256> &vHashesToUpdate);
 
@@ -653,7 +775,7 @@ public:
     size_t DynamicMemoryUsage() const;
 
     boost::signals2::signal<void (CTransactionRef)> NotifyEntryAdded;
-    boost::signals2::signal<void (CTransactionRef, MemPoolRemovalReason)> NotifyEntryRemoved;
+    boost::signals2::signal<void (CTransactionRef, MemPoolRemovalReason, uint64_t mempool_sequence)> NotifyEntryRemoved;
 
 private:
     /** UpdateForDescendants is used by UpdateTransactionsFromBlock to update
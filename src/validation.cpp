@@ -47,6 +47,7 @@
 #include <xfieldhistory.h>
 #include <core_io.h>
 
+#include <deque>
 #include <future>
 #include <thread>
 #include <sstream>
@@ -225,6 +226,9 @@ CBlockIndex *pindexBestHeader = nullptr;
 Mutex g_best_block_mutex;
 CConditionVariable g_best_block_cv;
 uint256 g_best_block;
+
+//! Read and replaced with std::atomic_load/std::atomic_store only
+static std::shared_ptr<const ChainTipSnapshot> g_chain_tip_snapshot;
 int nScriptCheckThreads = 0;
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
@@ -242,6 +246,38 @@ bool acceptnonstdtxn = false;
 
 uint256 hashAssumeValid;
 
+/**
+ * Block proposals whose transactions passed ConnectBlock on top of a given
+ * parent, as (parent hash, merkle root) pairs. In a signing round the same
+ * proposal is validated by CreateNewBlock, by testproposedblock and once more
+ * when the signed block is connected; only the header fields outside the
+ * merkle root (like the block proof) differ between those. What ConnectBlock
+ * checks depends on nothing but the parent and the transactions, and an
+ * unmutated merkle root commits to the exact transactions, so the result is
+ * reused instead of verifying every script again.
+ */
+static std::deque<std::pair<uint256, uint256>> g_validated_proposals GUARDED_BY(cs_main);
+//! Number of proposals remembered in g_validated_proposals
+static const size_t MAX_VALIDATED_PROPOSALS = 8;
+
+bool IsProposalValidated(const uint256& hashPrevBlock, const uint256& hashMerkleRoot)
+{
+    AssertLockHeld(cs_main);
+    for (const auto& proposal : g_validated_proposals) {
+        if (proposal.first == hashPrevBlock && proposal.second == hashMerkleRoot) return true;
+    }
+    return false;
+}
+
+static void AddValidatedProposal(const uint256& hashPrevBlock, const uint256& hashMerkleRoot) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    if (IsProposalValidated(hashPrevBlock, hashMerkleRoot)) return;
+    if (g_validated_proposals.size() >= MAX_VALIDATED_PROPOSALS) {
+        g_validated_proposals.pop_front();
+    }
+    g_validated_proposals.emplace_back(hashPrevBlock, hashMerkleRoot);
+}
+
 CFeeRate minRelayTxFee = CFeeRate(DEFAULT_MIN_RELAY_TX_FEE);
 CAmount maxTxFee = DEFAULT_TRANSACTION_MAXFEE;
 
@@ -863,19 +899,20 @@ static bool AcceptToMemoryPoolWorker(const CTransactionRef &ptx, CTxMempoolAccep
         pool.ApplyDelta(hash, nModifiedFees);
 
         // Keep track of transactions that spend a coinbase, which we re-scan
-        // during reorgs to ensure COINBASE_MATURITY is still met.
+        // during reorgs to ensure COINBASE_MATURITY is still met, and of
+        // those that spend tokens, which fee estimation tells apart.
         bool fSpendsCoinbase = false;
+        bool fSpendsToken = false;
         for (const CTxIn &txin : tx.vin) {
             const Coin &coin = view.AccessCoin(txin.prevout);
             if (coin.IsCoinBase())
-            {
                 fSpendsCoinbase = true;
-                break;
-            }
+            if (coin.out.scriptPubKey.IsColoredScript())
+                fSpendsToken = true;
         }
 
         CTxMemPoolEntry entry(ptx, nFees, opt.nAcceptTime, chainActive.Height(),
-                              fSpendsCoinbase, nSigOps, lp);
+                              fSpendsCoinbase, fSpendsToken, nSigOps, lp);
         unsigned int nSize = entry.GetTxSize();
 
         CAmount mempoolRejectFee = pool.GetMinFee(gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000).GetFee(nSize);
@@ -907,6 +944,16 @@ static bool AcceptToMemoryPoolWorker(const CTransactionRef &ptx, CTxMempoolAccep
             return state.DoS(0, false, REJECT_NONSTANDARD, "too-long-mempool-chain", false, errString);
         }
 
+        // Clusters are rechunked whenever they change, so their size is bounded too.
+        if (pool.IsClusterMode()) {
+            const uint64_t nLimitCluster = pool.GetClusterLimit();
+            const uint64_t nClusterSize = pool.CalculateClusterSize(setAncestors);
+            if (nClusterSize > nLimitCluster) {
+                return state.DoS(0, false, REJECT_NONSTANDARD, "too-large-cluster", false,
+                                 strprintf("cluster would have %u transactions [limit: %u]", nClusterSize, nLimitCluster));
+            }
+        }
+
         // A transaction that spends outputs that would be replaced by it is invalid. Now
         // that we have the set of all ancestors we can detect this
         // pathological case by making sure setConflicts and setAncestors don't
@@ -1127,7 +1174,7 @@ static bool AcceptToMemoryPoolWorker(const CTransactionRef &ptx, CTxMempoolAccep
         }
     }
 
-    GetMainSignals().TransactionAddedToMempool(ptx);
+    GetMainSignals().TransactionAddedToMempool(ptx, pool.GetAndIncrementSequence());
 
     return true;
 }
@@ -1228,7 +1275,7 @@ static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMes
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight)
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, bool fCheckProof, bool fArena)
 {
     block.SetNull();
 
@@ -1239,20 +1286,24 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight)
 
     // Read block
     try {
-        filein >> block;
+        if (fArena) {
+            UnserializeBlockInArena(filein, block);
+        } else {
+            filein >> block;
+        }
     }
     catch (const std::exception& e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
 
     CValidationState state;
-    if(!CheckBlockHeader(block.GetBlockHeader(), state, nullptr, nHeight, true))
+    if(!CheckBlockHeader(block.GetBlockHeader(), state, nullptr, nHeight, fCheckProof))
         return error("%s: ReadBlockFromDisk: %s nHeight = %d", __func__, FormatStateMessage(state), nHeight);
 
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
+bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, bool fCheckProof, bool fArena)
 {
     CDiskBlockPos blockPos;
     uint32_t height = 0;
@@ -1262,7 +1313,7 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
         height = pindex->nHeight;
     }
 
-    if (!ReadBlockFromDisk(block, blockPos, height))
+    if (!ReadBlockFromDisk(block, blockPos, height, fCheckProof, fArena))
         return false;
     if (block.GetHash() != pindex->GetBlockHash())
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
@@ -1647,7 +1698,9 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
-static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
+} // namespace
+
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
 {
     CDiskBlockPos pos = pindex->GetUndoPos();
     if (pos.IsNull()) {
@@ -1678,6 +1731,8 @@ static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
     return true;
 }
 
+namespace {
+
 /** Abort with a message */
 static bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
 {
@@ -1847,6 +1902,125 @@ void StartScriptCheckWorkerThreads(int threads_num)
     g_chainstate.scriptcheckqueue = std::make_unique< CCheckQueue<CScriptCheck> >(128, threads_num);
 }
 
+//! Script check threads of PreCheckMempoolTransaction, separate from block validation's
+static std::unique_ptr<CCheckQueue<CScriptCheck>> g_mempool_scriptcheckqueue;
+
+//! Number of transactions PreCheckMempoolTransactions() hands to the queue at once
+static const size_t MEMPOOL_PRECHECK_CHUNK = 8;
+
+void StartMempoolScriptCheckThreads(int threads_num)
+{
+    g_mempool_scriptcheckqueue = std::make_unique<CCheckQueue<CScriptCheck>>(128, threads_num);
+}
+
+void PreCheckMempoolTransaction(const CTransactionRef& ptx, const std::function<bool(const CTransaction&)>& skip)
+{
+    PreCheckMempoolTransactions({ptx}, skip);
+}
+
+void PreCheckMempoolTransactions(const std::vector<CTransactionRef>& txs, const std::function<bool(const CTransaction&)>& skip)
+{
+    // Transactions that AcceptToMemoryPool turns down before looking at any
+    // script are not worth the work.
+    std::vector<const CTransaction*> candidates;
+    candidates.reserve(txs.size());
+    std::map<uint256, const CTransaction*> batch_txs;
+    for (const CTransactionRef& ptx : txs) {
+        CValidationState state;
+        std::string reason;
+        if (!CheckTransaction(*ptx, state) || ptx->IsCoinBase() || !IsStandardTx(*ptx, reason) ||
+            ::GetSerializeSize(*ptx, SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS) < MIN_STANDARD_TX_SIZE)
+            continue;
+        candidates.push_back(ptx.get());
+        batch_txs.emplace(ptx->GetHashMalFix(), ptx.get());
+    }
+
+    std::vector<std::pair<const CTransaction*, std::vector<CTxOut>>> checked_txs;
+    checked_txs.reserve(candidates.size());
+    {
+        LOCK(cs_main);
+        // Before mempool.cs, which skip() may take after its own locks
+        if (skip) {
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](const CTransaction* tx) { return skip(*tx); }), candidates.end());
+        }
+        LOCK(mempool.cs);
+        CCoinsViewMemPool view_mempool(pcoinsTip.get(), mempool);
+        const CFeeRate mempool_min_fee = mempool.GetMinFee(gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000);
+        for (const CTransaction* tx : candidates) {
+            const uint256 hash = tx->GetHashMalFix();
+            if (mempool.exists(hash) || !CheckFinalTx(*tx, STANDARD_LOCKTIME_VERIFY_FLAGS))
+                continue;
+            std::vector<CTxOut> spent_outputs;
+            spent_outputs.reserve(tx->vin.size());
+            CAmount value_in = 0;
+            for (const CTxIn& txin : tx->vin) {
+                auto parent = batch_txs.find(txin.prevout.hashMalFix);
+                if (parent != batch_txs.end()) {
+                    if (txin.prevout.n >= parent->second->vout.size())
+                        break;
+                    spent_outputs.push_back(parent->second->vout[txin.prevout.n]);
+                } else {
+                    const bool was_cached = pcoinsTip->HaveCoinInCache(txin.prevout);
+                    Coin coin;
+                    const bool found = view_mempool.GetCoin(txin.prevout, coin);
+                    // Leave it to the admission to decide whether the coin stays cached.
+                    if (!was_cached)
+                        pcoinsTip->Uncache(txin.prevout);
+                    if (!found)
+                        break;
+                    spent_outputs.push_back(coin.out);
+                }
+                const CTxOut& spent = spent_outputs.back();
+                if (GetColorIdFromScript(spent.scriptPubKey).type == TokenTypes::NONE && MoneyRange(spent.nValue))
+                    value_in = std::min(value_in + spent.nValue, MAX_MONEY);
+            }
+            if (spent_outputs.size() != tx->vin.size())
+                continue;
+            // Skip transactions the admission would turn down for their fee.
+            // The size used here never exceeds the one the admission uses.
+            CAmount modified_fee = value_in - tx->GetValueOut(ColorIdentifier());
+            mempool.ApplyDelta(hash, modified_fee);
+            const int64_t size = GetTransactionSize(*tx);
+            if (modified_fee < mempool_min_fee.GetFee(size) || modified_fee < ::minRelayTxFee.GetFee(size))
+                continue;
+            checked_txs.emplace_back(tx, std::move(spent_outputs));
+        }
+    }
+
+    // The outputs are committed to by the prevouts, so checking against the
+    // copy gives the same result as checking against the coins view later.
+    // Each chunk of transactions gets its own control: the queue gives up on
+    // the rest of a chunk after its first failure (those transactions are
+    // simply checked at admission), and concurrent callers take turns on the
+    // queue between chunks instead of waiting for a whole batch.
+    std::vector<PrecomputedTransactionData> txdata;
+    txdata.reserve(checked_txs.size());
+    for (size_t chunk_start = 0; chunk_start < checked_txs.size(); chunk_start += MEMPOOL_PRECHECK_CHUNK) {
+        const size_t chunk_end = std::min(checked_txs.size(), chunk_start + MEMPOOL_PRECHECK_CHUNK);
+        std::vector<CScriptCheck> checks;
+        for (size_t pos = chunk_start; pos < chunk_end; ++pos) {
+            const CTransaction& tx = *checked_txs[pos].first;
+            txdata.emplace_back(tx);
+            for (unsigned int i = 0; i < tx.vin.size(); i++) {
+                checks.emplace_back(checked_txs[pos].second[i], tx, i, STANDARD_SCRIPT_VERIFY_FLAGS, true, &txdata.back());
+            }
+        }
+        if (g_mempool_scriptcheckqueue && checks.size() > 1) {
+            CCheckQueueControl<CScriptCheck> control(g_mempool_scriptcheckqueue.get());
+            control.Add(std::move(checks));
+            control.Wait();
+        } else {
+            // Stop at the first failing input of each transaction, as the admission will.
+            size_t next = 0;
+            for (size_t pos = chunk_start; pos < chunk_end; ++pos) {
+                const size_t end = next + checked_txs[pos].first->vin.size();
+                while (next < end && checks[next]()) ++next;
+                next = end;
+            }
+        }
+    }
+}
+
 
 
 static int64_t nTimeCheck = 0;
@@ -1931,6 +2105,13 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         }
     }
 
+    // CheckBlock above verified the merkle root, so a proposal with the same
+    // transactions already passed everything below on this parent.
+    if (fScriptChecks && !fJustCheck && IsProposalValidated(hashPrevBlock, block.hashMerkleRoot)) {
+        LogPrint(BCLog::BENCH, "    - Reusing the validation of proposal %s\n", block.GetHashForSign().ToString());
+        fScriptChecks = false;
+    }
+
     int64_t nTime1 = GetTimeMicros(); nTimeCheck += nTime1 - nTimeStart;
     LogPrint(BCLog::BENCH, "    - Sanity checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime1 - nTimeStart), nTimeCheck * MICRO, nTimeCheck * MILLI / nBlocksTotal);
 
@@ -2199,6 +2380,46 @@ void PruneAndFlush() {
     }
 }
 
+std::shared_ptr<const ChainTipSnapshot> GetChainTipSnapshot()
+{
+    return std::atomic_load(&g_chain_tip_snapshot);
+}
+
+/** Publish a new chain tip snapshot for pindex, or clear it if pindex is nullptr. */
+static void PublishChainTipSnapshot(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+
+    std::shared_ptr<ChainTipSnapshot> snapshot;
+    if (pindex) {
+        snapshot = std::make_shared<ChainTipSnapshot>();
+        snapshot->tip = pindex;
+        snapshot->hash = pindex->GetBlockHash();
+        snapshot->height = pindex->nHeight;
+        snapshot->time = pindex->GetBlockTime();
+        snapshot->median_time = pindex->GetMedianTimePast();
+        snapshot->chain_tx = pindex->nChainTx;
+
+        // ConnectTip records the xfield change of a block before the tip
+        // moves to it, so the history matches pindex here.
+        CXFieldHistory xfieldHistory;
+        for (auto x : XFIELDTYPES_INIT_LIST) {
+            snapshot->xfield_changes.emplace(x, xfieldHistory[x].xfieldChanges);
+        }
+        xfieldHistory.GetLatest(TAPYRUS_XFIELDTYPES::AGGPUBKEY, snapshot->aggpubkey);
+        XFieldMaxBlockSize maxBlockSize;
+        xfieldHistory.GetLatest(TAPYRUS_XFIELDTYPES::MAXBLOCKSIZE, maxBlockSize);
+        snapshot->max_block_size = maxBlockSize.data;
+    }
+    std::atomic_store(&g_chain_tip_snapshot, std::shared_ptr<const ChainTipSnapshot>(std::move(snapshot)));
+}
+
+void RepublishChainTipSnapshot()
+{
+    AssertLockHeld(cs_main);
+    if (chainActive.Tip()) PublishChainTipSnapshot(chainActive.Tip());
+}
+
 /** Check warning conditions and do some notifications on new chain tip set. */
 void static UpdateTip(const CBlockIndex *pindexNew)
 {
@@ -2207,6 +2428,8 @@ void static UpdateTip(const CBlockIndex *pindexNew)
     // New best block
     mempool.AddTransactionsUpdated(1);
 
+    PublishChainTipSnapshot(pindexNew);
+
     {
         WaitableLock lock(g_best_block_mutex);
         g_best_block = pindexNew->GetBlockHash();
@@ -3447,10 +3670,21 @@ bool TestBlockValidity(CValidationState& state, const CBlock& block, CBlockIndex
         return error("%s: Consensus::CheckBlock: %s", __func__, FormatStateMessage(state));
     if (!ContextualCheckBlock(block, state, pindexPrev))
         return error("%s: Consensus::ContextualCheckBlock: %s", __func__, FormatStateMessage(state));
+
+    // Without fCheckMerkleRoot the header may not commit to the transactions
+    // yet, so the proposal is identified by the merkle root they produce.
+    bool mutated = false;
+    const uint256 hashMerkleRoot = fCheckMerkleRoot ? block.hashMerkleRoot : BlockMerkleRoot(block, &mutated);
+    if (!mutated && IsProposalValidated(pindexPrev->GetBlockHash(), hashMerkleRoot))
+        return true;
+
     if (!g_chainstate.ConnectBlock(block, state, &indexDummy, viewNew, true))
         return false;
     assert(state.IsValid());
 
+    if (!mutated)
+        AddValidatedProposal(pindexPrev->GetBlockHash(), hashMerkleRoot);
+
     return true;
 }
 
@@ -3809,6 +4043,7 @@ bool LoadChainTip()
         return false;
     }
     chainActive.SetTip(pindex);
+    PublishChainTipSnapshot(pindex);
 
     g_chainstate.PruneBlockIndexCandidates();
 
@@ -3864,7 +4099,7 @@ bool CVerifyDB::VerifyDB(CCoinsView *coinsview, int nCheckLevel, int nCheckDepth
         }
         CBlock block;
         // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex))
+        if (!ReadBlockFromDisk(block, pindex, true, true))
             return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
         // check level 1: verify block validity
         if (nCheckLevel >= 1 && !CheckBlock(block, state))
@@ -3908,7 +4143,7 @@ bool CVerifyDB::VerifyDB(CCoinsView *coinsview, int nCheckLevel, int nCheckDepth
             uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, 100 - (int)(((double)(chainActive.Height() - pindex->nHeight)) / (double)nCheckDepth * 50))), false);
             pindex = chainActive.Next(pindex);
             CBlock block;
-            if (!ReadBlockFromDisk(block, pindex))
+            if (!ReadBlockFromDisk(block, pindex, true, true))
                 return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
             if (!g_chainstate.ConnectBlock(block, state, pindex, coins))
                 return error("VerifyDB(): *** found unconnectable block at %d, hash=%s (%s)", pindex->nHeight, pindex->GetBlockHash().ToString(), FormatStateMessage(state));
@@ -4109,6 +4344,7 @@ void UnloadBlockIndex()
 {
     LOCK(cs_main);
     chainActive.SetTip(nullptr);
+    PublishChainTipSnapshot(nullptr);
     pindexBestInvalid = nullptr;
     pindexBestHeader = nullptr;
     mempool.clear();
@@ -4504,7 +4740,117 @@ CBlockFileInfo* GetBlockFileInfo(size_t n)
     return &vinfoBlockFile.at(n);
 }
 
-static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+/**
+ * mempool.dat format versions. Version 2 adds the tip the mempool was dumped
+ * at and, per transaction, the fee, entry height, sigop cost and ancestor
+ * count it had in the mempool.
+ */
+static const uint64_t MEMPOOL_DUMP_VERSION_NO_CACHE = 1;
+static const uint64_t MEMPOOL_DUMP_VERSION = 2;
+
+//! Number of mempool.dat transactions whose scripts are verified together on reload
+static const size_t MEMPOOL_LOAD_BATCH = 1000;
+
+/** One transaction read from mempool.dat */
+struct MempoolDumpEntry
+{
+    CTransactionRef tx;
+    int64_t nTime;
+    int64_t nFeeDelta;
+    // Cached mempool state, only read from version 2 files
+    CAmount nFee{0};
+    unsigned int nHeight{0};
+    int32_t nSigOpCost{0};
+    uint64_t nCountWithAncestors{0};
+};
+
+/**
+ * Put back a transaction saved at the current tip without verifying its
+ * scripts again: the coins it spends and the script flags are the ones it
+ * was accepted with. The other checks of AcceptToMemoryPoolWorker are
+ * repeated with the current policy and limits, and the fee and ancestor
+ * count must come out as cached; otherwise it returns false and the
+ * transaction is left to AcceptToMemoryPoolWorker.
+ */
+static bool RestoreMempoolEntry(const MempoolDumpEntry& dumped, CCoinsViewMemPool& view_mempool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, mempool.cs)
+{
+    const CTransaction& tx = *dumped.tx;
+    const uint256 hash = tx.GetHashMalFix();
+
+#ifdef DEBUG
+    const bool require_standard = !acceptnonstdtxn;
+#else
+    const bool require_standard = true;
+#endif
+    CValidationState state;
+    std::string reason;
+    if (!CheckTransaction(tx, state) || tx.IsCoinBase() ||
+        (require_standard && !IsStandardTx(tx, reason)) ||
+        ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS) < MIN_STANDARD_TX_SIZE ||
+        !CheckFinalTx(tx, STANDARD_LOCKTIME_VERIFY_FLAGS))
+        return false;
+
+    for (const CTxIn& txin : tx.vin) {
+        // Something else was added since, e.g. by a wallet
+        if (mempool.mapNextTx.count(txin.prevout))
+            return false;
+    }
+
+    CCoinsViewCache view(&view_mempool);
+    CAmount nFees = 0;
+    for (const CTxIn& txin : tx.vin) {
+        if (!view.HaveCoin(txin.prevout))
+            return false;
+    }
+    if (!CheckColorIdentifierValidity(tx, state, view) ||
+        !Consensus::CheckTxInputs(tx, state, view, GetSpendHeight(view), nFees) || nFees != dumped.nFee ||
+        (require_standard && !AreInputsStandard(tx, view)))
+        return false;
+
+    LockPoints lp;
+    if (!CheckSequenceLocks(tx, STANDARD_LOCKTIME_VERIFY_FLAGS, view_mempool, &lp))
+        return false;
+
+    bool fSpendsCoinbase = false;
+    bool fSpendsToken = false;
+    TxColoredCoinBalancesMap inColoredCoinBalances;
+    for (const CTxIn& txin : tx.vin) {
+        const Coin& coin = view.AccessCoin(txin.prevout);
+        if (coin.IsCoinBase())
+            fSpendsCoinbase = true;
+        if (coin.out.scriptPubKey.IsColoredScript())
+            fSpendsToken = true;
+        inColoredCoinBalances[GetColorIdFromScript(coin.out.scriptPubKey)] += coin.out.nValue;
+    }
+
+    CTxMemPoolEntry entry(dumped.tx, nFees, dumped.nTime, dumped.nHeight, fSpendsCoinbase, fSpendsToken, dumped.nSigOpCost, lp);
+    const unsigned int nSize = entry.GetTxSize();
+
+    CAmount nModifiedFees = nFees;
+    mempool.ApplyDelta(hash, nModifiedFees);
+    if (nModifiedFees < mempool.GetMinFee(gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000).GetFee(nSize) ||
+        nModifiedFees < ::minRelayTxFee.GetFee(nSize) ||
+        !VerifyTokenBalances(tx, state, inColoredCoinBalances, ::minRelayTxFee.GetFee(nSize)))
+        return false;
+
+    // The package limits of now, and the cached ancestor count tells
+    // whether the same ancestors are back.
+    CTxMemPool::setEntries setAncestors;
+    const size_t nLimitAncestors = gArgs.GetArg("-limitancestorcount", DEFAULT_ANCESTOR_LIMIT);
+    const size_t nLimitAncestorSize = gArgs.GetArg("-limitancestorsize", DEFAULT_ANCESTOR_SIZE_LIMIT)*1000;
+    const size_t nLimitDescendants = gArgs.GetArg("-limitdescendantcount", DEFAULT_DESCENDANT_LIMIT);
+    const size_t nLimitDescendantSize = gArgs.GetArg("-limitdescendantsize", DEFAULT_DESCENDANT_SIZE_LIMIT)*1000;
+    std::string errString;
+    if (!mempool.CalculateMemPoolAncestors(entry, setAncestors, nLimitAncestors, nLimitAncestorSize, nLimitDescendants, nLimitDescendantSize, errString) ||
+        setAncestors.size() + 1 != dumped.nCountWithAncestors)
+        return false;
+    if (mempool.IsClusterMode() && mempool.CalculateClusterSize(setAncestors) > mempool.GetClusterLimit())
+        return false;
+
+    mempool.addUnchecked(hash, entry, setAncestors, false);
+    GetMainSignals().TransactionAddedToMempool(dumped.tx, mempool.GetAndIncrementSequence());
+    return true;
+}
 
 bool LoadMempool(void)
 {
@@ -4517,67 +4863,130 @@ bool LoadMempool(void)
     }
 
     int64_t count = 0;
+    int64_t restored = 0;
     int64_t expired = 0;
     int64_t failed = 0;
     int64_t already_there = 0;
     int64_t nNow = GetTime();
+    int64_t nStart = GetTimeMicros();
 
+    std::vector<MempoolDumpEntry> entries;
+    std::map<uint256, CAmount> mapDeltas;
+    bool fSameTip = false;
     try {
         uint64_t version;
         file >> version;
-        if (version != MEMPOOL_DUMP_VERSION) {
+        if (version != MEMPOOL_DUMP_VERSION && version != MEMPOOL_DUMP_VERSION_NO_CACHE) {
             return false;
         }
+        if (version == MEMPOOL_DUMP_VERSION) {
+            uint256 hashTip;
+            file >> hashTip;
+            LOCK(cs_main);
+            fSameTip = chainActive.Tip() && chainActive.Tip()->GetBlockHash() == hashTip;
+        }
         uint64_t num;
         file >> num;
         while (num--) {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta) {
-                mempool.PrioritiseTransaction(tx->GetHashMalFix(), amountdelta);
+            MempoolDumpEntry dumped;
+            file >> dumped.tx;
+            file >> dumped.nTime;
+            file >> dumped.nFeeDelta;
+            if (version == MEMPOOL_DUMP_VERSION) {
+                file >> dumped.nFee;
+                file >> dumped.nHeight;
+                file >> dumped.nSigOpCost;
+                file >> dumped.nCountWithAncestors;
             }
-            CTxMempoolAcceptanceOptions opt;
-            if (nTime + nExpiryTimeout > nNow) {
-                LOCK(cs_main);
-                opt.nAcceptTime = nTime;
-                AcceptToMemoryPoolWorker(tx, opt);
-                if (opt.state.IsValid()) {
-                    ++count;
-                } else {
-                    // mempool may contain the transaction already, e.g. from
-                    // wallet(s) having loaded it while we were processing
-                    // mempool transactions; consider these as valid, instead of
-                    // failed, but mark them as 'already there'
-                    if (mempool.exists(tx->GetHashMalFix())) {
-                        ++already_there;
-                    } else {
-                        ++failed;
-                    }
-                }
+            if (dumped.nTime + nExpiryTimeout > nNow) {
+                entries.push_back(std::move(dumped));
             } else {
                 ++expired;
             }
             if (ShutdownRequested())
                 return false;
         }
-        std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
-
-        for (const auto& i : mapDeltas) {
-            mempool.PrioritiseTransaction(i.first, i.second);
-        }
     } catch (const std::exception& e) {
         LogPrintf("Failed to deserialize mempool data on disk: %s. Continuing anyway.\n", e.what());
         return false;
     }
 
-    LogPrintf("Imported mempool transactions from disk: %i succeeded, %i failed, %i expired, %i already there\n", count, failed, expired, already_there);
+    // Parents before children, so that every transaction finds its inputs.
+    std::vector<CTransactionRef> txns;
+    txns.reserve(entries.size());
+    for (const MempoolDumpEntry& dumped : entries) {
+        txns.push_back(dumped.tx);
+    }
+    const std::vector<size_t> order = SortBatchByDependency(txns);
+
+    for (const MempoolDumpEntry& dumped : entries) {
+        if (dumped.nFeeDelta) {
+            mempool.PrioritiseTransaction(dumped.tx->GetHashMalFix(), dumped.nFeeDelta);
+        }
+    }
+
+    // With the tip unchanged, the saved transactions spend the same coins as
+    // when they were accepted, so their entries are rebuilt from the cached
+    // data. Whatever cannot be restored that way is validated in full below.
+    std::vector<size_t> to_validate;
+    if (fSameTip) {
+        LOCK2(cs_main, mempool.cs);
+        CCoinsViewMemPool view_mempool(pcoinsTip.get(), mempool);
+        for (size_t i : order) {
+            if (mempool.exists(entries[i].tx->GetHashMalFix())) {
+                ++already_there;
+            } else if (RestoreMempoolEntry(entries[i], view_mempool)) {
+                ++restored;
+            } else {
+                to_validate.push_back(i);
+            }
+        }
+        LimitMempoolSize(mempool, gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, nExpiryTimeout);
+    } else {
+        to_validate = order;
+    }
+
+    // Verify the scripts of a batch on the mempool script check threads
+    // before cs_main is taken to admit it.
+    for (size_t batch_start = 0; batch_start < to_validate.size(); batch_start += MEMPOOL_LOAD_BATCH) {
+        const size_t batch_end = std::min(to_validate.size(), batch_start + MEMPOOL_LOAD_BATCH);
+        std::vector<CTransactionRef> batch;
+        for (size_t pos = batch_start; pos < batch_end; ++pos) {
+            batch.push_back(entries[to_validate[pos]].tx);
+        }
+        PreCheckMempoolTransactions(batch);
+
+        LOCK(cs_main);
+        for (size_t pos = batch_start; pos < batch_end; ++pos) {
+            const MempoolDumpEntry& dumped = entries[to_validate[pos]];
+            CTxMempoolAcceptanceOptions opt;
+            opt.nAcceptTime = dumped.nTime;
+            AcceptToMemoryPoolWorker(dumped.tx, opt);
+            if (opt.state.IsValid()) {
+                ++count;
+            } else {
+                // mempool may contain the transaction already, e.g. from
+                // wallet(s) having loaded it while we were processing
+                // mempool transactions; consider these as valid, instead of
+                // failed, but mark them as 'already there'
+                if (mempool.exists(dumped.tx->GetHashMalFix())) {
+                    ++already_there;
+                } else {
+                    ++failed;
+                }
+            }
+        }
+        if (ShutdownRequested())
+            return false;
+    }
+
+    for (const auto& i : mapDeltas) {
+        mempool.PrioritiseTransaction(i.first, i.second);
+    }
+
+    LogPrintf("Imported mempool transactions from disk: %i succeeded, %i restored at the same tip, %i failed, %i expired, %i already there (%.2fs)\n",
+        count, restored, failed, expired, already_there, (GetTimeMicros() - nStart) * MICRO);
     return true;
 }
 
@@ -4587,13 +4996,17 @@ bool DumpMempool(void)
 
     std::map<uint256, CAmount> mapDeltas;
     std::vector<TxMempoolInfo> vinfo;
+    uint256 hashTip;
 
     {
-        LOCK(mempool.cs);
+        LOCK2(cs_main, mempool.cs);
         for (const auto &i : mempool.mapDeltas) {
             mapDeltas[i.first] = i.second;
         }
         vinfo = mempool.infoAll();
+        if (chainActive.Tip()) {
+            hashTip = chainActive.Tip()->GetBlockHash();
+        }
     }
 
     int64_t mid = GetTimeMicros();
@@ -4608,12 +5021,17 @@ bool DumpMempool(void)
 
         uint64_t version = MEMPOOL_DUMP_VERSION;
         file << version;
+        file << hashTip;
 
         file << (uint64_t)vinfo.size();
         for (const auto& i : vinfo) {
             file << *(i.tx);
             file << (int64_t)i.nTime;
             file << (int64_t)i.nFeeDelta;
+            file << i.nFee;
+            file << i.nHeight;
+            file << i.nSigOpCost;
+            file << i.nCountWithAncestors;
             mapDeltas.erase(i.tx->GetHashMalFix());
         }
 
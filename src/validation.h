@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
@@ -37,6 +38,7 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CBlockUndo;
 class CChainParams;
 class CCoinsViewDB;
 class CInv;
@@ -71,6 +73,10 @@ static const unsigned int DEFAULT_ANCESTOR_SIZE_LIMIT = 101;
 static const unsigned int DEFAULT_DESCENDANT_LIMIT = 25;
 /** Default for -limitdescendantsize, maximum kilobytes of in-mempool descendants */
 static const unsigned int DEFAULT_DESCENDANT_SIZE_LIMIT = 101;
+/** Default for -clustermempool, whether to track clusters of dependent mempool transactions */
+static const bool DEFAULT_CLUSTER_MEMPOOL = false;
+/** Default for -limitclustercount, max number of transactions in a mempool cluster in cluster mode */
+static const unsigned int DEFAULT_CLUSTER_LIMIT = 100;
 /** Default for -mempoolexpiry, expiration time for mempool transactions in hours */
 static const unsigned int DEFAULT_MEMPOOL_EXPIRY = 336;
 /** Maximum kilobytes for transactions to store for processing during reorg */
@@ -86,6 +92,8 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** -mempoolpar default (number of threads pre-checking mempool transaction scripts, 0 = auto) */
+static const int DEFAULT_MEMPOOL_SCRIPTCHECK_THREADS = 0;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -159,6 +167,39 @@ extern const std::string strMessageMagic;
 extern Mutex g_best_block_mutex;
 extern CConditionVariable g_best_block_cv;
 extern uint256 g_best_block;
+
+/**
+ * Immutable view of the active chain tip. A new one is published every time
+ * the tip changes, so read-only RPC and REST handlers can answer without
+ * taking cs_main. The fields are consistent with each other and, while
+ * cs_main is held, with chainActive and pcoinsTip.
+ */
+struct ChainTipSnapshot
+{
+    //! the tip itself; only its immutable fields (hash, height, header, pprev) may be read without cs_main
+    const CBlockIndex* tip;
+    uint256 hash;
+    int height;
+    int64_t time;
+    int64_t median_time;
+    unsigned int chain_tx;
+    //! xfield changes in the active chain up to the tip, by type
+    std::map<TAPYRUS_XFIELDTYPES, XFieldChangeList> xfield_changes;
+    //! aggregate pubkey and max block size that apply to the next block
+    XFieldAggPubKey aggpubkey;
+    uint32_t max_block_size;
+};
+
+/**
+ * Return the last published chain tip snapshot, or nullptr while no chain is
+ * loaded. Does not need cs_main.
+ */
+std::shared_ptr<const ChainTipSnapshot> GetChainTipSnapshot();
+/**
+ * Publish the chain tip snapshot again for the current tip, once the xfield
+ * history it holds has been loaded at startup.
+ */
+void RepublishChainTipSnapshot() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 extern std::atomic_bool fImporting;
 extern std::atomic_bool fReindex;
 extern int nScriptCheckThreads;
@@ -265,6 +306,8 @@ bool LoadChainTip();
 void UnloadBlockIndex();
 /** Run instances of script checking worker threads */
 void StartScriptCheckWorkerThreads(int threads_num);
+/** Run the worker threads used by PreCheckMempoolTransaction() */
+void StartMempoolScriptCheckThreads(int threads_num);
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -305,6 +348,35 @@ void PruneBlockFilesManual(int nManualPruneHeight);
  * plTxnReplaced will be appended to with all transactions replaced from mempool **/
 bool AcceptToMemoryPool(const CTransactionRef &tx, CTxMempoolAcceptanceOptions &opt);
 
+/**
+ * Verify the scripts of a transaction that is about to be passed to
+ * AcceptToMemoryPool, without holding cs_main while doing so. The coins it
+ * spends are copied from the chainstate and mempool under a short lock, then
+ * its inputs are checked against that copy on the mempool script check
+ * threads, storing each valid signature in the signature cache. The
+ * admission under cs_main repeats the checks as before, but finds every
+ * signature cached. Nothing is decided here: transactions that would fail are
+ * left for AcceptToMemoryPool to reject with the usual state. Transactions it
+ * would reject before looking at their scripts, such as those already in the
+ * mempool, non-final ones or those paying less than the mempool minimum fee,
+ * are not checked at all.
+ *
+ * If given, skip(tx) is called under the same cs_main lock as the coins are
+ * copied with, so that callers can check e.g. whether they already have the
+ * transaction without taking cs_main once more. It returns true to leave
+ * the transaction unchecked.
+ */
+void PreCheckMempoolTransaction(const CTransactionRef& tx, const std::function<bool(const CTransaction&)>& skip = nullptr) LOCKS_EXCLUDED(cs_main);
+
+/**
+ * PreCheckMempoolTransaction() for a batch of transactions. The coins of the
+ * whole batch are copied under one lock, and outputs created by an earlier
+ * or later transaction of the batch are taken from that transaction, so
+ * chained transactions are checked as well. The inputs of all transactions
+ * are queued together so the script check threads stay busy across them.
+ */
+void PreCheckMempoolTransactions(const std::vector<CTransactionRef>& txs, const std::function<bool(const CTransaction&)>& skip = nullptr) LOCKS_EXCLUDED(cs_main);
+
 /** remove old transactions from mempool based on age to keep it within size limits*/
 void LimitMempoolSize(CTxMemPool& pool, size_t limit, unsigned long age);
 
@@ -374,11 +446,19 @@ public:
 void InitScriptExecutionCache();
 
 
-/** Functions for disk access for blocks */
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int height);
-bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex);
+/** Functions for disk access for blocks.
+ * fCheckProof may be set to false by callers reading blocks that are already
+ * part of the validated block index (e.g. wallet rescans); the block hash is
+ * still compared against the index entry.
+ * fArena may be set by callers that do not keep any of the block's
+ * transactions after they are done with the block (e.g. serving it to peers);
+ * the transactions are then allocated together, see UnserializeBlockInArena. */
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int height, bool fCheckProof = true, bool fArena = false);
+bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, bool fCheckProof = true, bool fArena = false);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& message_start);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& message_start);
+/** Read the undo data of a block, which holds the coins spent by its inputs. */
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -388,6 +468,12 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW = t
 /** Check a block is completely valid from start to finish (only works on top of our current best block) */
 bool TestBlockValidity(CValidationState& state, const CBlock& block, CBlockIndex* pindexPrev, bool fCheckPOW = true, bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Whether a block with these transactions (identified by their unmutated merkle
+ * root) already passed ConnectBlock on top of hashPrevBlock, see TestBlockValidity.
+ */
+bool IsProposalValidated(const uint256& hashPrevBlock, const uint256& hashMerkleRoot) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 /** When there are blocks in the active chain with missing data, rewind the chainstate and remove them from the block index */
 bool RewindBlockIndex();
 
@@ -84,7 +84,7 @@ bool TestWalletSetup::AddToWalletAndMempool(const CTransactionRef tx) {
     if(!wallet->AddToWallet(wtx)) {
         return false;
     }
-    wallet->TransactionAddedToMempool(tx);
+    wallet->TransactionAddedToMempool(tx, 0 /* mempool_sequence */);
 
     return true;
 }
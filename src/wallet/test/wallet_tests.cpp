@@ -539,7 +539,7 @@ public:
         if(!wallet->AddToWallet(wtx)) {
             return false;
         }
-        wallet->TransactionAddedToMempool(tx);
+        wallet->TransactionAddedToMempool(tx, 0 /* mempool_sequence */);
 
         return true;
     }
@@ -933,4 +933,46 @@ BOOST_FIXTURE_TEST_CASE(wallet_tx_getchange, TestChainSetup)
     BOOST_CHECK_EQUAL(wtx.GetChange(colorId), 100 * CENT);
 }
 
+BOOST_AUTO_TEST_CASE(wallet_scan_filter)
+{
+    CKey key, otherKey;
+    key.MakeNewKey(true);
+    otherKey.MakeNewKey(true);
+    const CKeyID keyid = key.GetPubKey().GetID();
+    const ColorIdentifier colorId(ParseHex("c11863143c14c5166804bd19203356da136c985678cd4d27a1b8c6329604903262"));
+    const CScript redeemScript = GetScriptForMultisig(1, {key.GetPubKey(), otherKey.GetPubKey()});
+    const CScript watchScript = GetScriptForMultisig(1, {otherKey.GetPubKey()});
+
+    WalletScanFilter filter;
+    filter.Insert(keyid);
+    filter.Insert(CScriptID(redeemScript));
+    filter.Finalize();
+
+    // Uncolored and colored outputs to our key or script match
+    BOOST_CHECK(filter.MatchesOutput(GetScriptForDestination(keyid)));
+    BOOST_CHECK(filter.MatchesOutput(GetScriptForRawPubKey(key.GetPubKey())));
+    BOOST_CHECK(filter.MatchesOutput(GetScriptForDestination(CColorKeyID(keyid, colorId))));
+    BOOST_CHECK(filter.MatchesOutput(GetScriptForDestination(CScriptID(redeemScript))));
+    BOOST_CHECK(filter.MatchesOutput(GetScriptForDestination(CColorScriptID(CScriptID(redeemScript), colorId))));
+
+    // Everything else does not
+    BOOST_CHECK(!filter.MatchesOutput(GetScriptForDestination(otherKey.GetPubKey().GetID())));
+    BOOST_CHECK(!filter.MatchesOutput(GetScriptForDestination(CColorKeyID(otherKey.GetPubKey().GetID(), colorId))));
+    BOOST_CHECK(!filter.MatchesOutput(redeemScript));
+    BOOST_CHECK(!filter.MatchesOutput(watchScript));
+
+    // Watch-only scripts match on the whole scriptPubKey
+    filter.InsertWatchOnly(watchScript);
+    filter.Finalize();
+    BOOST_CHECK(filter.MatchesOutput(watchScript));
+
+    CMutableTransaction mtx;
+    mtx.vout.resize(2);
+    mtx.vout[0].scriptPubKey = GetScriptForDestination(otherKey.GetPubKey().GetID());
+    mtx.vout[1].scriptPubKey = GetScriptForDestination(CColorKeyID(keyid, colorId));
+    BOOST_CHECK(filter.MatchesAnyOutput(CTransaction(mtx)));
+    mtx.vout.pop_back();
+    BOOST_CHECK(!filter.MatchesAnyOutput(CTransaction(mtx)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -34,6 +34,7 @@
 #include <algorithm>
 #include <assert.h>
 #include <future>
+#include <thread>
 
 #include <boost/algorithm/string/replace.hpp>
 
@@ -1212,7 +1213,7 @@ void CWallet::SyncTransaction(const CTransactionRef& ptx, const CBlockIndex *pin
     MarkInputsDirty(ptx);
 }
 
-void CWallet::TransactionAddedToMempool(const CTransactionRef& ptx) {
+void CWallet::TransactionAddedToMempool(const CTransactionRef& ptx, uint64_t mempool_sequence) {
     LOCK2(cs_main, cs_wallet);
     SyncTransaction(ptx);
 
@@ -1222,7 +1223,7 @@ void CWallet::TransactionAddedToMempool(const CTransactionRef& ptx) {
     }
 }
 
-void CWallet::TransactionRemovedFromMempool(const CTransactionRef &ptx) {
+void CWallet::TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolRemovalReason reason, uint64_t mempool_sequence) {
     LOCK(cs_wallet);
     auto it = mapWallet.find(ptx->GetHashMalFix());
     if (it != mapWallet.end()) {
@@ -1242,11 +1243,11 @@ void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const
 
     for (const CTransactionRef& ptx : vtxConflicted) {
         SyncTransaction(ptx);
-        TransactionRemovedFromMempool(ptx);
+        TransactionRemovedFromMempool(ptx, MemPoolRemovalReason::CONFLICT, 0 /* mempool_sequence */);
     }
     for (size_t i = 0; i < pblock->vtx.size(); i++) {
         SyncTransaction(pblock->vtx[i], pindex, i);
-        TransactionRemovedFromMempool(pblock->vtx[i]);
+        TransactionRemovedFromMempool(pblock->vtx[i], MemPoolRemovalReason::BLOCK, 0 /* mempool_sequence */);
     }
 
     m_last_block_processed = pindex;
@@ -1695,6 +1696,93 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
     return startTime;
 }
 
+void WalletScanFilter::InsertWatchOnly(const CScript& script)
+{
+    m_hashes.push_back(CScriptID(script));
+    m_match_script_hash = true;
+}
+
+void WalletScanFilter::Finalize()
+{
+    std::sort(m_hashes.begin(), m_hashes.end());
+    m_hashes.erase(std::unique(m_hashes.begin(), m_hashes.end()), m_hashes.end());
+}
+
+bool WalletScanFilter::Contains(const uint160& hash) const
+{
+    return std::binary_search(m_hashes.begin(), m_hashes.end(), hash);
+}
+
+bool WalletScanFilter::MatchesOutput(const CScript& scriptPubKey) const
+{
+    std::vector<std::vector<unsigned char>> vSolutions;
+    txnouttype whichType;
+    Solver(scriptPubKey, whichType, vSolutions);
+
+    switch (whichType)
+    {
+    case TX_PUBKEY:
+        if (Contains(Hash160(vSolutions[0])))
+            return true;
+        break;
+    case TX_PUBKEYHASH:
+    case TX_COLOR_PUBKEYHASH:
+    case TX_SCRIPTHASH:
+    case TX_COLOR_SCRIPTHASH:
+        if (Contains(uint160(vSolutions[0])))
+            return true;
+        break;
+    default:
+        break;
+    }
+    return m_match_script_hash && Contains(CScriptID(scriptPubKey));
+}
+
+bool WalletScanFilter::MatchesAnyOutput(const CTransaction& tx) const
+{
+    for (const CTxOut& txout : tx.vout) {
+        if (MatchesOutput(txout.scriptPubKey))
+            return true;
+    }
+    return false;
+}
+
+void CWallet::BuildScanFilter(WalletScanFilter& filter) const
+{
+    for (const CKeyID& keyid : GetKeys()) {
+        filter.Insert(keyid);
+    }
+    for (const CScriptID& scriptid : GetCScripts()) {
+        filter.Insert(scriptid);
+    }
+    {
+        LOCK(cs_KeyStore);
+        for (const CScript& script : setWatchOnly) {
+            filter.InsertWatchOnly(script);
+        }
+    }
+    filter.Finalize();
+}
+
+size_t CWallet::KeyStoreEntryCount() const
+{
+    LOCK(cs_KeyStore);
+    return mapKeys.size() + mapCryptedKeys.size() + mapScripts.size() + setWatchOnly.size();
+}
+
+bool CWallet::IsRescanCandidate(const CTransaction& tx) const
+{
+    AssertLockHeld(cs_wallet);
+    if (mapWallet.count(tx.GetHashMalFix()))
+        return true;
+    for (const CTxIn& txin : tx.vin) {
+        // Spends a wallet coin, or conflicts with a wallet transaction
+        if (mapWallet.count(txin.prevout.hashMalFix) || mapTxSpends.count(txin.prevout))
+            return true;
+    }
+    return false;
+}
+
 /**
  * Scan the block chain (starting in pindexStart) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -1743,43 +1831,133 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
             }
         }
         double progress_current = progress_begin;
-        while (pindex && !fAbortRescan && !ShutdownRequested())
+
+        int nThreads = gArgs.GetArg("-rescanthreads", DEFAULT_RESCAN_THREADS);
+        if (nThreads <= 0)
+            nThreads += GetNumCores();
+        nThreads = std::max(1, std::min(nThreads, MAX_RESCAN_THREADS));
+
+        // Blocks are read, deserialized and matched against the output filter
+        // in batches by nThreads reader threads. Only transactions that pass
+        // the filter, or that spend or conflict with wallet coins, are handed to
+        // SyncTransaction, which runs in chain order under cs_main and cs_wallet.
+        struct ScannedBlock {
+            CBlockIndex* pindex;
+            CBlock block;
+            bool fRead{false};
+            unsigned int nFilterGeneration{0};
+            std::vector<bool> vMatches;
+        };
+
+        WalletScanFilter filter;
+        BuildScanFilter(filter);
+        unsigned int nFilterGeneration = 0;
+        size_t nKeyStoreEntries = KeyStoreEntryCount();
+
+        auto fnPrefilter = [&](ScannedBlock& scanned) {
+            scanned.nFilterGeneration = nFilterGeneration;
+            scanned.vMatches.assign(scanned.block.vtx.size(), false);
+            for (size_t i = 0; i < scanned.block.vtx.size(); ++i) {
+                scanned.vMatches[i] = filter.MatchesAnyOutput(*scanned.block.vtx[i]);
+            }
+        };
+
+        std::vector<ScannedBlock> vBatch;
+        bool fDone = false;
+        while (pindex && !fDone && !fAbortRescan && !ShutdownRequested())
         {
-            if (pindex->nHeight % 100 == 0 && progress_end - progress_begin > 0.0) {
-                ShowProgress(strprintf("%s " + _("Rescanning..."), GetDisplayName()), std::max(1, std::min(99, (int)((progress_current - progress_begin) / (progress_end - progress_begin) * 100))));
+            // Collect the next batch of blocks on the active chain.
+            vBatch.clear();
+            {
+                LOCK(cs_main);
+                for (CBlockIndex* pnext = pindex; pnext && vBatch.size() < (size_t)nThreads * RESCAN_BLOCKS_PER_THREAD; pnext = chainActive.Next(pnext)) {
+                    vBatch.emplace_back();
+                    vBatch.back().pindex = pnext;
+                    if (pnext == pindexStop) break;
+                }
             }
-            if (GetTime() >= nNow + 60) {
-                nNow = GetTime();
-                WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight, progress_current);
+
+            std::atomic<size_t> nNextBlock{0};
+            auto fnReader = [&]() {
+                for (size_t i = nNextBlock++; i < vBatch.size(); i = nNextBlock++) {
+                    ScannedBlock& scanned = vBatch[i];
+                    // The block is already part of the validated index; only the
+                    // hash is compared, the proof is not verified again.
+                    scanned.fRead = ReadBlockFromDisk(scanned.block, scanned.pindex, false);
+                    if (scanned.fRead) {
+                        fnPrefilter(scanned);
+                    }
+                }
+            };
+            std::vector<std::thread> vReaders;
+            for (int n = 1; n < nThreads && (size_t)n < vBatch.size(); ++n) {
+                vReaders.emplace_back(fnReader);
+            }
+            fnReader();
+            for (std::thread& t : vReaders) {
+                t.join();
             }
 
-            CBlock block;
-            if (ReadBlockFromDisk(block, pindex)) {
-                LOCK2(cs_main, cs_wallet);
-                if (pindex && !chainActive.Contains(pindex)) {
-                    // Abort scan if current block is no longer active, to prevent
-                    // marking transactions as coming from the wrong block.
+            for (ScannedBlock& scanned : vBatch) {
+                if (fAbortRescan || ShutdownRequested()) {
+                    break;
+                }
+                pindex = scanned.pindex;
+                if (pindex->nHeight % 100 == 0 && progress_end - progress_begin > 0.0) {
+                    ShowProgress(strprintf("%s " + _("Rescanning..."), GetDisplayName()), std::max(1, std::min(99, (int)((progress_current - progress_begin) / (progress_end - progress_begin) * 100))));
+                }
+                if (GetTime() >= nNow + 60) {
+                    nNow = GetTime();
+                    WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight, progress_current);
+                }
+
+                if (scanned.fRead) {
+                    LOCK2(cs_main, cs_wallet);
+                    if (!chainActive.Contains(pindex)) {
+                        // Abort scan if current block is no longer active, to prevent
+                        // marking transactions as coming from the wrong block.
+                        ret = pindex;
+                        fDone = true;
+                        break;
+                    }
+                    // The keystore may have grown (keypool top-up) since this
+                    // block was filtered; match it again against a fresh filter.
+                    if (scanned.nFilterGeneration != nFilterGeneration) {
+                        fnPrefilter(scanned);
+                    }
+                    for (size_t posInBlock = 0; posInBlock < scanned.block.vtx.size(); ++posInBlock) {
+                        const CTransactionRef& ptx = scanned.block.vtx[posInBlock];
+                        if (scanned.vMatches[posInBlock] || IsRescanCandidate(*ptx)) {
+                            SyncTransaction(ptx, pindex, posInBlock, fUpdate, true);
+                        }
+                    }
+                    size_t nEntries = KeyStoreEntryCount();
+                    if (nEntries != nKeyStoreEntries) {
+                        nKeyStoreEntries = nEntries;
+                        filter = WalletScanFilter();
+                        BuildScanFilter(filter);
+                        ++nFilterGeneration;
+                    }
+                } else {
                     ret = pindex;
+                }
+                if (pindex == pindexStop) {
+                    fDone = true;
                     break;
                 }
-                for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
-                    SyncTransaction(block.vtx[posInBlock], pindex, posInBlock, fUpdate, true);
+                {
+                    LOCK(cs_main);
+                    progress_current = GuessVerificationProgress(chainParams.TxData(), chainActive.Next(pindex));
+                    if (pindexStop == nullptr && tip != chainActive.Tip()) {
+                        tip = chainActive.Tip();
+                        // in case the tip has changed, update progress max
+                        progress_end = GuessVerificationProgress(chainParams.TxData(), tip);
+                    }
                 }
-            } else {
-                ret = pindex;
             }
-            if (pindex == pindexStop) {
-                break;
-            }
-            {
+            if (!fDone && !fAbortRescan && !ShutdownRequested()) {
                 LOCK(cs_main);
-                pindex = chainActive.Next(pindex);
-                progress_current = GuessVerificationProgress(chainParams.TxData(), pindex);
-                if (pindexStop == nullptr && tip != chainActive.Tip()) {
-                    tip = chainActive.Tip();
-                    // in case the tip has changed, update progress max
-                    progress_end = GuessVerificationProgress(chainParams.TxData(), tip);
-                }
+                pindex = chainActive.Next(vBatch.back().pindex);
             }
         }
         if (pindex && fAbortRescan) {
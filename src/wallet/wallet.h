@@ -64,6 +64,12 @@ static const unsigned int DEFAULT_TX_CONFIRM_TARGET = 6;
 static const bool DEFAULT_WALLET_RBF = false;
 static const bool DEFAULT_WALLETBROADCAST = true;
 static const bool DEFAULT_DISABLE_WALLET = false;
+//! -rescanthreads default (0 = auto-detect)
+static const int DEFAULT_RESCAN_THREADS = 0;
+//! Maximum number of block reader threads used by a wallet rescan
+static const int MAX_RESCAN_THREADS = 16;
+//! Number of blocks read ahead per rescan thread
+static const int RESCAN_BLOCKS_PER_THREAD = 4;
 
 class CBlockIndex;
 class CCoinControl;
@@ -656,6 +662,35 @@ struct CoinSelectionParams
     CoinSelectionParams() {}
 };
 
+/**
+ * Compact, read-only summary of everything in a keystore that can make an
+ * output IsMine: key ids, P2SH script ids and the hashes of watch-only
+ * scripts. Colored outputs (CP2PKH/CP2SH) carry the same 20 byte hash as
+ * their uncolored counterparts, so one sorted set covers both.
+ *
+ * Matches may be false positives but never false negatives; the wallet still
+ * runs the exact IsMine check on matching transactions. The filter holds no
+ * reference to the wallet and can be used from any thread.
+ */
+class WalletScanFilter
+{
+private:
+    std::vector<uint160> m_hashes;
+    bool m_match_script_hash = false;
+
+public:
+    void Insert(const uint160& hash) { m_hashes.push_back(hash); }
+    //! Also match outputs by the hash of their whole scriptPubKey (watch-only scripts)
+    void InsertWatchOnly(const CScript& script);
+    //! Sort and deduplicate; must be called before the filter is queried
+    void Finalize();
+
+    bool Contains(const uint160& hash) const;
+    bool MatchesOutput(const CScript& scriptPubKey) const;
+    bool MatchesAnyOutput(const CTransaction& tx) const;
+    size_t Size() const { return m_hashes.size(); }
+};
+
 class WalletRescanReserver; //forward declarations for ScanForWalletTransactions/RescanFromTime
 /**
  * A CWallet is an extension of a keystore, which also maintains a set of transactions and balances,
@@ -718,6 +753,18 @@ private:
      * Should be called with pindexBlock and posInBlock if this is for a transaction that is included in a block. */
     void SyncTransaction(const CTransactionRef& tx, const CBlockIndex *pindex = nullptr, int posInBlock = 0, bool update_tx = true, bool rescanning_old_block = false) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /* Used by ScanForWalletTransactions. Cheap check whether a transaction in a block
+     * already matched by the output prefilter, or spending/conflicting with wallet coins,
+     * needs to go through SyncTransaction. */
+    bool IsRescanCandidate(const CTransaction& tx) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /* Snapshot the keystore into a WalletScanFilter. */
+    void BuildScanFilter(WalletScanFilter& filter) const;
+
+    /* Number of keys, scripts and watch-only entries in the keystore. Used to detect
+     * keystore growth (keypool top-up) while a rescan is in progress. */
+    size_t KeyStoreEntryCount() const;
+
     /* the HD chain data model (external chain counters) */
     CHDChain hdChain;
 
@@ -940,12 +987,12 @@ public:
     void MarkDirty();
     bool AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose=true, bool rescanning_old_block = false);
     void LoadToWallet(const CWalletTx& wtxIn) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
-    void TransactionAddedToMempool(const CTransactionRef& tx) override;
+    void TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) override;
     void BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex *pindex, const std::vector<CTransactionRef>& vtxConflicted) override;
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) override;
     int64_t RescanFromTime(int64_t startTime, const WalletRescanReserver& reserver, bool update);
     CBlockIndex* ScanForWalletTransactions(CBlockIndex* pindexStart, CBlockIndex* pindexStop, const WalletRescanReserver& reserver, bool fUpdate = false);
-    void TransactionRemovedFromMempool(const CTransactionRef &ptx) override;
+    void TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override;
     void ReacceptWalletTransactions();
     void ResendWalletTransactions(int64_t nBestBlockTime, CConnman* connman) override;
     // ResendWalletTransactionsBefore may only be called if fBroadcastTransactions!
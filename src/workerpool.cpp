@@ -0,0 +1,112 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <workerpool.h>
+
+#include <reverselock.h>
+#include <util.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+struct CWorkerPool::Job
+{
+    const std::function<void(size_t)>& fn;
+    const size_t count;
+    std::atomic<size_t> next{0};
+    //! Pool threads running this job, guarded by the pool's m_mutex
+    int running = 0;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    Job(const std::function<void(size_t)>& fn_in, size_t count_in) : fn(fn_in), count(count_in) {}
+
+    void Run()
+    {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+                next = count;
+            }
+        }
+    }
+};
+
+CWorkerPool::~CWorkerPool()
+{
+    Stop();
+}
+
+void CWorkerPool::Start(const std::string& name, int num_threads)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = false;
+    }
+    for (int n = 0; n < num_threads; ++n) {
+        m_threads.emplace_back(&TraceThread, name + "." + std::to_string(n), [this] { ThreadLoop(); });
+    }
+}
+
+void CWorkerPool::Stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_work_cond.notify_all();
+    for (std::thread& t : m_threads) {
+        t.join();
+    }
+    m_threads.clear();
+}
+
+void CWorkerPool::ThreadLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_work_cond.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) return;
+
+        Job* job = m_queue.front();
+        m_queue.pop_front();
+        job->running++;
+        {
+            reverse_lock<std::unique_lock<std::mutex> > rlock(lock);
+            job->Run();
+        }
+        if (--job->running == 0) m_done_cond.notify_all();
+    }
+}
+
+void CWorkerPool::ForEach(size_t count, size_t max_parallel, const std::function<void(size_t)>& fn)
+{
+    if (count == 0) return;
+
+    Job job(fn, count);
+    size_t helpers = std::min(std::max<size_t>(max_parallel, 1), count) - 1;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        helpers = std::min(helpers, m_threads.size());
+        if (m_stop) helpers = 0;
+        m_queue.insert(m_queue.end(), helpers, &job);
+    }
+    for (size_t n = 0; n < helpers; ++n) {
+        m_work_cond.notify_one();
+    }
+
+    job.Run();
+
+    {
+        // The threads that have not taken up the job by now are not needed.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queue.erase(std::remove(m_queue.begin(), m_queue.end(), &job), m_queue.end());
+        m_done_cond.wait(lock, [&] { return job.running == 0; });
+    }
+    if (job.error) std::rethrow_exception(job.error);
+}
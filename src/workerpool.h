@@ -0,0 +1,64 @@
+// Copyright (c) 2024 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WORKERPOOL_H
+#define BITCOIN_WORKERPOOL_H
+
+#include <sync.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of threads shared by the requests that split their work into
+ * independent items. However many requests do that at once, no more than
+ * the threads of the pool run their items besides the requests' own threads.
+ *
+ * Usage:
+ *
+ * CWorkerPool pool;
+ * pool.Start("worker", 4);
+ * pool.ForEach(items.size(), 8, [&](size_t i) { Process(items[i]); });
+ * ...
+ * pool.Stop();
+ */
+class CWorkerPool
+{
+public:
+    ~CWorkerPool();
+
+    //! Start num_threads threads named <name>.<n>. Nothing is started for 0.
+    void Start(const std::string& name, int num_threads);
+    //! Finish the items that were handed to the threads and join them
+    void Stop();
+
+    /**
+     * Call fn(i) for every i below count and return when all calls are done.
+     * The calling thread takes part, together with up to max_parallel - 1
+     * threads of the pool that are free, so that this works the same before
+     * Start() and after Stop(), only on one thread. After an exception, the
+     * remaining items are skipped and the first exception is rethrown.
+     */
+    void ForEach(size_t count, size_t max_parallel, const std::function<void(size_t)>& fn);
+
+private:
+    struct Job;
+
+    void ThreadLoop();
+
+    Mutex m_mutex;
+    std::condition_variable m_work_cond;
+    std::condition_variable m_done_cond;
+    //! One entry per thread asked to help with a job
+    std::deque<Job*> m_queue;
+    std::vector<std::thread> m_threads;
+    bool m_stop = false;
+};
+
+#endif // BITCOIN_WORKERPOOL_H
@@ -55,9 +55,12 @@ const XFieldChange& CXFieldHistoryMap::Get(TAPYRUS_XFIELDTYPES type, uint256 blo
 }
 
 void CXFieldHistory::ToUniValue(TAPYRUS_XFIELDTYPES type, UniValue* xFieldChangeUnival) {
+    XFieldChangesToUniValue(this->operator[](type).xfieldChanges, xFieldChangeUnival);
+}
+
+void XFieldChangesToUniValue(const XFieldChangeList& xfieldChanges, UniValue* xFieldChangeUnival) {
     *xFieldChangeUnival = UniValue(UniValue::VARR);
-    XFieldChangeListWrapper& xFieldChangeList = this->operator[](type);
-    for (const auto& xFieldChange : xFieldChangeList)
+    for (const auto& xFieldChange : xfieldChanges)
     {
         UniValue xFieldChangeObj(UniValue::VOBJ);
         std::string value = XFieldDataToString(xFieldChange.xfieldValue);
@@ -236,6 +236,9 @@ public:
 
 bool IsXFieldNew(const CXField& xfield, CXFieldHistoryMap* pxfieldHistory);
 
+/** Write a list of xfield changes as an array of {value: height} objects */
+void XFieldChangesToUniValue(const XFieldChangeList& xfieldChanges, UniValue* xFieldChangeUnival);
+
 /** 
  * The maximum block size according the current xfield history */
 uint32_t GetCurrentMaxBlockSize();
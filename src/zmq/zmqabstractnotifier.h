@@ -9,6 +9,8 @@
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
+class uint256;
+enum class MemPoolRemovalReason;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
@@ -35,6 +37,13 @@ public:
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     virtual bool NotifyTransaction(const CTransaction &transaction);
 
+    // Notifies of a block connected to or disconnected from the active chain
+    virtual bool NotifyBlockConnect(const CBlockIndex *pindex);
+    virtual bool NotifyBlockDisconnect(const uint256 &hash);
+    // Notifies of a transaction entering or leaving the mempool
+    virtual bool NotifyTransactionAcceptance(const CTransaction &transaction, uint64_t mempool_sequence);
+    virtual bool NotifyTransactionRemoval(const CTransaction &transaction, MemPoolRemovalReason reason, uint64_t mempool_sequence);
+
 protected:
     void *psocket;
     std::string type;
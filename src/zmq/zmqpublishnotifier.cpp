@@ -5,7 +5,9 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <coloridentifier.h>
 #include <streams.h>
+#include <txmempool.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <validation.h>
 #include <util.h>
@@ -17,6 +19,8 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_TOKENTX   = "tokentx";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -175,7 +179,7 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
     {
         LOCK(cs_main);
         CBlock block;
-        if(!ReadBlockFromDisk(block, pindex))
+        if(!ReadBlockFromDisk(block, pindex, true, true))
         {
             zmqError("Can't read block from disk");
             return false;
@@ -195,3 +199,77 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+// Helper function to send a 'sequence' topic message with the following structure:
+//    <32-byte hash> | <1-byte label> | <8-byte LE sequence> (optional) | <1-byte removal reason> (optional)
+static bool SendSequenceMsg(CZMQAbstractPublishNotifier& notifier, uint256 hash, char label, const uint64_t* sequence = nullptr, const MemPoolRemovalReason* reason = nullptr)
+{
+    unsigned char data[sizeof(hash) + sizeof(label) + sizeof(uint64_t) + 1];
+    for (unsigned int i = 0; i < sizeof(hash); ++i) {
+        data[sizeof(hash) - 1 - i] = hash.begin()[i];
+    }
+    size_t size = sizeof(hash);
+    data[size++] = label;
+    if (sequence) {
+        WriteLE64(data + size, *sequence);
+        size += sizeof(uint64_t);
+    }
+    if (reason) {
+        data[size++] = static_cast<unsigned char>(*reason);
+    }
+    return notifier.SendMessage(MSG_SEQUENCE, data, size);
+}
+
+bool CZMQPublishSequenceNotifier::NotifyBlockConnect(const CBlockIndex *pindex)
+{
+    uint256 hash = pindex->GetBlockHash();
+    LogPrint(BCLog::ZMQ, "zmq: Publish sequence block connect %s\n", hash.GetHex());
+    return SendSequenceMsg(*this, hash, /* Block (C)onnect */ 'C');
+}
+
+bool CZMQPublishSequenceNotifier::NotifyBlockDisconnect(const uint256 &hash)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish sequence block disconnect %s\n", hash.GetHex());
+    return SendSequenceMsg(*this, hash, /* Block (D)isconnect */ 'D');
+}
+
+bool CZMQPublishSequenceNotifier::NotifyTransactionAcceptance(const CTransaction &transaction, uint64_t mempool_sequence)
+{
+    uint256 hash = transaction.GetHashMalFix();
+    LogPrint(BCLog::ZMQ, "zmq: Publish sequence mempool acceptance %s\n", hash.GetHex());
+    return SendSequenceMsg(*this, hash, /* Mempool (A)cceptance */ 'A', &mempool_sequence);
+}
+
+bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &transaction, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    uint256 hash = transaction.GetHashMalFix();
+    LogPrint(BCLog::ZMQ, "zmq: Publish sequence mempool removal %s (%s)\n", hash.GetHex(), RemovalReasonToString(reason));
+    return SendSequenceMsg(*this, hash, /* Mempool (R)emoval */ 'R', &mempool_sequence, &reason);
+}
+
+bool CZMQPublishTokenTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
+{
+    // <32-byte txid> | <compact size count> | count * (<4-byte LE index> | <33-byte color id> | <8-byte LE amount>)
+    std::vector<uint32_t> colored;
+    for (uint32_t n = 0; n < transaction.vout.size(); ++n) {
+        if (transaction.vout[n].scriptPubKey.IsColoredScript()) {
+            colored.push_back(n);
+        }
+    }
+    if (colored.empty()) {
+        return true;
+    }
+
+    uint256 hash = transaction.GetHashMalFix();
+    LogPrint(BCLog::ZMQ, "zmq: Publish tokentx %s\n", hash.GetHex());
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    for (unsigned int i = 0; i < sizeof(hash); i++) {
+        ss << hash.begin()[sizeof(hash) - 1 - i];
+    }
+    WriteCompactSize(ss, colored.size());
+    for (uint32_t n : colored) {
+        const CTxOut& txout = transaction.vout[n];
+        ss << n << GetColorIdFromScript(txout.scriptPubKey) << txout.nValue;
+    }
+    return SendMessage(MSG_TOKENTX, &(*ss.begin()), ss.size());
+}
@@ -548,6 +548,13 @@ class MaxBloxkSizeInXFieldTest(BitcoinTestFramework):
         assert_equal(blockchaininfo["aggregatePubkeys"], expectedAggPubKeys)
         assert_equal(blockchaininfo["maxBlockSizes"], expectedblockheights)
 
+        self.log.info("Restarting node0 keeps the xfield history")
+        self.stop_node(0)
+        self.start_node(0)
+        blockchaininfo = node.getblockchaininfo()
+        assert_equal(blockchaininfo["aggregatePubkeys"], expectedAggPubKeys)
+        assert_equal(blockchaininfo["maxBlockSizes"], expectedblockheights)
+
         self.log.info("Restarting node0 with '-reindex-chainstate'")
         self.stop_node(0)
         self.start_node(0, extra_args=["-reindex-chainstate"])
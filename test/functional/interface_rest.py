@@ -11,10 +11,12 @@ from enum import Enum
 from io import BytesIO
 import json
 from struct import pack, unpack
+import time
 
 import http.client
 import urllib.parse
 
+from test_framework.messages import COutPoint, CTxOut, deser_string_vector, ser_compact_size, ser_uint256
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
     assert_equal,
@@ -165,6 +167,29 @@ class RESTTest (BitcoinTestFramework):
             assert tx in json_obj
             assert_equal(json_obj[tx]['spentby'], txs[i + 1:i + 2])
             assert_equal(json_obj[tx]['depends'], txs[i - 1:i])
+        assert_equal(json_obj, self.nodes[0].getrawmempool(True))
+
+        # Pages are continued from the cursor returned with the previous one
+        json_obj = self.test_rest_request("/mempool/contents/1")
+        assert_equal(json_obj, self.nodes[0].getrawmempool(True, False, 1))
+        paged = dict(json_obj['transactions'])
+        while json_obj['next'] is not None:
+            json_obj = self.test_rest_request("/mempool/contents/1/{}".format(json_obj['next']))
+            assert_equal(len(json_obj['transactions']), 1)
+            paged.update(json_obj['transactions'])
+        assert_equal(set(paged), set(txs))
+        json_obj = self.test_rest_request("/mempool/contents/10")
+        assert_equal(set(json_obj['transactions']), set(txs))
+        assert_equal(json_obj['next'], None)
+        self.test_rest_request("/mempool/contents/0", status=400, ret_type=RetType.OBJ)
+        self.test_rest_request("/mempool/contents/1/nocursor", status=400, ret_type=RetType.OBJ)
+
+        # The binary output starts with the mempool size and sequence number
+        bin_response = self.test_rest_request("/mempool/contents/2", req_type=ReqType.BIN, ret_type=RetType.BYTES)
+        total, mempool_sequence = unpack("<QQ", bin_response[:16])
+        assert_equal(total, 3)
+        assert_equal(mempool_sequence, self.nodes[0].getrawmempool(False, True)['mempool_sequence'])
+        assert_equal(bin_response[16], 2)
 
         # Now mine the transactions
         newblockhash = self.nodes[1].generate(1, self.signblockprivkey_wif)
@@ -228,6 +253,51 @@ class RESTTest (BitcoinTestFramework):
         long_uri = '/'.join(['{}-{}'.format(txid, n_) for n_ in range(15)])
         self.test_rest_request("/getutxos/checkmempool/{}".format(long_uri), http_method='POST', status=200)
 
+        self.log.info("Test the /batch/utxos URI")
+
+        # One unspent, one spent and one missing outpoint
+        outpoints = [spending, spent, (spending[0], 99)]
+        bin_request = b'\x01' + ser_compact_size(len(outpoints))
+        for txid_, n_ in outpoints:
+            bin_request += COutPoint(int(txid_, 16), n_).serialize()
+        bin_response = self.test_rest_request("/batch/utxos", http_method='POST', req_type=ReqType.BIN, body=bin_request, ret_type=RetType.BYTES)
+        output = BytesIO(bin_response)
+        chain_height, = unpack("<i", output.read(4))
+        assert_equal(chain_height, self.nodes[0].getblockcount())
+        assert_equal(binascii.hexlify(output.read(32)[::-1]).decode('ascii'), self.nodes[0].getbestblockhash())
+        coins = deser_string_vector(output)
+        assert_equal(output.read(), b'')
+        assert_equal([len(coin) > 0 for coin in coins], [True, False, False])
+        # a coin is the dummy version, the height and the output
+        coin = BytesIO(coins[0])
+        _, coin_height = unpack("<II", coin.read(8))
+        assert_equal(coin_height, self.nodes[0].getblockcount())
+        txout = CTxOut()
+        txout.deserialize(coin)
+        assert_equal(txout.nValue, 10000000)
+
+        # Only binary POST requests are accepted
+        self.test_rest_request("/batch/utxos", req_type=ReqType.BIN, body=bin_request, status=405, ret_type=RetType.OBJ)
+        self.test_rest_request("/batch/utxos", http_method='POST', req_type=ReqType.HEX, body=bin_request, status=404, ret_type=RetType.OBJ)
+        self.test_rest_request("/batch/utxos", http_method='POST', req_type=ReqType.BIN, body=bin_request[:-1], status=400, ret_type=RetType.OBJ)
+
+        self.log.info("Test the /batch/txs URI")
+
+        # Without -txindex only mempool transactions are found
+        mempool_txid = self.nodes[0].sendtoaddress(not_related_address, 1)
+        bin_request = ser_compact_size(2) + ser_uint256(int(mempool_txid, 16)) + ser_uint256(int(spending[0], 16))
+        bin_response = self.test_rest_request("/batch/txs", http_method='POST', req_type=ReqType.BIN, body=bin_request, ret_type=RetType.BYTES)
+        output = BytesIO(bin_response)
+        txs = deser_string_vector(output)
+        assert_equal(output.read(), b'')
+        assert_equal(len(txs), 2)
+        # a transaction is its block hash, zero in the mempool, and the transaction
+        assert_equal(txs[0][:32], b'\x00' * 32)
+        assert_equal(binascii.hexlify(txs[0][32:]).decode('ascii'), self.nodes[0].getrawtransaction(mempool_txid))
+        assert_equal(txs[1], b'')
+        self.nodes[0].generate(1, self.signblockprivkey_wif)
+        self.sync_all()
+
         self.log.info("Test the /block and /headers URIs")
         bb_hash = self.nodes[0].getbestblockhash()
 
@@ -293,5 +363,21 @@ class RESTTest (BitcoinTestFramework):
         json_obj = self.test_rest_request("/chaininfo")
         assert_equal(json_obj['bestblockhash'], bb_hash)
 
+        self.log.info("Test mempool pages with transactions entering in the same second")
+        # All of them have the same entry time, so only their entry sequence
+        # tells whether they were added after the cursor.
+        self.nodes[0].setmocktime(int(time.time()))
+        address = self.nodes[1].getnewaddress()
+        first = [self.nodes[0].sendtoaddress(address, 0.1) for _ in range(2)]
+        json_obj = self.test_rest_request("/mempool/contents/1")
+        paged = list(json_obj['transactions'])
+        later = [self.nodes[0].sendtoaddress(address, 0.1) for _ in range(10)]
+        while json_obj['next'] is not None:
+            json_obj = self.test_rest_request("/mempool/contents/1/{}".format(json_obj['next']))
+            paged += list(json_obj['transactions'])
+        assert_equal(sorted(paged), sorted(self.nodes[0].getrawmempool()))
+        assert_equal(paged[-12:], first + later)
+        self.nodes[0].setmocktime(0)
+
 if __name__ == '__main__':
     RESTTest().main()
@@ -61,7 +61,22 @@ class ZMQTest (BitcoinTestFramework):
         self.rawblock = ZMQSubscriber(socket, b"rawblock")
         self.rawtx = ZMQSubscriber(socket, b"rawtx")
 
-        self.extra_args = [["-zmqpub%s=%s" % (sub.topic.decode(), address) for sub in [self.hashblock, self.hashtx, self.rawblock, self.rawtx]], []]
+        # The sequence topic gets its own socket so it does not change the
+        # publishing order seen above.
+        seq_address = "tcp://127.0.0.1:28333"
+        seq_socket = self.zmq_context.socket(zmq.SUB)
+        seq_socket.set(zmq.RCVTIMEO, 60000)
+        seq_socket.connect(seq_address)
+        self.sequence = ZMQSubscriber(seq_socket, b"sequence")
+
+        # So does the tokentx topic.
+        token_address = "tcp://127.0.0.1:28334"
+        token_socket = self.zmq_context.socket(zmq.SUB)
+        token_socket.set(zmq.RCVTIMEO, 60000)
+        token_socket.connect(token_address)
+        self.tokentx = ZMQSubscriber(token_socket, b"tokentx")
+
+        self.extra_args = [["-zmqpub%s=%s" % (sub.topic.decode(), address) for sub in [self.hashblock, self.hashtx, self.rawblock, self.rawtx]] + ["-zmqpubsequence=%s" % seq_address, "-zmqpubtokentx=%s" % token_address], []]
         self.add_nodes(self.num_nodes, self.extra_args)
         self.start_nodes()
 
@@ -117,5 +132,55 @@ class ZMQTest (BitcoinTestFramework):
         tx.calc_sha256()
         assert_equal(tx.hashMalFix, bytes_to_hex_str(txid))
 
+        self.log.info("Test the sequence topic")
+        for x in range(num_blocks):
+            body = self.sequence.receive()
+            assert_equal(len(body), 33)
+            assert_equal(bytes_to_hex_str(body[:32]), genhashes[x])
+            assert_equal(body[32:], b"C")
+
+        body = self.sequence.receive()
+        assert_equal(len(body), 41)
+        assert_equal(bytes_to_hex_str(body[:32]), payment_txid)
+        assert_equal(body[32:33], b"A")
+        mempool_sequence = struct.unpack("<Q", body[33:])[0]
+        assert_equal(self.nodes[0].getrawmempool(False, True), {"txids": [payment_txid], "mempool_sequence": mempool_sequence + 1})
+
+        # Mining the transaction removes it with the block, not as a separate event
+        blockhash = self.nodes[0].generate(1, self.signblockprivkey_wif)[0]
+        body = self.sequence.receive()
+        assert_equal(bytes_to_hex_str(body[:32]), blockhash)
+        assert_equal(body[32:], b"C")
+        assert_equal(self.nodes[0].getrawmempool(False, True), {"txids": [], "mempool_sequence": mempool_sequence + 2})
+
+        # Disconnecting the block puts the transaction back into the mempool
+        self.nodes[0].invalidateblock(blockhash)
+        body = self.sequence.receive()
+        assert_equal(bytes_to_hex_str(body[:32]), blockhash)
+        assert_equal(body[32:], b"D")
+        body = self.sequence.receive()
+        assert_equal(bytes_to_hex_str(body[:32]), payment_txid)
+        assert_equal(body[32:33], b"A")
+        assert_equal(struct.unpack("<Q", body[33:])[0], mempool_sequence + 2)
+
+        self.log.info("Test the tokentx topic")
+        # Nothing was published for the TPC transactions above, so the token
+        # issue is the first message.
+        utxo = self.nodes[0].listunspent()[0]
+        issued = self.nodes[0].issuetoken(2, 1000, utxo['txid'], utxo['vout'])
+        body = self.tokentx.receive()
+        assert_equal(bytes_to_hex_str(body[:32]), issued['txid'])
+        colored = [out for out in self.nodes[0].getrawtransaction(issued['txid'], True)['vout'] if out['token'] != 'TPC']
+        assert_equal(len(colored), 1)
+        assert_equal(body[32], len(colored))
+        pos = 33
+        for out in colored:
+            assert_equal(struct.unpack("<I", body[pos:pos + 4])[0], out['n'])
+            assert_equal(bytes_to_hex_str(body[pos + 4:pos + 37]), issued['color'])
+            assert_equal(struct.unpack("<q", body[pos + 37:pos + 45])[0], 1000)
+            assert_equal(out['value'], 1000)
+            pos += 45
+        assert_equal(pos, len(body))
+
 if __name__ == '__main__':
     ZMQTest().main()
@@ -116,6 +116,12 @@ class MempoolPersistTest(BitcoinTestFramework):
         assert_raises_rpc_error(-1, "Unable to dump mempool to disk", self.nodes[1].savemempool)
         os.rmdir(mempooldotnew1)
 
+        self.log.debug("Restart node1 at the same tip with a higher relay fee. Verify that the current policy rejects the transactions.")
+        self.stop_nodes()
+        with self.nodes[1].assert_debug_log(["0 succeeded, 0 restored at the same tip, 5 failed"]):
+            self.start_node(1, extra_args=["-minrelaytxfee=0.01", "-disablewallet"])
+        assert_equal(len(self.nodes[1].getrawmempool()), 0)
+
 
 if __name__ == '__main__':
     MempoolPersistTest().main()
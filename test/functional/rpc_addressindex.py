@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 Chaintope Inc.
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test -addressindex with the getaddresshistory and getaddressutxos rpc calls and /rest/address/."""
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error
+
+from decimal import Decimal
+import http.client
+import json
+import urllib.parse
+
+class AddressIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [['-addressindex', '-rest'], []]
+        self.setup_clean_chain = True
+
+    def rest_get(self, uri, status=200):
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', '/rest/address/' + uri)
+        resp = conn.getresponse()
+        assert_equal(resp.status, status)
+        if status != 200:
+            return resp.read().decode('utf-8')
+        return json.loads(resp.read().decode('utf-8'), parse_float=Decimal)
+
+    def run_test(self):
+        node = self.nodes[0]
+        node.generate(1, self.signblockprivkey_wif)
+
+        self.log.info("Test outputs and the inputs spending them")
+        addr = node.getnewaddress()
+        txid = node.sendtoaddress(addr, 1)
+        node.generate(1, self.signblockprivkey_wif)
+        height = node.getblockcount()
+        vout = [o['n'] for o in node.getrawtransaction(txid, True)['vout'] if o['value'] == 1][0]
+
+        history = node.getaddresshistory(addr)
+        assert_equal(history, [{
+            'txid': txid,
+            'vout': vout,
+            'category': 'receive',
+            'token': 'TPC',
+            'amount': Decimal('1'),
+            'height': height,
+            'blockhash': node.getblockhash(height),
+        }])
+        assert_equal(node.getaddressutxos(addr), history)
+
+        addr2 = node.getnewaddress()
+        raw = node.createrawtransaction([{'txid': txid, 'vout': vout}], {addr2: Decimal('0.999')})
+        spend_txid = node.sendrawtransaction(node.signrawtransactionwithwallet(raw)['hex'])
+        node.generate(1, self.signblockprivkey_wif)
+
+        history = node.getaddresshistory(addr)
+        assert_equal(len(history), 2)
+        assert_equal(history[1]['txid'], spend_txid)
+        assert_equal(history[1]['category'], 'send')
+        assert_equal(history[1]['vin'], 0)
+        assert_equal(history[1]['amount'], Decimal('1'))
+        assert_equal((history[1]['prevout_txid'], history[1]['prevout_vout']), (txid, vout))
+        assert_equal(history[1]['height'], height + 1)
+        assert_equal(node.getaddressutxos(addr), [])
+        utxos2 = node.getaddressutxos(addr2)
+        assert_equal([(u['txid'], u['vout'], u['amount']) for u in utxos2], [(spend_txid, 0, Decimal('0.999'))])
+
+        self.log.info("Test pages")
+        assert_equal(node.getaddresshistory(addr, 1), history[1:])
+        assert_equal(node.getaddresshistory(addr, 0, 1), history[:1])
+        assert_equal(node.getaddresshistory(addr, 2, 1), [])
+
+        self.log.info("Test that entries of disconnected blocks are left out")
+        tip = node.getbestblockhash()
+        node.invalidateblock(tip)
+        assert_equal(node.getaddresshistory(addr), history[:1])
+        assert_equal(len(node.getaddressutxos(addr)), 1)
+        node.reconsiderblock(tip)
+        assert_equal(node.getaddresshistory(addr), history)
+
+        self.log.info("Test colored outputs")
+        utxo = node.listunspent()[0]
+        color = node.issuetoken(2, 1000, utxo['txid'], utxo['vout'])['color']
+        node.generate(1, self.signblockprivkey_wif)
+        caddr = node.getnewaddress("", color)
+        token_txid = node.transfertoken(caddr, 100)
+        node.generate(1, self.signblockprivkey_wif)
+
+        token_utxos = node.getaddressutxos(caddr)
+        assert_equal([(u['txid'], u['token'], u['amount']) for u in token_utxos], [(token_txid, color, 100)])
+        # The script without the color has the token outputs too
+        script = node.getaddressinfo(caddr)['scriptPubKey']
+        assert_equal(script[68:70], 'bc')  # <color> OP_COLOR
+        assert_equal(node.getaddressutxos(script[70:]), token_utxos)
+        assert_equal(node.getaddresshistory(script), node.getaddresshistory(caddr))
+
+        self.log.info("Test REST")
+        assert_equal(self.rest_get('history/%s.json' % addr), history)
+        assert_equal(self.rest_get('history/%s/1/1.json' % addr), history[1:])
+        assert_equal(self.rest_get('utxos/%s.json' % addr2), utxos2)
+
+        self.log.info("Test errors")
+        assert_raises_rpc_error(-5, 'Invalid address or script', node.getaddresshistory, 'notanaddress')
+        assert_raises_rpc_error(-8, 'Negative count', node.getaddresshistory, addr, 0, -1)
+        assert_raises_rpc_error(-8, 'Negative skip', node.getaddressutxos, addr, -1)
+        assert_raises_rpc_error(-8, 'Count larger than 10000', node.getaddressutxos, addr, 0, 10001)
+        assert_equal(node.getaddresshistory(addr, 0, 10000), node.getaddresshistory(addr))
+        assert 'Count larger than 10000' in self.rest_get('history/%s/0/10001.json' % addr, 400)
+        assert_raises_rpc_error(-1, 'Requires -addressindex enabled', self.nodes[1].getaddresshistory, addr)
+
+if __name__ == '__main__':
+    AddressIndexTest().main()
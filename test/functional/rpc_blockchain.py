@@ -55,6 +55,7 @@ class BlockchainTest(BitcoinTestFramework):
         self._test_getchaintxstats()
         self._test_gettxoutsetinfo()
         self._test_getblockheader()
+        self._test_batch()
         self._test_stopatheight()
         self._test_waitforblockheight()
         assert self.nodes[0].verifychain(4, 0)
@@ -236,6 +237,23 @@ class BlockchainTest(BitcoinTestFramework):
         self.start_node(0)
         assert_equal(self.nodes[0].getblockcount(), 107)
 
+    def _test_batch(self):
+        self.log.info("Test batch requests with read-only calls executed in parallel")
+        node = self.nodes[0]
+        height = node.getblockcount()
+        requests = [node.getblockhash.get_request(h) for h in range(height + 1)]
+        # calls that are not read-only split the batch into separately executed runs
+        requests.insert(3, node.help.get_request("getblockhash"))
+        requests.insert(7, node.getblockhash.get_request(height + 1))
+        requests.append(node.getblockheader.get_request(node.getbestblockhash()))
+        results = node.batch(requests)
+        assert_equal([r["id"] for r in results], [r["id"] for r in requests])
+        hashes = [r["result"] for r in results[:3] + results[4:7] + results[8:-1]]
+        assert_equal(hashes, [node.getblockhash(h) for h in range(height + 1)])
+        assert results[3]["result"].startswith("getblockhash")
+        assert_equal(results[7]["error"]["code"], -8)
+        assert_equal(results[-1]["result"]["height"], height)
+
     def _test_waitforblockheight(self):
         self.log.info("Test waitforblockheight")
         node = self.nodes[0]
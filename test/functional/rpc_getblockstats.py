@@ -14,8 +14,10 @@ from test_framework.util import (
     bytes_to_hex_str,
     initialize_datadir,
     connect_nodes_bi,
-    NetworkDirName
+    NetworkDirName,
+    wait_until,
 )
+from test_framework.authproxy import JSONRPCException
 from test_framework.blocktools import createTestGenesisBlock
 import json
 import os
@@ -206,5 +208,61 @@ class GetblockstatsTest(BitcoinTestFramework):
         assert_raises_rpc_error(-5, 'Block not found', self.nodes[0].getblockstats,
                                 hash_or_height='000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f')
 
+        self.log.info('Test getblockstatsrange')
+        # Inputs come from the undo data, so the node without txindex gets every statistic
+        range_stats = self.nodes[1].getblockstatsrange(self.start_height, tip)
+        for row in range_stats:
+            assert_equal(row.pop('tokens'), {})
+        assert_equal(range_stats, self.expected_stats)
+        assert_equal(self.nodes[1].getblockstatsrange(tip, tip, ['height', 'tokens']), [{'height': tip, 'tokens': {}}])
+
+        assert_raises_rpc_error(-8, 'Target block height %d after current tip %d' % (tip+1, tip),
+                                self.nodes[1].getblockstatsrange, 0, tip+1)
+        assert_raises_rpc_error(-8, 'Start height %d is after end height %d' % (tip, tip-1),
+                                self.nodes[1].getblockstatsrange, tip, tip-1)
+        assert_raises_rpc_error(-8, 'Range of 1001 blocks is longer than 1000 blocks',
+                                self.nodes[1].getblockstatsrange, 0, 1000)
+        assert_raises_rpc_error(-8, 'Invalid selected statistic %s' % inv_sel_stat,
+                                self.nodes[1].getblockstatsrange, 0, tip, [inv_sel_stat])
+
+        self.log.info('Test token statistics')
+        self.nodes[0].generate(1, self.signblockprivkey_wif)
+        utxo = self.nodes[0].listunspent()[0]
+        color = self.nodes[0].issuetoken(2, 1000, utxo['txid'], utxo['vout'])['color']
+        self.nodes[0].generate(1, self.signblockprivkey_wif)
+        self.nodes[0].transfertoken(self.nodes[1].getnewaddress("", color), 100)
+        self.nodes[0].generate(1, self.signblockprivkey_wif)
+        self.nodes[0].burntoken(color, 10)
+        self.nodes[0].generate(1, self.signblockprivkey_wif)
+        self.sync_all()
+
+        height = self.nodes[0].getblockcount()
+        tokens = [row['tokens'] for row in self.nodes[1].getblockstatsrange(height - 3, height, ['tokens'])]
+        assert_equal(tokens, [
+            {},
+            {color: {'transfers': 0, 'issuances': 1, 'issued': 1000, 'burned': 0}},
+            {color: {'transfers': 1, 'issuances': 0, 'issued': 0, 'burned': 0}},
+            {color: {'transfers': 1, 'issuances': 0, 'issued': 0, 'burned': 10}},
+        ])
+        # getblockstats has them too, when selected
+        assert_equal(self.nodes[0].getblockstats(height, ['tokens'])['tokens'], tokens[3])
+        assert 'tokens' not in self.nodes[0].getblockstats(height)
+
+        self.log.info('Test -blockstatsindex')
+        self.restart_node(1, ['-paytxfee=0.003', '-blockstatsindex'])
+
+        # The node has no txindex, so every statistic comes from the index once it is in sync
+        def index_synced():
+            try:
+                self.nodes[1].getblockstats(height)
+                return True
+            except JSONRPCException:
+                return False
+        wait_until(index_synced)
+        for h in range(self.start_height, height + 1):
+            assert_equal(self.nodes[1].getblockstats(h), self.nodes[0].getblockstats(h))
+            assert_equal(self.nodes[1].getblockstats(h, ['tokens', 'totalfee']), self.nodes[0].getblockstats(h, ['tokens', 'totalfee']))
+        assert_equal(self.nodes[1].getblockstatsrange(0, height), self.nodes[0].getblockstatsrange(0, height))
+
 if __name__ == '__main__':
     GetblockstatsTest().main()
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 Chaintope Inc.
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the HTTP work queues and the getrpcinfo RPC.
+
+Test corresponds to code in httpserver.cpp, httprpc.cpp and rpc/server.cpp.
+"""
+import http.client
+import urllib.parse
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_greater_than_or_equal,
+    assert_raises_rpc_error,
+    str_to_b64str,
+)
+
+
+class GetRPCInfoTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [['-rpcthreads=2', '-rpcheavythreads=3', '-rpcworkqueue=20']]
+
+    def queues(self):
+        return {q['name']: q for q in self.nodes[0].getrpcinfo()['queues']}
+
+    def run_test(self):
+        node = self.nodes[0]
+
+        self.log.info("Check the work queues")
+        queues = self.queues()
+        assert_equal(sorted(queues), ['default', 'fast', 'heavy'])
+        assert_equal(queues['fast']['threads'], 1)
+        assert_equal(queues['default']['threads'], 2)
+        assert_equal(queues['heavy']['threads'], 3)
+        for queue in queues.values():
+            assert_equal(queue['limit'], 20)
+            assert_equal(queue['rejected'], 0)
+
+        self.log.info("Check that calls go to the queue of their class")
+        methods = node.getrpcinfo()['methods']
+        queues = self.queues()
+        calls = {m: methods.get(m, {'calls': 0, 'errors': 0}) for m in ['getblockhash', 'gettxoutsetinfo']}
+        fast = queues['fast']['processed']
+        default = queues['default']['processed']
+        heavy = queues['heavy']['processed']
+        node.getblockcount()
+        node.getblockhash(0)
+        node.gettxoutsetinfo()
+        # a batch goes where its slowest call goes
+        node.batch([node.getblockcount.get_request(), node.gettxoutsetinfo.get_request()])
+        queues = self.queues()
+        # the getrpcinfo calls themselves are fast too
+        assert_equal(queues['fast']['processed'], fast + 2)
+        assert_equal(queues['default']['processed'], default + 1)
+        assert_equal(queues['heavy']['processed'], heavy + 2)
+
+        self.log.info("Check that only starting a scan is heavy")
+        node.scantxoutset("start", [])
+        node.scantxoutset("status")
+        node.scantxoutset(action="abort")
+        queues = self.queues()
+        assert_equal(queues['fast']['processed'], fast + 5)
+        assert_equal(queues['heavy']['processed'], heavy + 3)
+
+        self.log.info("Check that requests failing authorization go to the default queue")
+        url = urllib.parse.urlparse(node.url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('POST', '/', '{"method": "gettxoutsetinfo"}', {"Authorization": "Basic " + str_to_b64str(url.username + ":wrong")})
+        assert_equal(conn.getresponse().status, 401)
+        conn.close()
+        queues = self.queues()
+        assert_equal(queues['default']['processed'], default + 2)
+        assert_equal(queues['heavy']['processed'], heavy + 3)
+
+        self.log.info("Check the method statistics")
+        assert_raises_rpc_error(-8, "Block height out of range", node.getblockhash, 1)
+        methods = node.getrpcinfo()['methods']
+        assert_equal(methods['getblockhash']['calls'], calls['getblockhash']['calls'] + 2)
+        assert_equal(methods['getblockhash']['errors'], calls['getblockhash']['errors'] + 1)
+        assert_equal(methods['gettxoutsetinfo']['calls'], calls['gettxoutsetinfo']['calls'] + 2)
+        assert_equal(methods['gettxoutsetinfo']['errors'], calls['gettxoutsetinfo']['errors'])
+        assert_greater_than_or_equal(methods['gettxoutsetinfo']['total_time_us'], methods['gettxoutsetinfo']['max_time_us'])
+
+
+if __name__ == '__main__':
+    GetRPCInfoTest().main()
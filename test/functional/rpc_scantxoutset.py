@@ -5,11 +5,12 @@
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test the scantxoutset rpc call."""
 from test_framework.test_framework import BitcoinTestFramework
-from test_framework.util import assert_equal,  assert_raises_rpc_error, NetworkDirName
+from test_framework.util import assert_equal,  assert_raises_rpc_error, get_rpc_proxy, wait_until, NetworkDirName
 
 from decimal import Decimal
 import shutil
 import os
+import threading
 
 class ScantxoutsetTest(BitcoinTestFramework):
     def set_test_params(self):
@@ -19,6 +20,12 @@ class ScantxoutsetTest(BitcoinTestFramework):
         self.log.info("Mining blocks...")
         self.nodes[0].generate(1, self.signblockprivkey_wif)
 
+        utxo = self.nodes[0].listunspent()[0]
+        issued = self.nodes[0].issuetoken(2, 1000, utxo['txid'], utxo['vout'])
+        color = issued['color']
+        token_script = [o['scriptPubKey']['hex'] for o in self.nodes[0].getrawtransaction(issued['txid'], True)['vout'] if o['token'] == color][0]
+        self.nodes[0].generate(1, self.signblockprivkey_wif)
+
         addr_LEGACY1 = self.nodes[0].getnewaddress("")
         pubk1 = self.nodes[0].getaddressinfo(addr_LEGACY1)['pubkey']
         addr_LEGACY2 = self.nodes[0].getnewaddress("")
@@ -87,5 +94,40 @@ class ScantxoutsetTest(BitcoinTestFramework):
         assert_equal(self.nodes[0].scantxoutset("start", [ {"desc": "combo(tpubD6NzVbkrYhZ4WaWSyoBvQwbpLkojyoTZPRsgXELWz3Popb3qkjcJyJUGLnL4qHHoQvao8ESaAstxYSnhyswJ76uZPStJRJCTKvosUCJZL5B/1/1/*)", "range": 1499}])['total_amount'], {'TPC': Decimal("12.288")})
         assert_equal(self.nodes[0].scantxoutset("start", [ {"desc": "combo(tpubD6NzVbkrYhZ4WaWSyoBvQwbpLkojyoTZPRsgXELWz3Popb3qkjcJyJUGLnL4qHHoQvao8ESaAstxYSnhyswJ76uZPStJRJCTKvosUCJZL5B/1/1/*)", "range": 1500}])['total_amount'], {'TPC': Decimal("28.672")})
 
+        self.log.info("Test color filters.")
+        assert_equal(self.nodes[0].scantxoutset("start", [ {"color": color} ])['total_amount'], {color: 1000})
+        # the descriptor's scripts colored with the token
+        assert_equal(token_script[68:70], 'bc')  # <color> OP_COLOR
+        assert_equal(self.nodes[0].scantxoutset("start", [ {"desc": "raw(" + token_script[70:] + ")", "color": color} ])['total_amount'], {color: 1000})
+        assert_equal(self.nodes[0].scantxoutset("start", [ "raw(" + token_script + ")" ])['total_amount'], {color: 1000})
+        assert_equal(self.nodes[0].scantxoutset("start", [ "raw(" + token_script[70:] + ")" ])['total_amount'], {})
+        assert_equal(self.nodes[0].scantxoutset("start", [ {"color": color}, "addr(" + addr_LEGACY1 + ")" ])['total_amount'], {'TPC': Decimal('0.001'), color: 1000})
+        assert_raises_rpc_error(-8, "Invalid color", self.nodes[0].scantxoutset, "start", [ {"color": "00" * 33} ])
+        assert_raises_rpc_error(-8, "Descriptor or color needs to be provided in scan object", self.nodes[0].scantxoutset, "start", [ {"range": 10} ])
+
+        self.log.info("Test status and abort without a scan running.")
+        assert_equal(self.nodes[0].scantxoutset("status"), None)
+        assert_equal(self.nodes[0].scantxoutset("abort"), False)
+
+        self.log.info("Test that scans started during a pass share the next one.")
+        self.restart_node(0, ["-testscanpassdelay=3000"])
+        descs = ["addr(" + addr_LEGACY1 + ")", "addr(" + addr_LEGACY2 + ")", "addr(" + addr_LEGACY3 + ")"]
+        results = [None] * len(descs)
+
+        def scan(i):
+            rpc = get_rpc_proxy(self.nodes[0].url, 0, timeout=60)
+            results[i] = rpc.scantxoutset("start", [descs[i]])
+
+        threads = [threading.Thread(target=scan, args=(i,)) for i in range(len(descs))]
+        threads[0].start()
+        wait_until(lambda: self.nodes[0].scantxoutset("status") is not None, timeout=30)
+        threads[1].start()
+        threads[2].start()
+        wait_until(lambda: (self.nodes[0].scantxoutset("status") or {}).get('scans') == 3, timeout=30)
+        for t in threads:
+            t.join()
+        assert_equal([r['pass_scans'] for r in results], [1, 2, 2])
+        assert_equal([r['total_amount'] for r in results], [{'TPC': Decimal('0.001')}, {'TPC': Decimal('0.002')}, {'TPC': Decimal('0.004')}])
+
 if __name__ == '__main__':
     ScantxoutsetTest().main()
@@ -168,9 +168,11 @@ BASE_SCRIPTS = [
     'p2p_initial_headers_sync.py',
     'feature_dersig.py',
     'rpc_uptime.py',
+    'rpc_getrpcinfo.py',
     'wallet_resendwallettransactions.py',
     'wallet_fallbackfee.py',
     'rpc_getblockstats.py',
+    'rpc_addressindex.py',
     'p2p_fingerprint.py',
     'feature_uacomment.py',
     'p2p_unrequested_blocks.py',